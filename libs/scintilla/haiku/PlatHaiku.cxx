@@ -13,6 +13,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -61,6 +62,7 @@ const Supports SupportsHaiku[] = {
 	Supports::FractionalStrokeWidth,
 	Supports::TranslucentStroke,
 	Supports::PixelModification,
+	Supports::ThreadSafeMeasureWidths,
 };
 
 class BitmapLock
@@ -98,9 +100,19 @@ BPoint toBPoint(Point p) {
 	return BPoint(p.x, p.y);
 }
 
+// The metrics of a font, cached as the layout asks for them on every line:
+// the height, the advance of the ASCII characters, measured at creation,
+// and the advance of the other code points, added as they are met.
+// The layout threads measure text at the same time, hence the lock on
+// the code points map.
 struct FontHaiku : public Font {
 	BFont *bfont;
-	FontHaiku() noexcept : bfont(nullptr) {
+	font_height height;
+	float asciiWidths[128];
+	mutable std::mutex widthsLock;
+	mutable std::unordered_map<uint32_t, float> widths;
+
+	FontHaiku() noexcept : bfont(nullptr), height(), asciiWidths() {
 	}
 	FontHaiku(const FontParameters &fp) {
 		bfont = new BFont();
@@ -112,6 +124,58 @@ struct FontHaiku : public Font {
 			face |= B_ITALIC_FACE;
 		bfont->SetFace(face);
 		bfont->SetSize(fp.size);
+
+		bfont->GetHeight(&height);
+		// all at once; NUL would end the string
+		char ascii[127];
+		for (int i = 0; i < 127; i++)
+			ascii[i] = i + 1;
+		asciiWidths[0] = 0;
+		bfont->GetEscapements(ascii, 127, asciiWidths + 1);
+		for (int i = 1; i < 128; i++)
+			asciiWidths[i] *= bfont->Size();
+	}
+	// widthsLock must be held
+	float CharacterWidth(const char *character, int length) const {
+		const unsigned char *us = reinterpret_cast<const unsigned char *>(character);
+		const bool valid = length > 1 && UTF8BytesOfLead[us[0]] == length;
+		// an invalid byte is measured as U+FFFD
+		const uint32_t codePoint = valid ? UnicodeFromUTF8(us) : 0xFFFD;
+		const auto found = widths.find(codePoint);
+		if (found != widths.end())
+			return found->second;
+
+		float escapement = 0;
+		bfont->GetEscapements(valid ? character : "\xEF\xBF\xBD", 1, &escapement);
+		const float width = escapement * bfont->Size();
+		widths.emplace(codePoint, width);
+		return width;
+	}
+	// Measures text without allocating: fills positions, when given, with
+	// the position after the character each byte belongs to.
+	XYPOSITION Measure(std::string_view text, XYPOSITION *positions) const {
+		std::unique_lock<std::mutex> lock(widthsLock, std::defer_lock);
+		XYPOSITION position = 0;
+		size_t i = 0;
+		while (i < text.length()) {
+			const unsigned char ch = text[i];
+			if (UTF8IsAscii(ch)) {
+				position += asciiWidths[ch];
+				if (positions != nullptr)
+					positions[i] = position;
+				i++;
+				continue;
+			}
+			const int length = UTF8DrawBytes(text.data() + i, text.length() - i);
+			if (!lock.owns_lock())
+				lock.lock();
+			position += CharacterWidth(text.data() + i, length);
+			for (int b = 0; b < length; b++, i++) {
+				if (positions != nullptr)
+					positions[i] = position;
+			}
+		}
+		return position;
 	}
 	FontHaiku(const FontHaiku &) = delete;
 	FontHaiku(FontHaiku &&) = delete;
@@ -632,77 +696,44 @@ void SurfaceImpl::DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPO
 	}
 }
 
-// borrowed from Qt port
 void SurfaceImpl::MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) {
-	BFont* font = HFont(font_)->bfont;
-	if (font) {
-		int fit = MultibyteToUTF8Length(text);
-		int ui = 0;
-		size_t i = 0;
-		float currentPos = 0.0f;
-		std::vector<float> escp(text.length());
-		font->GetEscapements(text.data(), text.length(), escp.data());
-		while(ui < fit) {
-			size_t lenChar = UTF8CharLength(text.data() + i);
-			int codeUnits = (lenChar < 4) ? 1 : 2;
-			float pos = currentPos + escp[ui] * font->Size();
-			for(unsigned int bytePos = 0; (bytePos < lenChar) && (i < text.length()); bytePos++) {
-				positions[i++] = pos;
-			}
-			ui += codeUnits;
-			currentPos = pos;
-		}
-		float lastPos = 0;
-		if(i > 0)
-			lastPos = positions[i - 1];
-		while(i < text.length())
-			positions[i++] = lastPos;
-	}
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		font->Measure(text, positions);
 }
 
 XYPOSITION SurfaceImpl::WidthTextUTF8(const Font *font_, std::string_view text) {
-	XYPOSITION width = round(HFont(font_)->bfont->StringWidth(text.data(), text.length()));
-	return width;
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		return round(font->Measure(text, nullptr));
+	return 0;
 }
 
 XYPOSITION SurfaceImpl::Ascent(const Font *font_) {
-	BFont* font = HFont(font_)->bfont;
-	if (font) {
-		font_height fh;
-		font->GetHeight(&fh);
-		return ceil(fh.ascent);
-	}
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		return ceil(font->height.ascent);
 	return 0;
 }
 
 XYPOSITION SurfaceImpl::Descent(const Font *font_) {
-	BFont* font = HFont(font_)->bfont;
-	if (font) {
-		font_height fh;
-		font->GetHeight(&fh);
-		return ceil(fh.descent);
-	}
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		return ceil(font->height.descent);
 	return 0;
 }
 
 XYPOSITION SurfaceImpl::InternalLeading(const Font *font_) {
-	BFont* font = HFont(font_)->bfont;
-	if (font) {
-		font_height fh;
-		font->GetHeight(&fh);
-		return ceil(fh.leading);
-	}
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		return ceil(font->height.leading);
 	return 0;
 }
 
 XYPOSITION SurfaceImpl::Height(const Font *font_) {
-	BFont* font = HFont(font_)->bfont;
-	if (font) {
-		font_height fh;
-		font->GetHeight(&fh);
-		int h = (ceil(fh.descent) + ceil(fh.ascent));
-		return h;
-	}
+	const FontHaiku* font = HFont(font_);
+	if (font && font->bfont)
+		return ceil(font->height.descent) + ceil(font->height.ascent);
 	return 0;
 }
 
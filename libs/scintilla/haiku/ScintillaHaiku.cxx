@@ -85,6 +85,7 @@ using namespace Scintilla::Internal;
 namespace {
 	const int32 sContextMenu = 'BSCM';
 	const int32 sTickMessage = 'TCKM';
+	const int32 sIdleMessage = 'IDLM';
 	const BString sMimeRectangularMarker("text/x-rectangular-marker");
 
 	struct pair_hash {
@@ -170,6 +171,7 @@ public:
 	bool FineTickerRunning(TickReason reason) override ;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override ;
 	void FineTickerCancel(TickReason reason) override ;
+	bool SetIdle(bool on) override ;
 	void SetMouseCapture(bool) override ;
 	bool HaveMouseCapture() override ;
 	sptr_t WndProc(Message, uptr_t, sptr_t) override ;
@@ -203,6 +205,10 @@ public:
 private:
 	bool capturedMouse;
 	BMessageRunner* timers[static_cast<size_t>(TickReason::dwell) + 1];
+	// an sIdleMessage is in the looper queue
+	bool idlePosted;
+
+	void _PostIdle();
 
 	void _Activate();
 	void _Deactivate();
@@ -379,6 +385,7 @@ void ScintillaHaiku::Initialise() {
 			tr++) {
 		timers[tr] = NULL;
 	}
+	idlePosted = false;
 
 	if(imeInteraction == IMEInteraction::Inline)
 		SetFlags(Flags() | B_INPUT_METHOD_AWARE);
@@ -393,6 +400,7 @@ void ScintillaHaiku::Finalise() {
 			tr++) {
 		FineTickerCancel(static_cast<TickReason>(tr));
 	}
+	SetIdle(false);
 	ScintillaBase::Finalise();
 }
 
@@ -555,6 +563,16 @@ void ScintillaHaiku::MessageReceived(BMessage* msg) {
 			TickFor(static_cast<TickReason>(reason));
 		}
 	} break;
+	case sIdleMessage: {
+		idlePosted = false;
+		if(!idler.state) break;
+		// Idle() does a bounded slice of work: the events queued meanwhile
+		// are handled before the next slice
+		if(Idle())
+			_PostIdle();
+		else
+			SetIdle(false);
+	} break;
 	default:
 		Command(msg->what);
 		BView::MessageReceived(msg);
@@ -599,6 +617,28 @@ void ScintillaHaiku::FineTickerCancel(TickReason reason) {
 	}
 }
 
+// Idle work (background styling and wrapping) runs in slices, each one
+// posted behind the messages already waiting in the window queue.
+bool ScintillaHaiku::SetIdle(bool on) {
+	if(on) {
+		if(!idler.state) {
+			idler.state = true;
+			_PostIdle();
+		}
+	} else {
+		// a message already posted finds the idler stopped
+		idler.state = false;
+	}
+	return true;
+}
+
+void ScintillaHaiku::_PostIdle() {
+	// not attached yet: AttachedToWindow() posts it
+	if(idlePosted || Looper() == NULL) return;
+	if(Looper()->PostMessage(sIdleMessage, this) == B_OK)
+		idlePosted = true;
+}
+
 void ScintillaHaiku::SetMouseCapture(bool on) {
 	capturedMouse = on;
 }
@@ -770,6 +810,8 @@ void ScintillaHaiku::AttachedToWindow() {
 	WndProc(Message::SetBufferedDraw, 0, 0);
 	WndProc(Message::SetCodePage, SC_CP_UTF8, 0);
 	wMain = (WindowID)Parent();
+	if(idler.state)
+		_PostIdle();
 }
 
 void ScintillaHaiku::MakeFocus(bool focus) {
@@ -409,6 +409,9 @@ GenioApp::_PrepareConfig(ConfigManager& cfg)
 	cfg.AddConfig(editor.String(), "brace_match", B_TRANSLATE("Enable brace matching"), true);
 	cfg.AddConfig(editor.String(), "save_caret", B_TRANSLATE("Save caret position"), true);
 	cfg.AddConfig(editor.String(), "ignore_editorconfig", B_TRANSLATE("Ignore .editorconfig"), false);
+	GMessage largeFileLimits = { {"min", 1}, {"max", 4096} };
+	cfg.AddConfig(editor.String(), "large_file_size",
+		B_TRANSLATE("Large file mode above (MiB):"), 20, &largeFileLimits);
 
 	cfg.AddConfigSeparator(editor.String(), "banner_ignore_editorconfig",
 		B_TRANSLATE_COMMENT("These are only applied if no .editorconfig is used:",
@@ -441,6 +444,8 @@ GenioApp::_PrepareConfig(ConfigManager& cfg)
 	cfg.AddConfig(editorVisual.String(), "show_linenumber", B_TRANSLATE("Show line numbers"), true);
 	cfg.AddConfig(editorVisual.String(), "show_commentmargin", B_TRANSLATE("Show comment margin"), true);
 	cfg.AddConfig(editorVisual.String(), "enable_folding", B_TRANSLATE("Show folding margin"), true);
+	cfg.AddConfig(editorVisual.String(), "show_git_changes", B_TRANSLATE("Show git changes in the margin"), true);
+	cfg.AddConfig(editorVisual.String(), "show_git_blame", B_TRANSLATE("Show git blame in the margin"), false);
 	cfg.AddConfig(editorVisual.String(), "mark_caretline", B_TRANSLATE("Mark caret line"), true);
 	cfg.AddConfig(editorVisual.String(), "show_white_space", B_TRANSLATE("Show whitespace"), false);
 	cfg.AddConfig(editorVisual.String(), "show_line_endings", B_TRANSLATE("Show line endings"), false);
@@ -480,6 +485,10 @@ GenioApp::_PrepareConfig(ConfigManager& cfg)
 	cfg.AddConfig(editorFind.String(), "find_whole_word", B_TRANSLATE_COMMENT("Whole word", "Short as possible."), false);
 	cfg.AddConfig(editorFind.String(), "find_match_case", B_TRANSLATE_COMMENT("Match case", "Short as possible."), false);
 	cfg.AddConfig(editorFind.String(), "find_exclude_directory", B_TRANSLATE("Exclude folders:"), ".*,objects.*");
+	cfg.AddConfig(editorFind.String(), "find_use_gitignore",
+		B_TRANSLATE_COMMENT("Skip files listed in .gitignore", "Find in project"), true);
+	cfg.AddConfig(editorFind.String(), "find_use_index",
+		B_TRANSLATE_COMMENT("Index projects for faster search", "Find in project"), true);
 
 	GMessage lsplevels = { {"mode", "options"},
 						   {"note", B_TRANSLATE("This setting will be updated on restart.")},
@@ -498,6 +507,20 @@ GenioApp::_PrepareConfig(ConfigManager& cfg)
 	cfg.AddConfig("LSP", "lsp_clangd_log_level", B_TRANSLATE("Log level:"),
 		(int32)lsp_log_level::LSP_LOG_LEVEL_ERROR, &lsplevels);
 
+	GMessage debounce_limits = { {"min", 50}, {"max", 2000} };
+	cfg.AddConfig("LSP", "lsp_change_debounce",
+		B_TRANSLATE("Send changes after idle time (ms):"), 250, &debounce_limits);
+
+	GMessage idle_limits = { {"min", 1}, {"max", 240} };
+	cfg.AddConfig("LSP", "lsp_idle_timeout",
+		B_TRANSLATE("Stop unused servers after (minutes):"), 10, &idle_limits);
+	GMessage servers_limits = { {"min", 1}, {"max", 32} };
+	cfg.AddConfig("LSP", "lsp_max_servers",
+		B_TRANSLATE("Maximum running servers:"), 4, &servers_limits);
+	GMessage memory_limits = { {"min", 256}, {"max", 65536} };
+	cfg.AddConfig("LSP", "lsp_max_memory",
+		B_TRANSLATE("Servers memory budget (MiB):"), 4096, &memory_limits);
+
 	BString sourceControl(B_TRANSLATE("Source control"));
 	cfg.AddConfig(sourceControl.String(), "repository_outline",
 		B_TRANSLATE("Show repository outline"), true);
@@ -40,7 +40,9 @@ enum {
 	MSG_NOTIFY_WORKSPACE_PREPARATION_COMPLETED = 'wkpc',
 
 	// git / source control
-	MSG_NOTIFY_GIT_BRANCH_CHANGED = 'gbch'			// current_branch (string)
+	MSG_NOTIFY_GIT_BRANCH_CHANGED = 'gbch',			// current_branch (string)
 													// project_path (string)
+	MSG_NOTIFY_GIT_STATUS_CHANGED = 'gsch'			// project_path (string)
+													// full (bool)
 };
 
@@ -9,8 +9,11 @@
 
 #include "Editor.h"
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <regex>
+#include <time.h>
 
 #include <Alert.h>
 #include <Application.h>
@@ -19,11 +22,13 @@
 #include <ControlLook.h>
 #include <editorconfig/editorconfig.h>
 #include <ILexer.h>
+#include <ILoader.h>
 #include <Lexilla.h>
 #include <NodeMonitor.h>
 #include <Path.h>
 #include <SciLexer.h>
 #include <StringFormat.h>
+#include <ToolTip.h>
 #include <Url.h>
 #include <Volume.h>
 
@@ -33,11 +38,13 @@
 #include "EditorStatusView.h"
 #include "GenioApp.h"
 #include "GenioWindowMessages.h"
+#include "GitWorker.h"
 #include "GoToLineWindow.h"
 #include "ResourceImport.h"
 #include "alert/GTextAlert.h"
 #include "Languages.h"
 #include "Log.h"
+#include "LineDiff.h"
 #include "LSPEditorWrapper.h"
 #include "NoticeMessages.h"
 #include "ProjectFolder.h"
@@ -52,13 +59,18 @@
 namespace Sci = Scintilla;
 using namespace Sci::Properties;
 
-const int kIdleTimeout = 250000; //1/4sec
 
 // Differentiate unset parameters from 0 ones
 // in scintilla messages
 #define UNSET 0
 #define UNUSED 0
 
+// files are read in chunks of this size; the bigger ones in the background
+static const size_t kLoadChunkSize = 256 * 1024;
+static const off_t kBackgroundLoadSize = 16 * 1024 * 1024;
+static const bigtime_t kLoadSendTimeout = 100000;
+
+
 editor_id get_unique_id() {
 	static editor_id g_id = 0;
 	return ++g_id;
@@ -69,6 +81,8 @@ Editor::Editor(entry_ref* ref, const BMessenger& target)
 	, fId(get_unique_id())
 	, fFileRef(*ref)
 	, fModified(false)
+	, fLoaded(false)
+	, fLargeFile(false)
 	, fBracingAvailable(false)
 	, fFoldingAvailable(false)
 	, fCommenter("")
@@ -76,6 +90,18 @@ Editor::Editor(entry_ref* ref, const BMessenger& target)
 	, fCurrentColumn(-1)
 	, fProjectFolder(NULL)
 	, fIdleHandler(nullptr)
+	, fLoader(nullptr)
+	, fLoadThread(-1)
+	, fLoadFile(nullptr)
+	, fLoadSize(0)
+	, fLoadProgress(0)
+	, fLoadEditable(true)
+	, fLoadStartTime(-1)
+	, fLoadCancelled(false)
+	, fGitUpdatePending(false)
+	, fBlameUpdatePending(false)
+	, fBlameToolTip(nullptr)
+	, fBlameToolTipShown(false)
 {
 	fStatusView = new editor::StatusView(this);
 	fFileName = BString(ref->name);
@@ -86,7 +112,7 @@ Editor::Editor(entry_ref* ref, const BMessenger& target)
 	LoadEditorConfig();
 
 	// MARGINS
-	SendMessage(SCI_SETMARGINS, 4, UNSET);
+	SendMessage(SCI_SETMARGINS, 6, UNSET);
 
 	//Line number margins.
 	SendMessage(SCI_SETMARGINTYPEN, sci_NUMBER_MARGIN, SC_MARGIN_NUMBER);
@@ -125,6 +151,23 @@ Editor::Editor(entry_ref* ref, const BMessenger& target)
 
 	// Comment margin
 	SendMessage(SCI_SETMARGINSENSITIVEN, sci_COMMENT_MARGIN, 1);
+
+	// Git blame margin
+	SendMessage(SCI_SETMARGINTYPEN, sci_BLAME_MARGIN, SC_MARGIN_TEXT);
+	SendMessage(SCI_SETMARGINWIDTHN, sci_BLAME_MARGIN, 0);
+
+	// Git changes margin, next to the text
+	SendMessage(SCI_SETMARGINTYPEN, sci_GIT_MARGIN, SC_MARGIN_SYMBOL);
+	SendMessage(SCI_SETMARGINMASKN, sci_GIT_MARGIN,
+		(1 << sci_GIT_ADDED) | (1 << sci_GIT_MODIFIED) | (1 << sci_GIT_DELETED));
+	SendMessage(SCI_SETMARGINWIDTHN, sci_GIT_MARGIN, 0);
+	SendMessage(SCI_MARKERDEFINE, sci_GIT_ADDED, SC_MARK_LEFTRECT);
+	SendMessage(SCI_MARKERSETBACK, sci_GIT_ADDED, 0x3CA03C);
+	SendMessage(SCI_MARKERDEFINE, sci_GIT_MODIFIED, SC_MARK_LEFTRECT);
+	SendMessage(SCI_MARKERSETBACK, sci_GIT_MODIFIED, 0xDD8833);
+	SendMessage(SCI_MARKERDEFINE, sci_GIT_DELETED, SC_MARK_ARROW);
+	SendMessage(SCI_MARKERSETFORE, sci_GIT_DELETED, 0x3030D0);
+	SendMessage(SCI_MARKERSETBACK, sci_GIT_DELETED, 0x3030D0);
 	//Wrap visual flag
 	SendMessage(SCI_SETWRAPVISUALFLAGS, SC_WRAPVISUALFLAG_MARGIN);
 
@@ -132,6 +175,10 @@ Editor::Editor(entry_ref* ref, const BMessenger& target)
 
 	// This ensure that a GoToLine call will try to center on screen the line.
 	SendMessage(SCI_SETVISIBLEPOLICY, VISIBLE_STRICT);
+
+	// The Haiku surface can measure text from several threads: long lines
+	// are laid out and wrapped in parallel. Scintilla caps it to the CPUs.
+	SendMessage(SCI_SETLAYOUTTHREADS, 16);
 }
 
 
@@ -151,11 +198,20 @@ Editor::HasLSPCapability(const LSPCapability cap) const
 
 Editor::~Editor()
 {
+	if (IsLoading()) {
+		fLoadCancelled = true;
+		status_t result;
+		wait_for_thread(fLoadThread, &result);
+		delete fLoadFile;
+	}
+	if (fLoader != nullptr)
+		fLoader->Release();
+
 	// Stop monitoring
 	StopMonitoring();
 
-	// Set caret position
-	if (gCFG["save_caret"]) {
+	// Set caret position, unless the file was never read
+	if (fLoaded && gCFG["save_caret"]) {
 		BNode node(&fFileRef);
 		if (node.InitCheck() == B_OK) {
 			int32 pos = GetCurrentPosition();
@@ -166,6 +222,9 @@ Editor::~Editor()
 	fLSPEditorWrapper->UnsetLSPServer();
 	delete fLSPEditorWrapper;
 	fLSPEditorWrapper = NULL;
+
+	if (fBlameToolTip != nullptr)
+		fBlameToolTip->ReleaseReference();
 }
 
 
@@ -179,6 +238,71 @@ Editor::MessageReceived(BMessage* message)
 		case kIdle:
 			fLSPEditorWrapper->flushChanges();
 			break;
+		case kGitDiffUpdate:
+		{
+			fGitUpdatePending = false;
+			int32 first;
+			int32 last;
+			if (fGitDiff != nullptr && fGitDiff->Update(first, last)) {
+				_MarkGitChanges(first - 1, last);
+				_PostBlameUpdate();
+			}
+			break;
+		}
+		case kBlameUpdate:
+			_UpdateBlame();
+			break;
+		case MSG_GIT_JOB_DONE:
+			switch (message->GetInt32("job", -1)) {
+				case Genio::Git::GitWorker::kJobHeadLines:
+					_SetGitBase(message);
+					break;
+				case Genio::Git::GitWorker::kJobBlame:
+					_SetBlame(message);
+					break;
+			}
+			break;
+		case kLoadProgress:
+			fLoadProgress = message->GetInt32("percent", 0);
+			UpdateStatusBar();
+			break;
+		case kLoadDone:
+		{
+			status_t result;
+			wait_for_thread(fLoadThread, &result);
+			fLoadThread = -1;
+			delete fLoadFile;
+			fLoadFile = nullptr;
+
+			std::vector<std::string> edits;
+			edits.swap(fPendingEdits);
+			SendMessage(SCI_SETREADONLY, 0, UNSET);
+			const status_t status = _LoadFinished(message->GetInt32("status", B_ERROR));
+			if (status != B_OK) {
+				// don't let the empty document be saved over the file
+				SendMessage(SCI_SETREADONLY, 1, UNSET);
+				UpdateStatusBar();
+				LogError("Failed loading file %s: %s", fFileName.String(), ::strerror(status));
+				if (!edits.empty()) {
+					BString text(B_TRANSLATE("Can't apply the changes to %file%: the file "
+						"couldn't be loaded."));
+					text.ReplaceFirst("%file%", fFileName.String());
+					OKAlert(B_TRANSLATE("Apply changes"), text.String(), B_STOP_ALERT);
+				}
+				break;
+			}
+			// the settings, the caret and the LSP server went to the
+			// document shown while loading
+			ApplySettings();
+			SetSavedCaretPosition();
+			SetProjectFolder(fProjectFolder);
+			fLSPEditorWrapper->RequestDocumentSymbols();
+			for (const std::string& edit : edits)
+				fLSPEditorWrapper->ApplyEdit(edit);
+			LogInfo("File loaded in background: %s (%" B_PRIdOFF " bytes)",
+				fFileName.String(), fLoadSize);
+			break;
+		}
 		case MSG_REPLACE_ALL:
 		case MSG_REPLACE_NEXT:
 		case MSG_REPLACE_ONE:
@@ -410,7 +534,8 @@ Editor::ApplySettings()
 
 	_HighlightBraces();
 
-	if(gCFG["wrap_lines"]) {
+	// wrapping has to lay out every line of the file
+	if (gCFG["wrap_lines"] && !fLargeFile) {
 		SendMessage(SCI_SETWRAPMODE, SC_WRAP_WORD, 0);
 	} else {
 		SendMessage(SCI_SETWRAPMODE, SC_WRAP_NONE, 0);
@@ -426,8 +551,21 @@ Editor::ApplySettings()
 		SendMessage(SCI_SETMARGINWIDTHN, sci_COMMENT_MARGIN, 0);
 	}
 
+	// Git changes margin
+	SendMessage(SCI_SETMARGINWIDTHN, sci_GIT_MARGIN, bool(gCFG["show_git_changes"]) ? 6 : 0);
+
 	SetZoom(gCFG["editor_zoom"]);
 
+	// Git blame margin: a date and an author
+	int32 blameWidth = 0;
+	if (gCFG["show_git_blame"]) {
+		const float zoom = 1 + ((float)SendMessage(SCI_GETZOOM) / 100.0);
+		blameWidth = SendMessage(SCI_TEXTWIDTH, STYLE_LINENUMBER,
+			(sptr_t)"0000-00-00 Mmmmmmmmmmmmmm") * zoom;
+	}
+	SendMessage(SCI_SETMARGINWIDTHN, sci_BLAME_MARGIN, blameWidth);
+	UpdateGitChanges();
+
 	fLSPEditorWrapper->ApplySettings();
 
 	// custom ContextMenu!
@@ -440,6 +578,11 @@ Editor::ApplySettings()
 void
 Editor::ApplyEdit(const std::string& info)
 {
+	// the document shown while loading is a read-only placeholder
+	if (IsLoading()) {
+		fPendingEdits.push_back(info);
+		return;
+	}
 	fLSPEditorWrapper->ApplyEdit(info);
 }
 
@@ -1052,38 +1195,181 @@ Editor::LoadEditorConfig()
 }
 
 
+// Feeds the file to the loader, which copies each chunk straight into the
+// new document: the file is never held in memory twice.
+static status_t
+ReadIntoLoader(BFile& file, off_t size, Scintilla::ILoader* loader,
+	const std::atomic<bool>* cancelled, const BMessenger* progress)
+{
+	status_t status = file.Lock();
+	if (status != B_OK)
+		return status;
+
+	std::unique_ptr<char[]> chunk(new(std::nothrow) char[kLoadChunkSize]);
+	if (chunk == nullptr)
+		return B_NO_MEMORY;
+
+	off_t total = 0;
+	int32 percent = 0;
+	while (total < size) {
+		if (cancelled != nullptr && *cancelled) {
+			status = B_CANCELED;
+			break;
+		}
+		const ssize_t read = file.Read(chunk.get(), kLoadChunkSize);
+		if (read <= 0) {
+			status = read < 0 ? (status_t)read : B_ERROR;
+			break;
+		}
+		if (loader->AddData(chunk.get(), read) != SC_STATUS_OK) {
+			status = B_NO_MEMORY;
+			break;
+		}
+		total += read;
+		if (progress != nullptr && total * 100 / size > percent) {
+			percent = total * 100 / size;
+			BMessage message(kLoadProgress);
+			message.AddInt32("percent", percent);
+			// the window may be joining this thread: never wait on its port,
+			// a progress update can be lost
+			progress->SendMessage(&message, (BHandler*)nullptr, 0);
+		}
+	}
+	file.Unlock();
+	return status;
+}
+
+
+status_t
+Editor::LoadFromFile()
+{
+	if (IsLoading())
+		return B_BUSY;
+
+	const status_t status = _LoadFromFile();
+	if (status != B_OK) {
+		// the empty document stays in the tab: don't let it be edited
+		// and saved over the file
+		SendMessage(SCI_SETREADONLY, 1, UNSET);
+		UpdateStatusBar();
+	}
+	return status;
+}
+
+
 /*
  * Code (editable) taken from stylededit
  */
 status_t
-Editor::LoadFromFile()
+Editor::_LoadFromFile()
 {
+	fLoadStartTime = system_time();
+	std::unique_ptr<BFile> file(new BFile(&fFileRef, B_READ_ONLY));
 	status_t status;
-	BFile file;
-	if ((status = file.SetTo(&fFileRef, B_READ_ONLY)) != B_OK)
-		return status;
-	if ((status = file.InitCheck()) != B_OK)
-		return status;
-	if ((status = file.Lock()) != B_OK)
+	if ((status = file->InitCheck()) != B_OK)
 		return status;
 	struct stat st;
-	if ((status = file.GetStat(&st)) != B_OK)
+	if ((status = file->GetStat(&st)) != B_OK)
 		return status;
 
 	bool editable = (getuid() == st.st_uid && S_IWUSR & st.st_mode)
 					|| (getgid() == st.st_gid && S_IWGRP & st.st_mode)
 					|| (S_IWOTH & st.st_mode);
 	BVolume volume(fFileRef.device);
-	editable = editable && !volume.IsReadOnly();
+	fLoadEditable = editable && !volume.IsReadOnly();
 
-	off_t size;
-	file.GetSize(&size);
+	fFileType = "";
+	if (!Languages::GetLanguageForExtension(GetFileExtension(fFileName.String()), fFileType)) {
+		BPath path(fFileName.String());
+		if (path.InitCheck() == B_OK) {
+			Languages::GetLanguageForExtension(path.Leaf(), fFileType);
+		}
+	}
 
-	char* buffer = new char[size + 1];
-	off_t len = file.Read(buffer, size);
-	buffer[size] = '\0';
+	fLoadSize = st.st_size;
+	const int options = fLoadSize > INT32_MAX
+		? SC_DOCUMENTOPTION_TEXT_LARGE : SC_DOCUMENTOPTION_DEFAULT;
+	fLoader = reinterpret_cast<Sci::ILoader*>(SendMessage(SCI_CREATELOADER, fLoadSize, options));
+	if (fLoader == nullptr)
+		return B_NO_MEMORY;
+
+	if (fLoadSize < kBackgroundLoadSize)
+		return _LoadFinished(ReadIntoLoader(*file, fLoadSize, fLoader, nullptr, nullptr));
+
+	// the current, empty, document is shown with the progress until
+	// the thread is done
+	fLoadFile = file.release();
+	fLoadProgress = 0;
+	fLoadCancelled = false;
+	fLoadThread = spawn_thread(_LoadThread, "Editor loader", B_LOW_PRIORITY, this);
+	if (fLoadThread < 0 || resume_thread(fLoadThread) != B_OK) {
+		status = fLoadThread < 0 ? fLoadThread : B_ERROR;
+		if (fLoadThread >= 0)
+			kill_thread(fLoadThread);
+		fLoadThread = -1;
+		delete fLoadFile;
+		fLoadFile = nullptr;
+		fLoader->Release();
+		fLoader = nullptr;
+		return status;
+	}
+	SendMessage(SCI_SETREADONLY, 1, UNSET);
+	UpdateStatusBar();
+	return B_OK;
+}
 
-	SendMessage(SCI_SETTEXT, 0, (sptr_t) buffer);
+
+/* static */
+status_t
+Editor::_LoadThread(void* cookie)
+{
+	Editor* editor = static_cast<Editor*>(cookie);
+	BMessenger messenger(editor);
+	const status_t status = ReadIntoLoader(*editor->fLoadFile, editor->fLoadSize,
+		editor->fLoader, &editor->fLoadCancelled, &messenger);
+
+	BMessage done(kLoadDone);
+	done.AddInt32("status", status);
+	// wait for room in the port, unless the editor is being deleted and
+	// joins this thread
+	while (messenger.SendMessage(&done, (BHandler*)nullptr, kLoadSendTimeout) == B_TIMED_OUT
+		&& !editor->fLoadCancelled) {
+	}
+	return status;
+}
+
+
+// Shows the document built by fLoader, or drops it if the load failed
+status_t
+Editor::_LoadFinished(status_t status)
+{
+	if (status != B_OK) {
+		fLoader->Release();
+		fLoader = nullptr;
+		return status;
+	}
+
+	void* document = fLoader->ConvertToDocument();
+	fLoader = nullptr;
+	// the diff was against the text being replaced
+	_ClearGitChanges();
+	SendMessage(SCI_SETDOCPOINTER, 0, (sptr_t)document);
+	// the view holds the only reference now
+	SendMessage(SCI_RELEASEDOCUMENT, 0, (sptr_t)document);
+	const off_t largeFileSize = int32(gCFG["large_file_size"]) * 1024LL * 1024;
+	fLargeFile = SendMessage(SCI_GETLENGTH, UNSET, UNSET) >= largeFileSize;
+	if (fLargeFile)
+		LogInfo("Large file mode for %s", fFileName.String());
+	// the text past the visible area is styled in idle time: all of it,
+	// unless it's a large file
+	SendMessage(SCI_SETIDLESTYLING,
+		fLargeFile ? SC_IDLESTYLING_TOVISIBLE : SC_IDLESTYLING_ALL, UNSET);
+
+	// the loader turned the undo collection off, and the lexer properties
+	// belong to the document. Folding a large file means lexing all of it.
+	SendMessage(SCI_SETUNDOCOLLECTION, 1, UNSET);
+	SendMessage(SCI_SETPROPERTY, (sptr_t) "fold", (sptr_t) (fLargeFile ? "0" : "1"));
+	SendMessage(SCI_SETPROPERTY, (sptr_t) "fold.comment", (sptr_t) "1");
 
 	// Check the first newline only
 	int32 lineLength = SendMessage(SCI_LINELENGTH, 0, UNSET);
@@ -1091,31 +1377,17 @@ Editor::LoadFromFile()
 	SendMessage(SCI_GETLINE, 0, (sptr_t)lineBuffer);
 	_EndOfLineAssign(lineBuffer, lineLength);
 	delete[] lineBuffer;
-	delete[] buffer;
-
-	if (len != size)
-		return B_ERROR;
-
-	if ((status = file.Unlock()) != B_OK)
-		return status;
 
 	SendMessage(SCI_EMPTYUNDOBUFFER, UNSET, UNSET);
 	SendMessage(SCI_SETSAVEPOINT, UNSET, UNSET);
 
-	if (editable == false)
+	if (fLoadEditable == false)
 		SetReadOnly();
 
 	// Monitor node
 	StartMonitoring();
 
-	fFileType = "";
-	if (!Languages::GetLanguageForExtension(GetFileExtension(fFileName.String()), fFileType)) {
-		BPath path(fFileName.String());
-		if (path.InitCheck() == B_OK) {
-			Languages::GetLanguageForExtension(path.Leaf(), fFileType);
-		}
-	}
-
+	fLoaded = true;
 	UpdateStatusBar();
 	return B_OK;
 }
@@ -1166,6 +1438,8 @@ Editor::NotificationReceived(SCNotification* notification)
 		}
 		case SCN_MODIFIED:
 		{
+			if (notification->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
+				fLSPEditorWrapper->InvalidatePositionCache();
 			if (notification->modificationType & SC_MOD_INSERTTEXT) {
 				fLSPEditorWrapper->didChange(notification->text, notification->length, notification->position, 0);
 				EvaluateIdleTime();
@@ -1177,9 +1451,12 @@ Editor::NotificationReceived(SCNotification* notification)
 					fLSPEditorWrapper->CharAdded(0);
 					EvaluateIdleTime();
 			}
-			if (notification->linesAdded != 0)
+			if (notification->linesAdded != 0 && !fLargeFile)
 				if (gCFG["show_linenumber"])
 					_RedrawNumberMargin(false);
+			if (fGitDiff != nullptr
+				&& (notification->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)))
+				_GitLinesChanged(notification->position, notification->linesAdded);
 			break;
 		}
 		case SCN_CALLTIPCLICK:
@@ -1190,12 +1467,16 @@ Editor::NotificationReceived(SCNotification* notification)
 		}
 		case SCN_DWELLSTART:
 		{
-			if (Window()->IsActive())
+			if (Window()->IsActive() && !_ShowBlameToolTip(notification->x, notification->y))
 				fLSPEditorWrapper->StartHover(notification->position);
 			break;
 		}
 		case SCN_DWELLEND:
 		{
+			if (fBlameToolTipShown) {
+				HideToolTip();
+				fBlameToolTipShown = false;
+			}
 			fLSPEditorWrapper->EndHover();
 			break;
 		}
@@ -1204,6 +1485,15 @@ Editor::NotificationReceived(SCNotification* notification)
 			fLSPEditorWrapper->IndicatorClick(notification->position);
 			break;
 		}
+		case SCN_PAINTED:
+		{
+			if (fLoaded && fLoadStartTime >= 0) {
+				LogInfo("First paint of %s (%" B_PRIdOFF " bytes) %.2f ms after load",
+					fFileName.String(), fLoadSize, (system_time() - fLoadStartTime) / 1000.0);
+				fLoadStartTime = -1;
+			}
+			break;
+		}
 		case SCN_SAVEPOINTLEFT:
 		{
 			_UpdateSavePoint(true);
@@ -1222,6 +1512,10 @@ Editor::NotificationReceived(SCNotification* notification)
 				SendMessage(SCI_AUTOCCANCEL, 0, 0);
 				fLSPEditorWrapper->HideCallTip();
 			}
+			if (notification->updated & SC_UPDATE_V_SCROLL) {
+				fLSPEditorWrapper->RequestVisibleCodeActions();
+				_PostBlameUpdate();
+			}
 			_BraceHighlight();
 			// Selection/Position has changed
 			if (notification->updated & SC_UPDATE_SELECTION) {
@@ -1323,6 +1617,339 @@ Editor::_NotifyFindStatus(const char* status)
 }
 
 
+// The lines of the file in HEAD are read and hashed by the GitWorker: the
+// diff against them is done here, as it's kept up to date line by line.
+// The blame needs it too, to know which line of HEAD each line is.
+void
+Editor::UpdateGitChanges()
+{
+	const BString path = _GitPath();
+	if (!fLoaded || fLargeFile || path.IsEmpty()
+		|| (!gCFG["show_git_changes"] && !gCFG["show_git_blame"])) {
+		_ClearGitChanges();
+		return;
+	}
+	fProjectFolder->GetGitWorker()->HeadLines(BMessenger(this), path, fGitBlobId);
+
+	// HEAD may have moved with the file unchanged: the blocks shown are
+	// asked again, the cache answers for the ones which didn't change
+	if (gCFG["show_git_blame"]) {
+		fBlameBlocks.clear();
+		_PostBlameUpdate();
+	} else
+		_ClearBlame();
+}
+
+
+void
+Editor::_SetGitBase(BMessage* message)
+{
+	// the project or the settings may have changed since it was asked
+	if (!fLoaded || (!gCFG["show_git_changes"] && !gCFG["show_git_blame"])
+		|| _GitPath() != message->GetString("path", "")) {
+		return;
+	}
+	if (message->GetInt32("status", B_ERROR) != B_OK) {
+		_ClearGitChanges();
+		return;
+	}
+	if (message->GetBool("unchanged", false)) {
+		// the diff was dropped after it was asked: ask for the lines
+		if (fGitDiff == nullptr)
+			UpdateGitChanges();
+		return;
+	}
+
+	const void* data;
+	ssize_t size;
+	if (message->FindData("lines", B_RAW_TYPE, &data, &size) != B_OK) {
+		_ClearGitChanges();
+		return;
+	}
+	const uint32* base = static_cast<const uint32*>(data);
+	std::vector<uint32> lines;
+	const char* text = reinterpret_cast<const char*>(SendMessage(SCI_GETCHARACTERPOINTER,
+		UNSET, UNSET));
+	Genio::Git::LineDiff::HashLines(text, SendMessage(SCI_GETLENGTH, UNSET, UNSET), lines);
+	// lines ending with a lone CR aren't split the same way
+	if ((int32)lines.size() != CountLines()) {
+		_ClearGitChanges();
+		return;
+	}
+
+	const bigtime_t start = system_time();
+	fGitDiff.reset(new Genio::Git::LineDiff(
+		std::vector<uint32>(base, base + size / sizeof(uint32))));
+	fGitDiff->SetLines(std::move(lines));
+	fGitBlobId = message->GetString("blob_id", "");
+	fGitUpdatePending = false;
+	_MarkGitChanges(0, CountLines());
+	// the blame was of another base
+	_ClearBlame();
+	_PostBlameUpdate();
+	LogInfo("Git changes of %s: %d hunks in %.2f ms", fFileName.String(),
+		(int)fGitDiff->Hunks().size(), (system_time() - start) / 1000.0);
+}
+
+
+// The lines touched by an edit are hashed again at once, the diff waits
+// for the whole batch of edits to be done
+void
+Editor::_GitLinesChanged(Sci_Position position, Sci_Position linesAdded)
+{
+	const int32 first = SendMessage(SCI_LINEFROMPOSITION, position, UNSET);
+	const int32 removed = 1 - std::min(linesAdded, (Sci_Position)0);
+	if (first + removed > fGitDiff->CountLines()) {
+		_ClearGitChanges();
+		return;
+	}
+	std::vector<uint32> added;
+	_HashLines(first, first + 1 + std::max(linesAdded, (Sci_Position)0), added);
+	fGitDiff->Replace(first, removed, added);
+
+	if (!fGitUpdatePending) {
+		fGitUpdatePending = true;
+		Looper()->PostMessage(kGitDiffUpdate, this);
+	}
+}
+
+
+void
+Editor::_HashLines(int32 first, int32 last, std::vector<uint32>& hashes)
+{
+	hashes.clear();
+	for (int32 line = first; line < last; line++) {
+		const Sci_Position start = SendMessage(SCI_POSITIONFROMLINE, line, UNSET);
+		const Sci_Position length = SendMessage(SCI_GETLINEENDPOSITION, line, UNSET) - start;
+		const char* text = reinterpret_cast<const char*>(SendMessage(SCI_GETRANGEPOINTER,
+			start, length));
+		hashes.push_back(Genio::Git::LineDiff::HashLine(text, length));
+	}
+}
+
+
+// Sets the markers of lines [first, last] again. A removal is shown on the
+// line above it.
+void
+Editor::_MarkGitChanges(int32 first, int32 last)
+{
+	first = std::max(first, (int32)0);
+	last = std::min(last, CountLines() - 1);
+	const int32 mask = (1 << sci_GIT_ADDED) | (1 << sci_GIT_MODIFIED) | (1 << sci_GIT_DELETED);
+	for (int32 line = first; line <= last; line++) {
+		// merged lines can hold a marker more than once
+		int32 markers;
+		while (((markers = SendMessage(SCI_MARKERGET, line, UNSET)) & mask) != 0) {
+			for (int32 marker : { sci_GIT_ADDED, sci_GIT_MODIFIED, sci_GIT_DELETED }) {
+				if ((markers & (1 << marker)) != 0)
+					SendMessage(SCI_MARKERDELETE, line, marker);
+			}
+		}
+	}
+
+	for (const Genio::Git::DiffHunk& hunk : fGitDiff->Hunks()) {
+		if (hunk.newStart > last + 1)
+			break;
+		if (hunk.newCount == 0) {
+			const int32 line = std::max(hunk.newStart - 1, (int32)0);
+			if (line >= first && line <= last)
+				SendMessage(SCI_MARKERADD, line, sci_GIT_DELETED);
+			continue;
+		}
+		const int32 marker = hunk.oldCount == 0 ? sci_GIT_ADDED : sci_GIT_MODIFIED;
+		const int32 end = std::min(hunk.newStart + hunk.newCount - 1, last);
+		for (int32 line = std::max(hunk.newStart, first); line <= end; line++)
+			SendMessage(SCI_MARKERADD, line, marker);
+	}
+}
+
+
+void
+Editor::_ClearGitChanges()
+{
+	fGitDiff.reset();
+	fGitBlobId = "";
+	fGitUpdatePending = false;
+	SendMessage(SCI_MARKERDELETEALL, sci_GIT_ADDED, UNSET);
+	SendMessage(SCI_MARKERDELETEALL, sci_GIT_MODIFIED, UNSET);
+	SendMessage(SCI_MARKERDELETEALL, sci_GIT_DELETED, UNSET);
+	_ClearBlame();
+}
+
+
+// The path of the file relative to the repository, empty when it isn't in one
+BString
+Editor::_GitPath() const
+{
+	if (fProjectFolder == nullptr || fProjectFolder->GetGitWorker() == nullptr)
+		return "";
+	const BString projectPath = fProjectFolder->Path();
+	const BString filePath = FilePath();
+	if (!filePath.StartsWith(BString(projectPath) << "/"))
+		return "";
+	return BString(filePath.String() + projectPath.Length() + 1);
+}
+
+
+void
+Editor::_PostBlameUpdate()
+{
+	if (!fBlameUpdatePending && Looper() != nullptr && gCFG["show_git_blame"]) {
+		fBlameUpdatePending = true;
+		Looper()->PostMessage(kBlameUpdate, this);
+	}
+}
+
+
+// Only the lines shown are annotated: the blocks of HEAD lines they are in
+// are blamed by the GitWorker, if they weren't already
+void
+Editor::_UpdateBlame()
+{
+	fBlameUpdatePending = false;
+	const BString path = _GitPath();
+	if (fGitDiff == nullptr || path.IsEmpty() || !gCFG["show_git_blame"])
+		return;
+
+	const int32 firstVisible = SendMessage(SCI_GETFIRSTVISIBLELINE, UNSET, UNSET);
+	const int32 first = SendMessage(SCI_DOCLINEFROMVISIBLE, firstVisible, UNSET);
+	const int32 last = std::min((int32)SendMessage(SCI_DOCLINEFROMVISIBLE,
+		firstVisible + SendMessage(SCI_LINESONSCREEN, UNSET, UNSET), UNSET),
+		CountLines() - 1);
+	std::set<int32> blocks;
+	for (int32 line = first; line <= last; line++) {
+		const int32 baseLine = fGitDiff->BaseLine(line);
+		if (baseLine >= 0) {
+			const int32 block = baseLine / Genio::Git::BlameCache::kBlockLines;
+			if (fBlameBlocks.count(block) == 0)
+				blocks.insert(block);
+		}
+		// setting the same text would draw the margin again
+		const BString text = _BlameText(line, false);
+		const int32 length = SendMessage(SCI_MARGINGETTEXT, line, UNSET);
+		BString current;
+		SendMessage(SCI_MARGINGETTEXT, line, (sptr_t)current.LockBuffer(length + 1));
+		current.UnlockBuffer(length);
+		if (text != current) {
+			SendMessage(SCI_MARGINSETTEXT, line, (sptr_t)text.String());
+			SendMessage(SCI_MARGINSETSTYLE, line, STYLE_LINENUMBER);
+		}
+	}
+
+	if (!blocks.empty()) {
+		fBlameBlocks.insert(blocks.begin(), blocks.end());
+		fProjectFolder->GetGitWorker()->Blame(BMessenger(this), path, blocks);
+	}
+}
+
+
+void
+Editor::_SetBlame(BMessage* message)
+{
+	if (!fLoaded || !gCFG["show_git_blame"] || _GitPath() != message->GetString("path", ""))
+		return;
+	if (message->GetInt32("status", B_ERROR) != B_OK) {
+		// asked again when shown
+		fBlameBlocks.clear();
+		return;
+	}
+	// lines of another base: the blocks are asked again with the new one
+	int32 block;
+	if (fGitDiff == nullptr || fGitBlobId != message->GetString("blob_id", "")) {
+		for (int32 i = 0; message->FindInt32("blocks", i, &block) == B_OK; i++)
+			fBlameBlocks.erase(block);
+		return;
+	}
+
+	const BString headId = message->GetString("head_id", "");
+	if (headId != fBlameHeadId) {
+		fBlame.clear();
+		fBlameBlocks.clear();
+		fBlameHeadId = headId;
+	}
+	for (int32 i = 0; message->FindInt32("blocks", i, &block) == B_OK; i++)
+		fBlameBlocks.insert(block);
+	int32 start;
+	for (int32 i = 0; message->FindInt32("start", i, &start) == B_OK; i++) {
+		fBlame[start] = {
+			message->GetInt32("count", i, 0),
+			message->GetString("commit", i, ""),
+			message->GetString("author", i, ""),
+			message->GetString("summary", i, ""),
+			message->GetInt64("time", i, 0)
+		};
+	}
+	_PostBlameUpdate();
+}
+
+
+void
+Editor::_ClearBlame()
+{
+	fBlame.clear();
+	fBlameBlocks.clear();
+	fBlameHeadId = "";
+	SendMessage(SCI_MARGINTEXTCLEARALL, UNSET, UNSET);
+}
+
+
+// The date and the author for the margin, with the commit and its summary
+// for the tooltip
+BString
+Editor::_BlameText(int32 line, bool details)
+{
+	const int32 baseLine = fGitDiff->BaseLine(line);
+	if (baseLine < 0)
+		return B_TRANSLATE("Not committed yet");
+
+	auto next = fBlame.upper_bound(baseLine);
+	if (next == fBlame.begin())
+		return "";
+	const auto& [start, info] = *std::prev(next);
+	if (baseLine >= start + info.count)
+		return "";
+
+	char date[32];
+	const time_t time = info.time;
+	struct tm local;
+	strftime(date, sizeof(date), details ? "%Y-%m-%d %H:%M" : "%Y-%m-%d",
+		localtime_r(&time, &local));
+	BString text;
+	if (details) {
+		BString commit(info.commitId);
+		commit.Truncate(10);
+		text << commit << "  " << info.author << "  " << date << "\n\n" << info.summary;
+	} else
+		text << date << " " << info.author;
+	return text;
+}
+
+
+bool
+Editor::_ShowBlameToolTip(int32 x, int32 y)
+{
+	if (fGitDiff == nullptr || !gCFG["show_git_blame"])
+		return false;
+	int32 left = 0;
+	for (int32 margin = 0; margin < sci_BLAME_MARGIN; margin++)
+		left += SendMessage(SCI_GETMARGINWIDTHN, margin, UNSET);
+	if (x < left || x >= left + SendMessage(SCI_GETMARGINWIDTHN, sci_BLAME_MARGIN, UNSET))
+		return false;
+
+	const int32 line = SendMessage(SCI_LINEFROMPOSITION,
+		SendMessage(SCI_POSITIONFROMPOINT, x, y), UNSET);
+	const BString text = _BlameText(line, true);
+	if (text.IsEmpty())
+		return false;
+	if (fBlameToolTip == nullptr)
+		fBlameToolTip = new BTextToolTip(text);
+	fBlameToolTip->SetText(text);
+	ShowToolTip(fBlameToolTip);
+	fBlameToolTipShown = true;
+	return true;
+}
+
+
 void
 Editor::OverwriteToggle()
 {
@@ -1489,6 +2116,10 @@ Editor::ReplaceOne(const BString& selection, const BString& replacement)
 status_t
 Editor::SaveToFile()
 {
+	// the document doesn't hold the file yet
+	if (!fLoaded)
+		return B_BUSY;
+
 	BFile file;
 	status_t status = file.SetTo(&fFileRef, B_READ_WRITE | B_ERASE_FILE | B_CREATE_FILE);
 	if (status != B_OK)
@@ -1497,15 +2128,21 @@ Editor::SaveToFile()
 	if ((status = file.Lock()) != B_OK)
 		return status;
 
-	off_t size = SendMessage(SCI_GETLENGTH, UNSET, UNSET);
+	// written straight from Scintilla's buffer, as the two halves around
+	// its gap, so the text isn't copied at all
+	const Sci_Position size = SendMessage(SCI_GETLENGTH, UNSET, UNSET);
+	const Sci_Position gap = SendMessage(SCI_GETGAPPOSITION, UNSET, UNSET);
 	file.Seek(0, SEEK_SET);
-	char* buffer = new char[size + 1];
-
-	SendMessage(SCI_GETTEXT, size + 1, (sptr_t)buffer);
-
-	off_t bytes = file.Write(buffer, size);
+	ssize_t bytes = 0;
+	if (gap > 0) {
+		bytes = file.Write((const char*)SendMessage(SCI_GETRANGEPOINTER, 0, gap), gap);
+	}
+	if (size > gap && bytes == gap) {
+		const ssize_t written = file.Write(
+			(const char*)SendMessage(SCI_GETRANGEPOINTER, gap, size - gap), size - gap);
+		bytes = written < 0 ? written : bytes + written;
+	}
 	file.Flush();
-	delete[] buffer;
 
 	if ((status = file.Unlock()) != B_OK)
 		return status;
@@ -1647,6 +2284,8 @@ Editor::UpdateStatusBar()
 		update.AddString("status", fLSPEditorWrapper->GetFileStatus());
 	update.AddInt32("line", line + 1);
 	update.AddInt32("column", column + 1);
+	if (IsLoading())
+		update.AddInt32("loading", fLoadProgress);
 	update.AddString("overwrite", IsOverwriteString());//EndOfLineString());
 	update.AddString("readOnly", ModeString());
 	update.AddString("eol", _EndOfLineString());
@@ -1897,7 +2536,11 @@ void
 Editor::SetProjectFolder(ProjectFolder* proj)
 {
 	fProjectFolder = proj;
-	if (proj != nullptr) {
+	// the LSP server depends on the file type: it's set once the file is read
+	if (!fLoaded)
+		return;
+	// a large file would be sent whole at each change
+	if (proj != nullptr && !fLargeFile) {
 		LSPProjectWrapper* lspProject = proj->GetLSPServer(fFileType.c_str());
 		if (lspProject != nullptr)
 			fLSPEditorWrapper->SetLSPServer(lspProject);
@@ -1907,6 +2550,7 @@ Editor::SetProjectFolder(ProjectFolder* proj)
 		fLSPEditorWrapper->UnsetLSPServer();
 
 	SetProblems();
+	UpdateGitChanges();
 }
 
 
@@ -1947,7 +2591,7 @@ Editor::_ApplyExtensionSettings()
 		Styler::ApplyLanguage(this, styles);
 	}
 
-	fBracingAvailable = gCFG["brace_match"];
+	fBracingAvailable = gCFG["brace_match"] && !fLargeFile;
 }
 
 
@@ -2208,6 +2852,9 @@ Editor::_RedrawNumberMargin(bool forced)
 
 	int linesLog10 = log10(SendMessage(SCI_GETLINECOUNT, UNSET, UNSET));
 	linesLog10 += 2;
+	// large files aren't measured at each new line: leave room to grow
+	if (fLargeFile)
+		linesLog10++;
 
 	if (linesLog10 != fLinesLog10 || forced) {
 		fLinesLog10 = linesLog10;
@@ -2305,6 +2952,8 @@ Editor::SetCommentBlockTokens(const std::string& startBlock, const std::string&
 void
 Editor::EvaluateIdleTime()
 {
+	// pending LSP changes are sent once the user stops typing for this long
+	const bigtime_t kIdleTimeout = int32(gCFG["lsp_change_debounce"]) * 1000;
 	if (fIdleHandler == nullptr || fIdleHandler->SetInterval(kIdleTimeout) != B_OK) {
 		LogInfo("EvaluateIdleTime: Re-arming IdleHandler...");
 		delete fIdleHandler;
@@ -10,17 +10,31 @@
 #include <Messenger.h>
 #include <MessageRunner.h>
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "EditorId.h"
 #include "LSPCapabilities.h"
 #include "ScintillaView.h"
 
+class BFile;
+class BTextToolTip;
 class LSPEditorWrapper;
 class ProjectFolder;
 
+namespace Genio::Git {
+	class LineDiff;
+}
+
+namespace Scintilla {
+	class ILoader;
+}
+
 namespace editor {
 	class StatusView;
 }
@@ -56,8 +70,13 @@ constexpr auto sci_NUMBER_MARGIN = 0;
 constexpr auto sci_BOOKMARK_MARGIN = 1;
 constexpr auto sci_FOLD_MARGIN = 2;
 constexpr auto sci_COMMENT_MARGIN = 3;
+constexpr auto sci_BLAME_MARGIN = 4;
+constexpr auto sci_GIT_MARGIN = 5;
 
 constexpr auto sci_BOOKMARK = 0; //Marker
+constexpr auto sci_GIT_ADDED = 1; //Marker
+constexpr auto sci_GIT_MODIFIED = 2; //Marker
+constexpr auto sci_GIT_DELETED = 3; //Marker
 
 struct EditorConfig {
 	enum IndentStyle	IndentStyle;
@@ -121,6 +140,7 @@ public:
 			//
 			void				LoadEditorConfig();
 			void				ApplySettings();
+			// deferred until the end of a background load
 			void				ApplyEdit(const std::string& info);
 			void				TrimTrailingWhitespace();
 
@@ -129,6 +149,12 @@ public:
 
 			bool				IsFoldingAvailable() const { return fFoldingAvailable; }
 			bool				IsModified() const { return fModified; }
+			// false for the tabs restored at startup and not shown yet
+			bool				IsLoaded() const { return fLoaded; }
+			// a big file being read in the background
+			bool				IsLoading() const { return fLoadThread >= 0; }
+			// above "large_file_size": no folding, brace matching, wrapping or LSP
+			bool				IsLargeFile() const { return fLargeFile; }
 			bool				IsTextSelected();
 			bool				IsOverwrite();
 			bool				IsReadOnly();
@@ -138,6 +164,9 @@ public:
 
 
 			void				SetProblems();
+			// asks again for the file in HEAD, which may have moved, and
+			// for its blame
+			void				UpdateGitChanges();
 
 			void				SetDocumentSymbols(const BMessage* symbols, Editor::symbols_status status);
 			void				GetDocumentSymbols(BMessage* symbols) const;
@@ -240,11 +269,26 @@ private:
 			bool				_BraceMatch(int pos);
 			void				_CommentLine(int32 position);
 			void				_EndOfLineAssign(char *buffer, int32 size);
+			status_t			_LoadFromFile();
+			status_t			_LoadFinished(status_t status);
+	static	status_t			_LoadThread(void* cookie);
 			void				_HighlightBraces();
 			void				_RedrawNumberMargin(bool forced = false);
 			void				_SetFoldMargin(bool enabled);
 			void				_UpdateSavePoint(bool modified);
 			void				_NotifyFindStatus(const char* status);
+			void				_SetGitBase(BMessage* message);
+			void				_GitLinesChanged(Sci_Position position, Sci_Position linesAdded);
+			void				_HashLines(int32 first, int32 last, std::vector<uint32>& hashes);
+			void				_MarkGitChanges(int32 first, int32 last);
+			void				_ClearGitChanges();
+			BString				_GitPath() const;
+			void				_PostBlameUpdate();
+			void				_UpdateBlame();
+			void				_SetBlame(BMessage* message);
+			void				_ClearBlame();
+			BString				_BlameText(int32 line, bool details);
+			bool				_ShowBlameToolTip(int32 x, int32 y);
 
 			template<typename T>
 			typename T::type	Get() { return T::Get(this); }
@@ -257,6 +301,8 @@ private:
 			editor_id			fId;
 			entry_ref			fFileRef;
 			bool				fModified;
+			bool				fLoaded;
+			bool				fLargeFile;
 			BString				fFileName;
 			node_ref			fNodeRef;
 			BMessenger			fTarget;
@@ -283,6 +329,38 @@ private:
 
 			BMessageRunner*		fIdleHandler;
 
+			// LoadFromFile() builds a new document out of the file chunks
+			Scintilla::ILoader*	fLoader;
+			thread_id			fLoadThread;
+			BFile*				fLoadFile;
+			off_t				fLoadSize;
+			int32				fLoadProgress;
+			bool				fLoadEditable;
+			bigtime_t			fLoadStartTime;	// logged at the first paint
+			std::atomic<bool>	fLoadCancelled;
+			std::vector<std::string>	fPendingEdits;	// received while loading
+
+			// the lines changed since HEAD, shown in the git margin
+			std::unique_ptr<Genio::Git::LineDiff> fGitDiff;
+			BString				fGitBlobId;
+			bool				fGitUpdatePending;
+
+			// who last changed the lines of HEAD, by first line
+			struct BlameInfo {
+				int32			count;
+				BString			commitId;
+				BString			author;
+				BString			summary;
+				int64			time;
+			};
+			std::map<int32, BlameInfo> fBlame;
+			// the blocks blamed, or asked for, at fBlameHeadId
+			std::set<int32>		fBlameBlocks;
+			BString				fBlameHeadId;
+			bool				fBlameUpdatePending;
+			BTextToolTip*		fBlameToolTip;
+			bool				fBlameToolTipShown;
+
 			Sci_Position		fLastWordStartPosition = -1;
 			Sci_Position		fLastWordEndPosition = -1;
 };
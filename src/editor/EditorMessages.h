@@ -11,7 +11,11 @@ enum {
 	kClassOutline		= 'ClsO',
 	kCallTipClick		= 'Ctck',
 	kIdle				= 'IDLE',
-	kCheckEntryRemoved  = 'ENRE'
+	kCheckEntryRemoved  = 'ENRE',
+	kLoadProgress		= 'ELpr',
+	kLoadDone			= 'ELdn',
+	kGitDiffUpdate		= 'EGdu',
+	kBlameUpdate		= 'EGbu'
 };
 
 
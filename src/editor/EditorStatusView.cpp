@@ -238,8 +238,10 @@ StatusView::Width()
 void
 StatusView::SetStatus(BMessage* message)
 {
-	int32 line = 0, column = 0;
-	if (message->FindInt32("line", &line) == B_OK
+	int32 line = 0, column = 0, loading = 0;
+	if (message->FindInt32("loading", &loading) == B_OK) {
+		fCellText[kPositionCell].SetToFormat(B_TRANSLATE("Loading %" B_PRIi32 "%%"), loading);
+	} else if (message->FindInt32("line", &line) == B_OK
 		&& message->FindInt32("column", &column) == B_OK) {
 		fCellText[kPositionCell].SetToFormat("%" B_PRIi32 ":%" B_PRIi32, line, column);
 	}
@@ -54,10 +54,11 @@ EditorTabView::~EditorTabView()
 
 
 void
-EditorTabView::AddEditor(const char* label, Editor* editor, BMessage* info)
+EditorTabView::AddEditor(const char* label, Editor* editor, BMessage* info, int32 index)
 {
 	// by default the new editor is placed next to the selected one.
-	int32 index = SelectedTabIndex() + 1;
+	if (index < 0)
+		index = SelectedTabIndex() + 1;
 	GTabEditor*	tab = new GTabEditor(label, this, editor);
 	AddTab(tab, editor, index);
 
@@ -29,7 +29,9 @@ public:
 			 EditorTabView(BMessenger target);
 			~EditorTabView();
 
-	void	AddEditor(const char* label, Editor* editor, BMessage* info = nullptr);
+	// index -1 places the editor next to the selected one
+	void	AddEditor(const char* label, Editor* editor, BMessage* info = nullptr,
+				int32 index = -1);
 
 	Editor* SelectedEditor() const;
 
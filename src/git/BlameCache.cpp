@@ -0,0 +1,231 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "BlameCache.h"
+
+#include <Directory.h>
+#include <Entry.h>
+#include <FindDirectory.h>
+#include <Path.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <string>
+
+#include "Log.h"
+
+
+static constexpr uint32 kBlameMagic = 'GBLM';
+static constexpr uint32 kBlameVersion = 1;
+// files kept in memory by each repository
+static const size_t kMaxCachedFiles = 32;
+// files on disk not written for this long are removed
+static const time_t kMaxCacheAge = 30 * 24 * 60 * 60;
+
+
+template<typename T>
+static void
+WriteValue(std::ofstream& stream, const T& value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+template<typename T>
+static bool
+ReadValue(std::ifstream& stream, T& value)
+{
+	return (bool)stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+
+static void
+WriteString(std::ofstream& stream, const BString& string)
+{
+	WriteValue<uint32>(stream, string.Length());
+	stream.write(string.String(), string.Length());
+}
+
+
+static bool
+ReadString(std::ifstream& stream, BString& string)
+{
+	uint32 length;
+	// commit summaries can be long, but not this long
+	if (!ReadValue(stream, length) || length > 64 * 1024)
+		return false;
+	std::string buffer(length, '\0');
+	if (!stream.read(buffer.data(), length))
+		return false;
+	string.SetTo(buffer.data(), length);
+	return true;
+}
+
+
+namespace Genio::Git {
+
+	BlameCache::BlameCache(const BString& repositoryPath)
+		:
+		fRepositoryPath(repositoryPath)
+	{
+	}
+
+	bool
+	BlameCache::Get(const BString& path, const BString& commitId, int32 block,
+		GitRepository::BlameHunks& hunks)
+	{
+		const Entry& entry = _Find(path, commitId);
+		auto found = entry.blocks.find(block);
+		if (found == entry.blocks.end())
+			return false;
+		hunks = found->second;
+		return true;
+	}
+
+	void
+	BlameCache::Put(const BString& path, const BString& commitId, int32 block,
+		const GitRepository::BlameHunks& hunks)
+	{
+		Entry& entry = _Find(path, commitId);
+		entry.blocks[block] = hunks;
+		_Save(entry);
+	}
+
+	/* static */
+	void
+	BlameCache::_Prune(const BString& directory)
+	{
+		BDirectory folder(directory.String());
+		const time_t now = time(nullptr);
+		int32 removed = 0;
+		BEntry file;
+		while (folder.GetNextEntry(&file) == B_OK) {
+			time_t modified;
+			if (file.GetModificationTime(&modified) == B_OK
+				&& now - modified > kMaxCacheAge && file.Remove() == B_OK)
+				removed++;
+		}
+		if (removed > 0)
+			LogInfo("BlameCache: %d old files removed", (int)removed);
+	}
+
+	BlameCache::Entry&
+	BlameCache::_Find(const BString& path, const BString& commitId)
+	{
+		for (auto entry = fEntries.begin(); entry != fEntries.end(); entry++) {
+			if (entry->path == path && entry->commitId == commitId) {
+				fEntries.splice(fEntries.begin(), fEntries, entry);
+				return fEntries.front();
+			}
+		}
+		if (fEntries.size() >= kMaxCachedFiles)
+			fEntries.pop_back();
+		fEntries.push_front({ path, commitId, {} });
+		_Load(fEntries.front());
+		return fEntries.front();
+	}
+
+	void
+	BlameCache::_Load(Entry& entry) const
+	{
+		std::ifstream stream(_CachePath(entry).String(), std::ios::binary);
+		if (!stream.is_open())
+			return;
+
+		uint32 magic, version, blockCount;
+		BString repositoryPath, path, commitId;
+		if (!ReadValue(stream, magic) || magic != kBlameMagic
+			|| !ReadValue(stream, version) || version != kBlameVersion
+			|| !ReadString(stream, repositoryPath) || repositoryPath != fRepositoryPath
+			|| !ReadString(stream, path) || path != entry.path
+			|| !ReadString(stream, commitId) || commitId != entry.commitId
+			|| !ReadValue(stream, blockCount))
+			return;
+
+		std::map<int32, GitRepository::BlameHunks> blocks;
+		for (uint32 i = 0; i < blockCount; i++) {
+			int32 block;
+			uint32 hunkCount;
+			if (!ReadValue(stream, block) || !ReadValue(stream, hunkCount))
+				return;
+			GitRepository::BlameHunks& hunks = blocks[block];
+			hunks.resize(hunkCount);
+			for (GitRepository::BlameHunk& hunk : hunks) {
+				if (!ReadValue(stream, hunk.start) || !ReadValue(stream, hunk.count)
+					|| !ReadString(stream, hunk.commitId) || !ReadString(stream, hunk.author)
+					|| !ReadString(stream, hunk.summary) || !ReadValue(stream, hunk.time))
+					return;
+			}
+		}
+		entry.blocks.swap(blocks);
+	}
+
+	// The whole file is written again: it holds the few blocks shown of
+	// one file
+	void
+	BlameCache::_Save(const Entry& entry) const
+	{
+		const BString path = _CachePath(entry);
+		if (path.IsEmpty())
+			return;
+		BString temporary(path);
+		temporary << ".tmp";
+		std::ofstream stream(temporary.String(), std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+			return;
+
+		WriteValue(stream, kBlameMagic);
+		WriteValue(stream, kBlameVersion);
+		WriteString(stream, fRepositoryPath);
+		WriteString(stream, entry.path);
+		WriteString(stream, entry.commitId);
+		WriteValue<uint32>(stream, entry.blocks.size());
+		for (const auto& [block, hunks] : entry.blocks) {
+			WriteValue(stream, block);
+			WriteValue<uint32>(stream, hunks.size());
+			for (const GitRepository::BlameHunk& hunk : hunks) {
+				WriteValue(stream, hunk.start);
+				WriteValue(stream, hunk.count);
+				WriteString(stream, hunk.commitId);
+				WriteString(stream, hunk.author);
+				WriteString(stream, hunk.summary);
+				WriteValue(stream, hunk.time);
+			}
+		}
+		stream.close();
+		if (!stream || rename(temporary.String(), path.String()) != 0) {
+			LogError("BlameCache: can't save %s", path.String());
+			unlink(temporary.String());
+		}
+	}
+
+	BString
+	BlameCache::_CachePath(const Entry& entry) const
+	{
+		BPath path;
+		if (find_directory(B_USER_CACHE_DIRECTORY, &path, true) != B_OK)
+			return "";
+		path.Append("Genio/blame");
+		if (create_directory(path.Path(), 0755) != B_OK)
+			return "";
+
+		// once per session, by the first repository getting here
+		static std::atomic<bool> sPruned(false);
+		if (!sPruned.exchange(true))
+			_Prune(path.Path());
+
+		BString key(fRepositoryPath);
+		key << "\n" << entry.path << "\n" << entry.commitId;
+		char name[32];
+		snprintf(name, sizeof(name), "%016zx.blame", std::hash<std::string>()(key.String()));
+		path.Append(name);
+		return path.Path();
+	}
+}
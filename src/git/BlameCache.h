@@ -0,0 +1,53 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#pragma once
+
+
+#include <list>
+#include <map>
+
+#include <String.h>
+
+#include "GitRepository.h"
+
+
+namespace Genio::Git {
+
+	// The blame of files, by block of kBlockLines lines of the file as it is
+	// in a commit: it never changes, so it is kept in memory for the last
+	// files asked and on disk for the next sessions. Only used by the
+	// GitWorker thread.
+
+	class BlameCache {
+	public:
+		static const int32				kBlockLines = 256;
+
+										BlameCache(const BString& repositoryPath);
+
+		bool							Get(const BString& path, const BString& commitId,
+											int32 block, GitRepository::BlameHunks& hunks);
+		void							Put(const BString& path, const BString& commitId,
+											int32 block, const GitRepository::BlameHunks& hunks);
+
+	private:
+		struct Entry {
+			BString						path;
+			BString						commitId;
+			std::map<int32, GitRepository::BlameHunks> blocks;
+		};
+
+		static	void					_Prune(const BString& directory);
+
+		Entry&							_Find(const BString& path, const BString& commitId);
+		void							_Load(Entry& entry) const;
+		void							_Save(const Entry& entry) const;
+		BString							_CachePath(const Entry& entry) const;
+
+		BString							fRepositoryPath;
+		// the last used first
+		std::list<Entry>				fEntries;
+	};
+}
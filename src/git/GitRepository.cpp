@@ -14,6 +14,9 @@
 #include <Catalog.h>
 #include <FindDirectory.h>
 #include <Path.h>
+#include <sys/stat.h>
+
+#include <map>
 
 #include "GitCredentialsWindow.h"
 #include "NoticeMessages.h"
@@ -155,7 +158,7 @@ namespace Genio::Git {
 	}
 
 	int
-	GitRepository::SwitchBranch(const BString name)
+	GitRepository::SwitchBranch(const BString name, const ProgressCallbacks* callbacks)
 	{
 		git_object* tree = nullptr;
 		git_reference* ref = nullptr;
@@ -169,6 +172,11 @@ namespace Genio::Git {
 			opts.checkout_strategy = GIT_CHECKOUT_SAFE;
 			opts.notify_cb = checkout_notify;
 			opts.notify_payload = &files;
+			// a checkout is never stopped halfway
+			if (callbacks != nullptr) {
+				opts.progress_cb = callbacks->checkout;
+				opts.progress_payload = callbacks->payload;
+			}
 
 			check(git_revparse_single(&tree, fRepository, branchName.String()));
 
@@ -323,51 +331,145 @@ namespace Genio::Git {
 		}
 	}
 
-	GitRepository::RepoFiles
-	GitRepository::GetFiles() const
+	GitRepository::StatusEntries
+	GitRepository::GetStatus(const std::vector<BString>& paths) const
 	{
+		// untracked and ignored folders aren't walked: they are reported
+		// once, and so are submodules, which can be expensive to check
 		git_status_options statusopt;
 		git_status_init_options(&statusopt, GIT_STATUS_OPTIONS_VERSION);
 		statusopt.show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR;
-		statusopt.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_RENAMES_HEAD_TO_INDEX | GIT_STATUS_OPT_SORT_CASE_SENSITIVELY;
+		statusopt.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_INCLUDE_IGNORED
+			| GIT_STATUS_OPT_EXCLUDE_SUBMODULES | GIT_STATUS_OPT_SORT_CASE_SENSITIVELY;
+
+		// the paths are taken literally, and libgit2 only walks the part
+		// of the tree they have in common
+		std::vector<const char*> pathspecs;
+		for (const BString& path : paths)
+			pathspecs.push_back(path.String());
+		if (!pathspecs.empty()) {
+			statusopt.flags |= GIT_STATUS_OPT_DISABLE_PATHSPEC_MATCH;
+			statusopt.pathspec.strings = const_cast<char**>(pathspecs.data());
+			statusopt.pathspec.count = pathspecs.size();
+		}
+
 		git_status_list *status = nullptr;
 		check(git_status_list_new(&status, fRepository, &statusopt));
 
-		RepoFiles fileStatuses;
-		size_t maxi = git_status_list_entrycount(status);
-		for (size_t i = 0; i < maxi; ++i) {
+		StatusEntries entries;
+		const size_t count = git_status_list_entrycount(status);
+		entries.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
 			const git_status_entry *s = git_status_byindex(status, i);
-
 			if (s->status == GIT_STATUS_CURRENT)
 				continue;
+			const git_diff_delta* delta = s->index_to_workdir != nullptr
+				? s->index_to_workdir : s->head_to_index;
+			if (delta == nullptr)
+				continue;
+			entries.emplace_back(delta->new_file.path, s->status);
+		}
 
-			BString filePath = s->index_to_workdir->old_file.path;
-			BString fileStatus;
-
-			if (s->status & GIT_STATUS_WT_NEW)
-				fileStatus = B_TRANSLATE("New file");
-
-			else if (s->status & GIT_STATUS_INDEX_NEW)
-				fileStatus = B_TRANSLATE("New file staged");
-
-			else if (s->status & GIT_STATUS_WT_MODIFIED)
-				fileStatus = B_TRANSLATE("File modified");
+		git_status_list_free(status);
 
-			else if (s->status & GIT_STATUS_INDEX_MODIFIED)
-				fileStatus = B_TRANSLATE("File modified on index");
+		return entries;
+	}
 
-			else if (s->status & GIT_STATUS_WT_DELETED)
-				fileStatus = B_TRANSLATE("File deleted");
+	BString
+	GitRepository::StatusStamp() const
+	{
+		BString stamp;
+		BPath index(git_repository_path(fRepository));
+		index.Append("index");
+		struct stat st;
+		if (stat(index.Path(), &st) == 0)
+			stamp << (int64)st.st_mtim.tv_sec << "." << (int64)st.st_mtim.tv_nsec;
 
-			else if (s->status & GIT_STATUS_INDEX_DELETED)
-				fileStatus = B_TRANSLATE("File deleted from index");
+		const BString head = HeadCommitId();
+		if (!head.IsEmpty())
+			stamp << ":" << head;
+		return stamp;
+	}
 
-			fileStatuses.emplace_back(filePath, fileStatus);
+	bool
+	GitRepository::GetHeadBlob(const BString& path, BString& blobId, BString& content) const
+	{
+		BString spec("HEAD:");
+		spec << path;
+		git_object* object = nullptr;
+		const int status = git_revparse_single(&object, fRepository, spec.String());
+		if (status == GIT_ENOTFOUND || status == GIT_EUNBORNBRANCH)
+			return false;
+		check(status);
+
+		bool found = false;
+		if (git_object_type(object) == GIT_OBJECT_BLOB) {
+			const git_blob* blob = reinterpret_cast<const git_blob*>(object);
+			if (!git_blob_is_binary(blob)) {
+				char id[GIT_OID_HEXSZ + 1];
+				git_oid_tostr(id, sizeof(id), git_object_id(object));
+				blobId = id;
+				content.SetTo(static_cast<const char*>(git_blob_rawcontent(blob)),
+					git_blob_rawsize(blob));
+				found = true;
+			}
 		}
+		git_object_free(object);
+		return found;
+	}
 
-		git_status_list_free(status);
-
-		return fileStatuses;
+	BString
+	GitRepository::HeadCommitId() const
+	{
+		git_oid head;
+		if (git_reference_name_to_id(&head, fRepository, "HEAD") != 0)
+			return "";
+		char id[GIT_OID_HEXSZ + 1];
+		git_oid_tostr(id, sizeof(id), &head);
+		return id;
+	}
+
+	GitRepository::BlameHunks
+	GitRepository::Blame(const BString& path, const BString& commitId, int32 first,
+		int32 last) const
+	{
+		git_blame_options options;
+		check(git_blame_options_init(&options, GIT_BLAME_OPTIONS_VERSION));
+		check(git_oid_fromstr(&options.newest_commit, commitId.String()));
+		options.min_line = first + 1;
+		options.max_line = last + 1;
+		git_blame* blame = nullptr;
+		check(git_blame_file(&blame, fRepository, path.String(), &options));
+
+		// the hunks of a commit share its summary
+		std::map<BString, BString> summaries;
+		BlameHunks hunks;
+		const uint32 count = git_blame_get_hunk_count(blame);
+		for (uint32 i = 0; i < count; i++) {
+			const git_blame_hunk* hunk = git_blame_get_hunk_byindex(blame, i);
+			char id[GIT_OID_HEXSZ + 1];
+			git_oid_tostr(id, sizeof(id), &hunk->final_commit_id);
+			BlameHunk entry = { (int32)hunk->final_start_line_number - 1,
+				(int32)hunk->lines_in_hunk, id, "", "", 0 };
+			if (hunk->final_signature != nullptr) {
+				entry.author = hunk->final_signature->name;
+				entry.time = hunk->final_signature->when.time;
+			}
+			auto summary = summaries.find(entry.commitId);
+			if (summary == summaries.end()) {
+				BString text;
+				git_commit* commit = nullptr;
+				if (git_commit_lookup(&commit, fRepository, &hunk->final_commit_id) == 0) {
+					text = git_commit_summary(commit);
+					git_commit_free(commit);
+				}
+				summary = summaries.emplace(entry.commitId, text).first;
+			}
+			entry.summary = summary->second;
+			hunks.push_back(entry);
+		}
+		git_blame_free(blame);
+		return hunks;
 	}
 
 	/* static */
@@ -404,11 +506,33 @@ namespace Genio::Git {
 	}
 
 	void
-	GitRepository::Fetch(bool prune)
+	GitRepository::Fetch(bool prune, const ProgressCallbacks* callbacks)
 	{
 		git_remote* remote = nullptr;
 		git_fetch_options fetch_opts = GIT_FETCH_OPTIONS_INIT;
 		fetch_opts.callbacks.credentials = GitCredentialsWindow::authentication_callback;
+		if (callbacks != nullptr) {
+			// the remote callbacks share the payload: a non zero return
+			// from any of them stops the transfer
+			fetch_opts.callbacks.transfer_progress
+				= [](const git_indexer_progress* stats, void* payload) -> int {
+					const ProgressCallbacks* callbacks
+						= reinterpret_cast<const ProgressCallbacks*>(payload);
+					if (callbacks->cancelled != nullptr && callbacks->cancelled(callbacks->payload))
+						return GIT_EUSER;
+					if (callbacks->transfer != nullptr)
+						return callbacks->transfer(stats, callbacks->payload);
+					return 0;
+				};
+			fetch_opts.callbacks.sideband_progress = [](const char*, int, void* payload) -> int {
+				const ProgressCallbacks* callbacks
+					= reinterpret_cast<const ProgressCallbacks*>(payload);
+				if (callbacks->cancelled != nullptr && callbacks->cancelled(callbacks->payload))
+					return GIT_EUSER;
+				return 0;
+			};
+			fetch_opts.callbacks.payload = const_cast<ProgressCallbacks*>(callbacks);
+		}
 		if (prune)
 			fetch_opts.prune = GIT_FETCH_PRUNE;
 		else
@@ -585,17 +709,22 @@ namespace Genio::Git {
 		std::function<void(void)> execute_on_fail,
 		std::function<bool(const int)> checker)
 	{
+		// a callback which stopped an operation may leave no error behind
+		auto message = []() -> BString {
+			const git_error* error = git_error_last();
+			return error != nullptr ? error->message : "";
+		};
 		if (checker != nullptr) {
 			if (checker(status)) {
 				if (execute_on_fail != nullptr)
 					execute_on_fail();
-				throw GitException(status, git_error_last()->message);
+				throw GitException(status, message());
 			}
 		} else {
 			if (status < 0) {
 				if (execute_on_fail != nullptr)
 					execute_on_fail();
-				throw GitException(status, git_error_last()->message);
+				throw GitException(status, message());
 			}
 		}
 		return status;
@@ -621,17 +750,43 @@ namespace Genio::Git {
 		// TODO: Also catch generic exception
 	}
 
+	int
+	stash_apply_progress(git_stash_apply_progress_t progress, void* payload)
+	{
+		const GitRepository::ProgressCallbacks* callbacks
+			= reinterpret_cast<const GitRepository::ProgressCallbacks*>(payload);
+		// once the checkout started the stash is applied to the end
+		if (progress >= GIT_STASH_APPLY_PROGRESS_CHECKOUT_UNTRACKED
+			|| callbacks->cancelled == nullptr)
+			return 0;
+		return callbacks->cancelled(callbacks->payload) ? GIT_EUSER : 0;
+	}
+
+	void
+	init_stash_apply_options(git_stash_apply_options& opts,
+		const GitRepository::ProgressCallbacks* callbacks)
+	{
+		if (callbacks == nullptr)
+			return;
+		opts.progress_cb = stash_apply_progress;
+		opts.progress_payload = const_cast<GitRepository::ProgressCallbacks*>(callbacks);
+		opts.checkout_options.progress_cb = callbacks->checkout;
+		opts.checkout_options.progress_payload = callbacks->payload;
+	}
+
 	void
-	GitRepository::StashPop()
+	GitRepository::StashPop(const ProgressCallbacks* callbacks)
 	{
 		git_stash_apply_options opts = GIT_STASH_APPLY_OPTIONS_INIT;
+		init_stash_apply_options(opts, callbacks);
 		check(git_stash_pop(fRepository, 0, &opts));
 	}
 
 	void
-	GitRepository::StashApply()
+	GitRepository::StashApply(const ProgressCallbacks* callbacks)
 	{
 		git_stash_apply_options opts = GIT_STASH_APPLY_OPTIONS_INIT;
+		init_stash_apply_options(opts, callbacks);
 		check(git_stash_apply(fRepository, 0, &opts));
 	}
 
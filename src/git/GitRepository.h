@@ -72,7 +72,32 @@ namespace Genio::Git {
 
 	class GitRepository {
 	public:
-		typedef std::vector<std::pair<BString, BString>> RepoFiles;
+		// paths relative to the working directory, with their git_status_t
+		// flags; untracked and ignored folders end with a slash
+		typedef std::vector<std::pair<BString, uint32>> StatusEntries;
+
+		// lines [start, start + count) of a file, from 0, last changed by
+		// a commit
+		struct BlameHunk {
+			int32						start;
+			int32						count;
+			BString						commitId;
+			BString						author;
+			BString						summary;
+			int64						time;
+		};
+		typedef std::vector<BlameHunk>	BlameHunks;
+
+		// Progress and cancellation of the operations which can take long.
+		// The callbacks run on the thread doing the operation; cancelled()
+		// is asked between the steps which can be stopped without leaving
+		// the working tree half updated.
+		struct ProgressCallbacks {
+			git_indexer_progress_cb		transfer = nullptr;
+			git_checkout_progress_cb	checkout = nullptr;
+			bool						(*cancelled)(void* payload) = nullptr;
+			void*						payload = nullptr;
+		};
 
 		// Payload to search for merge branch.
 		struct fetch_payload {
@@ -94,7 +119,8 @@ namespace Genio::Git {
 		std::vector<BString>			GetTags(size_t maxTags = MAX_ELEMENTS) const;
 
 		std::vector<BString>			GetBranches(git_branch_t type = GIT_BRANCH_LOCAL, size_t maxBranches = MAX_ELEMENTS) const;
-		int								SwitchBranch(const BString branch);
+		int								SwitchBranch(const BString branch,
+											const ProgressCallbacks* callbacks = nullptr);
 		BString							GetCurrentBranch() const;
 		void							DeleteBranch(const BString branch, git_branch_t type);
 		void							RenameBranch(const BString oldName, const BString newName,
@@ -102,7 +128,8 @@ namespace Genio::Git {
 		void							CreateBranch(const BString existingBranchName,
 											git_branch_t type, const BString newBranchName);
 
-		void							Fetch(bool prune = false);
+		void							Fetch(bool prune = false,
+											const ProgressCallbacks* callbacks = nullptr);
 		void							Merge(const BString source, const BString dest);
 		PullResult						Pull(const BString branchName);
 		void 							PullRebase();
@@ -111,10 +138,26 @@ namespace Genio::Git {
 		git_signature*					_GetSignature() const;
 
 		void 							StashSave(const BString message);
-		void 							StashPop();
-		void 							StashApply();
-
-		RepoFiles						GetFiles() const;
+		void 							StashPop(const ProgressCallbacks* callbacks = nullptr);
+		void 							StashApply(const ProgressCallbacks* callbacks = nullptr);
+
+		// the status of the files below the paths, of all of them when
+		// paths is empty; files which didn't change are left out
+		StatusEntries					GetStatus(const std::vector<BString>& paths = {}) const;
+		// changes when the index or HEAD do, which can change the status
+		// of any file
+		BString							StatusStamp() const;
+		// the content of a file, relative to the working directory, in the
+		// HEAD commit: false when it isn't there or isn't text
+		bool							GetHeadBlob(const BString& path, BString& blobId,
+											BString& content) const;
+		// empty on an unborn branch
+		BString							HeadCommitId() const;
+		// who changed lines [first, last], from 0, of the file as it is in
+		// the commit. Git follows the history only as far as those lines
+		// need.
+		BlameHunks						Blame(const BString& path, const BString& commitId,
+											int32 first, int32 last) const;
 
 		static BLooper*					Looper();
 
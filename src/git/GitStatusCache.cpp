@@ -0,0 +1,125 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "GitStatusCache.h"
+
+#include <Autolock.h>
+
+
+namespace Genio::Git {
+
+	GitStatusCache::GitStatusCache()
+		:
+		fLock("GitStatusCache")
+	{
+	}
+
+	uint32
+	GitStatusCache::StatusOf(const BString& path, bool isDirectory) const
+	{
+		BAutolock lock(fLock);
+		BString key(path);
+		if (isDirectory)
+			key << "/";
+		auto entry = fEntries.find(key);
+		if (entry != fEntries.end())
+			return entry->second;
+		const uint32* above = _FolderEntryAbove(path);
+		if (above != nullptr)
+			return *above;
+		if (isDirectory) {
+			auto folder = fFolders.find(path);
+			if (folder != fFolders.end())
+				return folder->second;
+		}
+		return GIT_STATUS_CURRENT;
+	}
+
+	void
+	GitStatusCache::GetChanges(GitRepository::StatusEntries& changes) const
+	{
+		BAutolock lock(fLock);
+		changes.clear();
+		for (const auto& [path, flags] : fEntries) {
+			if ((flags & GIT_STATUS_IGNORED) == 0)
+				changes.emplace_back(path, flags);
+		}
+	}
+
+	int32
+	GitStatusCache::CountEntries() const
+	{
+		BAutolock lock(fLock);
+		return fEntries.size();
+	}
+
+	bool
+	GitStatusCache::IsCovered(const BString& path) const
+	{
+		BAutolock lock(fLock);
+		return _FolderEntryAbove(path) != nullptr;
+	}
+
+	void
+	GitStatusCache::Update(const std::vector<BString>& paths,
+		const GitRepository::StatusEntries& entries)
+	{
+		BAutolock lock(fLock);
+		if (paths.empty())
+			fEntries.clear();
+		for (const BString& path : paths) {
+			// "dir-x" sorts between "dir" and "dir/": skip what isn't below
+			auto entry = fEntries.lower_bound(path);
+			while (entry != fEntries.end() && entry->first.StartsWith(path)) {
+				if (_IsBelow(entry->first, path))
+					entry = fEntries.erase(entry);
+				else
+					entry++;
+			}
+		}
+		for (const auto& [path, flags] : entries)
+			fEntries[path] = flags;
+		_UpdateFolders();
+	}
+
+	/* static */
+	bool
+	GitStatusCache::_IsBelow(const BString& path, const BString& parent)
+	{
+		return path.StartsWith(parent)
+			&& (path.Length() == parent.Length() || path[parent.Length()] == '/');
+	}
+
+	const uint32*
+	GitStatusCache::_FolderEntryAbove(const BString& path) const
+	{
+		for (int32 slash = path.FindFirst('/'); slash >= 0;
+				slash = path.FindFirst('/', slash + 1)) {
+			BString folder;
+			path.CopyInto(folder, 0, slash + 1);
+			auto entry = fEntries.find(folder);
+			if (entry != fEntries.end())
+				return &entry->second;
+		}
+		return nullptr;
+	}
+
+	void
+	GitStatusCache::_UpdateFolders()
+	{
+		fFolders.clear();
+		for (const auto& [path, flags] : fEntries) {
+			if ((flags & GIT_STATUS_IGNORED) != 0)
+				continue;
+			for (int32 slash = path.FindFirst('/'); slash > 0;
+					slash = path.FindFirst('/', slash + 1)) {
+				BString folder;
+				path.CopyInto(folder, 0, slash);
+				fFolders[folder] |= flags;
+			}
+		}
+	}
+}
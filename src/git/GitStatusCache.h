@@ -0,0 +1,57 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#pragma once
+
+
+#include <map>
+#include <vector>
+
+#include <Locker.h>
+#include <String.h>
+
+#include "GitRepository.h"
+
+
+namespace Genio::Git {
+
+	// The git status of the files of a repository which aren't current, by
+	// path relative to the working directory. The GitWorker fills it one
+	// subtree at a time, as the files change, and the window reads it to
+	// draw the project browser and the changes list.
+
+	class GitStatusCache {
+	public:
+										GitStatusCache();
+
+		// the git_status_t flags of the path: the ones of an untracked or
+		// ignored folder above it, and for folders the ones of the files
+		// changed below them
+		uint32							StatusOf(const BString& path,
+											bool isDirectory) const;
+		// the paths which aren't current, ignored ones excluded
+		void							GetChanges(GitRepository::StatusEntries& changes) const;
+		int32							CountEntries() const;
+
+		// whether the status of the path only depends on a folder entry
+		// above it, which doesn't change with the files inside
+		bool							IsCovered(const BString& path) const;
+		// replaces what is known below the paths with the entries found
+		// there, or everything when the paths are empty
+		void							Update(const std::vector<BString>& paths,
+											const GitRepository::StatusEntries& entries);
+
+	private:
+		static	bool					_IsBelow(const BString& path, const BString& parent);
+
+		const uint32*					_FolderEntryAbove(const BString& path) const;
+		void							_UpdateFolders();
+
+		mutable BLocker					fLock;
+		std::map<BString, uint32>		fEntries;
+		// the flags of the changed files, or'ed into each folder above them
+		std::map<BString, uint32>		fFolders;
+	};
+}
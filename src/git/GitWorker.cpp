@@ -0,0 +1,637 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "GitWorker.h"
+
+#include <Autolock.h>
+#include <Catalog.h>
+#include <Message.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "GitRepository.h"
+#include "LineDiff.h"
+#include "Log.h"
+#include "Utils.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "GitWorker"
+
+
+// notifications are sent to another team: don't flood it
+static const bigtime_t kProgressInterval = 100000;
+// each changed subtree is read on its own: past this many, the whole tree
+// is read at once
+static const size_t kMaxStatusPaths = 64;
+// a full port is waited on for this long, again until the worker quits
+static const bigtime_t kSendTimeout = 100000;
+
+
+static bool
+HasAncestorIn(const BString& path, const std::set<BString>& paths)
+{
+	for (int32 slash = path.FindLast('/'); slash > 0; slash = path.FindLast('/', slash - 1)) {
+		BString parent;
+		path.CopyInto(parent, 0, slash);
+		if (paths.count(parent) != 0)
+			return true;
+	}
+	return false;
+}
+
+
+namespace Genio::Git {
+
+	GitWorker::GitWorker(GitRepository* repository, const BString& path)
+		:
+		fRepository(repository),
+		fPath(path),
+		fLock("GitWorker queue"),
+		fQueueSem(-1),
+		fThread(-1),
+		fQuitting(false),
+		fBusy(false),
+		fCancelled(false),
+		fIsRepository(false),
+		fLastProgress(0),
+		fBlame(path)
+	{
+		// the thread isn't running yet
+		fIsRepository = fRepository->IsInitialized();
+	}
+
+	GitWorker::~GitWorker()
+	{
+		if (fQueueSem >= 0)
+			delete_sem(fQueueSem);
+		delete fRepository;
+	}
+
+	// Called by the window thread, which doesn't wait for the running job:
+	// the thread deletes the worker when it's done
+	void
+	GitWorker::Quit()
+	{
+		fLock.Lock();
+		fQuitting = true;
+		fCancelled = true;
+		fQueue.clear();
+		const bool running = fThread >= 0;
+		const sem_id queueSem = fQueueSem;
+		fLock.Unlock();
+		if (running)
+			release_sem(queueSem);
+		else
+			delete this;
+	}
+
+	void
+	GitWorker::Fetch(const BMessenger& target, bool prune)
+	{
+		_Enqueue({ .type = prune ? kJobFetchPrune : kJobFetch }, target);
+	}
+
+	void
+	GitWorker::StashSave(const BMessenger& target, const BString& message)
+	{
+		_Enqueue({ .type = kJobStashSave, .argument = message }, target);
+	}
+
+	void
+	GitWorker::StashPop(const BMessenger& target)
+	{
+		_Enqueue({ .type = kJobStashPop }, target);
+	}
+
+	void
+	GitWorker::StashApply(const BMessenger& target)
+	{
+		_Enqueue({ .type = kJobStashApply }, target);
+	}
+
+	void
+	GitWorker::SwitchBranch(const BMessenger& target, const BString& branch)
+	{
+		_Enqueue({ .type = kJobSwitchBranch, .argument = branch }, target);
+	}
+
+	void
+	GitWorker::Refresh(const BMessenger& target)
+	{
+		_Enqueue({ .type = kJobRefresh }, target);
+	}
+
+	void
+	GitWorker::RefreshStatus(const BMessenger& target, const std::set<BString>& paths)
+	{
+		_Enqueue({ .type = kJobStatus, .paths = paths }, target);
+	}
+
+	void
+	GitWorker::HeadLines(const BMessenger& target, const BString& path,
+		const BString& knownBlobId)
+	{
+		_Enqueue({ .type = kJobHeadLines, .argument = path, .blobId = knownBlobId }, target);
+	}
+
+	void
+	GitWorker::Blame(const BMessenger& target, const BString& path,
+		const std::set<int32>& blocks)
+	{
+		_Enqueue({ .type = kJobBlame, .argument = path, .blocks = blocks }, target);
+	}
+
+	void
+	GitWorker::BranchTree(const BMessenger& target)
+	{
+		_Enqueue({ .type = kJobBranchTree }, target);
+	}
+
+	void
+	GitWorker::RenameBranch(const BMessenger& target, const BString& branch,
+		const BString& newName, git_branch_t type)
+	{
+		_Enqueue({ .type = kJobRenameBranch, .argument = branch, .name = newName,
+			.branchType = type }, target);
+	}
+
+	void
+	GitWorker::DeleteBranch(const BMessenger& target, const BString& branch,
+		git_branch_t type)
+	{
+		_Enqueue({ .type = kJobDeleteBranch, .argument = branch, .branchType = type }, target);
+	}
+
+	void
+	GitWorker::CreateBranch(const BMessenger& target, const BString& branch,
+		git_branch_t type, const BString& newName)
+	{
+		_Enqueue({ .type = kJobCreateBranch, .argument = branch, .name = newName,
+			.branchType = type }, target);
+	}
+
+	void
+	GitWorker::InitRepository(const BMessenger& target, bool createInitialCommit)
+	{
+		_Enqueue({ .type = kJobInit, .initialCommit = createInitialCommit }, target);
+	}
+
+	// The dropped jobs are replied to by the thread: the caller may be the
+	// target's looper, which can't wait on its own port
+	void
+	GitWorker::Cancel()
+	{
+		int32 dropped = 0;
+		{
+			BAutolock lock(fLock);
+			for (Job& job : fQueue) {
+				if (!job.cancelled)
+					dropped++;
+				job.cancelled = true;
+			}
+			if (fBusy)
+				fCancelled = true;
+		}
+		LogInfo("GitWorker: %s cancelled, %d queued jobs dropped", fPath.String(),
+			(int)dropped);
+	}
+
+	bool
+	GitWorker::IsBusy() const
+	{
+		BAutolock lock(fLock);
+		return fBusy || !fQueue.empty();
+	}
+
+	void
+	GitWorker::GetBranches(std::vector<BString>& branches, BString& currentBranch) const
+	{
+		BAutolock lock(fLock);
+		branches = fBranches;
+		currentBranch = fCurrentBranch;
+	}
+
+	BString
+	GitWorker::CurrentBranch() const
+	{
+		BAutolock lock(fLock);
+		return fCurrentBranch;
+	}
+
+	void
+	GitWorker::_Enqueue(Job job, const BMessenger& target)
+	{
+		BAutolock lock(fLock);
+		if (fQuitting)
+			return;
+
+		if (job.type == kJobRefresh || job.type == kJobStatus) {
+			for (Job& queued : fQueue) {
+				if (queued.type != job.type || queued.cancelled)
+					continue;
+				bool found = false;
+				for (const BMessenger& other : queued.targets)
+					found = found || other == target;
+				if (!found && target.IsValid())
+					queued.targets.push_back(target);
+				queued.paths.insert(job.paths.begin(), job.paths.end());
+				return;
+			}
+		} else if (job.type == kJobHeadLines || job.type == kJobBlame) {
+			// an editor asking again for its file before the answer came
+			for (Job& queued : fQueue) {
+				if (queued.type == job.type && queued.argument == job.argument
+					&& !queued.cancelled && queued.targets.size() == 1
+					&& queued.targets[0] == target) {
+					queued.blobId = job.blobId;
+					queued.blocks.insert(job.blocks.begin(), job.blocks.end());
+					return;
+				}
+			}
+		}
+
+		if (target.IsValid())
+			job.targets.push_back(target);
+		fQueue.push_back(job);
+
+		// the thread is started by the first job
+		if (fQueueSem < 0)
+			fQueueSem = create_sem(0, "GitWorker jobs");
+		if (fThread < 0) {
+			fThread = spawn_thread(_ThreadEntry, "GitWorker", B_LOW_PRIORITY, this);
+			if (fThread < 0) {
+				LogError("GitWorker: can't start the thread for %s", fPath.String());
+				return;
+			}
+			resume_thread(fThread);
+		}
+		release_sem(fQueueSem);
+	}
+
+	/* static */
+	status_t
+	GitWorker::_ThreadEntry(void* cookie)
+	{
+		GitWorker* worker = static_cast<GitWorker*>(cookie);
+		worker->_Run();
+		// _Run() only returns once Quit() was called
+		delete worker;
+		return B_OK;
+	}
+
+	void
+	GitWorker::_Run()
+	{
+		while (true) {
+			status_t status = acquire_sem(fQueueSem);
+			if (status != B_OK && status != B_INTERRUPTED) {
+				LogError("GitWorker: can't wait for jobs: %s", strerror(status));
+				// the worker can only be deleted here
+				while (!fQuitting)
+					snooze(kSendTimeout);
+				return;
+			}
+
+			Job job;
+			{
+				BAutolock lock(fLock);
+				if (fQuitting)
+					return;
+				if (fQueue.empty())
+					continue;
+				job = fQueue.front();
+				fQueue.pop_front();
+				fBusy = !job.cancelled;
+				fCancelled = false;
+			}
+
+			BMessage reply(MSG_GIT_JOB_DONE);
+			reply.AddInt32("job", job.type);
+			reply.AddString("project_path", fPath);
+			if (job.cancelled) {
+				reply.AddInt32("status", GIT_EUSER);
+				reply.AddBool("cancelled", true);
+			} else {
+				const bigtime_t start = system_time();
+				_RunJob(job, reply);
+				LogInfo("GitWorker: job %d on %s done in %.2f ms", job.type, fPath.String(),
+					(system_time() - start) / 1000.0);
+			}
+
+			{
+				BAutolock lock(fLock);
+				fBusy = false;
+			}
+			for (const BMessenger& target : job.targets)
+				_Send(target, reply);
+		}
+	}
+
+	// The target's looper may be busy for long, or gone: its port is never
+	// waited on once the worker quits
+	void
+	GitWorker::_Send(const BMessenger& target, BMessage& reply)
+	{
+		while (target.SendMessage(&reply, (BHandler*)nullptr, kSendTimeout) == B_TIMED_OUT
+			&& !fQuitting) {
+		}
+	}
+
+	void
+	GitWorker::_RunJob(const Job& job, BMessage& reply)
+	{
+		GitRepository::ProgressCallbacks callbacks;
+		callbacks.transfer = _TransferProgress;
+		callbacks.checkout = _CheckoutProgress;
+		callbacks.cancelled = _IsCancelled;
+		callbacks.payload = this;
+		fLastProgress = 0;
+
+		status_t status = B_OK;
+		try {
+			switch (job.type) {
+				case kJobFetch:
+				case kJobFetchPrune:
+					fRepository->Fetch(job.type == kJobFetchPrune, &callbacks);
+					break;
+				case kJobStashSave:
+					fRepository->StashSave(job.argument);
+					break;
+				case kJobStashPop:
+					fRepository->StashPop(&callbacks);
+					break;
+				case kJobStashApply:
+					fRepository->StashApply(&callbacks);
+					break;
+				case kJobSwitchBranch:
+					fRepository->SwitchBranch(job.argument, &callbacks);
+					// the caller wants the new branch
+					[[fallthrough]];
+				case kJobRefresh:
+				{
+					if (!fRepository->IsInitialized()) {
+						status = B_NO_INIT;
+						reply.AddString("error", B_TRANSLATE("Not a git repository."));
+						break;
+					}
+					std::vector<BString> branches = fRepository->GetBranches();
+					const BString currentBranch = fRepository->GetCurrentBranch();
+					for (const BString& branch : branches)
+						reply.AddString("branches", branch);
+					reply.AddString("current_branch", currentBranch);
+					BAutolock lock(fLock);
+					fBranches.swap(branches);
+					fCurrentBranch = currentBranch;
+					break;
+				}
+				case kJobStatus:
+					status = _RefreshStatus(job.paths, reply);
+					break;
+				case kJobHeadLines:
+					status = _ReadHeadLines(job, reply);
+					break;
+				case kJobBlame:
+					status = _Blame(job, reply);
+					break;
+				case kJobBranchTree:
+					status = _ReadBranchTree(reply);
+					break;
+				case kJobRenameBranch:
+					fRepository->RenameBranch(job.argument, job.name, job.branchType);
+					break;
+				case kJobDeleteBranch:
+					fRepository->DeleteBranch(job.argument, job.branchType);
+					break;
+				case kJobCreateBranch:
+					fRepository->CreateBranch(job.argument, job.branchType, job.name);
+					reply.AddString("branch", job.name);
+					break;
+				case kJobInit:
+					fRepository->Init(job.initialCommit);
+					break;
+			}
+		} catch (const GitConflictException& ex) {
+			status = ex.Error();
+			reply.AddString("error", ex.Message());
+			for (const BString& file : ex.GetFiles())
+				reply.AddString("files", file);
+		} catch (const GitException& ex) {
+			status = ex.Error();
+			reply.AddString("error", ex.Message());
+		} catch (const std::exception& ex) {
+			status = B_ERROR;
+			reply.AddString("error", ex.what());
+		} catch (...) {
+			status = B_ERROR;
+			reply.AddString("error", B_TRANSLATE("An unknown error occurred."));
+		}
+		if (job.type == kJobRefresh || job.type == kJobStatus || job.type == kJobInit)
+			fIsRepository = fRepository->IsInitialized();
+		reply.AddInt32("status", status);
+		reply.AddBool("cancelled", status == GIT_EUSER && fCancelled);
+	}
+
+	status_t
+	GitWorker::_RefreshStatus(const std::set<BString>& changed, BMessage& reply)
+	{
+		if (!fRepository->IsInitialized())
+			return B_NO_INIT;
+
+		// the index or HEAD moved, or which files are ignored changed:
+		// any file can have a different status
+		const BString stamp = fRepository->StatusStamp();
+		bool full = fStatusStamp.IsEmpty() || stamp != fStatusStamp || changed.count("") != 0;
+		std::vector<BString> paths;
+		for (const BString& path : changed) {
+			if (full)
+				break;
+			if (path == ".gitignore" || path.EndsWith("/.gitignore"))
+				full = true;
+			else if (!HasAncestorIn(path, changed) && !fStatus.IsCovered(path))
+				paths.push_back(path);
+		}
+		full = full || paths.size() > kMaxStatusPaths;
+		if (full)
+			paths.clear();
+		reply.AddBool("changed", full || !paths.empty());
+		reply.AddBool("full", full);
+		if (!full && paths.empty()) {
+			reply.AddInt32("entries", fStatus.CountEntries());
+			return B_OK;
+		}
+
+		const bigtime_t start = system_time();
+		GitRepository::StatusEntries entries;
+		if (full)
+			entries = fRepository->GetStatus();
+		for (const BString& path : paths) {
+			const GitRepository::StatusEntries found = fRepository->GetStatus({ path });
+			entries.insert(entries.end(), found.begin(), found.end());
+		}
+		fStatus.Update(paths, entries);
+		fStatusStamp = stamp;
+
+		reply.AddInt32("entries", fStatus.CountEntries());
+		LogInfo("GitWorker: status of %s read in %.2f ms (%s, %d entries found, %d cached)",
+			fPath.String(), (system_time() - start) / 1000.0,
+			full ? "whole tree" : BString().SetToFormat("%d paths", (int)paths.size()).String(),
+			(int)entries.size(), (int)fStatus.CountEntries());
+		return B_OK;
+	}
+
+	status_t
+	GitWorker::_ReadHeadLines(const Job& job, BMessage& reply)
+	{
+		reply.AddString("path", job.argument);
+		if (!fRepository->IsInitialized())
+			return B_NO_INIT;
+
+		BString blobId;
+		BString content;
+		if (!fRepository->GetHeadBlob(job.argument, blobId, content))
+			return B_ENTRY_NOT_FOUND;
+		reply.AddString("blob_id", blobId);
+		if (blobId == job.blobId) {
+			reply.AddBool("unchanged", true);
+			return B_OK;
+		}
+
+		std::vector<uint32> lines;
+		LineDiff::HashLines(content.String(), content.Length(), lines);
+		reply.AddData("lines", B_RAW_TYPE, lines.data(), lines.size() * sizeof(uint32));
+		return B_OK;
+	}
+
+	status_t
+	GitWorker::_Blame(const Job& job, BMessage& reply)
+	{
+		reply.AddString("path", job.argument);
+		if (!fRepository->IsInitialized())
+			return B_NO_INIT;
+
+		const BString headId = fRepository->HeadCommitId();
+		BString blobId;
+		BString content;
+		if (headId.IsEmpty() || !fRepository->GetHeadBlob(job.argument, blobId, content))
+			return B_ENTRY_NOT_FOUND;
+		reply.AddString("head_id", headId);
+		reply.AddString("blob_id", blobId);
+
+		// for git there's no line after the last newline
+		const char* text = content.String();
+		int32 lineCount = std::count(text, text + content.Length(), '\n');
+		if (content.Length() > 0 && text[content.Length() - 1] != '\n')
+			lineCount++;
+
+		const bigtime_t start = system_time();
+		int32 blamed = 0;
+		for (const int32 block : job.blocks) {
+			const int32 first = block * BlameCache::kBlockLines;
+			if (block < 0 || first >= lineCount)
+				continue;
+			GitRepository::BlameHunks hunks;
+			if (!fBlame.Get(job.argument, headId, block, hunks)) {
+				if (fCancelled)
+					return GIT_EUSER;
+				hunks = fRepository->Blame(job.argument, headId, first,
+					std::min(first + BlameCache::kBlockLines, lineCount) - 1);
+				fBlame.Put(job.argument, headId, block, hunks);
+				blamed++;
+			}
+			reply.AddInt32("blocks", block);
+			for (const GitRepository::BlameHunk& hunk : hunks) {
+				reply.AddInt32("start", hunk.start);
+				reply.AddInt32("count", hunk.count);
+				reply.AddString("commit", hunk.commitId);
+				reply.AddString("author", hunk.author);
+				reply.AddString("summary", hunk.summary);
+				reply.AddInt64("time", hunk.time);
+			}
+		}
+		if (blamed > 0) {
+			LogInfo("GitWorker: %d blocks of %s blamed in %.2f ms, %d cached", (int)blamed,
+				job.argument.String(), (system_time() - start) / 1000.0,
+				(int)job.blocks.size() - blamed);
+		}
+		return B_OK;
+	}
+
+	status_t
+	GitWorker::_ReadBranchTree(BMessage& reply)
+	{
+		if (!fRepository->IsInitialized())
+			return B_NO_INIT;
+
+		std::vector<BString> local = fRepository->GetBranches(GIT_BRANCH_LOCAL);
+		std::vector<BString> remote = fRepository->GetBranches(GIT_BRANCH_REMOTE);
+		std::vector<BString> tags = fRepository->GetTags();
+		std::sort(local.begin(), local.end());
+		std::sort(remote.begin(), remote.end());
+		std::sort(tags.begin(), tags.end());
+		for (const BString& branch : local)
+			reply.AddString("local", branch);
+		for (const BString& branch : remote)
+			reply.AddString("remote", branch);
+		for (const BString& tag : tags)
+			reply.AddString("tags", tag);
+		return B_OK;
+	}
+
+	void
+	GitWorker::_ShowProgress(const BString& text, float progress)
+	{
+		const bigtime_t now = system_time();
+		if (now - fLastProgress < kProgressInterval)
+			return;
+		fLastProgress = now;
+		// same message id as the notification closing the job, which replaces it
+		ProgressNotification("Genio", fPath, fPath, text, progress);
+	}
+
+	/* static */
+	int
+	GitWorker::_TransferProgress(const git_indexer_progress* stats, void* payload)
+	{
+		GitWorker* worker = static_cast<GitWorker*>(payload);
+		if (stats->total_objects == 0)
+			return 0;
+		BString text;
+		if (stats->received_objects < stats->total_objects) {
+			text.SetToFormat(B_TRANSLATE("Receiving objects: %u/%u (%zu KiB)"),
+				stats->received_objects, stats->total_objects,
+				stats->received_bytes / 1024);
+			worker->_ShowProgress(text,
+				(float)stats->received_objects / stats->total_objects);
+		} else {
+			text.SetToFormat(B_TRANSLATE("Resolving deltas: %u/%u"),
+				stats->indexed_deltas, stats->total_deltas);
+			worker->_ShowProgress(text, stats->total_deltas > 0
+				? (float)stats->indexed_deltas / stats->total_deltas : 1.0f);
+		}
+		return 0;
+	}
+
+	/* static */
+	void
+	GitWorker::_CheckoutProgress(const char* path, size_t completed, size_t total,
+		void* payload)
+	{
+		GitWorker* worker = static_cast<GitWorker*>(payload);
+		if (total == 0)
+			return;
+		BString text;
+		text.SetToFormat(B_TRANSLATE("Updating files: %zu/%zu"), completed, total);
+		worker->_ShowProgress(text, (float)completed / total);
+	}
+
+	/* static */
+	bool
+	GitWorker::_IsCancelled(void* payload)
+	{
+		return static_cast<GitWorker*>(payload)->fCancelled;
+	}
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#pragma once
+
+
+#include <git2.h>
+
+#include <atomic>
+#include <deque>
+#include <set>
+#include <vector>
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <String.h>
+
+#include "BlameCache.h"
+#include "GitStatusCache.h"
+
+
+enum {
+	MSG_GIT_JOB_DONE = 'gjdn'	// job (int32), project_path (string), status (int32),
+								// cancelled (bool), error (string), files (strings),
+								// refresh: branches (strings), current_branch (string)
+								// status: changed (bool), full (bool), entries (int32)
+								// head lines: path (string), blob_id (string),
+								// unchanged (bool), lines (uint32 array, raw)
+								// blame: path (string), head_id (string), blob_id (string),
+								// blocks (int32s), start, count (int32s), commit,
+								// author, summary (strings), time (int64s)
+								// branch tree: local, remote, tags (strings)
+								// create branch: branch (string)
+};
+
+
+namespace Genio::Git {
+
+	class GitRepository;
+
+	// Runs the libgit2 operations of a repository, one at a time, on a
+	// thread of its own, so the window never waits for them. A libgit2
+	// repository can't be shared by threads: it is only used by this thread,
+	// which owns it.
+	// Each job replies to its target with a MSG_GIT_JOB_DONE message; fetch
+	// and checkout progress are shown as notifications. Refreshes queued
+	// while another one is waiting are merged into it.
+
+	class GitWorker {
+	public:
+		enum JobType {
+			kJobFetch,
+			kJobFetchPrune,
+			kJobStashSave,
+			kJobStashPop,
+			kJobStashApply,
+			kJobSwitchBranch,
+			kJobRefresh,
+			kJobStatus,
+			kJobHeadLines,
+			kJobBlame,
+			kJobBranchTree,
+			kJobRenameBranch,
+			kJobDeleteBranch,
+			kJobCreateBranch,
+			kJobInit
+		};
+
+										GitWorker(GitRepository* repository, const BString& path);
+
+		// stops the worker, which deletes itself and the repository once
+		// its thread is done
+		void							Quit();
+
+		void							Fetch(const BMessenger& target, bool prune = false);
+		void							StashSave(const BMessenger& target, const BString& message);
+		void							StashPop(const BMessenger& target);
+		void							StashApply(const BMessenger& target);
+		void							SwitchBranch(const BMessenger& target, const BString& branch);
+		// reads the branches and the current one
+		void							Refresh(const BMessenger& target);
+		// reads the status of the paths which changed, relative to the
+		// working directory, or of all the files for an empty path. All
+		// of them are read again anyway when the index or HEAD changed.
+		void							RefreshStatus(const BMessenger& target,
+											const std::set<BString>& paths);
+		// reads the lines of the file, relative to the working directory, in
+		// HEAD, hashed for a LineDiff: they aren't sent again when the blob
+		// is still the known one. B_ENTRY_NOT_FOUND when HEAD has no such
+		// text file.
+		void							HeadLines(const BMessenger& target, const BString& path,
+											const BString& knownBlobId);
+		// who changed the lines of the file in HEAD, by BlameCache block:
+		// the blocks already blamed at this commit are read from the cache
+		void							Blame(const BMessenger& target, const BString& path,
+											const std::set<int32>& blocks);
+		// reads the local and remote branches and the tags
+		void							BranchTree(const BMessenger& target);
+		void							RenameBranch(const BMessenger& target,
+											const BString& branch, const BString& newName,
+											git_branch_t type);
+		void							DeleteBranch(const BMessenger& target,
+											const BString& branch, git_branch_t type);
+		void							CreateBranch(const BMessenger& target,
+											const BString& branch, git_branch_t type,
+											const BString& newName);
+		void							InitRepository(const BMessenger& target,
+											bool createInitialCommit);
+
+		// stops the running job, when it can be stopped, and drops the queued ones
+		void							Cancel();
+		bool							IsBusy() const;
+		// whether the working directory was a repository at the last refresh
+		bool							IsRepository() const { return fIsRepository; }
+
+		// what the last refresh found
+		void							GetBranches(std::vector<BString>& branches,
+											BString& currentBranch) const;
+		BString							CurrentBranch() const;
+		const GitStatusCache&			Status() const { return fStatus; }
+
+	private:
+		struct Job {
+			JobType						type;
+			BString						argument;
+			BString						blobId;
+			BString						name;
+			git_branch_t				branchType = GIT_BRANCH_LOCAL;
+			bool						initialCommit = false;
+			std::set<int32>				blocks;
+			std::set<BString>			paths;
+			std::vector<BMessenger>		targets;
+			// dropped by Cancel(): replied to without running
+			bool						cancelled = false;
+		};
+
+										~GitWorker();
+
+		static	status_t				_ThreadEntry(void* cookie);
+		static	int						_TransferProgress(const git_indexer_progress* stats,
+											void* payload);
+		static	void					_CheckoutProgress(const char* path, size_t completed,
+											size_t total, void* payload);
+		static	bool					_IsCancelled(void* payload);
+
+		void							_Enqueue(Job job, const BMessenger& target);
+		void							_Run();
+		void							_RunJob(const Job& job, BMessage& reply);
+		void							_Send(const BMessenger& target, BMessage& reply);
+		status_t						_RefreshStatus(const std::set<BString>& changed,
+											BMessage& reply);
+		status_t						_ReadHeadLines(const Job& job, BMessage& reply);
+		status_t						_Blame(const Job& job, BMessage& reply);
+		status_t						_ReadBranchTree(BMessage& reply);
+		void							_ShowProgress(const BString& text, float progress);
+
+		GitRepository*					fRepository;
+		BString							fPath;
+
+		mutable BLocker					fLock;
+		std::deque<Job>					fQueue;
+		sem_id							fQueueSem;
+		thread_id						fThread;
+		std::atomic<bool>				fQuitting;
+		bool							fBusy;
+		std::atomic<bool>				fCancelled;
+		std::atomic<bool>				fIsRepository;
+		bigtime_t						fLastProgress;
+
+		std::vector<BString>			fBranches;
+		BString							fCurrentBranch;
+
+		GitStatusCache					fStatus;
+		// only used by the thread
+		BString							fStatusStamp;
+		BlameCache						fBlame;
+	};
+}
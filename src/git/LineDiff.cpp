@@ -0,0 +1,320 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "LineDiff.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+// beyond this many lines added or removed in a range, the diff would
+// take too long for a keystroke
+static const int32 kMaxEditCost = 500;
+
+
+namespace Genio::Git {
+
+	/* static */
+	uint32
+	LineDiff::HashLine(const char* text, size_t length)
+	{
+		// line ends don't count: "\r\n" and "\n" are the same line
+		while (length > 0 && (text[length - 1] == '\n' || text[length - 1] == '\r'))
+			length--;
+		// FNV-1a
+		uint32 hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+			hash = (hash ^ (uint8)text[i]) * 16777619u;
+		return hash;
+	}
+
+	/* static */
+	void
+	LineDiff::HashLines(const char* text, size_t length, std::vector<uint32>& hashes)
+	{
+		// as many lines as the editor has: the last one can be empty
+		hashes.clear();
+		size_t start = 0;
+		for (size_t i = 0; i < length; i++) {
+			if (text[i] == '\n') {
+				hashes.push_back(HashLine(text + start, i - start));
+				start = i + 1;
+			}
+		}
+		hashes.push_back(HashLine(text + start, length - start));
+	}
+
+	LineDiff::LineDiff(std::vector<uint32>&& base)
+		:
+		fBase(std::move(base)),
+		fDirtyStart(-1),
+		fDirtyEnd(-1)
+	{
+	}
+
+	void
+	LineDiff::SetLines(std::vector<uint32>&& lines)
+	{
+		fLines = std::move(lines);
+		fHunks.clear();
+		_Diff(0, fBase.size(), 0, fLines.size(), fHunks);
+		fDirtyStart = fDirtyEnd = -1;
+	}
+
+	void
+	LineDiff::Replace(int32 line, int32 removed, const std::vector<uint32>& added)
+	{
+		const int32 addedCount = added.size();
+		const int32 delta = addedCount - removed;
+		const int32 removedEnd = line + removed;
+
+		fLines.erase(fLines.begin() + line, fLines.begin() + removedEnd);
+		fLines.insert(fLines.begin() + line, added.begin(), added.end());
+
+		// the hunks after the edit move with it, the ones it overlaps are
+		// stretched over it until they are diffed again
+		for (DiffHunk& hunk : fHunks) {
+			const int32 hunkEnd = hunk.newStart + hunk.newCount;
+			if (hunk.newStart >= removedEnd && (hunk.newStart > line || removed > 0)) {
+				hunk.newStart += delta;
+			} else if (hunkEnd > line || (hunkEnd == line && hunk.newCount == 0)) {
+				const int32 newEnd = hunkEnd > removedEnd ? hunkEnd + delta : line + addedCount;
+				hunk.newStart = std::min(hunk.newStart, line);
+				hunk.newCount = newEnd - hunk.newStart;
+			}
+		}
+
+		if (fDirtyStart < 0) {
+			fDirtyStart = line;
+			fDirtyEnd = line + addedCount;
+		} else {
+			if (fDirtyEnd >= removedEnd)
+				fDirtyEnd += delta;
+			else if (fDirtyEnd > line)
+				fDirtyEnd = line + addedCount;
+			fDirtyStart = std::min(fDirtyStart, line);
+			fDirtyEnd = std::max(fDirtyEnd, line + addedCount);
+		}
+	}
+
+	bool
+	LineDiff::Update(int32& first, int32& last)
+	{
+		if (fDirtyStart < 0)
+			return false;
+
+		// the hunks touching the dirty lines are diffed again with them
+		int32 newStart = fDirtyStart;
+		int32 newEnd = fDirtyEnd;
+		auto begin = std::partition_point(fHunks.begin(), fHunks.end(),
+			[newStart](const DiffHunk& hunk) { return hunk.newStart + hunk.newCount < newStart; });
+		auto end = begin;
+		for (; end != fHunks.end() && end->newStart <= newEnd; end++) {
+			newStart = std::min(newStart, end->newStart);
+			newEnd = std::max(newEnd, end->newStart + end->newCount);
+		}
+		newEnd = std::min(newEnd, (int32)fLines.size());
+
+		// around them the lines are the same as in the base
+		int32 oldStart = newStart;
+		if (begin != fHunks.begin()) {
+			const DiffHunk& previous = *(begin - 1);
+			oldStart = previous.oldStart + previous.oldCount
+				+ newStart - (previous.newStart + previous.newCount);
+		}
+		int32 oldEnd;
+		if (end != fHunks.end())
+			oldEnd = end->oldStart - (end->newStart - newEnd);
+		else
+			oldEnd = fBase.size() - (fLines.size() - newEnd);
+
+		std::vector<DiffHunk> hunks;
+		_Diff(oldStart, oldEnd, newStart, newEnd, hunks);
+		begin = fHunks.erase(begin, end);
+		fHunks.insert(begin, hunks.begin(), hunks.end());
+
+		first = newStart;
+		last = newEnd;
+		fDirtyStart = fDirtyEnd = -1;
+		return true;
+	}
+
+	int32
+	LineDiff::BaseLine(int32 line) const
+	{
+		auto next = std::partition_point(fHunks.begin(), fHunks.end(),
+			[line](const DiffHunk& hunk) { return hunk.newStart <= line; });
+		if (next == fHunks.begin())
+			return line;
+		const DiffHunk& hunk = *(next - 1);
+		if (line < hunk.newStart + hunk.newCount)
+			return -1;
+		return line - (hunk.newStart + hunk.newCount) + hunk.oldStart + hunk.oldCount;
+	}
+
+	// Myers' greedy algorithm, on the lines left once the common prefix and
+	// suffix are skipped. The furthest points reached for each number of
+	// edits are kept, to walk the path back.
+	void
+	LineDiff::_Diff(int32 oldStart, int32 oldEnd, int32 newStart, int32 newEnd,
+		std::vector<DiffHunk>& hunks) const
+	{
+		while (oldStart < oldEnd && newStart < newEnd && fBase[oldStart] == fLines[newStart]) {
+			oldStart++;
+			newStart++;
+		}
+		while (oldEnd > oldStart && newEnd > newStart && fBase[oldEnd - 1] == fLines[newEnd - 1]) {
+			oldEnd--;
+			newEnd--;
+		}
+		const int32 n = oldEnd - oldStart;
+		const int32 m = newEnd - newStart;
+		if (n == 0 && m == 0)
+			return;
+		if (n == 0 || m == 0) {
+			hunks.push_back({ oldStart, n, newStart, m });
+			return;
+		}
+
+		const uint32* a = fBase.data() + oldStart;
+		const uint32* b = fLines.data() + newStart;
+		const int32 maxCost = std::min(n + m, kMaxEditCost);
+		const int32 offset = maxCost + 1;
+		std::vector<int32> v(2 * maxCost + 3, 0);
+		// trace[d] holds the diagonals -d..d after d edits
+		std::vector<std::vector<int32>> trace;
+		int32 cost = -1;
+		for (int32 d = 0; d <= maxCost && cost < 0; d++) {
+			for (int32 k = -d; k <= d; k += 2) {
+				int32 x;
+				if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+					x = v[offset + k + 1];
+				else
+					x = v[offset + k - 1] + 1;
+				int32 y = x - k;
+				while (x < n && y < m && a[x] == b[y]) {
+					x++;
+					y++;
+				}
+				v[offset + k] = x;
+				if (x >= n && y >= m) {
+					cost = d;
+					break;
+				}
+			}
+			trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+		}
+		if (cost < 0) {
+			if (!_DiffAnchored(oldStart, oldEnd, newStart, newEnd, hunks))
+				hunks.push_back({ oldStart, n, newStart, m });
+			return;
+		}
+
+		// the edits, from the last one: (x, y) before it, and whether it
+		// inserts a line of the text or removes one of the base
+		struct Edit {
+			int32	x;
+			int32	y;
+			bool	insert;
+		};
+		std::vector<Edit> edits;
+		edits.reserve(cost);
+		int32 x = n;
+		int32 y = m;
+		for (int32 d = cost; d > 0; d--) {
+			const std::vector<int32>& previous = trace[d - 1];
+			const int32 k = x - y;
+			const bool insert = k == -d
+				|| (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]);
+			const int32 previousK = insert ? k + 1 : k - 1;
+			const int32 previousX = previous[previousK + d - 1];
+			const int32 previousY = previousX - previousK;
+			edits.push_back({ previousX, previousY, insert });
+			x = previousX;
+			y = previousY;
+		}
+
+		for (auto edit = edits.rbegin(); edit != edits.rend(); edit++) {
+			const int32 oldLine = oldStart + edit->x;
+			const int32 newLine = newStart + edit->y;
+			if (hunks.empty() || hunks.back().oldStart + hunks.back().oldCount != oldLine
+				|| hunks.back().newStart + hunks.back().newCount != newLine)
+				hunks.push_back({ oldLine, 0, newLine, 0 });
+			if (edit->insert)
+				hunks.back().newCount++;
+			else
+				hunks.back().oldCount++;
+		}
+	}
+
+	// Too many edits for Myers: as patience diff does, the lines found once
+	// in both ranges are matched, the longest run of them in the same order
+	// is kept, and the ranges between them are diffed on their own.
+	// Returns false when no line can be matched.
+	bool
+	LineDiff::_DiffAnchored(int32 oldStart, int32 oldEnd, int32 newStart, int32 newEnd,
+		std::vector<DiffHunk>& hunks) const
+	{
+		struct Occurrences {
+			int32	oldCount = 0;
+			int32	newCount = 0;
+			int32	oldLine = 0;
+		};
+		std::unordered_map<uint32, Occurrences> occurrences;
+		occurrences.reserve(newEnd - newStart);
+		for (int32 line = oldStart; line < oldEnd; line++) {
+			Occurrences& o = occurrences[fBase[line]];
+			o.oldCount++;
+			o.oldLine = line;
+		}
+		for (int32 line = newStart; line < newEnd; line++) {
+			auto found = occurrences.find(fLines[line]);
+			if (found != occurrences.end())
+				found->second.newCount++;
+		}
+
+		// in the order of the text
+		struct Anchor {
+			int32	oldLine;
+			int32	newLine;
+		};
+		std::vector<Anchor> anchors;
+		for (int32 line = newStart; line < newEnd; line++) {
+			auto found = occurrences.find(fLines[line]);
+			if (found != occurrences.end() && found->second.oldCount == 1
+				&& found->second.newCount == 1)
+				anchors.push_back({ found->second.oldLine, line });
+		}
+		if (anchors.empty())
+			return false;
+
+		// the longest increasing run of base lines, by patience sorting:
+		// tails[i] ends the best run of length i + 1
+		std::vector<int32> tails;
+		std::vector<int32> previous(anchors.size(), -1);
+		for (int32 i = 0; i < (int32)anchors.size(); i++) {
+			auto tail = std::partition_point(tails.begin(), tails.end(),
+				[&](int32 t) { return anchors[t].oldLine < anchors[i].oldLine; });
+			if (tail != tails.begin())
+				previous[i] = *(tail - 1);
+			if (tail == tails.end())
+				tails.push_back(i);
+			else
+				*tail = i;
+		}
+		std::vector<Anchor> run;
+		for (int32 i = tails.back(); i >= 0; i = previous[i])
+			run.push_back(anchors[i]);
+
+		for (auto anchor = run.rbegin(); anchor != run.rend(); anchor++) {
+			_Diff(oldStart, anchor->oldLine, newStart, anchor->newLine, hunks);
+			oldStart = anchor->oldLine + 1;
+			newStart = anchor->newLine + 1;
+		}
+		_Diff(oldStart, oldEnd, newStart, newEnd, hunks);
+		return true;
+	}
+}
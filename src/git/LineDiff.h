@@ -0,0 +1,71 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#pragma once
+
+
+#include <vector>
+
+#include <SupportDefs.h>
+
+
+namespace Genio::Git {
+
+	// lines [oldStart, oldStart + oldCount) of the base replaced by lines
+	// [newStart, newStart + newCount) of the text
+	struct DiffHunk {
+		int32	oldStart;
+		int32	oldCount;
+		int32	newStart;
+		int32	newCount;
+	};
+
+	// The line changes of a text against a base, both held as line hashes.
+	// Edits only mark the lines they touched: Update() diffs again the
+	// part of the text between the closest unchanged lines around them,
+	// so a keystroke costs a small Myers diff whatever the size of the
+	// file. Past kMaxEditCost edits a range is split on the lines found
+	// once in both sides, and reported as one hunk when there are none.
+
+	class LineDiff {
+	public:
+		static	uint32					HashLine(const char* text, size_t length);
+		static	void					HashLines(const char* text, size_t length,
+											std::vector<uint32>& hashes);
+
+										LineDiff(std::vector<uint32>&& base);
+
+		// replaces the text and diffs all of it
+		void							SetLines(std::vector<uint32>&& lines);
+		// lines [line, line + removed) of the text replaced by the given ones
+		void							Replace(int32 line, int32 removed,
+											const std::vector<uint32>& added);
+		// diffs the lines touched since the last call: returns false when
+		// there are none, else the range of lines of the text whose hunks
+		// changed
+		bool							Update(int32& first, int32& last);
+
+		// the line of the base which the line of the text is, or -1 when
+		// it was added or changed
+		int32							BaseLine(int32 line) const;
+
+		const std::vector<DiffHunk>&	Hunks() const { return fHunks; }
+		int32							CountLines() const { return fLines.size(); }
+
+	private:
+		void							_Diff(int32 oldStart, int32 oldEnd, int32 newStart,
+											int32 newEnd, std::vector<DiffHunk>& hunks) const;
+		bool							_DiffAnchored(int32 oldStart, int32 oldEnd,
+											int32 newStart, int32 newEnd,
+											std::vector<DiffHunk>& hunks) const;
+
+		std::vector<uint32>				fBase;
+		std::vector<uint32>				fLines;
+		// sorted, in the coordinates of the text
+		std::vector<DiffHunk>			fHunks;
+		int32							fDirtyStart;
+		int32							fDirtyEnd;
+	};
+}
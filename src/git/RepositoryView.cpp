@@ -17,20 +17,17 @@
 #include "ConfigManager.h"
 #include "GenioApp.h"
 #include "GenioWindow.h"
-#include "GitRepository.h"
+#include "GitWorker.h"
 #include "GMessage.h"
 #include "ProjectFolder.h"
 #include "SourceControlPanel.h"
 #include "StringFormatter.h"
-#include "Task.h"
 #include "Utils.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "SourceControlPanel"
 
 
-using Genio::Task::Task;
-
 RepositoryView::RepositoryView()
 	:
 	GOutlineListView("RepositoryView", B_SINGLE_SELECTION_LIST)
@@ -100,6 +97,10 @@ RepositoryView::MessageReceived(BMessage* message)
 			messenger.SendMessage(&switchMessage);
 			break;
 		}
+		case MSG_GIT_JOB_DONE:
+			if (message->GetInt32("job", -1) == GitWorker::kJobBranchTree)
+				_FillRepository(message);
+			break;
 		default:
 			GOutlineListView::MessageReceived(message);
 			break;
@@ -118,100 +119,54 @@ void
 RepositoryView::UpdateRepository(const ProjectFolder *project, const BString &branch)
 {
 	ASSERT(project != nullptr);
-	ASSERT(project->GetRepository());
 	ASSERT(!branch.IsEmpty());
 
 	LogInfo("UpdateRepository(project: %s, branch: %s)",
 		project->Name().String(), branch.String());
 
+	// Used to show the current branch in RepositoryView
+	fCurrentBranch = branch;
 	// TODO: we call this method also when current branch changes, and we rebuild
 	// the whole listview. Maybe we could avoid that
-	BString taskName;
-	taskName << "UpdateRepository-" << project->Name() << "-" << branch;
-	Task<status_t> task
-	(
-		taskName,
-		BMessenger(this),
-		std::bind
-		(
-			&RepositoryView::_UpdateRepositoryTask,
-			this,
-			project->GetRepository(),
-			branch
-		)
-	);
-
-	task.Run();
+	if (project->GetGitWorker() != nullptr)
+		project->GetGitWorker()->BranchTree(BMessenger(this));
 }
 
 
 void
-RepositoryView::_UpdateRepositoryTask(const GitRepository* repo, const BString& branch)
+RepositoryView::_FillRepository(BMessage* message)
 {
 	auto const NullLambda = [](const auto& val){ return false; };
 
-	// Used to show the current branch in RepositoryView
-	fCurrentBranch = branch;
-	try {
-		// Retrieve branches
-		auto localBranches = repo->GetBranches(GIT_BRANCH_LOCAL);
-		std::sort(localBranches.begin(), localBranches.end());
-		int32 numLocalBranches = localBranches.size();
-
-		LogInfo("%ld local branches", numLocalBranches);
-
-		auto remoteBranches = repo->GetBranches(GIT_BRANCH_REMOTE);
-		std::sort(remoteBranches.begin(), remoteBranches.end());
-		int32 numRemoteBranches = remoteBranches.size();
-
-		LogInfo("%ld remote branches", numRemoteBranches);
-
-		auto allTags = repo->GetTags();
-		std::sort(allTags.begin(), allTags.end());
-		int32 numTags = allTags.size();
-
-		LogInfo("%ld tags", numTags);
-
-		// populate Listview
-		// TODO: Try to do more fine-grained locking
-		if (LockLooper()) {
-			MakeEmpty();
-			// local branches
-			_InitEmptySuperItem(B_TRANSLATE("Local branches"));
-			for (auto &branch : localBranches) {
-				_BuildBranchTree(branch, kLocalBranch,
-					[&](const auto &branchname) {
-						return (branchname == fCurrentBranch);
-					});
-			}
+	MakeEmpty();
+	if (message->GetInt32("status", B_OK) != B_OK) {
+		_InitEmptySuperItem(B_TRANSLATE("Local branches"));
+		_InitEmptySuperItem(B_TRANSLATE("Remote branches"));
+		_InitEmptySuperItem(B_TRANSLATE("Tags"));
+		if (!message->GetBool("cancelled", false))
+			OKAlert("Git", message->GetString("error", ""), B_INFO_ALERT);
+		return;
+	}
 
-			// remote branches
-			_InitEmptySuperItem(B_TRANSLATE("Remote branches"));
-			for (auto &branch : remoteBranches) {
-				_BuildBranchTree(branch, kRemoteBranch, NullLambda);
-			}
+	// local branches
+	_InitEmptySuperItem(B_TRANSLATE("Local branches"));
+	BString branch;
+	for (int32 i = 0; message->FindString("local", i, &branch) == B_OK; i++) {
+		_BuildBranchTree(branch, kLocalBranch,
+			[&](const auto &branchname) {
+				return (branchname == fCurrentBranch);
+			});
+	}
 
-			// tags
-			_InitEmptySuperItem(B_TRANSLATE("Tags"));
-			for (auto &tag : allTags) {
-				_BuildBranchTree(tag, kTag, NullLambda);
-			}
+	// remote branches
+	_InitEmptySuperItem(B_TRANSLATE("Remote branches"));
+	for (int32 i = 0; message->FindString("remote", i, &branch) == B_OK; i++)
+		_BuildBranchTree(branch, kRemoteBranch, NullLambda);
 
-			UnlockLooper();
-		}
-	} catch (const GException &ex) {
-		if (Looper()->IsLocked())
-			UnlockLooper();
-		OKAlert("Git", ex.Message(), B_INFO_ALERT);
-
-		if (LockLooper()) {
-			MakeEmpty();
-			_InitEmptySuperItem(B_TRANSLATE("Local branches"));
-			_InitEmptySuperItem(B_TRANSLATE("Remote branches"));
-			_InitEmptySuperItem(B_TRANSLATE("Tags"));
-			UnlockLooper();
-		}
-	}
+	// tags
+	_InitEmptySuperItem(B_TRANSLATE("Tags"));
+	for (int32 i = 0; message->FindString("tags", i, &branch) == B_OK; i++)
+		_BuildBranchTree(branch, kTag, NullLambda);
 }
 
 
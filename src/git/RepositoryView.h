@@ -21,10 +21,6 @@ enum ItemType {
 	kTag
 };
 
-namespace Genio::Git {
-	class GitRepository;
-}
-
 class BranchItem;
 class ProjectFolder;
 class RepositoryView : public GOutlineListView {
@@ -43,7 +39,7 @@ public:
 private:
 	void			ShowPopupMenu(BPoint where) override;
 
-	void			_UpdateRepositoryTask(const Genio::Git::GitRepository* repo, const BString& branch);
+	void			_FillRepository(BMessage* message);
 
 	BranchItem*		_InitEmptySuperItem(const BString &label);
 	void			_BuildBranchTree(const BString &branch, uint32 branchType, const auto& checker);
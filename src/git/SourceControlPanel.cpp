@@ -15,8 +15,10 @@
 #include <CheckBox.h>
 #include <Clipboard.h>
 #include <LayoutBuilder.h>
+#include <ListView.h>
 #include <ObjectList.h>
 #include <OutlineListView.h>
+#include <Path.h>
 #include <PathMonitor.h>
 #include <PopUpMenu.h>
 #include <StringItem.h>
@@ -29,6 +31,7 @@
 #include "GenioWindow.h"
 #include "GitAlert.h"
 #include "GitRepository.h"
+#include "GitWorker.h"
 #include "GTextAlert.h"
 #include "Log.h"
 #include "NoticeMessages.h"
@@ -37,6 +40,7 @@
 #include "ProjectMenuField.h"
 #include "RepositoryView.h"
 #include "StringFormatter.h"
+#include "StyledItem.h"
 #include "Utils.h"
 
 
@@ -58,6 +62,31 @@ enum MainIndex {
 
 const int kBurstTimeout = 1000000;
 
+
+// created when the list is filled, so the language can change meanwhile
+static BString
+GitStatusLabel(uint32 status)
+{
+	if ((status & GIT_STATUS_CONFLICTED) != 0)
+		return B_TRANSLATE("Conflicting file");
+	if ((status & GIT_STATUS_WT_NEW) != 0)
+		return B_TRANSLATE("New file");
+	if ((status & GIT_STATUS_INDEX_NEW) != 0)
+		return B_TRANSLATE("New file staged");
+	if ((status & GIT_STATUS_WT_MODIFIED) != 0)
+		return B_TRANSLATE("File modified");
+	if ((status & GIT_STATUS_INDEX_MODIFIED) != 0)
+		return B_TRANSLATE("File modified on index");
+	if ((status & GIT_STATUS_WT_DELETED) != 0)
+		return B_TRANSLATE("File deleted");
+	if ((status & GIT_STATUS_INDEX_DELETED) != 0)
+		return B_TRANSLATE("File deleted from index");
+	if ((status & (GIT_STATUS_WT_RENAMED | GIT_STATUS_INDEX_RENAMED)) != 0)
+		return B_TRANSLATE("File renamed");
+	return B_TRANSLATE("File type changed");
+}
+
+
 SourceControlPanel::SourceControlPanel()
 	:
 	BView(B_TRANSLATE("Source control"), B_WILL_DRAW | B_FRAME_EVENTS ),
@@ -66,7 +95,8 @@ SourceControlPanel::SourceControlPanel()
 	fCurrentBranch(),
 	fInitializeButton(nullptr),
 	fDoNotCreateInitialCommitCheckBox(nullptr),
-	fBurstHandler(nullptr)
+	fBurstHandler(nullptr),
+	fInvokeBranchItem(false)
 {
 	fProjectMenu = new Genio::UI::ProjectMenuField("ProjectMenu", MsgChangeProject);
 	fBranchMenu = new OptionList<BString>("BranchMenu",
@@ -131,7 +161,7 @@ SourceControlPanel::_InitToolBar()
 	fToolBar = new ToolBar();
 	fToolBar->ChangeIconSize(16);
 	fToolBar->AddAction(MsgShowRepositoryPanel, B_TRANSLATE("Repository"), "kIconGitRepo", true);
-	// fToolBar->AddAction(MsgShowChangesPanel, B_TRANSLATE("Changes"), "kIconGitChanges");
+	fToolBar->AddAction(MsgShowChangesPanel, B_TRANSLATE("Changes"), "kIconGitChanges", true);
 	// fToolBar->AddAction(MsgShowLogPanel, B_TRANSLATE("Log"), "kIconGitLog");
 	fToolBar->AddGlue();
 	fToolBar->AddAction(MsgShowActionsMenu, B_TRANSLATE("Actions"), "kIconGitMore", true);
@@ -150,14 +180,65 @@ SourceControlPanel::_InitRepositoryView()
 void
 SourceControlPanel::_InitChangesView()
 {
-	fChangesView = BLayoutBuilder::Group<>(B_HORIZONTAL, B_USE_BORDER_INSETS)
-		.AddGroup(B_VERTICAL)
-			.AddGlue()
-			.Add(new BButton("changes"))
-			.AddGlue()
-		.End()
-		.AddGlue()
-		.View();
+	fChangesListView = new BListView("ChangesListView");
+	fChangesListView->SetInvocationMessage(new BMessage(MsgOpenChangedFile));
+	fChangesView = new BScrollView("Changes scroll view",
+		fChangesListView, B_FRAME_EVENTS | B_WILL_DRAW, true, true, border_style::B_NO_BORDER);
+}
+
+
+// Fills the list from the status the worker keeps up to date for the
+// project, without reading anything from the repository
+void
+SourceControlPanel::_UpdateChangesView()
+{
+	const ProjectFolder* project = _SelectedProject();
+	GitRepository::StatusEntries changes;
+	if (project != nullptr && project->GetGitWorker() != nullptr)
+		project->GetGitWorker()->Status().GetChanges(changes);
+
+	BString selectedPath;
+	const StyledItem* selectedItem
+		= static_cast<StyledItem*>(fChangesListView->ItemAt(fChangesListView->CurrentSelection()));
+	if (selectedItem != nullptr)
+		selectedPath = selectedItem->Text();
+
+	for (int32 i = fChangesListView->CountItems() - 1; i >= 0; i--)
+		delete fChangesListView->RemoveItem(i);
+
+	BList items(changes.size());
+	int32 selection = -1;
+	for (const auto& [path, status] : changes) {
+		StyledItem* item = new StyledItem(path.String());
+		item->SetExtraText(BString("  ") << GitStatusLabel(status));
+		if (path == selectedPath)
+			selection = items.CountItems();
+		items.AddItem(item);
+	}
+	fChangesListView->AddList(&items);
+	if (selection >= 0)
+		fChangesListView->Select(selection);
+}
+
+
+void
+SourceControlPanel::_OpenChangedFile()
+{
+	const ProjectFolder* project = _SelectedProject();
+	const StyledItem* item
+		= static_cast<StyledItem*>(fChangesListView->ItemAt(fChangesListView->CurrentSelection()));
+	if (project == nullptr || item == nullptr)
+		return;
+
+	// untracked folders and deleted files can't be opened
+	const BString path(item->Text());
+	entry_ref ref;
+	if (path.EndsWith("/")
+		|| get_ref_for_path(BPath(project->Path(), path).Path(), &ref) != B_OK)
+		return;
+	BMessage refs(B_REFS_RECEIVED);
+	refs.AddRef("refs", &ref);
+	Window()->PostMessage(&refs);
 }
 
 
@@ -214,8 +295,10 @@ SourceControlPanel::AttachedToWindow()
 		Window()->StartWatching(this, MSG_NOTIFY_PROJECT_LIST_CHANGED);
 		if (gMainWindow != nullptr) {
 			auto projectBrowser = gMainWindow->GetProjectBrowser();
-			if (projectBrowser != nullptr)
+			if (projectBrowser != nullptr) {
 				projectBrowser->StartWatching(this, B_PATH_MONITOR);
+				projectBrowser->StartWatching(this, MSG_NOTIFY_GIT_STATUS_CHANGED);
+			}
 		}
 		be_app->StartWatching(this, gCFG.UpdateMessageWhat());
 		Window()->UnlockLooper();
@@ -225,6 +308,7 @@ SourceControlPanel::AttachedToWindow()
 	fProjectMenu->SetSender(kSenderProjectOptionList);
 	fBranchMenu->SetTarget(this);
 	fToolBar->SetTarget(this);
+	fChangesListView->SetTarget(this);
 	fInitializeButton->SetTarget(this);
 }
 
@@ -236,8 +320,10 @@ SourceControlPanel::DetachedFromWindow()
 		Window()->StopWatching(this, MSG_NOTIFY_PROJECT_LIST_CHANGED);
 		if (gMainWindow != nullptr) {
 			auto projectBrowser = gMainWindow->GetProjectBrowser();
-			if (projectBrowser != nullptr)
+			if (projectBrowser != nullptr) {
 				projectBrowser->StopWatching(this, B_PATH_MONITOR);
+				projectBrowser->StopWatching(this, MSG_NOTIFY_GIT_STATUS_CHANGED);
+			}
 		}
 		be_app->StopWatching(this, gCFG.UpdateMessageWhat());
 		Window()->UnlockLooper();
@@ -259,10 +345,8 @@ SourceControlPanel::MessageReceived(BMessage *message)
 					BString key;
 					if (message->FindString("key", &key) == B_OK
 						&& key == "repository_outline") {
-						if (gMainWindow->GetProjectBrowser()->CountProjects() > 0) {
+						if (gMainWindow->GetProjectBrowser()->CountProjects() > 0)
 							_UpdateBranchListMenu(false);
-							_UpdateRepositoryView();
-						}
 					}
 					break;
 				}
@@ -273,6 +357,7 @@ SourceControlPanel::MessageReceived(BMessage *message)
 						if (gMainWindow->GetProjectBrowser()->CountProjects() == 0) {
 							fBranchMenu->MakeEmpty();
 							fRepositoryView->MakeEmpty();
+							_UpdateChangesView();
 							fMainLayout->SetVisibleItem(kPanelsIndexRepository);
 						} else
 							_UpdateProjectMenu();
@@ -321,6 +406,15 @@ SourceControlPanel::MessageReceived(BMessage *message)
 						_HandleProjectChangedExternalEvent(selected);
 						break;
 					}
+					case MSG_NOTIFY_GIT_STATUS_CHANGED:
+					{
+						const ProjectFolder* selected = _SelectedProject();
+						if (selected != nullptr
+							&& selected->Path() == message->GetString("project_path", "")
+							&& fPanelsLayout->VisibleIndex() == kPanelsIndexChanges)
+							_UpdateChangesView();
+						break;
+					}
 					default:
 						break;
 				}
@@ -340,6 +434,12 @@ SourceControlPanel::MessageReceived(BMessage *message)
 				if (fPanelsLayout->VisibleIndex() != kPanelsIndexChanges)
 					fPanelsLayout->SetVisibleItem(kPanelsIndexChanges);
 				fToolBar->ToggleActionPressed(MsgShowChangesPanel);
+				_UpdateChangesView();
+				break;
+			}
+			case MsgOpenChangedFile:
+			{
+				_OpenChangedFile();
 				break;
 			}
 			case MsgShowLogPanel:
@@ -359,25 +459,15 @@ SourceControlPanel::MessageReceived(BMessage *message)
 				break;
 			}
 			case MsgFetch:
-			{
-				LogInfo("MsgFetch");
-				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
-					break;
-				selectedProject->GetRepository()->Fetch();
-				_ShowGitNotification(B_TRANSLATE("Fetch completed."));
-				_UpdateBranchListMenu();
-				break;
-			}
 			case MsgFetchPrune:
 			{
-				LogInfo("MsgFetchPrune");
+				LogInfo(message->what == MsgFetch ? "MsgFetch" : "MsgFetchPrune");
 				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
 					break;
-				selectedProject->GetRepository()->Fetch(true);
-				_ShowGitNotification(B_TRANSLATE("Fetch prune completed."));
-				_UpdateBranchListMenu();
+				selectedProject->GetGitWorker()->Fetch(BMessenger(this),
+					message->what == MsgFetchPrune);
+				_ShowGitNotification(selectedProject->Path(), B_TRANSLATE("Fetching" B_UTF8_ELLIPSIS));
 				break;
 			}
 			case MsgStashSave:
@@ -391,10 +481,9 @@ SourceControlPanel::MessageReceived(BMessage *message)
 				auto alert = new GTextAlert("Stash", B_TRANSLATE("Enter a message for this stash"),
 					stashMessage, false);
 				auto result = alert->Go();
-				if (result.Button == GAlertButtons::OkButton) {
+				if (result.Button == GAlertButtons::OkButton && selectedProject->GetGitWorker() != nullptr) {
 					stashMessage = result.Result;
-					selectedProject->GetRepository()->StashSave(stashMessage);
-					_ShowGitNotification(B_TRANSLATE("Changes stashed."));
+					selectedProject->GetGitWorker()->StashSave(BMessenger(this), stashMessage);
 				}
 				break;
 			}
@@ -402,20 +491,32 @@ SourceControlPanel::MessageReceived(BMessage *message)
 			{
 				LogInfo("MsgStashPop");
 				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
 					break;
-				selectedProject->GetRepository()->StashPop();
-				_ShowGitNotification(B_TRANSLATE("Stashed changes popped."));
+				selectedProject->GetGitWorker()->StashPop(BMessenger(this));
 				break;
 			}
 			case MsgStashApply:
 			{
 				LogInfo("MsgStashApply");
 				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
 					break;
-				selectedProject->GetRepository()->StashApply();
-				_ShowGitNotification(B_TRANSLATE("Stashed changes applied."));
+				selectedProject->GetGitWorker()->StashApply(BMessenger(this));
+				break;
+			}
+			case MsgCancelGitOperation:
+			{
+				LogInfo("MsgCancelGitOperation");
+				const ProjectFolder* selectedProject = _SelectedProject();
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
+					break;
+				selectedProject->GetGitWorker()->Cancel();
+				break;
+			}
+			case MSG_GIT_JOB_DONE:
+			{
+				_HandleGitJobDone(message);
 				break;
 			}
 			case MsgChangeProject:
@@ -431,17 +532,19 @@ SourceControlPanel::MessageReceived(BMessage *message)
 			case MsgRenameBranch:
 			{
 				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
 					break;
 				BString selectedBranch = message->GetString("value");
 				git_branch_t branchType = static_cast<git_branch_t>(message->GetInt32("type",-1));
 				auto alert = new GTextAlert(B_TRANSLATE("Rename branch"),
 					B_TRANSLATE("Rename branch:"), selectedBranch);
 				auto result = alert->Go();
-				if (result.Button == GAlertButtons::OkButton) {
-					auto repo = selectedProject->GetRepository();
-					repo->RenameBranch(selectedBranch, result.Result, branchType);
-					_UpdateBranchListMenu();
+				// the alert ran a nested loop: the project may be gone
+				selectedProject = _SelectedProject();
+				if (result.Button == GAlertButtons::OkButton && selectedProject != nullptr
+					&& selectedProject->GetGitWorker() != nullptr) {
+					selectedProject->GetGitWorker()->RenameBranch(BMessenger(this),
+						selectedBranch, result.Result, branchType);
 					LogInfo("MsgRenameBranch: %s renamed to %s", selectedBranch.String(),
 						result.Result.String());
 				}
@@ -465,11 +568,12 @@ SourceControlPanel::MessageReceived(BMessage *message)
 					B_WIDTH_AS_USUAL, B_OFFSET_SPACING, B_WARNING_ALERT);
 				alert->SetShortcut(0, B_ESCAPE);
 				int32 choice = alert->Go();
-				if (choice == 1) {
+				selectedProject = _SelectedProject();
+				if (choice == 1 && selectedProject != nullptr
+					&& selectedProject->GetGitWorker() != nullptr) {
 					git_branch_t branchType = static_cast<git_branch_t>(message->GetInt32("type",-1));
-					auto repo = selectedProject->GetRepository();
-					repo->DeleteBranch(selectedBranch, branchType);
-					_UpdateBranchListMenu();
+					selectedProject->GetGitWorker()->DeleteBranch(BMessenger(this),
+						selectedBranch, branchType);
 					LogInfo("MsgDeleteBranch: %s", selectedBranch.String());
 				}
 				break;
@@ -486,27 +590,23 @@ SourceControlPanel::MessageReceived(BMessage *message)
 				auto alert = new GTextAlert(B_TRANSLATE("Create branch"),
 					B_TRANSLATE("New branch name:"), selectedBranch);
 				auto result = alert->Go();
-				if (result.Button == GAlertButtons::OkButton) {
-					auto repo = selectedProject->GetRepository();
-					repo->CreateBranch(selectedBranch, branchType, result.Result);
+				selectedProject = _SelectedProject();
+				if (result.Button == GAlertButtons::OkButton && selectedProject != nullptr
+					&& selectedProject->GetGitWorker() != nullptr) {
+					// the new branch is switched to when the worker created it
+					selectedProject->GetGitWorker()->CreateBranch(BMessenger(this),
+						selectedBranch, branchType, result.Result);
 					LogInfo("MsgNewBranch: %s created from %s", selectedBranch.String(),
 						result.Result.String());
-					GMessage switchMessage{
-						{"what", MsgSwitchBranch},
-						{"value", result.Result},
-						{"type", branchType},
-						{"sender", kSenderRepositoryPopupMenu}};
-					_SwitchBranch(&switchMessage);
 				}
 				break;
 			}
 			case MsgInitializeRepository:
 			{
 				const ProjectFolder* selectedProject = _SelectedProject();
-				if (selectedProject == nullptr)
+				if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
 					break;
-				auto repo = selectedProject->GetRepository();
-				if (!repo->IsInitialized()) {
+				if (!selectedProject->GetGitWorker()->IsRepository()) {
 					auto createInitialCommit = !IsChecked<BCheckBox>(fDoNotCreateInitialCommitCheckBox);
 					if (!createInitialCommit) {
 						BAlert* alert = new BAlert(B_TRANSLATE("Create initial commit"),
@@ -518,13 +618,14 @@ SourceControlPanel::MessageReceived(BMessage *message)
 						int32 choice = alert->Go();
 						if (choice == 0)
 							return;
+						selectedProject = _SelectedProject();
+						if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
+							break;
 					}
-					selectedProject->InitRepository(createInitialCommit);
+					// the panel is updated when the worker is done
+					selectedProject->GetGitWorker()->InitRepository(BMessenger(this),
+						createInitialCommit);
 					SetChecked<BCheckBox>(fDoNotCreateInitialCommitCheckBox, false);
-					BMessage message(MsgChangeProject);
-					message.AddString("value", selectedProject->Path());
-					message.AddString("sender", kSenderInitializeRepositoryButton);
-					BMessenger(this).SendMessage(&message);
 				}
 				break;
 			}
@@ -606,19 +707,17 @@ SourceControlPanel::_ChangeProject(BMessage *message)
 		// check if the project folder still exists
 		if (!BEntry(selectedProject->EntryRef()).Exists())
 			return;
-		// Check if the selected project is a valid git repository
-		auto repo = selectedProject->GetRepository();
-		if (repo->IsInitialized()) {
+		// Check if the selected project is a valid git repository, as the
+		// worker last found
+		GitWorker* worker = selectedProject->GetGitWorker();
+		if (worker != nullptr && worker->IsRepository()) {
 			if (sender == kSenderInitializeRepositoryButton ||
 				sender == kSenderProjectOptionList ||
 				sender == kSenderExternalEvent) {
-				try {
-					_UpdateBranchListMenu(false);
-					_UpdateRepositoryView();
-				} catch (const GitException &ex) {
-					LogInfo(" %s repository has no valid info", selectedProject->Name().String());
-				}
+				_UpdateBranchListMenu(false);
 				fMainLayout->SetVisibleItem(kMainIndexRepository);
+				if (fPanelsLayout->VisibleIndex() == kPanelsIndexChanges)
+					_UpdateChangesView();
 			}
 		} else {
 			fMainLayout->SetVisibleItem(kMainIndexInitialize);
@@ -667,15 +766,15 @@ void
 SourceControlPanel::_SwitchBranch(BMessage *message)
 {
 	const ProjectFolder* project = _SelectedProject();
+	if (project == nullptr || project->GetGitWorker() == nullptr)
+		return;
 	if (project->IsBuilding()) {
 		OKAlert("Source control panel",
 			B_TRANSLATE("The project is building, changing branch not allowed."),
 			B_STOP_ALERT);
 	} else {
 		const BString branch = message->GetString("value");
-		auto repo = project->GetRepository();
-		repo->SwitchBranch(branch);
-		_SetCurrentBranch(project, repo->GetCurrentBranch());
+		project->GetGitWorker()->SwitchBranch(BMessenger(this), branch);
 	}
 }
 
@@ -695,44 +794,147 @@ SourceControlPanel::_UpdateProjectMenu()
 		return;
 
 	// Also update the branch list menu
-	try {
-		GitRepository* repo = project->GetRepository();
-		if (repo->IsInitialized()) {
-			_UpdateBranchListMenu();
-		} else {
-			fMainLayout->SetVisibleItem(kMainIndexInitialize);
-		}
-	} catch (const GitException &ex) {
-		LogError("_UpdateProjectMenu(): %s", ex.Message().String());
-	}
+	GitWorker* worker = project->GetGitWorker();
+	if (worker != nullptr && worker->IsRepository())
+		_UpdateBranchListMenu();
+	else
+		fMainLayout->SetVisibleItem(kMainIndexInitialize);
 }
 
 
 void
 SourceControlPanel::_UpdateBranchListMenu(bool invokeItemMessage)
 {
-	try {
-		const ProjectFolder* selectedProject = _SelectedProject();
-		if (selectedProject != nullptr) {
-			auto repo = selectedProject->GetRepository();
-			if (repo->IsInitialized()) {
-				auto branches = repo->GetBranches();
-				_SetCurrentBranch(selectedProject, repo->GetCurrentBranch());
-				LogInfo("current branch is set to %s", fCurrentBranch.String());
-				fBranchMenu->SetTarget(this);
-				fBranchMenu->SetSender(kSenderBranchOptionList);
+	const ProjectFolder* selectedProject = _SelectedProject();
+	if (selectedProject == nullptr || selectedProject->GetGitWorker() == nullptr)
+		return;
+
+	// the menu is filled when the worker replies
+	fInvokeBranchItem = fInvokeBranchItem || invokeItemMessage;
+	selectedProject->GetGitWorker()->Refresh(BMessenger(this));
+}
+
+
+void
+SourceControlPanel::_FillBranchListMenu(BMessage* message)
+{
+	std::vector<BString> branches;
+	BString branch;
+	for (int32 i = 0; message->FindString("branches", i, &branch) == B_OK; i++)
+		branches.push_back(branch);
+	const bool invokeItemMessage = fInvokeBranchItem;
+	fInvokeBranchItem = false;
+
+	_SetCurrentBranch(_SelectedProject(), message->GetString("current_branch", ""));
+	LogInfo("current branch is set to %s", fCurrentBranch.String());
+	fBranchMenu->SetTarget(this);
+	fBranchMenu->SetSender(kSenderBranchOptionList);
+	fBranchMenu->MakeEmpty();
+	fBranchMenu->AddIterator(branches,
+		MsgSwitchBranch,
+		[](auto &item) { return item; },
+		invokeItemMessage,
+		[&currentBranch = fCurrentBranch](auto &item) { return (item == currentBranch);}
+	);
+	_UpdateRepositoryView();
+}
+
+
+void
+SourceControlPanel::_HandleGitJobDone(BMessage* message)
+{
+	const BString projectPath = message->GetString("project_path", "");
+	const int32 job = message->GetInt32("job", -1);
+	const status_t status = message->GetInt32("status", B_OK);
+	const ProjectFolder* selectedProject = _SelectedProject();
+	const bool selected = selectedProject != nullptr && selectedProject->Path() == projectPath;
+
+	if (message->GetBool("cancelled", false)) {
+		_ShowGitNotification(projectPath, B_TRANSLATE("Git operation cancelled."));
+		return;
+	}
+
+	if (status != B_OK) {
+		const BString error = message->GetString("error", "");
+		if (job == GitWorker::kJobRefresh) {
+			LogInfo("%s repository has no valid info: %s", projectPath.String(), error.String());
+			if (selected) {
 				fBranchMenu->MakeEmpty();
-				fBranchMenu->AddIterator(branches,
-					MsgSwitchBranch,
-					[](auto &item) { return item; },
-					invokeItemMessage,
-					[&currentBranch = fCurrentBranch](auto &item) { return (item == currentBranch);}
-				);
+				_SetCurrentBranch(nullptr, "");
+				if (status == B_NO_INIT)
+					fMainLayout->SetVisibleItem(kMainIndexInitialize);
 			}
+		} else if (message->HasString("files")) {
+			std::vector<BString> files;
+			BString file;
+			for (int32 i = 0; message->FindString("files", i, &file) == B_OK; i++)
+				files.push_back(file);
+			// TODO: Too bad we cannot translate a non-constant expression
+			auto alert = new GitAlert(B_TRANSLATE("Conflicts"), error.String(), files);
+			alert->Go();
+			// in case of conflicts the branch will not change but the item in the OptionList
+			// will so we ask the OptionList to redraw
+			_UpdateBranchListMenu(false);
+		} else {
+			OKAlert("SourceControlPanel", error.String(), B_STOP_ALERT);
+			_UpdateProjectMenu();
 		}
-	} catch (const GitException &ex) {
-		fBranchMenu->MakeEmpty();
-		_SetCurrentBranch(nullptr, "");
+		return;
+	}
+
+	switch (job) {
+		case GitWorker::kJobFetch:
+			_ShowGitNotification(projectPath, B_TRANSLATE("Fetch completed."));
+			_UpdateBranchListMenu();
+			break;
+		case GitWorker::kJobFetchPrune:
+			_ShowGitNotification(projectPath, B_TRANSLATE("Fetch prune completed."));
+			_UpdateBranchListMenu();
+			break;
+		case GitWorker::kJobStashSave:
+			_ShowGitNotification(projectPath, B_TRANSLATE("Changes stashed."));
+			break;
+		case GitWorker::kJobStashPop:
+			_ShowGitNotification(projectPath, B_TRANSLATE("Stashed changes popped."));
+			break;
+		case GitWorker::kJobStashApply:
+			_ShowGitNotification(projectPath, B_TRANSLATE("Stashed changes applied."));
+			break;
+		case GitWorker::kJobSwitchBranch:
+			// the option list already marks the new branch
+			fInvokeBranchItem = false;
+			if (selected)
+				_FillBranchListMenu(message);
+			break;
+		case GitWorker::kJobRefresh:
+			if (selected)
+				_FillBranchListMenu(message);
+			break;
+		case GitWorker::kJobRenameBranch:
+		case GitWorker::kJobDeleteBranch:
+			_UpdateBranchListMenu();
+			break;
+		case GitWorker::kJobCreateBranch:
+		{
+			if (!selected)
+				break;
+			GMessage switchMessage{
+				{"what", MsgSwitchBranch},
+				{"value", message->GetString("branch", "")},
+				{"sender", kSenderRepositoryPopupMenu}};
+			_SwitchBranch(&switchMessage);
+			break;
+		}
+		case GitWorker::kJobInit:
+		{
+			BMessage change(MsgChangeProject);
+			change.AddString("value", projectPath);
+			change.AddString("sender", kSenderInitializeRepositoryButton);
+			BMessenger(this).SendMessage(&change);
+			break;
+		}
+		default:
+			break;
 	}
 }
 
@@ -768,6 +970,14 @@ SourceControlPanel::_ShowOptionsMenu(BPoint where)
 	optionsMenu->AddItem(new BMenuItem(B_TRANSLATE("Stash changes"), new BMessage(MsgStashSave)));
 	optionsMenu->AddItem(new BMenuItem(B_TRANSLATE("Stash pop changes"), new BMessage(MsgStashPop)));
 	optionsMenu->AddItem(new BMenuItem(B_TRANSLATE("Stash apply changes"), new BMessage(MsgStashApply)));
+
+	const ProjectFolder* project = _SelectedProject();
+	optionsMenu->AddSeparatorItem();
+	BMenuItem* cancelItem = new BMenuItem(B_TRANSLATE("Cancel git operation"),
+		new BMessage(MsgCancelGitOperation));
+	cancelItem->SetEnabled(project != nullptr && project->GetGitWorker() != nullptr
+		&& project->GetGitWorker()->IsBusy());
+	optionsMenu->AddItem(cancelItem);
 	optionsMenu->SetTargetForItems(this);
 	optionsMenu->Go(fToolBar->ConvertToScreen(where), true);
 	delete optionsMenu;
@@ -775,14 +985,11 @@ SourceControlPanel::_ShowOptionsMenu(BPoint where)
 
 
 void
-SourceControlPanel::_ShowGitNotification(const BString &text)
+SourceControlPanel::_ShowGitNotification(const BString& projectPath, const BString &text)
 {
-	const ProjectFolder* project = _SelectedProject();
-	if (project == nullptr)
+	if (projectPath.IsEmpty())
 		return;
-	ShowNotification("Genio", project->Path().String(),
-		project->Path().String(),
-		text);
+	ShowNotification("Genio", projectPath.String(), projectPath.String(), text);
 }
 
 
@@ -35,7 +35,9 @@ enum Messages {
 	MsgNewBranch,
 	MsgNewTag,
 	MsgInitializeRepository,
-	MsgCopyRefName
+	MsgCopyRefName,
+	MsgCancelGitOperation,
+	MsgOpenChangedFile
 };
 
 
@@ -46,6 +48,7 @@ const char* const kSenderRepositoryPopupMenu = "RepositoryPopupMenu";
 const char* const kSenderExternalEvent = "ExternalEvent";
 
 class BCheckBox;
+class BListView;
 class ProjectFolder;
 class RepositoryView;
 class BScrollView;
@@ -68,27 +71,35 @@ private:
 	RepositoryView*			fRepositoryView;
 	BScrollView*			fRepositoryViewScroll;
 	BView*					fChangesView;
+	BListView*				fChangesListView;
 	BView*					fLogView;
 	BView*					fRepositoryNotInitializedView;
 	BString					fCurrentBranch;
 	BButton*				fInitializeButton;
 	BCheckBox*				fDoNotCreateInitialCommitCheckBox;
 	BMessageRunner*			fBurstHandler;
+	// whether the branch menu invokes the current branch once refreshed
+	bool					fInvokeBranchItem;
 
 	const ProjectFolder*	_SelectedProject() const;
 
 	void					_UpdateProjectMenu();
 	void					_UpdateBranchListMenu(bool invokeItemMessage = true);
+	void					_FillBranchListMenu(BMessage* message);
+	void					_HandleGitJobDone(BMessage* message);
 
 	void					_InitToolBar();
 	void					_InitRepositoryView();
 	void					_UpdateRepositoryView();
 	void					_InitChangesView();
+	void					_UpdateChangesView();
+	void					_OpenChangedFile();
 	void					_InitLogView();
 	void					_InitRepositoryNotInitializedView();
 
 	void					_ShowOptionsMenu(BPoint where);
-	void					_ShowGitNotification(const BString& text);
+	void					_ShowGitNotification(const BString& projectPath,
+								const BString& text);
 
 	void					_ChangeProject(BMessage *message);
 	void					_SwitchBranch(BMessage *message);
@@ -13,7 +13,8 @@
 
 #include "GenioApp.h"
 #include "GenioWindow.h"
-#include "GitRepository.h"
+#include "GitWorker.h"
+#include "ProjectBrowser.h"
 #include "ProjectFolder.h"
 
 
@@ -86,24 +87,25 @@ SwitchBranchMenu::_BuildMenu(const BString& projectPath)
 	int32 count = CountItems();
 	RemoveItems(0, count, true);
 
-	if (!projectPath.IsEmpty()) {
-		Genio::Git::GitRepository* repo = nullptr;
-		try {
-			repo = new Genio::Git::GitRepository(projectPath);
-			auto branches = repo->GetBranches();
-			auto current_branch = repo->GetCurrentBranch();
-			for(auto &branch : branches) {
-				BMessage *message = new BMessage(fMessage->what);
-				message->AddString("branch", branch);
-				message->AddString("project_path", projectPath);
-				auto item = new BMenuItem(branch, message);
-				AddItem(item);
-				if (branch == current_branch)
-					item->SetMarked(true);
-			}
-		} catch(...) {
+	const ProjectFolder* project = projectPath.IsEmpty() ? nullptr
+		: gMainWindow->GetProjectBrowser()->ProjectByPath(projectPath);
+	if (project != nullptr && project->GetGitWorker() != nullptr) {
+		// what the git worker read last time: it is asked to read again,
+		// without waiting for it
+		Genio::Git::GitWorker* worker = project->GetGitWorker();
+		std::vector<BString> branches;
+		BString currentBranch;
+		worker->GetBranches(branches, currentBranch);
+		worker->Refresh(BMessenger());
+		for (auto &branch : branches) {
+			BMessage *message = new BMessage(fMessage->what);
+			message->AddString("branch", branch);
+			message->AddString("project_path", projectPath);
+			auto item = new BMenuItem(branch, message);
+			AddItem(item);
+			if (branch == currentBranch)
+				item->SetMarked(true);
 		}
-		delete repo;
 	}
 	return count > 0;
 }
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "FindInFilesEngine.h"
+
+#include <Autolock.h>
+#include <Entry.h>
+#include <Message.h>
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "Log.h"
+#include "ProjectWalker.h"
+#include "TrigramIndex.h"
+
+
+// grep -I: a NUL byte in the first block marks the file as binary
+static constexpr size_t kBinaryProbeSize = 32 * 1024;
+static constexpr size_t kMapThreshold = 256 * 1024;
+// longer lines are truncated in the results
+static constexpr size_t kMaxLineLength = B_PATH_NAME_LENGTH * 2;
+static constexpr int32 kMaxWorkers = 16;
+static constexpr bigtime_t kSendTimeout = 100000;
+
+
+static inline bool
+IsWordChar(unsigned char c)
+{
+	// bytes of multibyte UTF-8 sequences count as word characters
+	return c == '_' || c >= 0x80 || isalnum(c);
+}
+
+
+FindInFilesEngine::FindInFilesEngine(const Options& options,
+	const BMessenger& target, int32 searchId)
+	:
+	fOptions(options),
+	fFinder(options.text.String(), options.caseSensitive),
+	fTarget(target),
+	fSearchId(searchId),
+	fCoordinator(-1),
+	fQueueLock("FindInFiles queue"),
+	fQueueSem(-1),
+	fWalkDone(false),
+	fCancelled(false),
+	fFilesScanned(0),
+	fFilesMatched(0),
+	fLinesMatched(0)
+{
+}
+
+
+FindInFilesEngine::~FindInFilesEngine()
+{
+	Cancel();
+	if (fCoordinator >= 0) {
+		status_t result;
+		wait_for_thread(fCoordinator, &result);
+	}
+	if (fQueueSem >= 0)
+		delete_sem(fQueueSem);
+}
+
+
+status_t
+FindInFilesEngine::Start()
+{
+	if (fFinder.Length() == 0)
+		return B_BAD_VALUE;
+
+	fQueueSem = create_sem(0, "FindInFiles queue");
+	if (fQueueSem < 0)
+		return fQueueSem;
+
+	fCoordinator = spawn_thread(_CoordinatorEntry, "FindInFiles coordinator",
+		B_LOW_PRIORITY, this);
+	if (fCoordinator < 0)
+		return fCoordinator;
+
+	return resume_thread(fCoordinator);
+}
+
+
+void
+FindInFilesEngine::Cancel()
+{
+	if (fCancelled.exchange(true))
+		return;
+	// wake up the workers waiting on an empty queue
+	if (fQueueSem >= 0)
+		release_sem_etc(fQueueSem, kMaxWorkers, 0);
+}
+
+
+/* static */
+status_t
+FindInFilesEngine::_CoordinatorEntry(void* cookie)
+{
+	static_cast<FindInFilesEngine*>(cookie)->_Coordinate();
+	return B_OK;
+}
+
+
+/* static */
+status_t
+FindInFilesEngine::_WorkerEntry(void* cookie)
+{
+	static_cast<FindInFilesEngine*>(cookie)->_Work();
+	return B_OK;
+}
+
+
+void
+FindInFilesEngine::_Coordinate()
+{
+	bigtime_t startTime = system_time();
+
+	system_info info;
+	int32 workerCount = 2;
+	if (get_system_info(&info) == B_OK)
+		workerCount = std::clamp((int32)info.cpu_count, (int32)1, kMaxWorkers);
+
+	for (int32 i = 0; i < workerCount; i++) {
+		thread_id worker = spawn_thread(_WorkerEntry, "FindInFiles worker",
+			B_LOW_PRIORITY, this);
+		if (worker < 0)
+			break;
+		fWorkers.push_back(worker);
+		resume_thread(worker);
+	}
+
+	if (fWorkers.empty()) {
+		LogError("FindInFiles: can't spawn any worker");
+	} else {
+		std::vector<std::string> candidates;
+		if (fOptions.index != nullptr && fOptions.index->Query(fOptions.text,
+				fOptions.excludeDirectories, fOptions.useGitIgnore, candidates)) {
+			for (std::string& path : candidates)
+				_Enqueue(std::move(path));
+		} else {
+			ProjectWalker walker(fOptions.rootPath, fOptions.excludeDirectories,
+				fOptions.useGitIgnore);
+			walker.Walk([this](std::string&& path, const struct stat&) {
+				_Enqueue(std::move(path));
+			}, fCancelled);
+		}
+	}
+
+	fQueueLock.Lock();
+	fWalkDone = true;
+	fQueueLock.Unlock();
+	release_sem_etc(fQueueSem, fWorkers.size(), 0);
+
+	for (thread_id worker : fWorkers) {
+		status_t result;
+		wait_for_thread(worker, &result);
+	}
+
+	LogInfo("FindInFiles: %d lines in %d files (%d scanned) in %.3f s%s",
+		(int32)fLinesMatched, (int32)fFilesMatched, (int32)fFilesScanned,
+		(system_time() - startTime) / 1000000.0, fCancelled ? ", cancelled" : "");
+
+	BMessage done(MSG_GREP_DONE);
+	done.AddInt32("search_id", fSearchId);
+	done.AddBool("cancelled", fCancelled);
+	_Send(&done);
+}
+
+
+// The window may be deleting this engine and joining its threads: the
+// target's port is never waited on once the search is cancelled
+void
+FindInFilesEngine::_Send(BMessage* message)
+{
+	while (fTarget.SendMessage(message, (BHandler*)nullptr, kSendTimeout) == B_TIMED_OUT
+		&& !fCancelled) {
+	}
+}
+
+
+void
+FindInFilesEngine::_Work()
+{
+	std::string path;
+	std::vector<char> buffer;
+	while (_Dequeue(path))
+		_ScanFile(path, buffer);
+}
+
+
+void
+FindInFilesEngine::_Enqueue(std::string path)
+{
+	fQueueLock.Lock();
+	fQueue.push_back(std::move(path));
+	fQueueLock.Unlock();
+	release_sem(fQueueSem);
+}
+
+
+bool
+FindInFilesEngine::_Dequeue(std::string& path)
+{
+	while (!fCancelled) {
+		if (acquire_sem(fQueueSem) != B_OK)
+			return false;
+		BAutolock lock(fQueueLock);
+		if (fCancelled)
+			return false;
+		if (!fQueue.empty()) {
+			path = std::move(fQueue.front());
+			fQueue.pop_front();
+			return true;
+		}
+		if (fWalkDone)
+			return false;
+	}
+	return false;
+}
+
+
+bool
+FindInFilesEngine::_IsWholeWord(const char* match, const char* start,
+	const char* end) const
+{
+	if (match > start && IsWordChar(match[-1]))
+		return false;
+	const char* after = match + fFinder.Length();
+	return after >= end || !IsWordChar(*after);
+}
+
+
+void
+FindInFilesEngine::_ScanFile(const std::string& path, std::vector<char>& buffer)
+{
+	if (fCancelled)
+		return;
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return;
+	}
+	const size_t size = st.st_size;
+
+	// mapping costs more than a copy for the small files making up most
+	// of a source tree
+	if (size <= kMapThreshold) {
+		buffer.resize(size);
+		ssize_t bytesRead = read(fd, buffer.data(), size);
+		close(fd);
+		if (bytesRead > 0)
+			_ScanBuffer(path, buffer.data(), bytesRead);
+		return;
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		return;
+	_ScanBuffer(path, (const char*)mapping, size);
+	munmap(mapping, size);
+}
+
+
+void
+FindInFilesEngine::_ScanBuffer(const std::string& path, const char* data, size_t size)
+{
+	fFilesScanned++;
+
+	const char* end = data + size;
+	if (memchr(data, '\0', std::min(size, kBinaryProbeSize)) != nullptr)
+		return;
+
+	BMessage result(MSG_REPORT_RESULT);
+	entry_ref ref;
+	int32 lineNumber = 1;
+	const char* lineCursor = data;
+	const char* p = data;
+	while (!fCancelled) {
+		const char* match = fFinder.Find(p, end);
+		if (match == nullptr)
+			break;
+		if (fOptions.wholeWord && !_IsWholeWord(match, data, end)) {
+			p = match + 1;
+			continue;
+		}
+
+		const char* newLine;
+		while ((newLine = (const char*)memchr(lineCursor, '\n', match - lineCursor)) != nullptr) {
+			lineNumber++;
+			lineCursor = newLine + 1;
+		}
+		const char* lineEnd = (const char*)memchr(match, '\n', end - match);
+		if (lineEnd == nullptr)
+			lineEnd = end;
+
+		size_t length = lineEnd - lineCursor;
+		if (length > 0 && lineCursor[length - 1] == '\r')
+			length--;
+		if (length > kMaxLineLength) {
+			length = kMaxLineLength;
+			// don't cut a UTF-8 sequence
+			while (length > 0 && (lineCursor[length] & 0xC0) == 0x80)
+				length--;
+		}
+
+		if (result.IsEmpty()) {
+			get_ref_for_path(path.c_str(), &ref);
+			result.AddInt32("search_id", fSearchId);
+			result.AddString("filename", path.c_str());
+		}
+
+		BString text;
+		text << lineNumber << ":";
+		text.Append(lineCursor, length);
+
+		BMessage line(B_REFS_RECEIVED);
+		line.AddString("text", text);
+		line.AddRef("refs", &ref);
+		line.AddInt32("start:line", lineNumber);
+		result.AddMessage("line", &line);
+		fLinesMatched++;
+
+		if (lineEnd == end)
+			break;
+		// one result per line, as grep does
+		p = lineCursor = lineEnd + 1;
+		lineNumber++;
+	}
+
+	if (!result.IsEmpty() && !fCancelled) {
+		fFilesMatched++;
+		_Send(&result);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Locker.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <String.h>
+
+#include "StringFinder.h"
+
+class TrigramIndex;
+
+enum {
+	MSG_REPORT_RESULT = 'mrre',
+	MSG_GREP_DONE = 'mgrd'
+};
+
+// In-process replacement for the "grep -IFHrn" pipeline.
+// A coordinator thread queues the files, walking the project or taking the
+// candidates of its TrigramIndex, a pool of workers reads and scans them. Each file with matches is reported
+// to the target as a MSG_REPORT_RESULT message ("filename" plus one "line"
+// message per matching line), MSG_GREP_DONE closes the search.
+// Every message carries the "search_id" given to the constructor.
+
+class FindInFilesEngine {
+public:
+	struct Options {
+		BString	text;
+		BString	rootPath;
+		BString	excludeDirectories;	// comma separated globs, as grep --exclude-dir
+		bool	wholeWord = false;
+		bool	caseSensitive = false;
+		bool	useGitIgnore = true;
+		// when set, only the candidates returned by the index are read
+		std::shared_ptr<TrigramIndex>	index;
+	};
+
+					FindInFilesEngine(const Options& options,
+						const BMessenger& target, int32 searchId);
+					~FindInFilesEngine();
+
+		status_t	Start();
+		void		Cancel();
+		bool		IsCancelled() const { return fCancelled; }
+
+private:
+	static	status_t	_CoordinatorEntry(void* cookie);
+	static	status_t	_WorkerEntry(void* cookie);
+
+		void		_Coordinate();
+		void		_Work();
+		void		_Enqueue(std::string path);
+		bool		_Dequeue(std::string& path);
+		void		_ScanFile(const std::string& path, std::vector<char>& buffer);
+		void		_ScanBuffer(const std::string& path, const char* data,
+						size_t size);
+		bool		_IsWholeWord(const char* match, const char* start,
+						const char* end) const;
+		void		_Send(BMessage* message);
+
+		Options			fOptions;
+		StringFinder	fFinder;
+		BMessenger		fTarget;
+		int32			fSearchId;
+
+		thread_id		fCoordinator;
+		std::vector<thread_id>	fWorkers;
+
+		BLocker			fQueueLock;
+		sem_id			fQueueSem;
+		std::deque<std::string>	fQueue;
+		bool			fWalkDone;
+
+		std::atomic<bool>	fCancelled;
+		std::atomic<int32>	fFilesScanned;
+		std::atomic<int32>	fFilesMatched;
+		std::atomic<int32>	fLinesMatched;
+};
@@ -9,10 +9,12 @@
 #include <algorithm>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 
 #include <Catalog.h>
 #include <Directory.h>
+#include <Entry.h>
 #include <FindDirectory.h>
 #include <Path.h>
 #include <String.h>
@@ -112,26 +114,133 @@ Languages::SortAlphabetically()
 
 
 /**
- * Reads YAML files from all data directories and creates a single style map,
- * where repeated keys are overridden.
+ * Compiled languages/<lang>.yaml files, one layer per data directory where
+ * the file exists, applied in order like the files used to be.
+ * Profiles are shared by all the editors and compiled again when one of
+ * the files is changed, added or removed.
+ */
+struct Languages::Profile {
+	struct Layer {
+		LexerLibrary*	library = nullptr;
+		std::string		lexerName;
+		std::vector<std::pair<std::string, std::string>>	properties;
+		std::vector<std::pair<int, std::string>>			keywords;
+		// lexem class id, identifiers of each of its substyles
+		std::vector<std::pair<int, std::vector<std::string>>>	identifiers;
+		bool			hasCommentLine = false;
+		std::string		commentLine;
+		bool			hasCommentBlock = false;
+		std::string		commentBlockStart;
+		std::string		commentBlockEnd;
+		std::map<int, int>	styles;
+		// lexem class id, Koder style ids of its substyles
+		std::vector<std::pair<int, std::vector<int>>>	substyles;
+	};
+
+	// the files looked up, with their modification time (0 when missing)
+	std::vector<std::pair<std::string, time_t>>	sources;
+	std::vector<Layer>	layers;
+};
+
+
+std::map<std::string, std::shared_ptr<const Languages::Profile>>	Languages::sProfiles;
+
+
+namespace {
+
+time_t
+ModificationTime(const char* path)
+{
+	time_t modified = 0;
+	BEntry(path).GetModificationTime(&modified);
+	return modified;
+}
+
+}
+
+
+/**
+ * Sets up the lexer of the editor and returns a single style map, where
+ * keys repeated in the user data directory override the system ones.
  */
 /* static */ std::map<int, int>
 Languages::ApplyLanguage(Editor* editor, const char* lang)
 {
 	editor->SendMessage(SCI_FREESUBSTYLES);
 	std::map<int, int> styleMapping;
-	DoInAllDataDirectories([&](const BPath& path) {
-			try {
-				auto m = _ApplyLanguage(editor, lang, path);
-				m.merge(styleMapping);
-				std::swap(styleMapping, m);
-			} catch (const YAML::BadFile &) {}
-		});
+	const std::shared_ptr<const Profile> profile = _GetProfile(lang);
+	for (const Profile::Layer& layer : profile->layers) {
+		// the lexer holds the properties, keywords and substyles:
+		// every editor needs its own
+		Scintilla::ILexer5* lexer = layer.library->CreateLexer(layer.lexerName.c_str());
+		if (lexer == nullptr)
+			continue;
+		editor->SendMessage(SCI_SETILEXER, 0, reinterpret_cast<sptr_t>(lexer));
+
+		for (const auto& property : layer.properties) {
+			editor->SendMessage(SCI_SETPROPERTY, (uptr_t) property.first.c_str(),
+				(sptr_t) property.second.c_str());
+		}
+
+		for (const auto& keyword : layer.keywords)
+			editor->SendMessage(SCI_SETKEYWORDS, keyword.first, (sptr_t) keyword.second.c_str());
+
+		std::unordered_map<int, int> substyleStartMap;
+		for (const auto& id : layer.identifiers) {
+			// TODO: allocate only once
+			const int start = editor->SendMessage(SCI_ALLOCATESUBSTYLES,
+				id.first, id.second.size());
+			substyleStartMap.emplace(id.first, start);
+			int i = 0;
+			for (const std::string& idents : id.second) {
+				editor->SendMessage(SCI_SETIDENTIFIERS, start + i++,
+					reinterpret_cast<sptr_t>(idents.c_str()));
+			}
+		}
+
+		if (layer.hasCommentLine)
+			editor->SetCommentLineToken(layer.commentLine);
+		if (layer.hasCommentBlock)
+			editor->SetCommentBlockTokens(layer.commentBlockStart, layer.commentBlockEnd);
+
+		std::map<int, int> styleMap = layer.styles;
+		for (const auto& id : layer.substyles) {
+			const int substyleStart = substyleStartMap[id.first];
+			int i = 0;
+			for (int styleId : id.second)
+				styleMap.emplace(substyleStart + i++, styleId);
+		}
+		styleMap.merge(styleMapping);
+		std::swap(styleMapping, styleMap);
+	}
 	return styleMapping;
 }
 
+
+/* static */ std::shared_ptr<const Languages::Profile>
+Languages::_GetProfile(const char* lang)
+{
+	auto it = sProfiles.find(lang);
+	if (it != sProfiles.end()) {
+		bool upToDate = true;
+		for (const auto& source : it->second->sources) {
+			if (ModificationTime(source.first.c_str()) != source.second) {
+				upToDate = false;
+				break;
+			}
+		}
+		if (upToDate)
+			return it->second;
+	}
+
+	std::shared_ptr<const Profile> profile = _CompileProfile(lang);
+	sProfiles[lang] = profile;
+	return profile;
+}
+
+
 /**
- * Loads YAML file with language specification:
+ * Compiles the YAML files with the language specification:
  *   lexer: string (required)
  *   properties: (string|string) map -> SCI_SETPROPERTY
  *   keywords: (index(int)|string) map -> SCI_SETKEYWORDS
@@ -152,107 +261,96 @@ Languages::ApplyLanguage(Editor* editor, const char* lang)
  * These are then passed to SCI_SETIDENTIFIERS and merged into regular styles
  * map to be handled by the Styler class.
  */
-/* static */ std::map<int, int>
-Languages::_ApplyLanguage(Editor* editor, const char* lang, const BPath &path)
+/* static */ std::shared_ptr<const Languages::Profile>
+Languages::_CompileProfile(const char* lang)
 {
-	if(sLexerLibraries.empty() == true)
-		return {};
-	// TODO: early exit if lexer not changed
-
-	BPath p = path;
-	p.Append("languages");
-	p.Append(lang);
-	BString fileName(p.Path());
-	fileName.Append(".yaml");
-	if (!BEntry(fileName.String()).Exists()) {
-		// TODO: Workaround for a bug in Haiku x86_32: exceptions
-		// thrown inside yaml_cpp aren't catchable. We throw this exception
-		// inside Genio and that works.
-		throw YAML::BadFile(fileName.String());
-	}
-	const YAML::Node language = YAML::LoadFile(std::string(p.Path()) + ".yaml");
-	std::string lexerName = language["lexer"].as<std::string>();
-	Scintilla::ILexer5* lexer;
-	// sLexerLibraries contains libraries in the following order:
-	// * system
-	// * user
-	// * non-packaged system
-	// * non-packaged user
-	// Going in reverse results in correct override hierarchy.
-	for(auto it = sLexerLibraries.rbegin(); it != sLexerLibraries.rend(); ++it) {
-		lexer = (*it)->CreateLexer(lexerName.c_str());
-		if(lexer != nullptr)
-			break;
-	}
-
-	if(lexer == nullptr)
-		return std::map<int, int>();
-
-	editor->SendMessage(SCI_SETILEXER, 0, reinterpret_cast<sptr_t>(lexer));
+	auto profile = std::make_shared<Profile>();
+	DoInAllDataDirectories([&](const BPath& path) {
+		BPath p = path;
+		p.Append("languages");
+		p.Append(lang);
+		const std::string fileName = std::string(p.Path()) + ".yaml";
+		const time_t modified = ModificationTime(fileName.c_str());
+		profile->sources.emplace_back(fileName, modified);
+		// Checking first is also a workaround for a bug in Haiku x86_32:
+		// exceptions thrown inside yaml_cpp aren't catchable.
+		if (modified == 0 || sLexerLibraries.empty())
+			return;
 
-	for(const auto& property : language["properties"]) {
-		auto name = property.first.as<std::string>();
-		auto value = property.second.as<std::string>();
-		editor->SendMessage(SCI_SETPROPERTY, (uptr_t) name.c_str(), (sptr_t) value.c_str());
-	}
+		const YAML::Node language = YAML::LoadFile(fileName);
+		Profile::Layer layer;
+		layer.lexerName = language["lexer"].as<std::string>();
+		// sLexerLibraries contains libraries in the following order:
+		// * system
+		// * user
+		// * non-packaged system
+		// * non-packaged user
+		// Going in reverse results in correct override hierarchy.
+		for (auto it = sLexerLibraries.rbegin(); it != sLexerLibraries.rend(); ++it) {
+			Scintilla::ILexer5* lexer = (*it)->CreateLexer(layer.lexerName.c_str());
+			if (lexer != nullptr) {
+				lexer->Release();
+				layer.library = it->get();
+				break;
+			}
+		}
+		if (layer.library == nullptr)
+			return;
 
-	for(const auto& keyword : language["keywords"]) {
-		auto num = keyword.first.as<int>();
-		auto words = keyword.second.as<std::string>();
-		editor->SendMessage(SCI_SETKEYWORDS, num, (sptr_t) words.c_str());
-	}
+		for (const auto& property : language["properties"]) {
+			layer.properties.emplace_back(property.first.as<std::string>(),
+				property.second.as<std::string>());
+		}
 
-	std::unordered_map<int, int> substyleStartMap;
-	const auto& identifiers = language["identifiers"];
-	if(identifiers && identifiers.IsMap()) {
-		for(const auto& id : identifiers) {
-			if(!id.second.IsSequence())
-				continue;
+		for (const auto& keyword : language["keywords"]) {
+			layer.keywords.emplace_back(keyword.first.as<int>(),
+				keyword.second.as<std::string>());
+		}
 
-			const int substyleId = id.first.as<int>();
-			// TODO: allocate only once
-			const int start = editor->SendMessage(SCI_ALLOCATESUBSTYLES,
-				substyleId, id.second.size());
-			substyleStartMap.emplace(substyleId, start);
-			int i = 0;
-			for(const auto& idents : id.second) {
-				editor->SendMessage(SCI_SETIDENTIFIERS, start + i++,
-					reinterpret_cast<sptr_t>(idents.as<std::string>().c_str()));
+		const YAML::Node& identifiers = language["identifiers"];
+		if (identifiers && identifiers.IsMap()) {
+			for (const auto& id : identifiers) {
+				if (!id.second.IsSequence())
+					continue;
+				std::vector<std::string> idents;
+				for (const auto& ident : id.second)
+					idents.push_back(ident.as<std::string>());
+				layer.identifiers.emplace_back(id.first.as<int>(), std::move(idents));
 			}
 		}
-	}
-
-	const YAML::Node comments = language["comments"];
-
-	if(comments) {
-		const YAML::Node line = comments["line"];
-		if(line)
-			editor->SetCommentLineToken(line.as<std::string>());
-		const YAML::Node block = comments["block"];
-		if(block && block.IsSequence())
-			editor->SetCommentBlockTokens(block[0].as<std::string>(),
-				block[1].as<std::string>());
-	}
 
-	std::map<int, int> styleMap;
-	const YAML::Node styles = language["styles"];
-	if(styles) {
-		styleMap = styles.as<std::map<int, int>>();
-	}
-	const YAML::Node substyles = language["substyles"];
-	if(substyles && substyles.IsMap()) {
-		for(const auto& id : substyles) {
-			if(!id.second.IsSequence())
-				continue;
+		const YAML::Node comments = language["comments"];
+		if (comments) {
+			const YAML::Node line = comments["line"];
+			if (line) {
+				layer.hasCommentLine = true;
+				layer.commentLine = line.as<std::string>();
+			}
+			const YAML::Node block = comments["block"];
+			if (block && block.IsSequence()) {
+				layer.hasCommentBlock = true;
+				layer.commentBlockStart = block[0].as<std::string>();
+				layer.commentBlockEnd = block[1].as<std::string>();
+			}
+		}
 
-			int i = 0;
-			for(const auto& styleId : id.second) {
-				const int substyleStart = substyleStartMap[id.first.as<int>()];
-				styleMap.emplace(substyleStart + i++, styleId.as<int>());
+		const YAML::Node styles = language["styles"];
+		if (styles)
+			layer.styles = styles.as<std::map<int, int>>();
+		const YAML::Node substyles = language["substyles"];
+		if (substyles && substyles.IsMap()) {
+			for (const auto& id : substyles) {
+				if (!id.second.IsSequence())
+					continue;
+				layer.substyles.emplace_back(id.first.as<int>(),
+					id.second.as<std::vector<int>>());
 			}
 		}
-	}
-	return styleMap;
+
+		profile->layers.push_back(std::move(layer));
+	});
+	LogInfo("Language profile [%s] compiled: %d files", lang, (int)profile->layers.size());
+	return profile;
 }
 
 
@@ -8,6 +8,7 @@
 
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,11 +28,15 @@ public:
 	static	void								LoadLanguages();
 
 private:
+	struct Profile;
+
 	static	void								_LoadLanguages(const BPath& path);
-	static	std::map<int, int>					_ApplyLanguage(Editor* editor, const char* lang, const BPath &path);
+	static	std::shared_ptr<const Profile>		_GetProfile(const char* lang);
+	static	std::shared_ptr<const Profile>		_CompileProfile(const char* lang);
 	static	std::vector<std::string>			sLanguages;
 	static	std::map<std::string, std::string>	sMenuItems;
 	static	std::map<std::string, std::string> 	sExtensions;
+	static	std::map<std::string, std::shared_ptr<const Profile>>	sProfiles;
 };
 
 
@@ -0,0 +1,422 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "PathIndex.h"
+
+#include <Autolock.h>
+
+#include <ctype.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "Log.h"
+
+
+static constexpr int32 kScoreMatch = 16;
+static constexpr int32 kBonusSegmentStart = 10;	// after a '/'
+static constexpr int32 kBonusWordStart = 8;		// after '_', '-', '.' or ' '
+static constexpr int32 kBonusCamelCase = 7;
+static constexpr int32 kBonusConsecutive = 5;
+static constexpr int32 kBonusInName = 3;
+static constexpr int32 kPenaltyGapStart = 3;
+static constexpr int32 kPenaltyGapExtension = 1;
+
+
+static inline char
+FoldCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+static inline uint64
+CharacterBit(uint8 c)
+{
+	if (c >= 'a' && c <= 'z')
+		return 1ULL << (c - 'a');
+	if (c >= '0' && c <= '9')
+		return 1ULL << (26 + c - '0');
+	switch (c) {
+		case '.':
+			return 1ULL << 36;
+		case '_':
+			return 1ULL << 37;
+		case '-':
+			return 1ULL << 38;
+		case '/':
+			return 1ULL << 39;
+		default:
+			// shared bits: the mask may let a path through, the scorer decides
+			return 1ULL << (40 + c % 24);
+	}
+}
+
+
+static uint64
+CharacterMask(const char* string, int32 length)
+{
+	uint64 mask = 0;
+	for (int32 i = 0; i < length; i++)
+		mask |= CharacterBit(string[i]);
+	return mask;
+}
+
+
+// Scores the shortest window, starting at from, holding the query letters
+// in order. Same idea as fzf: a greedy forward pass finds where the first
+// match ends, a backward pass from there finds the latest start.
+static int32
+ScoreWindow(const char* path, const char* folded, int32 length, int32 nameStart,
+	const char* query, int32 queryLength, int32 from)
+{
+	int32 q = 0;
+	int32 end = -1;
+	for (int32 i = from; i < length; i++) {
+		if (folded[i] == query[q] && ++q == queryLength) {
+			end = i;
+			break;
+		}
+	}
+	if (end < 0)
+		return 0;
+
+	int32 start = end;
+	q = queryLength - 1;
+	for (int32 i = end; i >= from; i--) {
+		if (folded[i] == query[q] && --q < 0) {
+			start = i;
+			break;
+		}
+	}
+
+	int32 score = 0;
+	int32 last = -1;
+	int32 consecutive = 0;
+	q = 0;
+	for (int32 i = start; i <= end && q < queryLength; i++) {
+		if (folded[i] != query[q])
+			continue;
+
+		int32 bonus = 0;
+		const char previous = i > 0 ? path[i - 1] : '/';
+		if (previous == '/')
+			bonus = kBonusSegmentStart;
+		else if (previous == '_' || previous == '-' || previous == '.' || previous == ' ')
+			bonus = kBonusWordStart;
+		else if (islower((unsigned char)previous) && isupper((unsigned char)path[i]))
+			bonus = kBonusCamelCase;
+
+		if (last >= 0 && last == i - 1) {
+			consecutive++;
+			bonus = std::max(bonus, kBonusConsecutive * consecutive);
+		} else {
+			consecutive = 0;
+			if (last >= 0)
+				score -= kPenaltyGapStart + kPenaltyGapExtension * (i - last - 2);
+		}
+		if (i >= nameStart)
+			bonus += kBonusInName;
+
+		score += kScoreMatch + bonus;
+		last = i;
+		q++;
+	}
+
+	// between equal matches, the shorter path wins
+	score -= length / 16;
+	return std::max(score, (int32)1);
+}
+
+
+PathIndex::PathIndex(const BString& rootPath)
+	:
+	fRootPath(rootPath),
+	fLock("PathIndex"),
+	fRemovedCount(0),
+	fThread(-1),
+	fWakeUp(-1),
+	fPendingLock("PathIndex pending"),
+	fQuitting(false)
+{
+	if (fRootPath.EndsWith("/") && fRootPath.Length() > 1)
+		fRootPath.Truncate(fRootPath.Length() - 1);
+}
+
+
+PathIndex::~PathIndex()
+{
+	fQuitting = true;
+	if (fThread >= 0) {
+		release_sem(fWakeUp);
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+	if (fWakeUp >= 0)
+		delete_sem(fWakeUp);
+}
+
+
+status_t
+PathIndex::Start(const BString& excludeDirectories, bool useGitIgnore)
+{
+	if (fThread >= 0)
+		return B_BUSY;
+
+	fWalker.reset(new ProjectWalker(fRootPath, excludeDirectories, useGitIgnore));
+
+	fWakeUp = create_sem(0, "PathIndex wake up");
+	if (fWakeUp < 0)
+		return fWakeUp;
+
+	fThread = spawn_thread(_ThreadEntry, "PathIndex", B_LOW_PRIORITY, this);
+	if (fThread < 0)
+		return fThread;
+
+	return resume_thread(fThread);
+}
+
+
+// Called by the window thread: the event is only queued
+void
+PathIndex::Update(const BString& path)
+{
+	if (fThread < 0 || path.Length() <= fRootPath.Length() + 1)
+		return;
+
+	BAutolock lock(fPendingLock);
+	fPending.push_back(path.String());
+	release_sem(fWakeUp);
+}
+
+
+/* static */
+status_t
+PathIndex::_ThreadEntry(void* cookie)
+{
+	static_cast<PathIndex*>(cookie)->_Run();
+	return B_OK;
+}
+
+
+void
+PathIndex::_Run()
+{
+	bigtime_t startTime = system_time();
+	fWalker->Walk([this](std::string&& path, const struct stat&) {
+		BAutolock lock(fLock);
+		_Add(path);
+	}, fQuitting);
+
+	LogInfo("PathIndex: %d paths of '%s' listed in %.2f ms, %.1f KiB",
+		CountPaths(), fRootPath.String(), (system_time() - startTime) / 1000.0,
+		(fPaths.size() * 2 + fMasks.size() * 16) / 1024.0);
+
+	// the events queued during the walk are applied now: a path already
+	// listed is not added twice
+	while (!fQuitting) {
+		if (acquire_sem(fWakeUp) != B_OK)
+			break;
+
+		std::vector<std::string> pending;
+		{
+			BAutolock lock(fPendingLock);
+			pending.swap(fPending);
+		}
+		// many events may arrive together: drop the extra wake ups
+		int32 count;
+		if (get_sem_count(fWakeUp, &count) == B_OK && count > 0)
+			acquire_sem_etc(fWakeUp, count, B_RELATIVE_TIMEOUT, 0);
+
+		for (const std::string& path : pending) {
+			if (fQuitting)
+				break;
+			_Apply(path);
+		}
+	}
+}
+
+
+void
+PathIndex::_Apply(const std::string& path)
+{
+	struct stat st;
+	if (lstat(path.c_str(), &st) != 0) {
+		BAutolock lock(fLock);
+		_Remove(path.substr(fRootPath.Length() + 1));
+	} else if (S_ISDIR(st.st_mode)) {
+		if (fWalker->IsExcluded(path, true))
+			return;
+		// walked without the lock, Search() can go on meanwhile
+		std::vector<std::string> files;
+		fWalker->Walk([&files](std::string&& file, const struct stat&) {
+			files.push_back(std::move(file));
+		}, fQuitting, path);
+		BAutolock lock(fLock);
+		for (const std::string& file : files)
+			_Add(file);
+	} else if (S_ISREG(st.st_mode) && !fWalker->IsExcluded(path, false)) {
+		BAutolock lock(fLock);
+		_Add(path);
+	}
+}
+
+
+int32
+PathIndex::CountPaths() const
+{
+	BAutolock lock(fLock);
+	return fMasks.size() - fRemovedCount;
+}
+
+
+void
+PathIndex::Search(const BString& query, int32 maxResults,
+	std::vector<Match>& matches) const
+{
+	std::string folded;
+	for (int32 i = 0; i < query.Length(); i++) {
+		if (query[i] != ' ')
+			folded.push_back(FoldCase(query[i]));
+	}
+	if (folded.empty() || maxResults <= 0)
+		return;
+
+	const uint64 queryMask = CharacterMask(folded.c_str(), folded.length());
+
+	BAutolock lock(fLock);
+	const uint32 count = fMasks.size();
+	const uint64* masks = fMasks.data();
+
+	std::vector<std::pair<int32, uint32>> scored;
+	for (uint32 i = 0; i < count; i++) {
+		if ((masks[i] & queryMask) != queryMask)
+			continue;
+		const uint32 offset = fOffsets[i];
+		const int32 score = Score(fPaths.data() + offset, fFolded.data() + offset,
+			fLengths[i], fNameStarts[i], folded.c_str(), folded.length());
+		if (score > 0)
+			scored.emplace_back(score, i);
+	}
+
+	auto better = [this](const std::pair<int32, uint32>& a, const std::pair<int32, uint32>& b) {
+		if (a.first != b.first)
+			return a.first > b.first;
+		return strcmp(fPaths.data() + fOffsets[a.second], fPaths.data() + fOffsets[b.second]) < 0;
+	};
+	if (scored.size() > (size_t)maxResults) {
+		std::nth_element(scored.begin(), scored.begin() + maxResults, scored.end(), better);
+		scored.resize(maxResults);
+	}
+	std::sort(scored.begin(), scored.end(), better);
+
+	for (const auto& [score, i] : scored) {
+		Match match;
+		match.score = score;
+		match.path.assign(fRootPath.String()).append("/").append(fPaths.data() + fOffsets[i]);
+		match.nameStart = fRootPath.Length() + 1 + fNameStarts[i];
+		matches.push_back(std::move(match));
+	}
+}
+
+
+/* static */
+int32
+PathIndex::Score(const char* path, const char* folded, int32 length, int32 nameStart,
+	const char* query, int32 queryLength)
+{
+	if (queryLength == 0 || queryLength > length)
+		return 0;
+
+	int32 score = ScoreWindow(path, folded, length, nameStart, query, queryLength, 0);
+	// the first window may start in a folder, while the file name matches too
+	if (score > 0 && nameStart > 0 && queryLength <= length - nameStart) {
+		score = std::max(score, ScoreWindow(path, folded, length, nameStart, query,
+			queryLength, nameStart));
+	}
+	return score;
+}
+
+
+void
+PathIndex::_Add(const std::string& path)
+{
+	std::string relativePath(path, fRootPath.Length() + 1);
+	auto inserted = fIds.emplace(std::move(relativePath), fMasks.size());
+	if (!inserted.second)
+		return;
+
+	const char* relative = inserted.first->first.c_str();
+	const int32 length = inserted.first->first.length();
+	const char* leaf = strrchr(relative, '/');
+	fOffsets.push_back(fPaths.size());
+	fLengths.push_back(length);
+	fNameStarts.push_back(leaf != nullptr ? leaf - relative + 1 : 0);
+	fPaths.insert(fPaths.end(), relative, relative + length + 1);
+	for (int32 i = 0; i <= length; i++)
+		fFolded.push_back(FoldCase(relative[i]));
+	fMasks.push_back(CharacterMask(fFolded.data() + fOffsets.back(), length));
+}
+
+
+void
+PathIndex::_Remove(const std::string& relativePath)
+{
+	auto found = fIds.find(relativePath);
+	if (found != fIds.end()) {
+		fMasks[found->second] = 0;
+		fRemovedCount++;
+		fIds.erase(found);
+	} else {
+		// a folder went away: the entries below it
+		const int32 length = relativePath.length();
+		for (uint32 i = 0; i < fMasks.size(); i++) {
+			if (fMasks[i] == 0 || fLengths[i] <= length)
+				continue;
+			const char* path = fPaths.data() + fOffsets[i];
+			if (path[length] == '/' && memcmp(path, relativePath.c_str(), length) == 0) {
+				fMasks[i] = 0;
+				fRemovedCount++;
+				fIds.erase(std::string(path, fLengths[i]));
+			}
+		}
+	}
+	if (fRemovedCount > 1024 && fRemovedCount > fMasks.size() / 2)
+		_Compact();
+}
+
+
+void
+PathIndex::_Compact()
+{
+	std::vector<char> paths;
+	std::vector<char> folded;
+	std::vector<uint64> masks;
+	std::vector<uint32> offsets;
+	std::vector<uint16> lengths;
+	std::vector<uint16> nameStarts;
+	for (uint32 i = 0; i < fMasks.size(); i++) {
+		if (fMasks[i] == 0)
+			continue;
+		const uint32 offset = fOffsets[i];
+		fIds[std::string(fPaths.data() + offset, fLengths[i])] = masks.size();
+		offsets.push_back(paths.size());
+		paths.insert(paths.end(), fPaths.begin() + offset,
+			fPaths.begin() + offset + fLengths[i] + 1);
+		folded.insert(folded.end(), fFolded.begin() + offset,
+			fFolded.begin() + offset + fLengths[i] + 1);
+		masks.push_back(fMasks[i]);
+		lengths.push_back(fLengths[i]);
+		nameStarts.push_back(fNameStarts[i]);
+	}
+	fPaths.swap(paths);
+	fFolded.swap(folded);
+	fMasks.swap(masks);
+	fOffsets.swap(offsets);
+	fLengths.swap(lengths);
+	fNameStarts.swap(nameStarts);
+	fRemovedCount = 0;
+}
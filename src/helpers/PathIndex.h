@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Locker.h>
+#include <OS.h>
+#include <String.h>
+
+#include "ProjectWalker.h"
+
+// Flat list of the files of a project, for the Quick open panel.
+// The paths are packed one after the other in a single buffer, with a
+// case folded copy and a bitmask of the characters used by each of them,
+// so a query runs over contiguous arrays: the masks discard most of the
+// paths, the fuzzy scorer ranks the others.
+// The list is filled by a background walk and kept in sync with the path
+// monitor events forwarded with Update(), applied by the same thread.
+
+class PathIndex {
+public:
+	struct Match {
+		int32		score;
+		std::string	path;		// absolute
+		int32		nameStart;	// offset of the leaf in path
+	};
+
+					PathIndex(const BString& rootPath);
+					~PathIndex();
+
+		status_t	Start(const BString& excludeDirectories, bool useGitIgnore);
+		void		Update(const BString& path);
+
+		int32		CountPaths() const;
+		// Appends the best maxResults paths matching query, best first
+		void		Search(const BString& query, int32 maxResults,
+						std::vector<Match>& matches) const;
+
+	// 0 if the query letters are not found in order in path
+	static	int32	Score(const char* path, const char* folded, int32 length,
+						int32 nameStart, const char* query, int32 queryLength);
+
+private:
+	static	status_t	_ThreadEntry(void* cookie);
+		void		_Run();
+		void		_Apply(const std::string& path);
+		void		_Add(const std::string& path);
+		void		_Remove(const std::string& relativePath);
+		void		_Compact();
+
+		BString		fRootPath;
+		mutable BLocker	fLock;	// guards the paths
+		std::unique_ptr<ProjectWalker>	fWalker;
+
+		std::vector<char>	fPaths;		// relative paths, NUL terminated
+		std::vector<char>	fFolded;	// the same, lower case
+		std::vector<uint64>	fMasks;		// characters used, 0 when removed
+		std::vector<uint32>	fOffsets;
+		std::vector<uint16>	fLengths;
+		std::vector<uint16>	fNameStarts;
+		std::unordered_map<std::string, uint32>	fIds;	// of the paths not removed
+		uint32		fRemovedCount;
+
+		thread_id	fThread;
+		sem_id		fWakeUp;
+		BLocker		fPendingLock;
+		std::vector<std::string>	fPending;
+		std::atomic<bool>	fQuitting;
+};
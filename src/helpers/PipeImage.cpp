@@ -11,6 +11,7 @@
 
 #include <cerrno>
 #include <cstdlib>
+#include <fcntl.h>
 #include <image.h>
 #include <unistd.h>
 
@@ -19,6 +20,17 @@
 // lock access play with stdin/stdout
 BLocker* PipeImage::sLockStdFilesPntr = new BLocker ("Std-In-Out Changed Lock");
 
+// Closes the fd once, even if called again or by another thread: a fd
+// closed twice may by then belong to another pipe of this team.
+static void
+CloseOnce(int& fd)
+{
+	const int closing = __atomic_exchange_n(&fd, -1, __ATOMIC_SEQ_CST);
+	if (closing >= 0)
+		close(closing);
+}
+
+
 status_t
 PipeImage::Init(const char **argv, int32 argc, bool dupStdErr, bool resume)
 {
@@ -82,34 +94,25 @@ PipeImage::Init(const char **argv, int32 argc, bool dupStdErr, bool resume)
 	}
 
 	dup2(fInPipe[WRITE_END], STDOUT_FILENO);
-	close(fInPipe[WRITE_END]);
+	CloseOnce(fInPipe[WRITE_END]);
 	dup2(fOutPipe[READ_END], STDIN_FILENO);
-	close(fOutPipe[READ_END]);
+	CloseOnce(fOutPipe[READ_END]);
 
 	if (fDupStdErr) {
 		dup2(fErrPipe[WRITE_END], STDERR_FILENO);
-		close(fErrPipe[WRITE_END]);
+		CloseOnce(fErrPipe[WRITE_END]);
 	}
 
 	status_t stat = B_OK;
 	fChildpid = load_image(argc, argv, const_cast<const char **>(environ));
 	if (fChildpid < 0) {
-		if (fDupStdErr) {
-			close(fErrPipe[READ_END]);
-		}
-		close(fOutPipe[WRITE_END]);
-		close(fInPipe[READ_END]);
+		Close();
 		stat = fChildpid;
 	} else {
 		setpgid(fChildpid, fChildpid);
 		if (resume)
 			resume_thread (fChildpid); // rock'n'roll!
 	}
-	if (fDupStdErr) {
-		close(fErrPipe[WRITE_END]);
-	}
-	close(fOutPipe[READ_END]);
-	close(fInPipe[WRITE_END]);
 
 	sLockStdFilesPntr->Lock();
 
@@ -127,11 +130,11 @@ PipeImage::Init(const char **argv, int32 argc, bool dupStdErr, bool resume)
 void
 PipeImage::Close()
 {
-	close(fOutPipe[WRITE_END]);
+	CloseOnce(fOutPipe[WRITE_END]);
 	if (fDupStdErr) {
-		close(fErrPipe[READ_END]);
+		CloseOnce(fErrPipe[READ_END]);
 	}
-	close(fInPipe[READ_END]);
+	CloseOnce(fInPipe[READ_END]);
 }
 
 
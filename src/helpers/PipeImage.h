@@ -34,9 +34,9 @@ public:
 	int GetStdInFD() const { return fOutPipe[WRITE_END]; };
 
 protected:
-	pid_t fChildpid;
-	int fOutPipe[2];
-	int fInPipe[2];
-	int fErrPipe[2];
-	bool fDupStdErr;
+	pid_t fChildpid = -1;
+	int fOutPipe[2] = { -1, -1 };
+	int fInPipe[2] = { -1, -1 };
+	int fErrPipe[2] = { -1, -1 };
+	bool fDupStdErr = false;
 };
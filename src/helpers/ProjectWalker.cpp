@@ -0,0 +1,281 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "ProjectWalker.h"
+
+#include <dirent.h>
+#include <fnmatch.h>
+#include <string.h>
+
+#include <fstream>
+
+
+struct GitIgnoreRule {
+	std::string	pattern;
+	bool		negate = false;
+	bool		directoryOnly = false;
+	bool		anchored = false;
+};
+
+
+struct ProjectWalker::IgnoreRules {
+	// directory holding the .gitignore, relative to the root, with a
+	// trailing slash ("" for the root itself)
+	std::string					base;
+	std::vector<GitIgnoreRule>	rules;
+
+	bool Load(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+			return false;
+
+		std::string line;
+		while (std::getline(file, line)) {
+			while (!line.empty() && (line.back() == ' ' || line.back() == '\t'
+					|| line.back() == '\r'))
+				line.pop_back();
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			GitIgnoreRule rule;
+			if (line[0] == '!') {
+				rule.negate = true;
+				line.erase(0, 1);
+			} else if (line[0] == '\\') {
+				line.erase(0, 1);
+			}
+			if (!line.empty() && line.back() == '/') {
+				rule.directoryOnly = true;
+				line.pop_back();
+			}
+			if (line.compare(0, 3, "**/") == 0 && line.find('/', 3) == std::string::npos)
+				line.erase(0, 3);
+			rule.anchored = line.find('/') != std::string::npos;
+			if (!line.empty() && line[0] == '/')
+				line.erase(0, 1);
+			if (line.empty())
+				continue;
+			rule.pattern = line;
+			rules.push_back(rule);
+		}
+		return !rules.empty();
+	}
+};
+
+
+ProjectWalker::ProjectWalker(const BString& rootPath,
+	const BString& excludeDirectories, bool useGitIgnore)
+	:
+	fRootPath(rootPath),
+	fExcludeDirectories(excludeDirectories),
+	fUseGitIgnore(useGitIgnore)
+{
+	if (fRootPath.EndsWith("/") && fRootPath.Length() > 1)
+		fRootPath.Truncate(fRootPath.Length() - 1);
+
+	int32 start = 0;
+	while (start <= fExcludeDirectories.Length()) {
+		int32 end = fExcludeDirectories.FindFirst(",", start);
+		if (end < 0)
+			end = fExcludeDirectories.Length();
+		BString glob;
+		fExcludeDirectories.CopyInto(glob, start, end - start);
+		glob.Trim();
+		if (!glob.IsEmpty())
+			fExcludeGlobs.push_back(glob);
+		start = end + 1;
+	}
+}
+
+
+void
+ProjectWalker::Walk(const Visitor& visit, const std::atomic<bool>& cancelled,
+	const std::string& directory) const
+{
+	std::string root(fRootPath.String());
+	RuleChain rules;
+	_EnterRoot(rules);
+
+	if (directory.empty() || directory == root) {
+		_Walk(root, rules, visit, cancelled);
+		return;
+	}
+
+	// rebuild the rules of the folders between the root and directory
+	if (directory.compare(0, root.length() + 1, root + "/") != 0)
+		return;
+	size_t slash = root.length();
+	while (slash != std::string::npos) {
+		slash = directory.find('/', slash + 1);
+		const std::string path = directory.substr(0, slash);
+		const char* name = strrchr(path.c_str(), '/') + 1;
+		if (strcmp(name, ".git") == 0 || _IsExcludedDirectory(name)
+			|| _IsIgnored(path, true, rules))
+			return;
+		_EnterDirectory(path, rules);
+	}
+	_Walk(directory, rules, visit, cancelled);
+}
+
+
+bool
+ProjectWalker::IsExcluded(const std::string& path, bool isDirectory) const
+{
+	std::string root(fRootPath.String());
+	if (path.compare(0, root.length() + 1, root + "/") != 0)
+		return true;
+
+	RuleChain rules;
+	_EnterRoot(rules);
+
+	size_t slash = root.length();
+	while (true) {
+		size_t next = path.find('/', slash + 1);
+		const std::string current = path.substr(0, next);
+		const bool directory = next != std::string::npos || isDirectory;
+		const char* name = current.c_str() + slash + 1;
+		if (directory && (strcmp(name, ".git") == 0 || _IsExcludedDirectory(name)))
+			return true;
+		if (_IsIgnored(current, directory, rules))
+			return true;
+		if (next == std::string::npos)
+			return false;
+		_EnterDirectory(current, rules);
+		slash = next;
+	}
+}
+
+
+const BString
+ProjectWalker::Fingerprint() const
+{
+	BString fingerprint(fExcludeDirectories);
+	fingerprint << (fUseGitIgnore ? "|gitignore" : "|all");
+	return fingerprint;
+}
+
+
+void
+ProjectWalker::_Walk(const std::string& path, RuleChain& rules,
+	const Visitor& visit, const std::atomic<bool>& cancelled) const
+{
+	DIR* dir = opendir(path.c_str());
+	if (dir == nullptr)
+		return;
+
+	std::vector<std::string> subDirectories;
+	while (dirent* entry = readdir(dir)) {
+		if (cancelled)
+			break;
+		const char* name = entry->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			continue;
+
+		std::string child(path);
+		child.append("/").append(name);
+
+		// like grep -r, symlinks met while recursing are not followed
+		struct stat st;
+		if (lstat(child.c_str(), &st) != 0 || S_ISLNK(st.st_mode))
+			continue;
+
+		if (S_ISDIR(st.st_mode)) {
+			if (strcmp(name, ".git") == 0 || _IsExcludedDirectory(name)
+				|| _IsIgnored(child, true, rules))
+				continue;
+			subDirectories.push_back(std::move(child));
+		} else if (S_ISREG(st.st_mode) && st.st_size > 0) {
+			if (!_IsIgnored(child, false, rules))
+				visit(std::move(child), st);
+		}
+	}
+	closedir(dir);
+
+	for (const std::string& subDirectory : subDirectories) {
+		if (cancelled)
+			return;
+		const bool pushed = _EnterDirectory(subDirectory, rules);
+		_Walk(subDirectory, rules, visit, cancelled);
+		if (pushed)
+			rules.pop_back();
+	}
+}
+
+
+void
+ProjectWalker::_EnterRoot(RuleChain& rules) const
+{
+	if (!fUseGitIgnore)
+		return;
+
+	const std::string root(fRootPath.String());
+	auto rootRules = std::make_shared<IgnoreRules>();
+	bool loaded = rootRules->Load(root + "/.git/info/exclude");
+	loaded = rootRules->Load(root + "/.gitignore") || loaded;
+	if (loaded)
+		rules.push_back(rootRules);
+}
+
+
+bool
+ProjectWalker::_EnterDirectory(const std::string& path, RuleChain& rules) const
+{
+	if (!fUseGitIgnore)
+		return false;
+
+	auto directoryRules = std::make_shared<IgnoreRules>();
+	if (!directoryRules->Load(path + "/.gitignore"))
+		return false;
+	directoryRules->base = path.substr(fRootPath.Length() + 1) + "/";
+	rules.push_back(directoryRules);
+	return true;
+}
+
+
+bool
+ProjectWalker::_IsExcludedDirectory(const char* name) const
+{
+	for (const BString& glob : fExcludeGlobs) {
+		if (fnmatch(glob.String(), name, 0) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+bool
+ProjectWalker::_IsIgnored(const std::string& path, bool isDirectory,
+	const RuleChain& rules) const
+{
+	if (rules.empty())
+		return false;
+
+	const std::string relative = path.substr(fRootPath.Length() + 1);
+	const char* leaf = strrchr(path.c_str(), '/') + 1;
+
+	// the last matching rule wins, deeper .gitignore files come last
+	bool ignored = false;
+	for (const auto& set : rules) {
+		const char* local = relative.c_str() + set->base.length();
+		for (const GitIgnoreRule& rule : set->rules) {
+			if (rule.directoryOnly && !isDirectory)
+				continue;
+			if (rule.negate != ignored)
+				continue;
+			bool match;
+			if (rule.anchored) {
+				int flags = rule.pattern.find("**") == std::string::npos ? FNM_PATHNAME : 0;
+				match = fnmatch(rule.pattern.c_str(), local, flags) == 0;
+			} else {
+				match = fnmatch(rule.pattern.c_str(), leaf, 0) == 0;
+			}
+			if (match)
+				ignored = !rule.negate;
+		}
+	}
+	return ignored;
+}
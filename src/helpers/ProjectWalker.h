@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <String.h>
+
+#include <sys/stat.h>
+
+// Walks the files of a project the way "Find in project" sees them:
+// symlinks are not followed, .git and the folders matching the
+// find_exclude_directory globs are pruned and, optionally, the entries
+// listed in .gitignore files and .git/info/exclude are skipped.
+
+class ProjectWalker {
+public:
+	typedef std::function<void(std::string&& path, const struct stat& st)> Visitor;
+
+					ProjectWalker(const BString& rootPath,
+						const BString& excludeDirectories, bool useGitIgnore);
+
+		// visits the non empty regular files below directory, the root if empty
+		void		Walk(const Visitor& visit, const std::atomic<bool>& cancelled,
+						const std::string& directory = "") const;
+
+		// whether a path below the root would be skipped by Walk()
+		bool		IsExcluded(const std::string& path, bool isDirectory) const;
+
+	const BString&	RootPath() const { return fRootPath; }
+	// identifies the settings, for the caches built from a walk
+	const BString	Fingerprint() const;
+
+private:
+	struct IgnoreRules;
+	typedef std::vector<std::shared_ptr<IgnoreRules>> RuleChain;
+
+		void		_Walk(const std::string& path, RuleChain& rules,
+						const Visitor& visit, const std::atomic<bool>& cancelled) const;
+		void		_EnterRoot(RuleChain& rules) const;
+		bool		_EnterDirectory(const std::string& path, RuleChain& rules) const;
+		bool		_IsExcludedDirectory(const char* name) const;
+		bool		_IsIgnored(const std::string& path, bool isDirectory,
+						const RuleChain& rules) const;
+
+		BString					fRootPath;
+		BString					fExcludeDirectories;
+		std::vector<BString>	fExcludeGlobs;
+		bool					fUseGitIgnore;
+};
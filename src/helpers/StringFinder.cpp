@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "StringFinder.h"
+
+#include <ctype.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+
+static const ptrdiff_t kBlockSize = 4096;
+
+
+static inline char
+FoldCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+StringFinder::StringFinder(const char* text, bool caseSensitive)
+	:
+	fNeedle(text),
+	fCaseSensitive(caseSensitive)
+{
+	if (!fCaseSensitive)
+		std::transform(fNeedle.begin(), fNeedle.end(), fNeedle.begin(), FoldCase);
+}
+
+
+const char*
+StringFinder::Find(const char* start, const char* end) const
+{
+	const size_t length = fNeedle.length();
+	if (length == 0 || (size_t)(end - start) < length)
+		return nullptr;
+	// last position where a match can begin
+	const char* limit = end - length + 1;
+	const char first = fNeedle[0];
+
+	// memchr() is vectorized by libc: use it to jump to the candidates
+	if (fCaseSensitive) {
+		const char* p = start;
+		while (p < limit) {
+			p = (const char*)memchr(p, first, limit - p);
+			if (p == nullptr)
+				return nullptr;
+			if (memcmp(p + 1, fNeedle.c_str() + 1, length - 1) == 0)
+				return p;
+			p++;
+		}
+		return nullptr;
+	}
+
+	// Both cases are looked for a block at a time, and the upper one only up
+	// to the next lower candidate: searching the whole buffer for a case
+	// which isn't there would make each call linear in the rest of the buffer.
+	const char upper = toupper((unsigned char)first);
+	const char* p = start;
+	while (p < limit) {
+		const char* blockEnd = limit - p > kBlockSize ? p + kBlockSize : limit;
+		const char* candidate = (const char*)memchr(p, first, blockEnd - p);
+		if (upper != first) {
+			const char* upperCandidate = (const char*)memchr(p, upper,
+				(candidate != nullptr ? candidate : blockEnd) - p);
+			if (upperCandidate != nullptr)
+				candidate = upperCandidate;
+		}
+		if (candidate == nullptr) {
+			p = blockEnd;
+			continue;
+		}
+
+		size_t i = 1;
+		while (i < length && FoldCase(candidate[i]) == fNeedle[i])
+			i++;
+		if (i == length)
+			return candidate;
+		p = candidate + 1;
+	}
+	return nullptr;
+}
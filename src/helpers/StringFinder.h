@@ -0,0 +1,23 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <string>
+
+// Finds a string in a buffer as grep -F does, optionally ignoring the case
+// of the ASCII letters.
+class StringFinder {
+public:
+					StringFinder(const char* text, bool caseSensitive);
+
+		size_t		Length() const { return fNeedle.length(); }
+
+		// the first match in [start, end), nullptr if none
+		const char*	Find(const char* start, const char* end) const;
+
+private:
+		std::string	fNeedle;	// case folded if not fCaseSensitive
+		bool		fCaseSensitive;
+};
@@ -13,6 +13,7 @@
 #include <Alert.h>
 #include <Catalog.h>
 #include <Directory.h>
+#include <Entry.h>
 #include <FindDirectory.h>
 #include <Font.h>
 #include <Path.h>
@@ -83,54 +84,69 @@ struct convert<Styler::Style> {
 }
 
 
-std::unordered_map<int, Styler::Style>	Styler::sStylesMapping;
+// A compiled styles/<style>.yaml file
+struct Styler::Layer {
+	struct Entry {
+		std::string	name;
+		int			id;
+		Style		style;
+	};
+	bool				hasDefault = false;
+	Style				defaultStyle;
+	// the entries of the "Global" map, in file order
+	std::vector<Entry>	global;
+	// the style ids of the other entries
+	std::vector<std::pair<int, Style>>	styles;
+};
 
 
-/* static */ void
-Styler::ApplyGlobal(BScintillaView* editor, const char* style, const BFont* font)
+// The style files found in the data directories, compiled once and shared
+// by all the editors until one of the files changes.
+struct Styler::Profile {
+	// the files looked up, with their modification time (0 when missing)
+	std::vector<std::pair<BString, time_t>>	sources;
+	std::vector<Layer>				layers;
+	std::unordered_map<int, Style>	stylesMapping;
+};
+
+
+std::map<std::string, std::shared_ptr<const Styler::Profile>>	Styler::sProfiles;
+std::shared_ptr<const Styler::Profile>	Styler::sGlobalProfile;
+
+
+namespace {
+
+time_t
+ModificationTime(const char* path)
 {
-	sStylesMapping.clear();
-	try {
-		_ApplyGlobal(editor, style, GetDataDirectory(), font);
-	} catch (const YAML::BadFile &) {
-	}
-	try {
-		_ApplyGlobal(editor, style, GetUserSettingsDirectory(), font);
-	} catch (const YAML::BadFile &) {
-	}
+	time_t modified = 0;
+	BEntry(path).GetModificationTime(&modified);
+	return modified;
+}
+
 }
 
 
 /* static */ void
-Styler::_ApplyGlobal(BScintillaView* editor, const char* style, const BPath &path, const BFont* font)
+Styler::ApplyGlobal(BScintillaView* editor, const char* style, const BFont* font)
 {
-	BString fullpath = _FullStylePath(style, path);
-	const YAML::Node styles = YAML::LoadFile(fullpath.String());
-	YAML::Node global;
-	if (styles["Global"]) {
-		global = styles["Global"];
-	}
-
-	_ApplyDefaultStyle(editor, global, font);
-	_ApplyBasicStyle(editor, global);
-
-	int id;
-	Style s;
-	for(const auto &node : global) {
-		std::string name = node.first.as<std::string>();
-		_GetAttributesFromNode(node.second, id, s);
-		if (id != -1) {
-			_ApplyAttributes(editor, id, s);
-			sStylesMapping.emplace(id, s);
-		} else {
-			if (name == "Fold") {
+	sGlobalProfile = _GetProfile(style);
+	for (const Layer& layer : sGlobalProfile->layers) {
+		_ApplyDefaultStyle(editor, layer, font);
+		_ApplyBasicStyle(editor, layer);
+
+		for (const Layer::Entry& entry : layer.global) {
+			const Style& s = entry.style;
+			if (entry.id != -1) {
+				_ApplyAttributes(editor, entry.id, s);
+			} else if (entry.name == "Fold") {
 				if (s.fgColor != -1) {
 					editor->SendMessage(SCI_SETFOLDMARGINHICOLOUR, true, s.fgColor);
 				}
 				if (s.bgColor != -1) {
 					editor->SendMessage(SCI_SETFOLDMARGINCOLOUR, true, s.bgColor);
 				}
-			} else if (name == "Fold marker") {
+			} else if (entry.name == "Fold marker") {
 				std::array<int32, 7> markers = {
 					SC_MARKNUM_FOLDER,
 					SC_MARKNUM_FOLDEROPEN,
@@ -148,7 +164,7 @@ Styler::_ApplyGlobal(BScintillaView* editor, const char* style, const BPath &pat
 						editor->SendMessage(SCI_MARKERSETBACK, marker, s.bgColor);
 					}
 				}
-			} else if (name == "Bookmark marker") {
+			} else if (entry.name == "Bookmark marker") {
 				if (s.fgColor != -1) {
 					editor->SendMessage(SCI_MARKERSETFORE, sci_BOOKMARK, s.fgColor);
 				}
@@ -158,12 +174,80 @@ Styler::_ApplyGlobal(BScintillaView* editor, const char* style, const BPath &pat
 			}
 		}
 	}
-	for (const auto& style : styles) {
-		if (style.first.as<std::string>() == "Global")
+}
+
+
+/* static */ std::shared_ptr<const Styler::Profile>
+Styler::_GetProfile(const char* style)
+{
+	auto it = sProfiles.find(style);
+	if (it != sProfiles.end()) {
+		bool upToDate = true;
+		for (const auto& source : it->second->sources) {
+			if (ModificationTime(source.first.String()) != source.second) {
+				upToDate = false;
+				break;
+			}
+		}
+		if (upToDate)
+			return it->second;
+	}
+
+	std::shared_ptr<const Profile> profile = _CompileProfile(style);
+	sProfiles[style] = profile;
+	return profile;
+}
+
+
+/* static */ std::shared_ptr<const Styler::Profile>
+Styler::_CompileProfile(const char* style)
+{
+	auto profile = std::make_shared<Profile>();
+	const BPath directories[] = { GetDataDirectory(), GetUserSettingsDirectory() };
+	for (const BPath& directory : directories) {
+		BPath p(directory);
+		p.Append("styles");
+		p.Append(style);
+		BString fileName(p.Path());
+		fileName.Append(".yaml");
+		const time_t modified = ModificationTime(fileName.String());
+		profile->sources.emplace_back(fileName, modified);
+		// Checking first is also a workaround for a bug in Haiku x86_32:
+		// exceptions thrown inside yaml_cpp aren't catchable.
+		if (modified == 0)
 			continue;
-		_GetAttributesFromNode(style.second, id, s);
-		sStylesMapping.emplace(id, s);
+
+		const YAML::Node styles = YAML::LoadFile(fileName.String());
+		Layer layer;
+		YAML::Node global;
+		if (styles["Global"]) {
+			global = styles["Global"];
+		}
+		if (global["Default"]) {
+			int id;
+			layer.hasDefault = true;
+			_GetAttributesFromNode(global["Default"], id, layer.defaultStyle);
+		}
+		for (const auto &node : global) {
+			Layer::Entry entry;
+			entry.name = node.first.as<std::string>();
+			_GetAttributesFromNode(node.second, entry.id, entry.style);
+			if (entry.id != -1)
+				profile->stylesMapping.emplace(entry.id, entry.style);
+			layer.global.push_back(entry);
+		}
+		for (const auto& node : styles) {
+			if (node.first.as<std::string>() == "Global")
+				continue;
+			int id;
+			Style s;
+			_GetAttributesFromNode(node.second, id, s);
+			layer.styles.emplace_back(id, s);
+			profile->stylesMapping.emplace(id, s);
+		}
+		profile->layers.push_back(std::move(layer));
 	}
+	return profile;
 }
 
 
@@ -205,42 +289,20 @@ Styler::ApplySystemStyle(BScintillaView* editor)
 /* static */ void
 Styler::ApplyBasicStyle(BScintillaView* editor, const char* style, const BFont* font)
 {
-	try {
-		_ApplyBasicStyle(editor, style, GetDataDirectory(), font);
-	} catch (const YAML::BadFile &) {
-	}
-	try {
-		_ApplyBasicStyle(editor, style, GetUserSettingsDirectory(), font);
-	} catch (const YAML::BadFile &) {
+	const std::shared_ptr<const Profile> profile = _GetProfile(style);
+	for (const Layer& layer : profile->layers) {
+		_ApplyDefaultStyle(editor, layer, font);
+		_ApplyBasicStyle(editor, layer);
 	}
 }
 
 
-/* static */
 void
-Styler::_ApplyBasicStyle(BScintillaView* editor, const char* style, const BPath &path, const BFont* font)
+Styler::_ApplyBasicStyle(BScintillaView* editor, const Layer& layer)
 {
-	BString fullpath = _FullStylePath(style, path);
-	const YAML::Node styles = YAML::LoadFile(fullpath.String());
-	YAML::Node global;
-	if (styles["Global"]) {
-		global = styles["Global"];
-	}
-
-	_ApplyDefaultStyle(editor, global, font);
-	_ApplyBasicStyle(editor, global);
-
-}
-
-
-void
-Styler::_ApplyBasicStyle(BScintillaView* editor, YAML::Node& global)
-{
-	int id;
-	Style s;
-	for (const auto &node : global) {
-		std::string name = node.first.as<std::string>();
-		_GetAttributesFromNode(node.second, id, s);
+	for (const Layer::Entry& entry : layer.global) {
+		const std::string& name = entry.name;
+		const Style& s = entry.style;
 
 		if (name == "Current line") {
 			editor->SendMessage(SCI_SETCARETLINEBACK, s.bgColor, 0);
@@ -269,21 +331,18 @@ Styler::_ApplyBasicStyle(BScintillaView* editor, YAML::Node& global)
 
 
 void
-Styler::_ApplyDefaultStyle(BScintillaView* editor, YAML::Node& global,  const BFont* font)
+Styler::_ApplyDefaultStyle(BScintillaView* editor, const Layer& layer,  const BFont* font)
 {
-	if (!global["Default"])
+	if (!layer.hasDefault)
 		return;
 
-	int id;
-	Style s;
-	_GetAttributesFromNode(global["Default"], id, s);
 	if (font == nullptr)
 		font = be_fixed_font;
 	font_family fontName;
 	font->GetFamilyAndStyle(&fontName, nullptr);
 	editor->SendMessage(SCI_STYLESETFONT, 32, (sptr_t) fontName);
 	editor->SendMessage(SCI_STYLESETSIZE, 32, (sptr_t) font->Size());
-	_ApplyAttributes(editor, 32, s);
+	_ApplyAttributes(editor, 32, layer.defaultStyle);
 	editor->SendMessage(SCI_STYLECLEARALL, 0, 0);
 	editor->SendMessage(SCI_STYLESETFONT, 36, (sptr_t) fontName);
 	editor->SendMessage(SCI_STYLESETSIZE, 36, (sptr_t) (font->Size() / 1.3));
@@ -305,11 +364,14 @@ Styler::_ApplyDefaultStyle(BScintillaView* editor, YAML::Node& global,  const BF
 void
 Styler::ApplyLanguage(BScintillaView* editor, const std::map<int, int>& styleMapping)
 {
+	if (sGlobalProfile == nullptr)
+		return;
+	const std::unordered_map<int, Style>& stylesMapping = sGlobalProfile->stylesMapping;
 	for (const auto& mapping : styleMapping) {
 		int scintillaId = mapping.first;
 		int styleId = mapping.second;
-		const auto it = sStylesMapping.find(styleId);
-		if (it != sStylesMapping.end()) {
+		const auto it = stylesMapping.find(styleId);
+		if (it != stylesMapping.end()) {
 			Style s = it->second;
 			_ApplyAttributes(editor, scintillaId, s);
 		}
@@ -380,21 +442,3 @@ Styler::_ApplyAttributes(BScintillaView* editor, int styleId, Styler::Style styl
 	}
 }
 
-
-BString
-Styler::_FullStylePath(const char* style, const BPath &path)
-{
-	BPath p(path);
-	p.Append("styles");
-	p.Append(style);
-	BString fileName(p.Path());
-	fileName.Append(".yaml");
-	if (!BEntry(fileName.String()).Exists()) {
-		// TODO: Workaround for a bug in Haiku x86_32: exceptions
-		// thrown inside yaml_cpp aren't catchable. We throw this exception
-		// inside Genio and that works.
-		// Should be fixed in beta5, though
-		throw YAML::BadFile(fileName.String());
-	}
-	return BString(p.Path()).Append(".yaml");
-}
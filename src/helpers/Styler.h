@@ -8,6 +8,7 @@
 
 
 #include <map>
+#include <memory>
 #include <string>
 #include <set>
 #include <unordered_map>
@@ -39,16 +40,19 @@ public:
 	static	void	ApplySystemStyle(BScintillaView* editor);
 
 private:
-	static	void	_ApplyGlobal(BScintillaView* editor, const char* style, const BPath &path, const BFont* font = nullptr);
+	struct Layer;
+	struct Profile;
+
+	static	std::shared_ptr<const Profile>	_GetProfile(const char* style);
+	static	std::shared_ptr<const Profile>	_CompileProfile(const char* style);
 	static	void	_GetAvailableStyles(std::set<std::string> &styles, const BPath &path);
 	static	void	_GetAttributesFromNode(const YAML::Node &node, int& styleId, Style& style);
 	static	void	_ApplyAttributes(BScintillaView* editor, int styleId, Style style);
-	static	void	_ApplyBasicStyle(BScintillaView* editor, const char* style, const BPath &path, const BFont* font = nullptr);
-	static  void	_ApplyDefaultStyle(BScintillaView* editor, YAML::Node& node, const BFont* font);
-	static	void	_ApplyBasicStyle(BScintillaView* editor, YAML::Node& global);
-	static  BString _FullStylePath(const char* style, const BPath &path);
+	static  void	_ApplyDefaultStyle(BScintillaView* editor, const Layer& layer, const BFont* font);
+	static	void	_ApplyBasicStyle(BScintillaView* editor, const Layer& layer);
 
-	static	std::unordered_map<int, Style>	sStylesMapping;
+	static	std::map<std::string, std::shared_ptr<const Profile>>	sProfiles;
+	static	std::shared_ptr<const Profile>	sGlobalProfile;
 };
 
 
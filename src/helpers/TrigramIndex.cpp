@@ -0,0 +1,789 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "TrigramIndex.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <Path.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+#include "Log.h"
+
+
+static constexpr uint32 kIndexMagic = 'GTRI';
+static constexpr uint32 kIndexVersion = 1;
+// bigger files are not indexed and are always searched
+static constexpr off_t kMaxIndexedFileSize = 4 * 1024 * 1024;
+// as FindInFilesEngine, a NUL byte here marks a binary file
+static constexpr size_t kBinaryProbeSize = 32 * 1024;
+static constexpr uint32 kTrigramCount = 1 << 24;
+
+
+static inline uint8
+FoldCase(uint8 c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+static inline uint32
+Trigram(const uint8* p)
+{
+	return (FoldCase(p[0]) << 16) | (FoldCase(p[1]) << 8) | FoldCase(p[2]);
+}
+
+
+static void
+AppendVarint(std::vector<uint8>& data, uint32 value)
+{
+	while (value >= 0x80) {
+		data.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	data.push_back(value);
+}
+
+
+// Fails, with the ids decoded so far, on a truncated varint or on ids
+// that are not ascending or not below fileCount: the cache file may be
+// corrupt or stale
+static bool
+DecodePosting(const std::vector<uint8>& data, uint32 fileCount, std::vector<uint32>& ids)
+{
+	ids.clear();
+	uint64 id = 0;
+	size_t i = 0;
+	while (i < data.size()) {
+		uint64 delta = 0;
+		int shift = 0;
+		uint8 byte;
+		do {
+			if (i == data.size() || shift > 28)
+				return false;
+			byte = data[i++];
+			delta |= uint64(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+		if (delta == 0 && !ids.empty())
+			return false;
+		id += delta;
+		if (id >= fileCount)
+			return false;
+		ids.push_back(id);
+	}
+	return true;
+}
+
+
+static inline int64
+ModificationTime(const struct stat& st)
+{
+	return (int64)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+
+template<typename T>
+static void
+WriteValue(std::ofstream& stream, const T& value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+template<typename T>
+static bool
+ReadValue(std::ifstream& stream, T& value)
+{
+	return (bool)stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+
+static void
+WriteString(std::ofstream& stream, const std::string& string)
+{
+	WriteValue<uint32>(stream, string.length());
+	stream.write(string.data(), string.length());
+}
+
+
+static bool
+ReadString(std::ifstream& stream, std::string& string)
+{
+	uint32 length;
+	if (!ReadValue(stream, length) || length > B_PATH_NAME_LENGTH * 4)
+		return false;
+	string.resize(length);
+	return (bool)stream.read(string.data(), length);
+}
+
+
+TrigramIndex::TrigramIndex(const BString& rootPath)
+	:
+	fRootPath(rootPath),
+	fLock("TrigramIndex"),
+	fRemovedCount(0),
+	fReady(false),
+	fDirty(false),
+	fThread(-1),
+	fWakeUp(-1),
+	fPendingLock("TrigramIndex pending"),
+	fQuitting(false),
+	fDetached(false)
+{
+	if (fRootPath.EndsWith("/") && fRootPath.Length() > 1)
+		fRootPath.Truncate(fRootPath.Length() - 1);
+}
+
+
+void
+TrigramIndex::Quit()
+{
+	if (fThread < 0) {
+		delete this;
+		return;
+	}
+	// the thread checks fDetached once it sees fQuitting
+	fDetached = true;
+	fQuitting = true;
+	release_sem(fWakeUp);
+}
+
+
+TrigramIndex::~TrigramIndex()
+{
+	fQuitting = true;
+	if (fThread >= 0) {
+		release_sem(fWakeUp);
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+	if (fWakeUp >= 0)
+		delete_sem(fWakeUp);
+}
+
+
+status_t
+TrigramIndex::Start(const BString& excludeDirectories, bool useGitIgnore)
+{
+	if (fThread >= 0)
+		return B_BUSY;
+
+	fWalker.reset(new ProjectWalker(fRootPath, excludeDirectories, useGitIgnore));
+
+	fWakeUp = create_sem(0, "TrigramIndex wake up");
+	if (fWakeUp < 0)
+		return fWakeUp;
+
+	fThread = spawn_thread(_ThreadEntry, "TrigramIndex", B_LOW_PRIORITY, this);
+	if (fThread < 0)
+		return fThread;
+
+	return resume_thread(fThread);
+}
+
+
+void
+TrigramIndex::Update(const BString& path)
+{
+	if (fThread < 0)
+		return;
+
+	BAutolock lock(fPendingLock);
+	fPending.push_back(path.String());
+	release_sem(fWakeUp);
+}
+
+
+bool
+TrigramIndex::Query(const BString& text, const BString& excludeDirectories,
+	bool useGitIgnore, std::vector<std::string>& paths)
+{
+	if (text.Length() < 3)
+		return false;
+
+	bigtime_t startTime = system_time();
+	std::vector<std::string> stale;
+	{
+		BAutolock lock(fLock);
+		if (!fReady)
+			return false;
+
+		ProjectWalker walker(fRootPath, excludeDirectories, useGitIgnore);
+		if (walker.Fingerprint() != fWalker->Fingerprint()) {
+			BAutolock pendingLock(fPendingLock);
+			if (fPendingWalker == nullptr
+				|| fPendingWalker->Fingerprint() != walker.Fingerprint()) {
+				fPendingWalker.reset(new ProjectWalker(fRootPath, excludeDirectories,
+					useGitIgnore));
+				release_sem(fWakeUp);
+			}
+			return false;
+		}
+
+		std::vector<uint32> trigrams;
+		const uint8* needle = (const uint8*)text.String();
+		for (int32 i = 0; i + 3 <= text.Length(); i++)
+			trigrams.push_back(Trigram(needle + i));
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+		// intersect the posting lists, starting from the shortest one
+		std::vector<const Posting*> postings;
+		for (uint32 trigram : trigrams) {
+			auto it = fPostings.find(trigram);
+			if (it == fPostings.end()) {
+				postings.clear();
+				break;
+			}
+			postings.push_back(&it->second);
+		}
+		std::sort(postings.begin(), postings.end(),
+			[](const Posting* a, const Posting* b) {
+				return a->deltas.size() < b->deltas.size();
+			});
+
+		std::vector<uint32> ids;
+		std::vector<uint32> other;
+		for (size_t i = 0; i < postings.size(); i++) {
+			if (i == 0) {
+				DecodePosting(postings[i]->deltas, fFiles.size(), ids);
+				continue;
+			}
+			DecodePosting(postings[i]->deltas, fFiles.size(), other);
+			auto last = std::set_intersection(ids.begin(), ids.end(),
+				other.begin(), other.end(), ids.begin());
+			ids.erase(last, ids.end());
+			if (ids.empty())
+				break;
+		}
+
+		std::vector<bool> candidate(fFiles.size(), false);
+		for (uint32 id : ids)
+			candidate[id] = true;
+
+		// files changed behind the path monitor (writes don't notify the
+		// watched folders) are searched anyway, and indexed again
+		const std::string root(fRootPath.String());
+		for (uint32 id = 0; id < fFiles.size(); id++) {
+			const FileEntry& file = fFiles[id];
+			if (file.state == kRemoved)
+				continue;
+			std::string path(root);
+			path.append("/").append(file.path);
+			if (candidate[id] || file.state == kUnindexed) {
+				paths.push_back(std::move(path));
+				continue;
+			}
+			struct stat st;
+			if (stat(path.c_str(), &st) != 0) {
+				stale.push_back(std::move(path));
+			} else if (ModificationTime(st) != file.modified || st.st_size != file.size) {
+				paths.push_back(path);
+				stale.push_back(std::move(path));
+			}
+		}
+
+		// events still waiting for the index thread
+		BAutolock pendingLock(fPendingLock);
+		std::vector<std::string> pending(fPending);
+		pending.insert(pending.end(), fApplying.begin(), fApplying.end());
+		for (const std::string& path : pending) {
+			struct stat st;
+			if (lstat(path.c_str(), &st) != 0)
+				continue;
+			if (S_ISDIR(st.st_mode)) {
+				fWalker->Walk([&paths](std::string&& file, const struct stat&) {
+					paths.push_back(std::move(file));
+				}, fQuitting, path);
+			} else if (S_ISREG(st.st_mode) && !fWalker->IsExcluded(path, false)) {
+				paths.push_back(path);
+			}
+		}
+	}
+
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+	for (const std::string& path : stale)
+		Update(path.c_str());
+
+	LogInfo("TrigramIndex: query [%s] on '%s': %d candidates, %d stale, in %.2f ms",
+		text.String(), fRootPath.String(), (int32)paths.size(), (int32)stale.size(),
+		(system_time() - startTime) / 1000.0);
+	return true;
+}
+
+
+/* static */
+status_t
+TrigramIndex::_ThreadEntry(void* cookie)
+{
+	TrigramIndex* index = static_cast<TrigramIndex*>(cookie);
+	index->_Run();
+	if (index->fDetached) {
+		// nobody to join this thread
+		index->fThread = -1;
+		delete index;
+	}
+	return B_OK;
+}
+
+
+void
+TrigramIndex::_Run()
+{
+	fSeen.resize(kTrigramCount / 64);
+
+	bigtime_t startTime = system_time();
+	if (_Load()) {
+		{
+			BAutolock lock(fLock);
+			fReady = true;
+		}
+		_Refresh();
+		_ReportStats("refreshed", system_time() - startTime);
+	} else {
+		_Build();
+		_ReportStats("built", system_time() - startTime);
+	}
+	if (fDirty && !fQuitting)
+		_Save();
+
+	while (!fQuitting) {
+		// Quit() relies on this loop seeing fQuitting
+		const status_t status = acquire_sem(fWakeUp);
+		if (status == B_INTERRUPTED)
+			continue;
+		if (status != B_OK)
+			break;
+
+		std::unique_ptr<ProjectWalker> walker;
+		std::vector<std::string> pending;
+		{
+			BAutolock lock(fPendingLock);
+			walker.swap(fPendingWalker);
+			pending.swap(fPending);
+			fApplying = pending;
+		}
+		// many events may arrive together: drop the extra wake ups
+		int32 count;
+		if (get_sem_count(fWakeUp, &count) == B_OK && count > 0)
+			acquire_sem_etc(fWakeUp, count, B_RELATIVE_TIMEOUT, 0);
+
+		if (walker != nullptr) {
+			LogInfo("TrigramIndex: exclude settings changed, rebuilding '%s'",
+				fRootPath.String());
+			{
+				BAutolock lock(fLock);
+				fWalker.swap(walker);
+			}
+			startTime = system_time();
+			_Build();
+			_ReportStats("rebuilt", system_time() - startTime);
+		}
+
+		for (const std::string& path : pending) {
+			if (fQuitting)
+				break;
+			_Apply(path);
+		}
+		{
+			BAutolock lock(fPendingLock);
+			fApplying.clear();
+		}
+
+		BAutolock lock(fLock);
+		if (fRemovedCount > 1024 && fRemovedCount > fFiles.size() / 4)
+			_CompactLocked();
+	}
+
+	if (fDirty)
+		_Save();
+}
+
+
+void
+TrigramIndex::_Build()
+{
+	{
+		BAutolock lock(fLock);
+		_Clear();
+	}
+	fWalker->Walk([this](std::string&& path, const struct stat& st) {
+		_IndexFile(path, st);
+	}, fQuitting);
+
+	// an interrupted walk leaves a partial index: never save it
+	BAutolock lock(fLock);
+	fReady = !fQuitting;
+	fDirty = fReady;
+}
+
+
+void
+TrigramIndex::_Refresh()
+{
+	// the files met during the walk are indexed again if changed,
+	// the others have been removed while the project was closed
+	std::vector<bool> seen;
+	{
+		BAutolock lock(fLock);
+		seen.resize(fFiles.size(), false);
+	}
+	const size_t rootLength = fRootPath.Length() + 1;
+	fWalker->Walk([&](std::string&& path, const struct stat& st) {
+		{
+			BAutolock lock(fLock);
+			auto it = fIds.find(path.substr(rootLength));
+			if (it != fIds.end() && it->second < seen.size()) {
+				seen[it->second] = true;
+				const FileEntry& file = fFiles[it->second];
+				if (file.modified == ModificationTime(st) && file.size == st.st_size)
+					return;
+			}
+		}
+		_IndexFile(path, st);
+	}, fQuitting);
+
+	if (fQuitting)
+		return;
+
+	BAutolock lock(fLock);
+	for (uint32 id = 0; id < seen.size(); id++) {
+		if (!seen[id] && fFiles[id].state != kRemoved)
+			_RemoveLocked(fFiles[id].path, false);
+	}
+}
+
+
+void
+TrigramIndex::_Apply(const std::string& path)
+{
+	const size_t rootLength = fRootPath.Length() + 1;
+	if (path.length() <= rootLength)
+		return;
+
+	struct stat st;
+	if (lstat(path.c_str(), &st) != 0) {
+		BAutolock lock(fLock);
+		_RemoveLocked(path.substr(rootLength), true);
+		return;
+	}
+
+	if (S_ISDIR(st.st_mode)) {
+		if (fWalker->IsExcluded(path, true))
+			return;
+		fWalker->Walk([this](std::string&& file, const struct stat& fileStat) {
+			_IndexFileIfChanged(file, fileStat);
+		}, fQuitting, path);
+	} else if (S_ISREG(st.st_mode)) {
+		if (fWalker->IsExcluded(path, false) || st.st_size == 0) {
+			BAutolock lock(fLock);
+			_RemoveLocked(path.substr(rootLength), false);
+			return;
+		}
+		_IndexFileIfChanged(path, st);
+	}
+}
+
+
+void
+TrigramIndex::_IndexFileIfChanged(const std::string& path, const struct stat& st)
+{
+	{
+		BAutolock lock(fLock);
+		auto it = fIds.find(path.substr(fRootPath.Length() + 1));
+		if (it != fIds.end()) {
+			const FileEntry& file = fFiles[it->second];
+			if (file.modified == ModificationTime(st) && file.size == st.st_size)
+				return;
+		}
+	}
+	_IndexFile(path, st);
+}
+
+
+void
+TrigramIndex::_IndexFile(const std::string& path, const struct stat& st)
+{
+	FileEntry entry;
+	entry.path = path.substr(fRootPath.Length() + 1);
+	entry.modified = ModificationTime(st);
+	entry.size = st.st_size;
+	entry.state = kUnindexed;
+
+	fTrigrams.clear();
+	bool binary = false;
+	if (st.st_size <= kMaxIndexedFileSize) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			fBuffer.resize(st.st_size);
+			ssize_t size = read(fd, fBuffer.data(), st.st_size);
+			close(fd);
+			if (size >= 0) {
+				entry.state = kIndexed;
+				const uint8* data = (const uint8*)fBuffer.data();
+				binary = memchr(data, '\0', std::min((size_t)size, kBinaryProbeSize)) != nullptr;
+				for (ssize_t i = 0; !binary && i + 3 <= size; i++) {
+					const uint32 trigram = Trigram(data + i);
+					uint64& word = fSeen[trigram >> 6];
+					const uint64 bit = 1ULL << (trigram & 63);
+					if ((word & bit) == 0) {
+						word |= bit;
+						fTrigrams.push_back(trigram);
+					}
+				}
+				for (uint32 trigram : fTrigrams)
+					fSeen[trigram >> 6] = 0;
+				if (binary)
+					fTrigrams.clear();
+			}
+		}
+	}
+
+	BAutolock lock(fLock);
+	_RemoveLocked(entry.path, false);
+	// binary files stay in the list, with no trigrams: the search skips
+	// them too, until they change
+	const uint32 id = fFiles.size();
+	fIds[entry.path] = id;
+	fFiles.push_back(std::move(entry));
+	for (uint32 trigram : fTrigrams) {
+		Posting& posting = fPostings[trigram];
+		AppendVarint(posting.deltas, posting.deltas.empty() ? id : id - posting.last);
+		posting.last = id;
+	}
+	fDirty = true;
+}
+
+
+void
+TrigramIndex::_RemoveLocked(const std::string& relativePath, bool recursive)
+{
+	auto it = fIds.find(relativePath);
+	if (it != fIds.end()) {
+		fFiles[it->second].state = kRemoved;
+		fIds.erase(it);
+		fRemovedCount++;
+		fDirty = true;
+	}
+	if (!recursive)
+		return;
+
+	const std::string prefix = relativePath + "/";
+	for (FileEntry& file : fFiles) {
+		if (file.state != kRemoved && file.path.compare(0, prefix.length(), prefix) == 0) {
+			fIds.erase(file.path);
+			file.state = kRemoved;
+			fRemovedCount++;
+			fDirty = true;
+		}
+	}
+}
+
+
+void
+TrigramIndex::_CompactLocked()
+{
+	std::vector<uint32> remap(fFiles.size(), UINT32_MAX);
+	std::vector<FileEntry> files;
+	files.reserve(fFiles.size() - fRemovedCount);
+	for (uint32 id = 0; id < fFiles.size(); id++) {
+		if (fFiles[id].state == kRemoved)
+			continue;
+		remap[id] = files.size();
+		fIds[fFiles[id].path] = files.size();
+		files.push_back(std::move(fFiles[id]));
+	}
+	fFiles.swap(files);
+	fRemovedCount = 0;
+
+	std::vector<uint32> ids;
+	for (auto it = fPostings.begin(); it != fPostings.end();) {
+		DecodePosting(it->second.deltas, remap.size(), ids);
+		Posting& posting = it->second;
+		posting.deltas.clear();
+		for (uint32 id : ids) {
+			if (remap[id] == UINT32_MAX)
+				continue;
+			AppendVarint(posting.deltas,
+				posting.deltas.empty() ? remap[id] : remap[id] - posting.last);
+			posting.last = remap[id];
+		}
+		if (posting.deltas.empty())
+			it = fPostings.erase(it);
+		else {
+			posting.deltas.shrink_to_fit();
+			++it;
+		}
+	}
+	fDirty = true;
+}
+
+
+void
+TrigramIndex::_Clear()
+{
+	fFiles.clear();
+	fIds.clear();
+	fPostings.clear();
+	fRemovedCount = 0;
+	fReady = false;
+}
+
+
+bool
+TrigramIndex::_Load()
+{
+	std::ifstream stream(_CachePath().String(), std::ios::binary);
+	if (!stream.is_open())
+		return false;
+
+	uint32 magic, version;
+	std::string root, fingerprint;
+	if (!ReadValue(stream, magic) || magic != kIndexMagic
+		|| !ReadValue(stream, version) || version != kIndexVersion
+		|| !ReadString(stream, root) || root != fRootPath.String()
+		|| !ReadString(stream, fingerprint) || fingerprint != fWalker->Fingerprint().String())
+		return false;
+
+	// nothing read is trusted: the counts are not used to allocate, and
+	// each posting is decoded once to check its ids
+	BAutolock lock(fLock);
+	uint32 fileCount;
+	if (!ReadValue(stream, fileCount))
+		return false;
+	for (uint32 id = 0; id < fileCount; id++) {
+		FileEntry file;
+		if (!ReadString(stream, file.path) || !ReadValue(stream, file.modified)
+			|| !ReadValue(stream, file.size) || !ReadValue(stream, file.state)
+			|| file.state == kRemoved || !fIds.emplace(file.path, id).second) {
+			_Clear();
+			return false;
+		}
+		fFiles.push_back(std::move(file));
+	}
+
+	uint32 postingCount;
+	if (!ReadValue(stream, postingCount) || postingCount > kTrigramCount) {
+		_Clear();
+		return false;
+	}
+	std::vector<uint32> ids;
+	for (uint32 i = 0; i < postingCount; i++) {
+		uint32 trigram, length, last;
+		// at most 5 bytes for each file
+		if (!ReadValue(stream, trigram) || !ReadValue(stream, length)
+			|| !ReadValue(stream, last) || length == 0 || length > fileCount * 5ULL
+			|| fPostings.count(trigram) != 0) {
+			_Clear();
+			return false;
+		}
+		Posting& posting = fPostings[trigram];
+		posting.last = last;
+		posting.deltas.resize(length);
+		if (!stream.read(reinterpret_cast<char*>(posting.deltas.data()), length)
+			|| !DecodePosting(posting.deltas, fileCount, ids) || ids.back() != last) {
+			_Clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+status_t
+TrigramIndex::_Save()
+{
+	const BString path = _CachePath();
+	if (path.IsEmpty())
+		return B_ERROR;
+	BString temporary(path);
+	temporary << ".tmp";
+
+	BAutolock lock(fLock);
+	if (fRemovedCount > 0)
+		_CompactLocked();
+
+	std::ofstream stream(temporary.String(), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open()) {
+		LogError("TrigramIndex: can't write %s", temporary.String());
+		return B_ERROR;
+	}
+
+	WriteValue(stream, kIndexMagic);
+	WriteValue(stream, kIndexVersion);
+	WriteString(stream, fRootPath.String());
+	WriteString(stream, fWalker->Fingerprint().String());
+	WriteValue<uint32>(stream, fFiles.size());
+	for (const FileEntry& file : fFiles) {
+		WriteString(stream, file.path);
+		WriteValue(stream, file.modified);
+		WriteValue(stream, file.size);
+		WriteValue(stream, file.state);
+	}
+	WriteValue<uint32>(stream, fPostings.size());
+	for (const auto& [trigram, posting] : fPostings) {
+		WriteValue(stream, trigram);
+		WriteValue<uint32>(stream, posting.deltas.size());
+		WriteValue(stream, posting.last);
+		stream.write(reinterpret_cast<const char*>(posting.deltas.data()),
+			posting.deltas.size());
+	}
+	stream.close();
+	if (!stream || rename(temporary.String(), path.String()) != 0) {
+		LogError("TrigramIndex: can't save %s", path.String());
+		unlink(temporary.String());
+		return B_ERROR;
+	}
+	fDirty = false;
+	return B_OK;
+}
+
+
+BString
+TrigramIndex::_CachePath() const
+{
+	BPath path;
+	if (find_directory(B_USER_CACHE_DIRECTORY, &path, true) != B_OK)
+		return "";
+	path.Append("Genio/index");
+	if (create_directory(path.Path(), 0755) != B_OK)
+		return "";
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016zx.trigrams",
+		std::hash<std::string>()(fRootPath.String()));
+	path.Append(name);
+	return path.Path();
+}
+
+
+void
+TrigramIndex::_ReportStats(const char* what, bigtime_t elapsed)
+{
+	BAutolock lock(fLock);
+	size_t bytes = 0;
+	for (const auto& [trigram, posting] : fPostings)
+		bytes += posting.deltas.size() + sizeof(trigram) + sizeof(Posting);
+	for (const FileEntry& file : fFiles)
+		bytes += file.path.length() + sizeof(FileEntry);
+
+	LogInfo("TrigramIndex: %s '%s' in %.2f s%s: %d files, %d trigrams, %.1f MiB",
+		what, fRootPath.String(), elapsed / 1000000.0, fQuitting ? " (interrupted)" : "",
+		(int32)(fFiles.size() - fRemovedCount), (int32)fPostings.size(),
+		bytes / (1024.0 * 1024.0));
+}
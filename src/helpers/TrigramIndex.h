@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Locker.h>
+#include <OS.h>
+#include <String.h>
+
+#include "ProjectWalker.h"
+
+// Per project index of the (case folded) trigrams of every file, used by
+// FindInFilesEngine to read only the files that may contain the text.
+// The index is kept in the user cache folder: when a project is opened it
+// is loaded and refreshed against the disk, or built from scratch, by a
+// background thread. The same thread applies the path monitor events
+// forwarded with Update().
+// The owner releases the index with Quit(): the thread saves it, when
+// changed, and deletes it, so the caller never waits for the save.
+
+class TrigramIndex {
+public:
+					TrigramIndex(const BString& rootPath);
+					~TrigramIndex();
+
+		status_t	Start(const BString& excludeDirectories, bool useGitIgnore);
+		// stops the index and deletes it, from its thread when running
+		void		Quit();
+
+		// path was created, removed, moved or modified
+		void		Update(const BString& path);
+
+		// Fills paths with the files which may contain text, to be verified
+		// by the caller. Returns false when the index can't answer (still
+		// building, text shorter than a trigram, other exclude settings):
+		// the caller has to walk the whole project.
+		bool		Query(const BString& text, const BString& excludeDirectories,
+						bool useGitIgnore, std::vector<std::string>& paths);
+
+private:
+	enum FileState : uint8 {
+		kIndexed,
+		kUnindexed,	// too big to be indexed, always a candidate
+		kRemoved
+	};
+
+	struct FileEntry {
+		std::string	path;	// relative to the root
+		int64		modified;
+		int64		size;
+		FileState	state;
+	};
+
+	struct Posting {
+		std::vector<uint8>	deltas;	// varint encoded, ascending file ids
+		uint32				last;
+	};
+
+	static	status_t	_ThreadEntry(void* cookie);
+		void		_Run();
+		void		_Build();
+		void		_Refresh();
+		void		_Apply(const std::string& path);
+		void		_IndexFileIfChanged(const std::string& path, const struct stat& st);
+		void		_IndexFile(const std::string& path, const struct stat& st);
+		void		_RemoveLocked(const std::string& relativePath, bool recursive);
+		void		_CompactLocked();
+		void		_Clear();
+
+		bool		_Load();
+		status_t	_Save();
+		BString		_CachePath() const;
+		void		_ReportStats(const char* what, bigtime_t elapsed);
+
+		BString		fRootPath;
+
+		BLocker		fLock;	// guards the index and fWalker
+		std::unique_ptr<ProjectWalker>	fWalker;
+		std::vector<FileEntry>		fFiles;
+		std::unordered_map<std::string, uint32>	fIds;
+		std::unordered_map<uint32, Posting>		fPostings;
+		uint32		fRemovedCount;
+		bool		fReady;
+		bool		fDirty;
+
+		// used by the index thread only, to collect the trigrams of a file
+		std::vector<uint64>	fSeen;
+		std::vector<uint32>	fTrigrams;
+		std::vector<char>	fBuffer;
+
+		thread_id	fThread;
+		sem_id		fWakeUp;
+		BLocker		fPendingLock;
+		std::vector<std::string>	fPending;
+		std::vector<std::string>	fApplying;
+		std::unique_ptr<ProjectWalker>	fPendingWalker;	// rebuild with other settings
+		std::atomic<bool>	fQuitting;
+		std::atomic<bool>	fDetached;	// deleted by its thread
+};
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "LSPDiagnostic.h"
+
+#include <SupportDefs.h>
+
+#include <algorithm>
+
+
+static bool
+SameRange(const InfoRange& a, const InfoRange& b)
+{
+	return a.from == b.from && a.to == b.to && a.info == b.info;
+}
+
+
+static bool
+RangeLess(const InfoRange& a, const InfoRange& b)
+{
+	if (a.from != b.from)
+		return a.from < b.from;
+	if (a.to != b.to)
+		return a.to < b.to;
+	return a.info < b.info;
+}
+
+
+bool
+DiffDiagnostics(const std::vector<LSPDiagnostic>& previous,
+	const std::vector<LSPDiagnostic>& current, std::vector<const InfoRange*>& removed,
+	std::vector<const InfoRange*>& added)
+{
+	// a server republishes in the same order: only the middle can differ
+	size_t first = 0;
+	while (first < previous.size() && first < current.size()
+		&& SameRange(previous[first].range, current[first].range)) {
+		first++;
+	}
+	size_t previousEnd = previous.size();
+	size_t currentEnd = current.size();
+	while (previousEnd > first && currentEnd > first
+		&& SameRange(previous[previousEnd - 1].range, current[currentEnd - 1].range)) {
+		previousEnd--;
+		currentEnd--;
+	}
+	if (first == previousEnd && first == currentEnd)
+		return false;
+
+	// sorted, the ranges of both are merged: the unpaired ones changed
+	auto sortedIndexes = [](const std::vector<LSPDiagnostic>& diagnostics, size_t from,
+			size_t to) {
+		std::vector<size_t> indexes(to - from);
+		for (size_t i = from; i < to; i++)
+			indexes[i - from] = i;
+		std::sort(indexes.begin(), indexes.end(), [&diagnostics](size_t a, size_t b) {
+			return RangeLess(diagnostics[a].range, diagnostics[b].range);
+		});
+		return indexes;
+	};
+	const std::vector<size_t> previousSorted = sortedIndexes(previous, first, previousEnd);
+	const std::vector<size_t> currentSorted = sortedIndexes(current, first, currentEnd);
+
+	std::vector<bool> isAdded(current.size(), false);
+	size_t p = 0;
+	size_t c = 0;
+	while (p < previousSorted.size() || c < currentSorted.size()) {
+		const InfoRange* old = p < previousSorted.size()
+			? &previous[previousSorted[p]].range : nullptr;
+		const InfoRange* range = c < currentSorted.size()
+			? &current[currentSorted[c]].range : nullptr;
+		if (old != nullptr && range != nullptr && SameRange(*old, *range)) {
+			p++;
+			c++;
+		} else if (range == nullptr || (old != nullptr && RangeLess(*old, *range))) {
+			removed.push_back(old);
+			p++;
+		} else {
+			added.push_back(range);
+			isAdded[currentSorted[c]] = true;
+			c++;
+		}
+	}
+
+	if (added.empty() && removed.empty())
+		return false;
+
+	// clearing a range could clear an overlapping diagnostic that's still there:
+	// it overlaps a removed one starting before its end and ending after its start
+	std::vector<const InfoRange*> sorted(removed);
+	std::sort(sorted.begin(), sorted.end(), [](const InfoRange* a, const InfoRange* b) {
+		return a->from < b->from;
+	});
+	std::vector<Sci_Position> maxEnd(sorted.size());
+	for (size_t i = 0; i < sorted.size(); i++)
+		maxEnd[i] = std::max(sorted[i]->to, i > 0 ? maxEnd[i - 1] : sorted[i]->to);
+
+	for (size_t i = 0; i < current.size(); i++) {
+		if (isAdded[i])
+			continue;
+		const InfoRange& range = current[i].range;
+		const size_t before = std::lower_bound(sorted.begin(), sorted.end(), range.to,
+			[](const InfoRange* r, Sci_Position to) { return r->from < to; }) - sorted.begin();
+		if (before > 0 && maxEnd[before - 1] > range.from)
+			added.push_back(&range);
+	}
+	return true;
+}
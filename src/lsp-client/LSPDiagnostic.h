@@ -0,0 +1,30 @@
+/*
+ * Copyright 2023, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "protocol_objects.h"
+#include "Sci_Position.h"
+
+struct InfoRange {
+	Sci_Position	from;
+	Sci_Position	to;
+	std::string		info;
+};
+
+struct LSPDiagnostic {
+	InfoRange range;
+	Diagnostic diagnostic;
+	std::string fixTitle;
+};
+
+// The indicator ranges to clear (removed) and to fill (added) to go from the
+// previous diagnostics to the current ones, both with editor ranges of the
+// same document version. Returns false if the set of diagnostics is the same.
+bool DiffDiagnostics(const std::vector<LSPDiagnostic>& previous,
+	const std::vector<LSPDiagnostic>& current, std::vector<const InfoRange*>& removed,
+	std::vector<const InfoRange*>& added);
@@ -18,6 +18,7 @@
 #include "Editor.h"
 #include "EditorStatusView.h"
 #include "Log.h"
+#include "LSPMessage.h"
 #include "LSPProjectWrapper.h"
 #include "JumpNavigator.h"
 #include "protocol.h"
@@ -32,6 +33,44 @@
 #define IND_LINK INDICATOR_CONTAINER + 2 //Style for Links
 #define IND_OVER INDICATOR_CONTAINER + 3 //Style for mouse hover
 
+// Above these limits the pending changes are replaced by a full document sync
+const size_t kMaxPendingChanges = 128;
+const size_t kMaxPendingBytes = 256 * 1024;
+
+
+// Identity of a diagnostic for the code actions cache
+static std::string
+DiagnosticKey(const Diagnostic& diagnostic)
+{
+	const Range& r = diagnostic.range;
+	return std::to_string(r.start.line) + ":" + std::to_string(r.start.character) + "-"
+		+ std::to_string(r.end.line) + ":" + std::to_string(r.end.character) + " "
+		+ diagnostic.message;
+}
+
+
+// The range of the diagnostic fixed by a code action: the standard 'diagnostics'
+// field or, for clangd, the range stored in its 'data'.
+static bool
+CodeActionRange(nlohmann::json& action, Range& range)
+{
+	try {
+		if (action.contains("diagnostics") && !action["diagnostics"].empty()) {
+			range = action["diagnostics"][0]["range"].get<Range>();
+			return true;
+		}
+		auto& r = action["data"]["Range"];
+		range.start.character = r["Start"]["Character"].get<int>();
+		range.start.line = r["Start"]["Line"].get<int>();
+		range.end.character = r["End"]["Character"].get<int>();
+		range.end.line = r["End"]["Line"].get<int>();
+	} catch (std::exception& e) {
+		LogError("CodeAction without a diagnostic range: %s", e.what());
+		return false;
+	}
+	return true;
+}
+
 LSPEditorWrapper::LSPEditorWrapper(BPath filenamePath, Editor* editor)
 	:
 	LSPTextDocument(filenamePath, editor->FileType().c_str()),
@@ -41,7 +80,13 @@ LSPEditorWrapper::LSPEditorWrapper(BPath filenamePath, Editor* editor)
 	fCallTip(editor),
 	fInitialized(false),
 	fLastWordStartPosition(-1),
-	fLastWordEndPosition(-1)
+	fLastWordEndPosition(-1),
+	fCodeActionsVersion(-1),
+	fDiagnosticsVersion(-1),
+	fLineIndexAllocated(false),
+	fLastChangeStart(-1),
+	fPendingBytes(0),
+	fFullSync(false)
 {
 	assert(fEditor);
 }
@@ -83,6 +128,15 @@ LSPEditorWrapper::UnsetLSPServer()
 	fFileStatus = "";
 	fLSPProjectWrapper->UnregisterTextDocument(this);
 	fLSPProjectWrapper = nullptr;
+
+	if (fLineIndexAllocated) {
+		fEditor->SendMessage(SCI_RELEASELINECHARACTERINDEX, SC_LINECHARACTERINDEX_UTF16);
+		fLineIndexAllocated = false;
+	}
+	InvalidatePositionCache();
+	fCodeActions.clear();
+	fCodeActionsVersion = -1;
+	fDiagnosticsVersion = -1;
 }
 
 
@@ -206,7 +260,42 @@ LSPEditorWrapper::didChange(
 	if (!IsInitialized() || fEditor == nullptr)
 		return;
 
-	Sci_Position end_pos = fEditor->SendMessage(SCI_POSITIONRELATIVE, start_pos, poslength);
+	// the whole document will be sent by flushChanges()
+	if (fFullSync)
+		return;
+
+	fPendingBytes += len + poslength;
+	if (fPendingBytes > kMaxPendingBytes || fChanges.size() >= kMaxPendingChanges) {
+		fChanges.clear();
+		fFullSync = true;
+		return;
+	}
+
+	// try to merge the edit with the last pending change.
+	// fLastChangeStart is where the text of that change starts in the current document.
+	if (!fChanges.empty()) {
+		TextDocumentContentChangeEvent& last = fChanges.back();
+		Sci_Position lastEnd = fLastChangeStart + last.text.length();
+		if (poslength == 0 && start_pos == lastEnd) {
+			// typing after the last change
+			last.text.append(text, len);
+			return;
+		}
+		if (len == 0 && start_pos >= fLastChangeStart && start_pos + poslength <= lastEnd) {
+			// deleting text inserted by the last change
+			last.text.erase(start_pos - fLastChangeStart, poslength);
+			return;
+		}
+		if (len == 0 && start_pos + poslength == fLastChangeStart) {
+			// deleting just before the last change: the text before it is
+			// unchanged so the position is valid for the old document too.
+			FromSciPositionToLSPPosition(start_pos, &last.range.value().start);
+			fLastChangeStart = start_pos;
+			return;
+		}
+	}
+
+	Sci_Position end_pos = start_pos + poslength;
 
 	TextDocumentContentChangeEvent event;
 	Range range;
@@ -217,16 +306,28 @@ LSPEditorWrapper::didChange(
 	event.text.assign(text, len);
 
 	fChanges.push_back(event);
+	fLastChangeStart = start_pos;
 }
 
 
 void
 LSPEditorWrapper::flushChanges()
 {
-	if (fChanges.size() > 0) {
-		fLSPProjectWrapper->DidChange(this, fChanges, false);
+	if (fFullSync && IsInitialized()) {
+		// an event without range replaces the whole document
+		TextDocumentContentChangeEvent event;
+		event.text = reinterpret_cast<const char*>(fEditor->SendMessage(SCI_GETCHARACTERPOINTER));
 		fChanges.clear();
+		fChanges.push_back(event);
 	}
+
+	if (fChanges.size() > 0 && IsInitialized())
+		fLSPProjectWrapper->DidChange(this, fChanges, false);
+
+	fChanges.clear();
+	fLastChangeStart = -1;
+	fPendingBytes = 0;
+	fFullSync = false;
 }
 
 
@@ -340,10 +441,13 @@ LSPEditorWrapper::StartHover(Sci_Position sci_position)
 
 	LSPDiagnostic dia;
 	if (DiagnosticFromPosition(sci_position, dia) > -1) {
+		_RequestCodeActions(dia.diagnostic.range);
 		_ShowToolTip(dia.range.info.c_str());
 		return;
 	}
 
+	flushChanges();
+
 	Position position;
 	FromSciPositionToLSPPosition(sci_position, &position);
 	fLSPProjectWrapper->Hover(this, position);
@@ -512,8 +616,8 @@ LSPEditorWrapper::StartCompletion()
 	if (fCurrentCompletion.items.size() > 0) {
 		// let's close the current Scintilla listbox
 		fEditor->SendMessage(SCI_AUTOCCANCEL, 0, 0);
-		// let's cancel any previous request running on clangd
-		// --> TODO: cancel previous clangd request!
+		// any previous request running on the server is cancelled
+		// by LSPProjectWrapper when the new one is sent.
 
 		// let's clean-up current request details:
 		this->fCurrentCompletion = CompletionList();
@@ -555,6 +659,7 @@ LSPEditorWrapper::RequestDocumentSymbols()
 	if (fLSPProjectWrapper == nullptr || fEditor == nullptr)
 		return;
 
+	flushChanges();
 	fLSPProjectWrapper->DocumentSymbol(this);
 }
 
@@ -607,7 +712,12 @@ LSPEditorWrapper::IndicatorClick(Sci_Position sci_position)
 	if (s_start != s_end)
 		return;
 
+	LSPDiagnostic dia;
+	if (DiagnosticFromPosition(sci_position, dia) > -1)
+		_RequestCodeActions(dia.diagnostic.range);
+
 	if (fEditor->SendMessage(SCI_INDICATORVALUEAT, IND_OVER, sci_position) == 1) {
+		flushChanges();
 		Position position;
 		FromSciPositionToLSPPosition(sci_position, &position);
 		fLSPProjectWrapper->GoToDefinition(this, position);
@@ -643,16 +753,23 @@ LSPEditorWrapper::_ShowToolTip(const char* text)
 void
 LSPEditorWrapper::_DoHover(nlohmann::json& result)
 {
-	if (fEditor == nullptr || !fEditor->Window()->IsActive())
-		return;
-
 	if (result == nlohmann::detail::value_t::null &&
 		!result["contents"].contains("value")) {
-		EndHover();
+		std::string empty;
+		_ShowHover(empty);
 		return;
 	}
 
 	std::string tip = result["contents"]["value"].get<std::string>();
+	_ShowHover(tip);
+}
+
+
+void
+LSPEditorWrapper::_ShowHover(const std::string& tip)
+{
+	if (fEditor == nullptr || !fEditor->Window()->IsActive())
+		return;
 
 	if (tip.empty()) {
 		EndHover();
@@ -702,12 +819,19 @@ LSPEditorWrapper::_DoSwitchSourceHeader(json& result)
 
 void
 LSPEditorWrapper::_DoCompletion(json& params)
+{
+	CompletionList allItems = params.get<CompletionList>();
+	_ShowCompletion(allItems);
+}
+
+
+void
+LSPEditorWrapper::_ShowCompletion(CompletionList& allItems)
 {
 	std::string line;
 	Position position;
 	position.character = -1;
 
-	CompletionList allItems = params.get<CompletionList>();
 	auto& items = allItems.items;
 	std::string list;
 	for (auto& item : items) {
@@ -748,7 +872,7 @@ LSPEditorWrapper::_DoCompletion(json& params)
 	}
 
 	if (list.length() > 0) {
-		fCurrentCompletion = allItems;
+		fCurrentCompletion = std::move(allItems);
 		fEditor->SendMessage(SCI_AUTOCSETSEPARATOR, (int) '\n', 0);
 		fEditor->SendMessage(SCI_AUTOCSETIGNORECASE, true);
 		fEditor->SendMessage(SCI_AUTOCGETCANCELATSTART, false);
@@ -779,37 +903,71 @@ void
 LSPEditorWrapper::_DoDiagnostics(nlohmann::json& params)
 {
 	auto vect = params["diagnostics"].get<std::vector<Diagnostic>>();
+	_UpdateDiagnostics(vect);
+}
 
-	_RemoveAllDiagnostics();
 
+void
+LSPEditorWrapper::_UpdateDiagnostics(std::vector<Diagnostic>& vect)
+{
+	bigtime_t start = system_time();
+
+	// the server republishes the same diagnostics often (i.e. when an included
+	// header changes): keep their code actions until the document changes.
+	if (fCodeActionsVersion != Version()) {
+		fCodeActions.clear();
+		fCodeActionsVersion = Version();
+	}
+
+	std::vector<const Position*> positions;
+	positions.reserve(vect.size() * 2);
+	for (auto& v : vect) {
+		positions.push_back(&v.range.start);
+		positions.push_back(&v.range.end);
+	}
+	std::vector<Sci_Position> sciPositions;
+	FromLSPPositionsToSciPositions(positions, sciPositions);
+
+	std::vector<LSPDiagnostic> diagnostics;
+	diagnostics.reserve(vect.size());
+	size_t index = 0;
 	for (auto& v : vect) {
-		LSPDiagnostic lspDiag;
+		LSPDiagnostic& lspDiag = diagnostics.emplace_back();
 
-		Range& r = v.range;
 		InfoRange& ir = lspDiag.range;
-		ir.from = FromLSPPositionToSciPosition(&r.start);
-		ir.to = FromLSPPositionToSciPosition(&r.end);
+		ir.from = sciPositions[index++];
+		ir.to = sciPositions[index++];
 		ir.info = v.message;
 
-		lspDiag.diagnostic = v;
+		lspDiag.diagnostic = std::move(v);
 
-		LogTrace("Diagnostics [%ld->%ld] [%s]", ir.from, ir.to, ir.info.c_str());
-		fEditor->SendMessage(SCI_INDICATORFILLRANGE, ir.from, ir.to - ir.from);
+		if (lspDiag.diagnostic.codeActions.value().size() == 0) {
+			// if the language server does not support in-line code actions we request
+			// them asynchronously, only when the diagnostic is visible or hovered.
+			auto cached = fCodeActions.find(DiagnosticKey(lspDiag.diagnostic));
+			if (cached != fCodeActions.end())
+				lspDiag.diagnostic.codeActions = cached->second;
+		}
+	}
+
+	// The indicators move with the text, the stored ranges don't: they can be
+	// compared with the new ones only if the document didn't change since
+	// the last update.
+	bool changed = true;
+	if (fDiagnosticsVersion == Version() && fChanges.empty() && !fFullSync)
+		changed = _UpdateDiagnosticIndicators(diagnostics);
+	else
+		_FillDiagnosticIndicators(diagnostics);
 
-		// dia["be:line"] = v.range.start.line + 1;
-		// dia["lsp:character"] = v.range.start.character;
+	fLastDiagnostics = std::move(diagnostics);
+	fDiagnosticsVersion = Version();
 
-		if (v.codeActions.value().size() == 0) {
-			// if the language serve does not support in-line code actions we request them
-			// asyncronously
-			// TODO: Check the capability
-			RequestCodeActions(v);
-		}
+	LogTrace("Diagnostics: %zu updated in %" B_PRId64 " us (changed: %d)",
+		fLastDiagnostics.size(), system_time() - start, changed);
 
-		fLastDiagnostics.push_back(lspDiag);
-	}
+	RequestVisibleCodeActions();
 
-	if (fEditor->LockLooper()) {
+	if (changed && fEditor->LockLooper()) {
 		fEditor->SetProblems();
 		fEditor->UnlockLooper();
 	}
@@ -824,11 +982,96 @@ LSPEditorWrapper::_DoDiagnostics(nlohmann::json& params)
 
 
 void
-LSPEditorWrapper::RequestCodeActions(Diagnostic& diagnostic)
+LSPEditorWrapper::_FillDiagnosticIndicators(const std::vector<LSPDiagnostic>& diagnostics)
 {
+	_RemoveAllDiagnostics();
+	for (const auto& d : diagnostics) {
+		LogTrace("Diagnostics [%ld->%ld] [%s]", d.range.from, d.range.to, d.range.info.c_str());
+		fEditor->SendMessage(SCI_INDICATORFILLRANGE, d.range.from, d.range.to - d.range.from);
+	}
+}
+
+
+// Touches only the indicators of the diagnostics which appeared or disappeared
+// since the last update. Returns false if the set of diagnostics is the same.
+bool
+LSPEditorWrapper::_UpdateDiagnosticIndicators(const std::vector<LSPDiagnostic>& diagnostics)
+{
+	// one clear costs less than one per diagnostic
+	if (diagnostics.empty()) {
+		if (fLastDiagnostics.empty())
+			return false;
+		_RemoveAllDiagnostics();
+		return true;
+	}
+
+	std::vector<const InfoRange*> removed;
+	std::vector<const InfoRange*> added;
+	if (!DiffDiagnostics(fLastDiagnostics, diagnostics, removed, added))
+		return false;
+
+	fEditor->SendMessage(SCI_SETINDICATORCURRENT, IND_DIAG);
+	for (const InfoRange* r : removed)
+		fEditor->SendMessage(SCI_INDICATORCLEARRANGE, r->from, r->to - r->from);
+	for (const InfoRange* r : added)
+		fEditor->SendMessage(SCI_INDICATORFILLRANGE, r->from, r->to - r->from);
+
+	LogTrace("Diagnostics: %zu added, %zu removed", added.size(), removed.size());
+	return true;
+}
+
+
+void
+LSPEditorWrapper::RequestVisibleCodeActions()
+{
+	if (!IsInitialized() || fLastDiagnostics.empty())
+		return;
+
+	const Sci_Position firstVisible = fEditor->SendMessage(SCI_GETFIRSTVISIBLELINE);
+	const Sci_Position first = fEditor->SendMessage(SCI_DOCLINEFROMVISIBLE, firstVisible);
+	const Sci_Position last = fEditor->SendMessage(SCI_DOCLINEFROMVISIBLE,
+		firstVisible + fEditor->SendMessage(SCI_LINESONSCREEN));
+
+	for (auto& d : fLastDiagnostics) {
+		const Range& range = d.diagnostic.range;
+		if (range.end.line >= first && range.start.line <= last)
+			_RequestCodeActions(range);
+	}
+}
+
+
+// Asks the code actions for all the diagnostics on the range with one request.
+// Every diagnostic is requested once per document version: the (possibly
+// empty) result is kept in fCodeActions.
+void
+LSPEditorWrapper::_RequestCodeActions(const Range& range)
+{
+	// the diagnostics are stale: wait for the ones of the current document.
+	if (!IsInitialized() || fCodeActionsVersion != Version() || !fChanges.empty() || fFullSync)
+		return;
+
 	CodeActionContext context;
-	context.diagnostics.push_back(std::move(diagnostic));
-	fLSPProjectWrapper->CodeAction(this, diagnostic.range, context);
+	for (auto& d : fLastDiagnostics) {
+		Diagnostic& diagnostic = d.diagnostic;
+		if (diagnostic.range != range || diagnostic.codeActions.value().size() > 0)
+			continue;
+		auto inserted = fCodeActions.emplace(DiagnosticKey(diagnostic), std::vector<CodeAction>());
+		if (inserted.second)
+			context.diagnostics.push_back(diagnostic);
+	}
+
+	if (context.diagnostics.empty())
+		return;
+
+	fLSPProjectWrapper->CodeAction(this, range, context);
+}
+
+
+void
+LSPEditorWrapper::_CacheCodeActions(const Diagnostic& diagnostic)
+{
+	if (fCodeActionsVersion == Version())
+		fCodeActions[DiagnosticKey(diagnostic)] = diagnostic.codeActions.value();
 }
 
 
@@ -851,20 +1094,26 @@ LSPEditorWrapper::_DoCodeActions(nlohmann::json& params)
 		action.data = data;
 
 		Range range;
-		range.start.character = data["Range"]["Start"]["Character"].get<int>();
-		range.start.line = data["Range"]["Start"]["Line"].get<int>();
-		range.end.character = data["Range"]["End"]["Character"].get<int>();
-		range.end.line = data["Range"]["End"]["Line"].get<int>();
+		if (!CodeActionRange(v, range))
+			continue;
 
+		bool found = false;
 		for (auto& d: fLastDiagnostics) {
 			if (d.diagnostic.range == range) {
-				d.diagnostic.codeActions.value().push_back(action);
+				auto& actions = d.diagnostic.codeActions.value();
+				if (std::find_if(actions.begin(), actions.end(), [&action](const CodeAction& ca) {
+						return ca.title == action.title; }) != actions.end()) {
+					continue;
+				}
+				actions.push_back(action);
 				action.diagnostics.value().push_back(d.diagnostic);
-
-				if (v["edit"].empty())
-					CodeActionResolve(v);
+				_CacheCodeActions(d.diagnostic);
+				found = true;
 			}
 		}
+		// one resolve per action, even if it applies to more diagnostics
+		if (found && v["edit"].empty())
+			CodeActionResolve(v);
 	}
 }
 
@@ -881,10 +1130,8 @@ LSPEditorWrapper::_DoCodeActionResolve(nlohmann::json& params)
 	action.data = data;
 
 	Range range;
-	range.start.character = data["Range"]["Start"]["Character"].get<int>();
-	range.start.line = data["Range"]["Start"]["Line"].get<int>();
-	range.end.character = data["Range"]["End"]["Character"].get<int>();
-	range.end.line = data["Range"]["End"]["Line"].get<int>();
+	if (!CodeActionRange(params, range))
+		return;
 
 	for (auto& d: fLastDiagnostics) {
 		if (d.diagnostic.range == range) {
@@ -895,6 +1142,7 @@ LSPEditorWrapper::_DoCodeActionResolve(nlohmann::json& params)
 					ca.edit = action.edit;
 				}
 			}
+			_CacheCodeActions(d.diagnostic);
 		}
 	}
 }
@@ -913,6 +1161,14 @@ void
 LSPEditorWrapper::_DoInitialize(nlohmann::json& params)
 {
 	fInitialized = true;
+
+	if (!fLineIndexAllocated
+		&& fLSPProjectWrapper->PositionEncoding() == OffsetEncoding::UTF16) {
+		fEditor->SendMessage(SCI_ALLOCATELINECHARACTERINDEX, SC_LINECHARACTERINDEX_UTF16);
+		fLineIndexAllocated = true;
+	}
+	InvalidatePositionCache();
+
 	didOpen();
 	BMessage symbols;
 	if (HasLSPServerCapability(kLCapDocumentSymbols))
@@ -929,11 +1185,20 @@ LSPEditorWrapper::_DoDocumentLink(nlohmann::json& result)
 
 	_RemoveAllDocumentLinks();
 
+	std::vector<const Position*> positions;
+	positions.reserve(links.size() * 2);
+	for (auto& l : links) {
+		positions.push_back(&l.range.start);
+		positions.push_back(&l.range.end);
+	}
+	std::vector<Sci_Position> sciPositions;
+	FromLSPPositionsToSciPositions(positions, sciPositions);
+
+	size_t index = 0;
 	for (auto& l : links) {
-		Range& r = l.range;
 		InfoRange ir;
-		ir.from = FromLSPPositionToSciPosition(&r.start);
-		ir.to = FromLSPPositionToSciPosition(&r.end);
+		ir.from = sciPositions[index++];
+		ir.to = sciPositions[index++];
 		ir.info = l.target;
 
 		LogTrace("DocumentLink [%ld->%ld] [%s]", ir.from, ir.to, l.target.c_str());
@@ -958,16 +1223,27 @@ LSPEditorWrapper::_DoFileStatus(nlohmann::json& params)
 void
 LSPEditorWrapper::_DoDocumentSymbol(nlohmann::json& params)
 {
-	BMessage msg(EDITOR_UPDATE_SYMBOLS);
+	std::vector<DocumentSymbol> symbols;
+	std::vector<SymbolInformation> information;
 	if (params.is_array() && params.size() > 0) {
-		if (params[0]["location"].is_null()) {
-			auto vect = params.get<std::vector<DocumentSymbol>>();
-			_DoRecursiveDocumentSymbol(vect, msg);
-		} else {
-			auto vect = params.get<std::vector<SymbolInformation>>();
-			_DoLinearSymbolInformation(vect, msg);
-		}
+		if (params[0]["location"].is_null())
+			symbols = params.get<std::vector<DocumentSymbol>>();
+		else
+			information = params.get<std::vector<SymbolInformation>>();
 	}
+	_UpdateDocumentSymbols(symbols, information);
+}
+
+
+void
+LSPEditorWrapper::_UpdateDocumentSymbols(std::vector<DocumentSymbol>& symbols,
+	std::vector<SymbolInformation>& information)
+{
+	BMessage msg(EDITOR_UPDATE_SYMBOLS);
+	if (!symbols.empty())
+		_DoRecursiveDocumentSymbol(symbols, msg);
+	else if (!information.empty())
+		_DoLinearSymbolInformation(information, msg);
 	if (fEditor != nullptr)
 		fEditor->SetDocumentSymbols(&msg, Editor::STATUS_HAS_SYMBOLS);
 }
@@ -1054,6 +1330,29 @@ LSPEditorWrapper::onResponse(RequestID id, value& result)
 }
 
 
+void
+LSPEditorWrapper::onDecoded(LSPMessage& message)
+{
+	switch (message.Decoded()) {
+		case LSPMessage::kCompletion:
+			_ShowCompletion(message.completion);
+			break;
+		case LSPMessage::kDiagnostics:
+			_UpdateDiagnostics(message.diagnostics);
+			break;
+		case LSPMessage::kDocumentSymbol:
+			_UpdateDocumentSymbols(message.documentSymbols, message.symbolInformation);
+			break;
+		case LSPMessage::kHover:
+			_ShowHover(message.hover);
+			break;
+		default:
+			LogError("LSPEditorWrapper::onDecoded not handled! [%s]", message.Method().c_str());
+			break;
+	}
+}
+
+
 void
 LSPEditorWrapper::onError(RequestID id, value& error)
 {
@@ -1070,26 +1369,87 @@ LSPEditorWrapper::onRequest(std::string method, value& params, value& ID)
 
 
 // utility
+const LSPEditorWrapper::LineInfo&
+LSPEditorWrapper::_LineInfo(Sci_Position line)
+{
+	if (fLineCache.line == line)
+		return fLineCache;
+
+	fLineCache.line = line;
+	fLineCache.start = fEditor->SendMessage(SCI_POSITIONFROMLINE, line, 0);
+	fLineCache.end = fEditor->SendMessage(SCI_GETLINEENDPOSITION, line, 0);
+	fLineCache.byteOffsets = true;
+	if (fLineCache.start < 0) {
+		// past the last line: everything maps to the end of the document
+		fLineCache.start = fLineCache.end = fEditor->SendMessage(SCI_GETLENGTH);
+	} else if (fLSPProjectWrapper != nullptr
+		&& fLSPProjectWrapper->PositionEncoding() == OffsetEncoding::UTF16) {
+		fLineCache.byteOffsets = false;
+		if (fLineIndexAllocated) {
+			// With the UTF-16 line index both lengths are O(1): a line with as many
+			// UTF-16 code units as bytes is plain ASCII and needs no conversion.
+			Sci_Position units
+				= fEditor->SendMessage(SCI_INDEXPOSITIONFROMLINE, line + 1, SC_LINECHARACTERINDEX_UTF16)
+				- fEditor->SendMessage(SCI_INDEXPOSITIONFROMLINE, line, SC_LINECHARACTERINDEX_UTF16);
+			Sci_Position next = fEditor->SendMessage(SCI_POSITIONFROMLINE, line + 1, 0);
+			if (next < 0)
+				next = fEditor->SendMessage(SCI_GETLENGTH);
+			fLineCache.byteOffsets = units == next - fLineCache.start;
+		}
+	}
+	return fLineCache;
+}
+
+
 void
 LSPEditorWrapper::FromSciPositionToLSPPosition(const Sci_Position& pos, Position* lsp_position)
 {
-	lsp_position->line = fEditor->SendMessage(SCI_LINEFROMPOSITION, pos, 0);
-	Sci_Position end_pos = fEditor->SendMessage(SCI_POSITIONFROMLINE, lsp_position->line, 0);
-	lsp_position->character = fEditor->SendMessage(SCI_COUNTCHARACTERS, end_pos, pos);
+	const LineInfo& info = _LineInfo(fEditor->SendMessage(SCI_LINEFROMPOSITION, pos, 0));
+	const Sci_Position end = std::min(pos, info.end);
+	lsp_position->line = info.line;
+	if (info.byteOffsets)
+		lsp_position->character = end - info.start;
+	else
+		lsp_position->character = fEditor->SendMessage(SCI_COUNTCODEUNITS, info.start, end);
 }
 
 
 Sci_Position
 LSPEditorWrapper::FromLSPPositionToSciPosition(const Position* lsp_position)
 {
+	const LineInfo& info = _LineInfo(lsp_position->line);
 	Sci_Position sci_position;
-	sci_position = fEditor->SendMessage(SCI_POSITIONFROMLINE, lsp_position->line, 0);
-	sci_position
-		= fEditor->SendMessage(SCI_POSITIONRELATIVE, sci_position, lsp_position->character);
+	if (info.byteOffsets) {
+		sci_position = info.start + lsp_position->character;
+	} else {
+		sci_position = fEditor->SendMessage(SCI_POSITIONRELATIVECODEUNITS, info.start,
+			lsp_position->character);
+	}
+	// a character past the end of the line means the end of the line
+	if (sci_position < info.start || sci_position > info.end)
+		sci_position = info.end;
 	return sci_position;
 }
 
 
+void
+LSPEditorWrapper::FromLSPPositionsToSciPositions(const std::vector<const Position*>& positions,
+	std::vector<Sci_Position>& sciPositions)
+{
+	// visit the positions line by line so each line is measured only once
+	std::vector<size_t> order(positions.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&positions](size_t a, size_t b) {
+		return positions[a]->line < positions[b]->line;
+	});
+
+	sciPositions.resize(positions.size());
+	for (size_t i : order)
+		sciPositions[i] = FromLSPPositionToSciPosition(positions[i]);
+}
+
+
 void
 LSPEditorWrapper::GetCurrentLSPPosition(Position* lsp_position)
 {
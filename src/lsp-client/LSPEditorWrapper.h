@@ -8,10 +8,12 @@
 #include <Autolock.h>
 #include <ToolTip.h>
 
+#include <map>
 #include <vector>
 
 #include "CallTipContext.h"
 #include "LSPCapabilities.h"
+#include "LSPDiagnostic.h"
 #include "LSPProjectWrapper.h"
 #include "LSPTextDocument.h"
 #include "protocol_objects.h"
@@ -20,18 +22,6 @@
 
 //#define DOCUMENT_LINK
 
-struct InfoRange {
-	Sci_Position	from;
-	Sci_Position	to;
-	std::string		info;
-};
-
-struct LSPDiagnostic {
-	InfoRange range;
-	Diagnostic diagnostic;
-	std::string fixTitle;
-};
-
 class Editor;
 class LSPProjectWrapper;
 
@@ -70,7 +60,7 @@ public:
 		void	StartHover(Sci_Position sci_position);
 		void	EndHover();
 		void	GetDiagnostics(std::vector<LSPDiagnostic>& diagnostics) { diagnostics = fLastDiagnostics; }
-		void	RequestCodeActions(Diagnostic& diagnostic);
+		void	RequestVisibleCodeActions();
 		void	CodeActionResolve(value &params);
 
 		void	IndicatorClick(Sci_Position position);
@@ -84,6 +74,9 @@ public:
 
 		void	MouseMoved(BMessage*);
 
+		// to be called on every text modification, before didChange()
+		void	InvalidatePositionCache() { fLineCache.line = -1; }
+
 public:
 	//still experimental
 	//std::string		fID;
@@ -91,6 +84,7 @@ public:
 	void onResponse(RequestID ID, value &result) override;
 	void onError(RequestID ID, value &error) override;
 	void onRequest(std::string method, value &params, value &ID) override;
+	void onDecoded(LSPMessage &message) override;
 
 	int32 DiagnosticFromPosition(Sci_Position p, LSPDiagnostic& dia);
 	int32 DiagnosticFromRange(Range& range, LSPDiagnostic& dia);
@@ -111,6 +105,19 @@ private:
 	std::vector<LSPDiagnostic>	fLastDiagnostics;
 	std::vector<InfoRange>		fLastDocumentLinks;
 
+	// code actions by diagnostic (range and message), valid for fCodeActionsVersion
+	std::map<std::string, std::vector<CodeAction>>	fCodeActions;
+	int							fCodeActionsVersion;
+
+	// document version of fLastDiagnostics ranges
+	int							fDiagnosticsVersion;
+
+	void				_FillDiagnosticIndicators(const std::vector<LSPDiagnostic>& diagnostics);
+	bool				_UpdateDiagnosticIndicators(const std::vector<LSPDiagnostic>& diagnostics);
+
+	void				_RequestCodeActions(const Range& range);
+	void				_CacheCodeActions(const Diagnostic& diagnostic);
+
 	void				_ShowToolTip(const char* text);
 	void				_RemoveAllDiagnostics();
 	void				_RemoveAllDocumentLinks();
@@ -132,12 +139,21 @@ private:
 	void	_DoCodeActions(nlohmann::json& params);
 	void	_DoCodeActionResolve(nlohmann::json& params);
 
+	// typed handlers, shared by the json callbacks and onDecoded
+	void	_ShowHover(const std::string& tip);
+	void	_ShowCompletion(CompletionList& allItems);
+	void	_UpdateDiagnostics(std::vector<Diagnostic>& vect);
+	void	_UpdateDocumentSymbols(std::vector<DocumentSymbol>& symbols,
+				std::vector<SymbolInformation>& information);
+
 	void	_DoRecursiveDocumentSymbol(std::vector<DocumentSymbol>& v, BMessage& msg);
 	void	_DoLinearSymbolInformation(std::vector<SymbolInformation>& v, BMessage& msg);
 private:
 	//utils
 	void 			FromSciPositionToLSPPosition(const Sci_Position &pos, Position *lsp_position);
 	Sci_Position 	FromLSPPositionToSciPosition(const Position* lsp_position);
+	void			FromLSPPositionsToSciPositions(const std::vector<const Position*>& positions,
+						std::vector<Sci_Position>& sciPositions);
 	void 			GetCurrentLSPPosition(Position *lsp_position);
 	void 			FromSciPositionToRange(Sci_Position s_start, Sci_Position s_end, Range *range);
 	Sci_Position 	ApplyTextEdit(nlohmann::json &textEdit);
@@ -146,7 +162,25 @@ private:
 						BString edits = "");
 	std::string 	GetCurrentLine();
 	bool			IsStatusValid();
+
+	// start, end and encoding info of the last line used by the conversions
+	struct LineInfo {
+		Sci_Position	line = -1;
+		Sci_Position	start = 0;
+		Sci_Position	end = 0;
+		// true when a Position::character is a byte offset on this line
+		bool			byteOffsets = true;
+	};
+	const LineInfo&	_LineInfo(Sci_Position line);
+
+	LineInfo		fLineCache;
+	bool			fLineIndexAllocated;
+
+	// pending didChange events, coalesced and sent by flushChanges()
 	std::vector<TextDocumentContentChangeEvent> fChanges;
+	Sci_Position	fLastChangeStart;
+	size_t			fPendingBytes;
+	bool			fFullSync;
 };
 
 #endif // LSPEditorWrapper_H
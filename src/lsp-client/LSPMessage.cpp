@@ -0,0 +1,967 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "LSPMessage.h"
+
+#include <OS.h>
+
+#include <cstring>
+#include <memory>
+
+#include "Log.h"
+#include "protocol.h"
+
+
+static const char* kCompletionMethod = "textDocument/completion";
+
+
+static bool
+EndsWith(const std::string& str, const char* suffix)
+{
+	size_t len = ::strlen(suffix);
+	return str.length() >= len && str.compare(str.length() - len, len, suffix) == 0;
+}
+
+
+// The method of a decoded response
+static const char*
+ResultMethod(LSPMessage::DecodedType type)
+{
+	switch (type) {
+		case LSPMessage::kCompletion:
+			return kCompletionMethod;
+		case LSPMessage::kDocumentSymbol:
+			return "textDocument/documentSymbol";
+		case LSPMessage::kHover:
+			return "textDocument/hover";
+		default:
+			return "";
+	}
+}
+
+
+// Builds a json value out of SAX events
+class JsonBuilder {
+public:
+	JsonBuilder(value& root)
+		:
+		fRoot(root)
+	{
+	}
+
+	size_t Depth() const { return fStack.size(); }
+
+	void Key(std::string& key)
+	{
+		fKey = std::move(key);
+	}
+
+	void Value(value&& item)
+	{
+		_Slot() = std::move(item);
+	}
+
+	void Start(bool array)
+	{
+		value& slot = _Slot();
+		slot = array ? value::array() : value::object();
+		fStack.push_back(&slot);
+	}
+
+	void End()
+	{
+		fStack.pop_back();
+	}
+
+private:
+	// the value being added: only the last child of an array is ever
+	// referenced, so a reallocation of the array can't invalidate fStack
+	value& _Slot()
+	{
+		if (fStack.empty())
+			return fRoot;
+		value& parent = *fStack.back();
+		if (parent.is_array()) {
+			parent.push_back(nullptr);
+			return parent.back();
+		}
+		return parent[fKey];
+	}
+
+	value&				fRoot;
+	std::vector<value*>	fStack;
+	std::string			fKey;
+};
+
+
+// Base of the streaming decoders of a payload, the result or the params of
+// a message: they fill the protocol_objects.h structs from the SAX events,
+// without building the json DOM. Each object or array is given a context
+// by _Enter(): the values of kSkip contexts are dropped, those of kCapture
+// are built as json and handed to _Captured(). Ranges are decoded here.
+class PayloadDecoder : public nlohmann::json_sax<value> {
+public:
+	PayloadDecoder()
+		:
+		fCapture(fCaptured),
+		fRange(nullptr),
+		fPosition(nullptr)
+	{
+	}
+
+	virtual ~PayloadDecoder()
+	{
+	}
+
+	// the payload is complete
+	virtual void Finish()
+	{
+	}
+
+	bool null() override
+	{
+		if (_Current() == kCapture)
+			fCapture.Value(nullptr);
+		return true;
+	}
+
+	bool boolean(bool val) override
+	{
+		if (_Current() == kCapture)
+			fCapture.Value(val);
+		else
+			_Boolean(_Current(), val);
+		return true;
+	}
+
+	bool number_integer(number_integer_t val) override
+	{
+		return _Number(val, value(val));
+	}
+
+	bool number_unsigned(number_unsigned_t val) override
+	{
+		return _Number(val, value(val));
+	}
+
+	bool number_float(number_float_t val, const string_t&) override
+	{
+		if (_Current() == kCapture)
+			fCapture.Value(val);
+		return true;
+	}
+
+	bool string(string_t& val) override
+	{
+		if (_Current() == kCapture)
+			fCapture.Value(std::move(val));
+		else
+			_String(_Current(), val);
+		return true;
+	}
+
+	bool binary(binary_t&) override
+	{
+		return true;
+	}
+
+	bool key(string_t& val) override
+	{
+		if (_Current() == kCapture)
+			fCapture.Key(val);
+		else if (_Current() != kSkip)
+			fKey = std::move(val);
+		return true;
+	}
+
+	bool start_object(std::size_t) override
+	{
+		_Start(false);
+		return true;
+	}
+
+	bool start_array(std::size_t) override
+	{
+		_Start(true);
+		return true;
+	}
+
+	bool end_object() override
+	{
+		_End();
+		return true;
+	}
+
+	bool end_array() override
+	{
+		_End();
+		return true;
+	}
+
+	bool parse_error(std::size_t, const std::string&,
+		const nlohmann::detail::exception&) override
+	{
+		// reported by the MessageDecoder
+		return false;
+	}
+
+protected:
+	// the contexts of the derived decoders start at kFirstContext
+	static constexpr int kSkip = 0;
+	static constexpr int kPayload = 1;	// the payload itself, for _Enter()
+	static constexpr int kRange = 2;
+	static constexpr int kPosition = 3;
+	static constexpr int kCapture = 4;
+	static constexpr int kFirstContext = 5;
+
+	// Returns the context of the object or array starting, a child of parent
+	// at fKey
+	virtual	int		_Enter(int parent, bool array) = 0;
+	virtual	void	_Leave(int context) {}
+	virtual	void	_String(int context, string_t& val) {}
+	virtual	void	_Integer(int context, int64_t val) {}
+	virtual	void	_Boolean(int context, bool val) {}
+	virtual	void	_Captured(int context, const std::string& key, value& json) {}
+
+	int _EnterRange(Range* range)
+	{
+		fRange = range;
+		return kRange;
+	}
+
+	std::string		fKey;
+
+private:
+	int _Current() const
+	{
+		return fStack.empty() ? kPayload : fStack.back();
+	}
+
+	bool _Number(int64_t val, value&& json)
+	{
+		const int context = _Current();
+		if (context == kCapture) {
+			fCapture.Value(std::move(json));
+		} else if (context == kPosition) {
+			if (fKey == "line")
+				fPosition->line = val;
+			else if (fKey == "character")
+				fPosition->character = val;
+		} else {
+			_Integer(context, val);
+		}
+		return true;
+	}
+
+	void _Start(bool array)
+	{
+		const int parent = _Current();
+		int context = kSkip;
+		if (parent == kCapture) {
+			fCapture.Start(array);
+			context = kCapture;
+		} else if (parent == kRange) {
+			if (!array && (fKey == "start" || fKey == "end")) {
+				fPosition = fKey == "start" ? &fRange->start : &fRange->end;
+				context = kPosition;
+			}
+		} else if (parent != kSkip && parent != kPosition) {
+			context = _Enter(parent, array);
+			if (context == kCapture)
+				fCapture.Start(array);
+		}
+		fStack.push_back(context);
+	}
+
+	void _End()
+	{
+		const int context = _Current();
+		fStack.pop_back();
+		if (context == kCapture) {
+			fCapture.End();
+			if (fCapture.Depth() == 0) {
+				_Captured(_Current(), fKey, fCaptured);
+				fCaptured = nullptr;
+			}
+		} else if (context >= kFirstContext) {
+			_Leave(context);
+		}
+	}
+
+	std::vector<int>	fStack;
+	value				fCaptured;
+	JsonBuilder			fCapture;
+	Range*				fRange;
+	Position*			fPosition;
+};
+
+
+// The result of textDocument/completion: a CompletionList or a plain
+// CompletionItem[]
+class CompletionDecoder : public PayloadDecoder {
+public:
+	CompletionDecoder(CompletionList& list)
+		:
+		fList(list),
+		fEdit(nullptr)
+	{
+	}
+
+protected:
+	enum {
+		kResult = kFirstContext,
+		kItems,
+		kItem,
+		kTextEdit,
+		kEdits
+	};
+
+	int _Enter(int parent, bool array) override
+	{
+		switch (parent) {
+			case kPayload:
+				return array ? kItems : kResult;
+			case kResult:
+				return array && fKey == "items" ? kItems : kSkip;
+			case kItems:
+				if (array)
+					return kSkip;
+				fList.items.emplace_back();
+				return kItem;
+			case kItem:
+				if (!array && fKey == "textEdit") {
+					fEdit = &fList.items.back().textEdit;
+					return kTextEdit;
+				}
+				return array && fKey == "additionalTextEdits" ? kEdits : kSkip;
+			case kEdits:
+				if (array)
+					return kSkip;
+				fEdit = &fList.items.back().additionalTextEdits.emplace_back();
+				return kTextEdit;
+			case kTextEdit:
+				return !array && fKey == "range" ? _EnterRange(&fEdit->range) : kSkip;
+			default:
+				return kSkip;
+		}
+	}
+
+	void _String(int context, string_t& val) override
+	{
+		if (context == kItem) {
+			CompletionItem& item = fList.items.back();
+			if (fKey == "label")
+				item.label = std::move(val);
+			else if (fKey == "insertText")
+				item.insertText = std::move(val);
+			else if (fKey == "detail")
+				item.detail = std::move(val);
+			else if (fKey == "sortText")
+				item.sortText = std::move(val);
+			else if (fKey == "filterText")
+				item.filterText = std::move(val);
+		} else if (context == kTextEdit && fKey == "newText") {
+			fEdit->newText = std::move(val);
+		}
+	}
+
+	void _Integer(int context, int64_t val) override
+	{
+		if (context != kItem)
+			return;
+		if (fKey == "kind")
+			fList.items.back().kind = (CompletionItemKind)val;
+		else if (fKey == "insertTextFormat")
+			fList.items.back().insertTextFormat = (InsertTextFormat)val;
+	}
+
+	void _Boolean(int context, bool val) override
+	{
+		if (context == kResult && fKey == "isIncomplete")
+			fList.isIncomplete = val;
+		else if (context == kItem && fKey == "deprecated")
+			fList.items.back().deprecated = val;
+	}
+
+private:
+	CompletionList&	fList;
+	TextEdit*		fEdit;
+};
+
+
+// The params of textDocument/publishDiagnostics. The code actions of clangd
+// are built as json and converted, they are few and small.
+class DiagnosticsDecoder : public PayloadDecoder {
+public:
+	DiagnosticsDecoder(std::string& uri, std::vector<Diagnostic>& diagnostics)
+		:
+		fURI(uri),
+		fDiagnostics(diagnostics)
+	{
+	}
+
+protected:
+	enum {
+		kParams = kFirstContext,
+		kDiagnostics,
+		kDiagnostic,
+		kRelatedList,
+		kRelated,
+		kLocation
+	};
+
+	int _Enter(int parent, bool array) override
+	{
+		switch (parent) {
+			case kPayload:
+				return array ? kSkip : kParams;
+			case kParams:
+				return array && fKey == "diagnostics" ? kDiagnostics : kSkip;
+			case kDiagnostics:
+				if (array)
+					return kSkip;
+				fDiagnostics.emplace_back();
+				return kDiagnostic;
+			case kDiagnostic:
+			{
+				Diagnostic& diagnostic = fDiagnostics.back();
+				if (!array && fKey == "range")
+					return _EnterRange(&diagnostic.range);
+				if (array && fKey == "relatedInformation") {
+					diagnostic.relatedInformation = std::vector<DiagnosticRelatedInformation>();
+					return kRelatedList;
+				}
+				return array && fKey == "codeActions" ? kCapture : kSkip;
+			}
+			case kRelatedList:
+				if (array)
+					return kSkip;
+				fDiagnostics.back().relatedInformation->emplace_back();
+				return kRelated;
+			case kRelated:
+				return !array && fKey == "location" ? kLocation : kSkip;
+			case kLocation:
+				return !array && fKey == "range"
+					? _EnterRange(&_Related().location.range) : kSkip;
+			default:
+				return kSkip;
+		}
+	}
+
+	void _String(int context, string_t& val) override
+	{
+		switch (context) {
+			case kParams:
+				if (fKey == "uri")
+					fURI = std::move(val);
+				break;
+			case kDiagnostic:
+			{
+				Diagnostic& diagnostic = fDiagnostics.back();
+				if (fKey == "message")
+					diagnostic.message = std::move(val);
+				else if (fKey == "source")
+					diagnostic.source = std::move(val);
+				else if (fKey == "category")
+					diagnostic.category = std::move(val);
+				break;
+			}
+			case kRelated:
+				if (fKey == "message")
+					_Related().message = std::move(val);
+				break;
+			case kLocation:
+				if (fKey == "uri")
+					_Related().location.uri = std::move(val);
+				break;
+			default:
+				break;
+		}
+	}
+
+	void _Captured(int context, const std::string& key, value& json) override
+	{
+		if (context == kDiagnostic && key == "codeActions")
+			fDiagnostics.back().codeActions = json.get<std::vector<CodeAction>>();
+	}
+
+private:
+	DiagnosticRelatedInformation& _Related()
+	{
+		return fDiagnostics.back().relatedInformation->back();
+	}
+
+	std::string&				fURI;
+	std::vector<Diagnostic>&	fDiagnostics;
+};
+
+
+// The result of textDocument/documentSymbol: a DocumentSymbol tree, or a
+// SymbolInformation list when the first symbol has a location. Both are
+// decoded until the end, then the wrong one is dropped.
+class SymbolDecoder : public PayloadDecoder {
+public:
+	SymbolDecoder(std::vector<DocumentSymbol>& symbols,
+			std::vector<SymbolInformation>& information)
+		:
+		fSymbols(symbols),
+		fInformation(information),
+		fFirstHasLocation(false)
+	{
+	}
+
+	void Finish() override
+	{
+		if (!fFirstHasLocation) {
+			fInformation.clear();
+			return;
+		}
+		for (size_t i = 0; i < fSymbols.size(); i++) {
+			fInformation[i].name = std::move(fSymbols[i].name);
+			fInformation[i].kind = fSymbols[i].kind;
+		}
+		fSymbols.clear();
+	}
+
+protected:
+	enum {
+		kSymbols = kFirstContext,
+		kSymbol,	// top level: a DocumentSymbol or a SymbolInformation
+		kChildren,
+		kChild,
+		kLocation
+	};
+
+	int _Enter(int parent, bool array) override
+	{
+		switch (parent) {
+			case kPayload:
+				return array ? kSymbols : kSkip;
+			case kSymbols:
+				if (array)
+					return kSkip;
+				fCurrent.push_back(&fSymbols.emplace_back());
+				fInformation.emplace_back();
+				return kSymbol;
+			case kSymbol:
+			case kChild:
+				if (array)
+					return fKey == "children" ? kChildren : kSkip;
+				if (fKey == "range")
+					return _EnterRange(&fCurrent.back()->range);
+				if (fKey == "selectionRange")
+					return _EnterRange(&fCurrent.back()->selectionRange);
+				if (parent == kSymbol && fKey == "location") {
+					fFirstHasLocation = fFirstHasLocation || fSymbols.size() == 1;
+					return kLocation;
+				}
+				return kSkip;
+			case kChildren:
+				if (array)
+					return kSkip;
+				fCurrent.push_back(&fCurrent.back()->children.emplace_back());
+				return kChild;
+			case kLocation:
+				return !array && fKey == "range"
+					? _EnterRange(&fInformation.back().location.range) : kSkip;
+			default:
+				return kSkip;
+		}
+	}
+
+	void _Leave(int context) override
+	{
+		if (context == kSymbol || context == kChild)
+			fCurrent.pop_back();
+	}
+
+	void _String(int context, string_t& val) override
+	{
+		if (context == kSymbol || context == kChild) {
+			if (fKey == "name")
+				fCurrent.back()->name = std::move(val);
+			else if (fKey == "detail")
+				fCurrent.back()->detail = std::move(val);
+			else if (context == kSymbol && fKey == "containerName")
+				fInformation.back().containerName = std::move(val);
+		} else if (context == kLocation && fKey == "uri") {
+			fInformation.back().location.uri = std::move(val);
+		}
+	}
+
+	void _Integer(int context, int64_t val) override
+	{
+		if ((context == kSymbol || context == kChild) && fKey == "kind")
+			fCurrent.back()->kind = (SymbolKind)val;
+	}
+
+	void _Boolean(int context, bool val) override
+	{
+		if ((context == kSymbol || context == kChild) && fKey == "deprecated")
+			fCurrent.back()->deprecated = val;
+	}
+
+private:
+	std::vector<DocumentSymbol>&	fSymbols;
+	std::vector<SymbolInformation>&	fInformation;
+	// the symbols being decoded: a child is added to the last one only,
+	// so the pointers stay valid
+	std::vector<DocumentSymbol*>	fCurrent;
+	bool							fFirstHasLocation;
+};
+
+
+// The result of textDocument/hover: only the markup of the contents is used
+class HoverDecoder : public PayloadDecoder {
+public:
+	HoverDecoder(std::string& hover)
+		:
+		fHover(hover)
+	{
+	}
+
+protected:
+	enum {
+		kResult = kFirstContext,
+		kContents
+	};
+
+	int _Enter(int parent, bool array) override
+	{
+		if (parent == kPayload)
+			return array ? kSkip : kResult;
+		if (parent == kResult && !array && fKey == "contents")
+			return kContents;
+		return kSkip;
+	}
+
+	void _String(int context, string_t& val) override
+	{
+		if (context == kContents && fKey == "value")
+			fHover = std::move(val);
+	}
+
+private:
+	std::string&	fHover;
+};
+
+
+// Parses a whole message in one pass. The envelope is built as json, the
+// payloads with a decoder are decoded straight into the message and left
+// null in the json. Servers send the id and the method before the payload:
+// when they don't, the payload is built as json too and converted later.
+class MessageDecoder : public nlohmann::json_sax<value> {
+public:
+	MessageDecoder(LSPMessage& message)
+		:
+		fMessage(message),
+		fBuilder(message.json),
+		fPayloadDepth(0),
+		fDecoded(LSPMessage::kNotDecoded)
+	{
+	}
+
+	LSPMessage::DecodedType Decoded() const { return fDecoded; }
+	const std::string& ID() const { return fID; }
+	const std::string& Method() const { return fMethod; }
+	const std::string& URI() const { return fURI; }
+
+	bool null() override
+	{
+		if (fPayload != nullptr)
+			return fPayload->null();
+		if (_AtRoot() && fKey == "result") {
+			// a null result is an empty one
+			fDecoded = _ResultType();
+		}
+		fBuilder.Value(nullptr);
+		return true;
+	}
+
+	bool boolean(bool val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->boolean(val);
+		fBuilder.Value(val);
+		return true;
+	}
+
+	bool number_integer(number_integer_t val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->number_integer(val);
+		fBuilder.Value(val);
+		return true;
+	}
+
+	bool number_unsigned(number_unsigned_t val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->number_unsigned(val);
+		fBuilder.Value(val);
+		return true;
+	}
+
+	bool number_float(number_float_t val, const string_t& text) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->number_float(val, text);
+		fBuilder.Value(val);
+		return true;
+	}
+
+	bool string(string_t& val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->string(val);
+		if (_AtRoot() && fKey == "id")
+			fID = val;
+		else if (_AtRoot() && fKey == "method")
+			fMethod = val;
+		fBuilder.Value(std::move(val));
+		return true;
+	}
+
+	bool binary(binary_t& val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->binary(val);
+		fBuilder.Value(value::binary(val));
+		return true;
+	}
+
+	bool key(string_t& val) override
+	{
+		if (fPayload != nullptr)
+			return fPayload->key(val);
+		if (_AtRoot())
+			fKey = val;
+		fBuilder.Key(val);
+		return true;
+	}
+
+	bool start_object(std::size_t length) override
+	{
+		if (_StartPayload(false))
+			return fPayload->start_object(length);
+		fBuilder.Start(false);
+		return true;
+	}
+
+	bool start_array(std::size_t length) override
+	{
+		if (_StartPayload(true))
+			return fPayload->start_array(length);
+		fBuilder.Start(true);
+		return true;
+	}
+
+	bool end_object() override
+	{
+		if (fPayload != nullptr)
+			return _EndPayload(fPayload->end_object());
+		fBuilder.End();
+		return true;
+	}
+
+	bool end_array() override
+	{
+		if (fPayload != nullptr)
+			return _EndPayload(fPayload->end_array());
+		fBuilder.End();
+		return true;
+	}
+
+	bool parse_error(std::size_t position, const std::string& lastToken,
+		const nlohmann::detail::exception& ex) override
+	{
+		LogError("LSPMessage: can't parse message: %s", ex.what());
+		return false;
+	}
+
+private:
+	bool _AtRoot() const
+	{
+		return fBuilder.Depth() == 1;
+	}
+
+	LSPMessage::DecodedType _ResultType() const
+	{
+		if (fID.empty() || !fMethod.empty())
+			return LSPMessage::kNotDecoded;
+		if (EndsWith(fID, kCompletionMethod))
+			return LSPMessage::kCompletion;
+		if (EndsWith(fID, "textDocument/documentSymbol"))
+			return LSPMessage::kDocumentSymbol;
+		if (EndsWith(fID, "textDocument/hover"))
+			return LSPMessage::kHover;
+		return LSPMessage::kNotDecoded;
+	}
+
+	bool _StartPayload(bool array)
+	{
+		if (fPayload != nullptr) {
+			fPayloadDepth++;
+			return true;
+		}
+		if (!_AtRoot())
+			return false;
+
+		if (fKey == "result") {
+			fDecoded = _ResultType();
+			switch (fDecoded) {
+				case LSPMessage::kCompletion:
+					fPayload.reset(new CompletionDecoder(fMessage.completion));
+					break;
+				case LSPMessage::kDocumentSymbol:
+					fPayload.reset(new SymbolDecoder(fMessage.documentSymbols,
+						fMessage.symbolInformation));
+					break;
+				case LSPMessage::kHover:
+					fPayload.reset(new HoverDecoder(fMessage.hover));
+					break;
+				default:
+					break;
+			}
+		} else if (fKey == "params" && fID.empty()
+			&& fMethod == "textDocument/publishDiagnostics") {
+			fDecoded = LSPMessage::kDiagnostics;
+			fPayload.reset(new DiagnosticsDecoder(fURI, fMessage.diagnostics));
+		}
+		if (fPayload == nullptr)
+			return false;
+		fBuilder.Value(nullptr);
+		fPayloadDepth = 1;
+		return true;
+	}
+
+	bool _EndPayload(bool result)
+	{
+		if (--fPayloadDepth == 0) {
+			fPayload->Finish();
+			fPayload.reset();
+		}
+		return result;
+	}
+
+	LSPMessage&			fMessage;
+	JsonBuilder			fBuilder;
+	std::string			fKey;	// the last key of the envelope
+	std::unique_ptr<PayloadDecoder>	fPayload;
+	int32				fPayloadDepth;
+	LSPMessage::DecodedType	fDecoded;
+	std::string			fID;
+	std::string			fMethod;
+	std::string			fURI;
+};
+
+
+LSPMessage::LSPMessage()
+	:
+	fDecoded(kNotDecoded)
+{
+}
+
+
+bool
+LSPMessage::Parse(const std::string& data)
+{
+	bigtime_t start = system_time();
+
+	try {
+		MessageDecoder decoder(*this);
+		if (!nlohmann::json::sax_parse(data, &decoder))
+			return false;
+		if (decoder.Decoded() != kNotDecoded) {
+			fDecoded = decoder.Decoded();
+			fID = decoder.ID();
+			fMethod = decoder.Method();
+			fURI = decoder.URI();
+			if (fMethod.empty())
+				fMethod = ResultMethod(fDecoded);
+			LogTrace("LSPMessage: decoded %s in %" B_PRId64 " us", fMethod.empty()
+				? fID.c_str() : fMethod.c_str(), system_time() - start);
+			return true;
+		}
+	} catch (std::exception& e) {
+		// a payload not matching its type: the window thread will handle
+		// the json, parsed again
+		LogTrace("LSPMessage: can't decode message: %s", e.what());
+		_Clear();
+		try {
+			json = nlohmann::json::parse(data);
+		} catch (std::exception& e) {
+			LogError("LSPMessage: can't parse message: %s", e.what());
+			return false;
+		}
+	}
+
+	// the payload came before the id or the method, or has no decoder
+	try {
+		_DecodeDOM();
+	} catch (std::exception& e) {
+		// leave the json untouched, the window thread will handle it.
+		LogTrace("LSPMessage: can't decode %s: %s", fMethod.c_str(), e.what());
+		_Clear();
+	}
+
+	if (fDecoded != kNotDecoded) {
+		LogTrace("LSPMessage: decoded %s in %" B_PRId64 " us", fMethod.c_str(),
+			system_time() - start);
+	}
+	return true;
+}
+
+
+void
+LSPMessage::_Clear()
+{
+	fDecoded = kNotDecoded;
+	completion = CompletionList();
+	diagnostics.clear();
+	documentSymbols.clear();
+	symbolInformation.clear();
+	hover.clear();
+}
+
+
+void
+LSPMessage::_DecodeDOM()
+{
+	if (json.contains("id") && json["id"].is_string() && json.contains("result")) {
+		fID = json["id"].get<std::string>();
+		value& result = json["result"];
+		if (EndsWith(fID, "textDocument/documentSymbol")) {
+			fMethod = "textDocument/documentSymbol";
+			if (result.is_array() && result.size() > 0) {
+				if (result[0]["location"].is_null())
+					documentSymbols = result.get<std::vector<DocumentSymbol>>();
+				else
+					symbolInformation = result.get<std::vector<SymbolInformation>>();
+			}
+			fDecoded = kDocumentSymbol;
+		} else if (EndsWith(fID, "textDocument/hover")) {
+			fMethod = "textDocument/hover";
+			if (result.is_object() && result["contents"].contains("value"))
+				hover = result["contents"]["value"].get<std::string>();
+			fDecoded = kHover;
+		} else if (EndsWith(fID, kCompletionMethod)) {
+			fMethod = kCompletionMethod;
+			if (!result.is_null())
+				completion = result.get<CompletionList>();
+			fDecoded = kCompletion;
+		}
+		if (fDecoded != kNotDecoded)
+			result = nullptr;
+	} else if (!json.contains("id") && json.contains("method")
+		&& json["method"] == "textDocument/publishDiagnostics") {
+		fMethod = "textDocument/publishDiagnostics";
+		value& params = json["params"];
+		fURI = params["uri"].get<std::string>();
+		diagnostics = params["diagnostics"].get<std::vector<Diagnostic>>();
+		fDecoded = kDiagnostics;
+		params = nullptr;
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MessageHandler.h"
+#include "protocol_objects.h"
+
+// A message read from the LSP server.
+// It's parsed by the reader thread: for the hottest methods the payload is
+// decoded into the protocol_objects.h structs while parsing, without the
+// json DOM (and left null in the json), so the window thread only has to
+// apply the result.
+class LSPMessage {
+public:
+	enum DecodedType {
+		kNotDecoded = 0,
+		kCompletion,
+		kDiagnostics,
+		kDocumentSymbol,
+		kHover
+	};
+
+						LSPMessage();
+
+	bool				Parse(const std::string& data);
+
+	DecodedType			Decoded() const { return fDecoded; }
+	bool				IsResponse() const { return !fID.empty(); }
+
+	// full message when not decoded, otherwise just the envelope.
+	value				json;
+
+	const RequestID&	ID() const { return fID; }
+	const std::string&	Method() const { return fMethod; }
+	const std::string&	URI() const { return fURI; }
+
+	CompletionList					completion;
+	std::vector<Diagnostic>			diagnostics;
+	std::vector<DocumentSymbol>		documentSymbols;
+	std::vector<SymbolInformation>	symbolInformation;
+	std::string						hover;
+
+private:
+	void				_DecodeDOM();
+	void				_Clear();
+
+	DecodedType			fDecoded;
+	RequestID			fID;
+	std::string			fMethod;
+	std::string			fURI;
+};
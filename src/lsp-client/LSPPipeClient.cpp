@@ -10,6 +10,11 @@
 
 #include "LSPPipeClient.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
 #include "Log.h"
 #include "LSPReaderThread.h"
 
@@ -38,36 +43,78 @@ LSPPipeClient::~LSPPipeClient()
 }
 
 
+// Initial size of the framing buffer. It grows only if a single header line
+// does not fit, bodies are copied out of it or read directly.
+const size_t kReadBufferSize = 64 * 1024;
+const size_t kMaxHeaderLine = 4096;
+
+
 bool
-LSPPipeClient::ReadHeaderLine(char* header, size_t maxlen)
-{
-	ssize_t hasRead = 0;
-	size_t length = 0;
-	while ((hasRead = fPipeImage.Read(&header[length], 1)) != -1) {
-		if (hasRead == 0 || length >= maxlen - 1) // pipe eof or protection
-			return false;
+LSPPipeClient::FillBuffer()
+{
+	// compact the unread bytes at the beginning of the buffer
+	if (fReadStart > 0) {
+		if (fReadEnd > fReadStart)
+			::memmove(fReadBuffer.data(), fReadBuffer.data() + fReadStart,
+				fReadEnd - fReadStart);
+		fReadEnd -= fReadStart;
+		fReadStart = 0;
+	}
 
-		if (header[length] == '\n') {
-			break;
+	if (fReadEnd == fReadBuffer.size())
+		fReadBuffer.resize(fReadBuffer.size() * 2);
+
+	ssize_t hasRead;
+	do {
+		hasRead = fPipeImage.Read(fReadBuffer.data() + fReadEnd,
+			fReadBuffer.size() - fReadEnd);
+	} while (hasRead == -1 && errno == EINTR);
+
+	if (hasRead <= 0) // pipe eof or error
+		return false;
+
+	fReadEnd += hasRead;
+	return true;
+}
+
+
+bool
+LSPPipeClient::ReadHeaderLine(const char** line, size_t* length)
+{
+	// the returned line points inside fReadBuffer and includes the '\n'.
+	// It's valid until the next call to FillBuffer.
+	while (true) {
+		const char* begin = fReadBuffer.data() + fReadStart;
+		size_t available = fReadEnd - fReadStart;
+		const char* newLine = (const char*)::memchr(begin, '\n', available);
+		if (newLine != nullptr) {
+			*line = begin;
+			*length = newLine - begin + 1;
+			fReadStart += *length;
+			return true;
 		}
-		length++;
+		if (available >= kMaxHeaderLine) // protection
+			return false;
+		if (!FillBuffer())
+			return false;
 	}
-	return true;
 }
 
 
 int
 LSPPipeClient::ReadMessageHeader()
 {
-	char szReadBuffer[255];
+	const char* line;
+	size_t lineLength;
 	int len = 0;
-	while (ReadHeaderLine(szReadBuffer, 255)) {
-		if (::strncmp(szReadBuffer, "Content-Length: ", 16) == 0) {
-			len = ::strtol(szReadBuffer + 16, nullptr, 10);
-		} else if (::strncmp(szReadBuffer, "\r\n", 2) == 0) {
+	while (ReadHeaderLine(&line, &lineLength)) {
+		if (lineLength > 16 && ::strncmp(line, "Content-Length: ", 16) == 0) {
+			// the line is terminated by \r\n so strtol can't overrun
+			len = ::strtol(line + 16, nullptr, 10);
+		} else if (lineLength == 2 && ::strncmp(line, "\r\n", 2) == 0) {
 			break;
 		} else {
-			LogTrace("Unsuported LSP message header: %s", szReadBuffer);
+			LogTrace("Unsuported LSP message header: %.*s", (int)lineLength, line);
 		}
 	}
 	return len;
@@ -77,17 +124,21 @@ LSPPipeClient::ReadMessageHeader()
 int
 LSPPipeClient::Read(int length, std::string &out)
 {
-	int readSize = 0;
-	ssize_t hasRead;
 	out.resize(length);
-	while ((hasRead = fPipeImage.Read(&out[readSize], length)) != -1) {
-		if (hasRead == 0) // pipe eof
-			return 0;
 
+	// first consume what is already buffered
+	size_t readSize = std::min((size_t)length, fReadEnd - fReadStart);
+	::memcpy(out.data(), fReadBuffer.data() + fReadStart, readSize);
+	fReadStart += readSize;
+
+	// then read the rest of the body straight into the destination
+	while (readSize < (size_t)length) {
+		ssize_t hasRead = fPipeImage.Read(&out[readSize], length - readSize);
+		if (hasRead == -1 && errno == EINTR)
+			continue;
+		if (hasRead <= 0) // pipe eof or error
+			return 0;
 		readSize += hasRead;
-		if (readSize >= length) {
-			break;
-		}
 	}
 
 	return readSize;
@@ -95,21 +146,18 @@ LSPPipeClient::Read(int length, std::string &out)
 
 
 bool
-LSPPipeClient::Write(std::string &in)
-{
-	ssize_t hasWritten = 0;
-	if (fWriteLock.Lock()) { // for production code: WithTimeout(1000000) == B_OK)
-		size_t writeSize = 0;
-		size_t totalSize = in.length();
-		while ((hasWritten = fPipeImage.Write(&in[writeSize], totalSize)) != -1) {
-			writeSize += hasWritten;
-			if (writeSize >= totalSize || hasWritten == 0) {
-				break;
-			}
-		}
-		fWriteLock.Unlock();
+LSPPipeClient::Write(const char* data, size_t totalSize)
+{
+	size_t writeSize = 0;
+	while (writeSize < totalSize) {
+		ssize_t hasWritten = fPipeImage.Write(data + writeSize, totalSize - writeSize);
+		if (hasWritten == -1 && errno == EINTR)
+			continue;
+		if (hasWritten <= 0)
+			return false;
+		writeSize += hasWritten;
 	}
-	return (hasWritten != 0);
+	return true;
 }
 
 
@@ -120,8 +168,6 @@ LSPPipeClient::readMessage(std::string &json)
 	int length = ReadMessageHeader();
 	if (length == 0)
 		return false;
-	//SkipLine();
-	//std::string read;
 	if (Read(length, json) == 0)
 		return false;
 	LogTrace("Client - rcv %d:\n%s\n", length, json.c_str());
@@ -132,17 +178,28 @@ LSPPipeClient::readMessage(std::string &json)
 bool
 LSPPipeClient::writeMessage(std::string &content)
 {
-	std::string header = "Content-Length: " + std::to_string(content.length()) +
-                       "\r\n\r\n" + content;
+	char header[64];
+	int headerLength = ::snprintf(header, sizeof(header), "Content-Length: %zu\r\n\r\n",
+		content.length());
 	LogTrace("Client: - snd \n%s\n", content.c_str());
-	return Write(header);
+
+	// header and body are written separately to avoid copying the whole body
+	bool written = false;
+	if (fWriteLock.Lock()) { // for production code: WithTimeout(1000000) == B_OK)
+		written = Write(header, headerLength) && Write(content.data(), content.length());
+		fWriteLock.Unlock();
+	}
+	return written;
 }
 
 
 LSPPipeClient::LSPPipeClient(uint32 what, BMessenger& msgr)
 	:
 	AsyncJsonTransport(what, msgr),
-	fReaderThread(nullptr)
+	fReaderThread(nullptr),
+	fReadBuffer(kReadBufferSize),
+	fReadStart(0),
+	fReadEnd(0)
 {
 }
 
@@ -157,6 +214,7 @@ LSPPipeClient::GetChildPid() const
 void
 LSPPipeClient::ForceQuit()
 {
+	StopDelivery();
 	if (fReaderThread)
 		fReaderThread->Suspend();
 
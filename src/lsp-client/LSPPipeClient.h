@@ -7,6 +7,8 @@
 
 #include <unistd.h>
 
+#include <vector>
+
 #include "PipeImage.h"
 #include "Transport.h"
 
@@ -35,13 +37,20 @@ public:
 
 private:
   int 	ReadMessageHeader();
-  bool	ReadHeaderLine(char* header, size_t maxlen);
+  bool	ReadHeaderLine(const char** line, size_t* length);
   int 	Read(int length, std::string &out);
-  bool 	Write(std::string &in);
+  bool	FillBuffer();
+  bool 	Write(const char* data, size_t size);
   void	Quit() override;
   thread_id	Run() override;
 
   BLocker 			fWriteLock;
   LSPReaderThread*	fReaderThread;
   PipeImage			fPipeImage;
+
+  // Buffered framing: the reader thread fills fReadBuffer with large
+  // reads and parses headers and bodies in place.
+  std::vector<char>	fReadBuffer;
+  size_t			fReadStart;
+  size_t			fReadEnd;
 };
@@ -4,7 +4,17 @@
  */
 #include "LSPProjectWrapper.h"
 
+#include <OS.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "ConfigManager.h"
+#include "GenioApp.h"
 #include "Log.h"
+#include "LSPMessage.h"
 #include "LSPPipeClient.h"
 #include "LSPReaderThread.h"
 #include "LSPServersManager.h"
@@ -13,6 +23,7 @@
 
 
 const int32 kLSPMessage = 'LSP!';
+const bigtime_t kMemorySampleInterval = 10000000;
 
 LSPProjectWrapper::LSPProjectWrapper(BPath rootPath, const BMessenger& msgr,
 		const LSPServerConfigInterface& serverConfig)
@@ -20,44 +31,133 @@ LSPProjectWrapper::LSPProjectWrapper(BPath rootPath, const BMessenger& msgr,
 	BHandler(rootPath.Path()),
 	fLSPPipeClient(nullptr),
 	fUrl(rootPath),
+	fWorkspaceFoldersSupported(false),
+	fLastUsed(system_time()),
+	fServerMemory(0),
+	fMemorySampled(0),
+	fIdleRunner(nullptr),
 	fMessenger(msgr),
 	fServerConfig(serverConfig),
-	fServerCapabilities(0U)
+	fServerCapabilities(0U),
+	fNextRequestID(0),
+	fPositionEncoding(OffsetEncoding::UTF16)
 {
 	fUrl.SetAuthority("");
 	fInitialized.store(false);
+	fWorkspaceFolders.insert(rootPath.Path());
 }
 
 
 void
 LSPProjectWrapper::MessageReceived(BMessage* msg)
 {
+	if (msg->what == kLSPIdleTimeout) {
+		delete fIdleRunner;
+		fIdleRunner = nullptr;
+		if (IsIdle() && IsRunning()) {
+			LogInfo("LSP server [%s] idle: stopping it", fServerConfig.Argv()[0]);
+			Stop();
+		}
+		return;
+	}
 	if (msg->what == kLSPMessage) {
-		const char* json;
-		if (msg->FindString("data", &json) == B_OK && fLSPPipeClient) {
-			try {
-				auto value = nlohmann::json::parse(json);
-
-				if (value.count("id")) {
-					if (value.contains("method")) {
-						onRequest(value["method"].get<std::string>(), value["params"], value["id"]);
-					} else if (value.contains("result")) {
-						onResponse(value["id"].get<std::string>(), value["result"]);
-					} else if (value.contains("error")) {
-						onError(value["id"].get<std::string>(), value["error"]);
-					}
-				} else if (value.contains("method")) {
-					if (value.contains("params")) {
-						onNotify(value["method"].get<std::string>(), value["params"]);
-					}
-				}
+		LSPPipeClient* client = fLSPPipeClient;
+		if (client == nullptr)
+			return;
+		// the messages not taken are deleted with the transport
+		std::deque<std::unique_ptr<LSPMessage>> messages;
+		client->TakeMessages(messages);
+		for (auto& message : messages) {
+			// the server may be stopped by one of them
+			if (fLSPPipeClient != client)
+				break;
+			_HandleMessage(*message);
+		}
+	}
+}
+
+
+void
+LSPProjectWrapper::_HandleMessage(LSPMessage& message)
+{
+	if (message.Decoded() != LSPMessage::kNotDecoded) {
+		_DispatchDecoded(message);
+		return;
+	}
+	try {
+		auto& value = message.json;
+
+		if (value.count("id")) {
+			if (value.contains("method")) {
+				onRequest(value["method"].get<std::string>(), value["params"], value["id"]);
+			} else if (value.contains("result")) {
+				onResponse(value["id"].get<std::string>(), value["result"]);
+			} else if (value.contains("error")) {
+				onError(value["id"].get<std::string>(), value["error"]);
 			}
-			catch (std::exception& e) {
-				LogTrace("LSPProjectWrapper exception: %s", e.what());
-				return;
+		} else if (value.contains("method")) {
+			if (value.contains("params")) {
+				onNotify(value["method"].get<std::string>(), value["params"]);
 			}
 		}
 	}
+	catch (std::exception& e) {
+		LogTrace("LSPProjectWrapper exception: %s", e.what());
+	}
+}
+
+
+// Requests that become useless as soon as the user asks for a new one
+// or edits the document: older ones are cancelled, stale answers dropped.
+static bool
+IsSupersedable(const std::string& method)
+{
+	return method.compare("textDocument/completion") == 0
+		|| method.compare("textDocument/hover") == 0
+		|| method.compare("textDocument/signatureHelp") == 0;
+}
+
+
+// Ids are built by SendRequest as "<key>_<sequence>_<method>":
+// split them in place leaving just the method.
+static std::string
+SplitRequestID(RequestID& id)
+{
+	std::size_t found = id.find('_');
+	std::string key;
+	if (found != std::string::npos) {
+		key = id.substr(0, found);
+		id = id.substr(found + 1);
+		found = id.find('_');
+		if (found != std::string::npos)
+			id = id.substr(found + 1);
+	}
+	return key;
+}
+
+
+void
+LSPProjectWrapper::_DispatchDecoded(LSPMessage& message)
+{
+	if (message.IsResponse() && !_CompleteRequest(message.ID()))
+		return;
+
+	LSPTextDocument* doc = nullptr;
+	if (message.IsResponse()) {
+		RequestID id = message.ID();
+		auto search = fTextDocs.find(SplitRequestID(id));
+		if (search != fTextDocs.end())
+			doc = search->second;
+	} else {
+		doc = _DocumentByURI(message.URI().c_str());
+	}
+
+	if (doc == nullptr) {
+		LogError("LSPProjectWrapper: can't deliver [%s][%s]", message.Method().c_str(),
+			message.IsResponse() ? message.ID().c_str() : message.URI().c_str());
+		return;
+	}
+	doc->onDecoded(message);
 }
 
 
@@ -68,8 +168,12 @@ LSPProjectWrapper::RegisterTextDocument(LSPTextDocument* textDocument)
 	if (!fServerConfig.IsFileTypeSupported(textDocument->FileType()))
 		return false;
 
-	if (!fLSPPipeClient)
-		_Create();
+	delete fIdleRunner;
+	fIdleRunner = nullptr;
+	fLastUsed = system_time();
+
+	if (!fLSPPipeClient && !_Create())
+		return false;
 
 	fTextDocs[X(textDocument)] = textDocument;
 
@@ -87,6 +191,105 @@ LSPProjectWrapper::UnregisterTextDocument(LSPTextDocument* textDocument)
 {
 	if (fTextDocs.find(X(textDocument)) != fTextDocs.end())
 		fTextDocs.erase(X(textDocument));
+
+	// answers to pending requests can't be delivered anymore
+	for (auto it = fInFlight.begin(); it != fInFlight.end();) {
+		if (it->second.key == X(textDocument))
+			it = fInFlight.erase(it);
+		else
+			it++;
+	}
+
+	fLastUsed = system_time();
+	if (IsIdle() && IsRunning()) {
+		_StartIdleTimer();
+		LSPServersManager::EnforceBudget(nullptr);
+	}
+}
+
+
+void
+LSPProjectWrapper::_StartIdleTimer()
+{
+	delete fIdleRunner;
+	bigtime_t timeout = int32(gCFG["lsp_idle_timeout"]) * 60 * 1000000LL;
+	BMessage idle(kLSPIdleTimeout);
+	fIdleRunner = new BMessageRunner(BMessenger(this), &idle, timeout, 1);
+}
+
+
+void
+LSPProjectWrapper::AddWorkspaceFolder(const BPath& path)
+{
+	fWorkspaceFolders.insert(path.Path());
+	_SyncWorkspaceFolders();
+}
+
+
+// Returns the number of folders still served
+int32
+LSPProjectWrapper::RemoveWorkspaceFolder(const BPath& path)
+{
+	fWorkspaceFolders.erase(path.Path());
+	_SyncWorkspaceFolders();
+	if (!fWorkspaceFolders.empty() && strcmp(Name(), path.Path()) == 0) {
+		// the project the server was started for is gone: the next start
+		// is rooted in a folder still served. A running server not knowing
+		// about workspace folders keeps the old root until it's restarted.
+		_SetRoot(*fWorkspaceFolders.begin());
+		if (IsRunning() && !fWorkspaceFoldersSupported && IsIdle())
+			Stop();
+	}
+	return fWorkspaceFolders.size();
+}
+
+
+void
+LSPProjectWrapper::_SetRoot(const std::string& path)
+{
+	SetName(path.c_str());
+	fUrl = BUrl(BPath(path.c_str()));
+	fUrl.SetAuthority("");
+}
+
+
+bool
+LSPProjectWrapper::HasWorkspaceFolder(const BPath& path) const
+{
+	return fWorkspaceFolders.find(path.Path()) != fWorkspaceFolders.end();
+}
+
+
+static WorkspaceFolder
+MakeWorkspaceFolder(const std::string& path)
+{
+	WorkspaceFolder folder;
+	BUrl url(BPath(path.c_str()));
+	url.SetAuthority("");
+	folder.uri = url.UrlString().String();
+	folder.name = BPath(path.c_str()).Leaf();
+	return folder;
+}
+
+
+// Tells the server which folders have been added or removed since the last time.
+void
+LSPProjectWrapper::_SyncWorkspaceFolders()
+{
+	if (!fInitialized || !fWorkspaceFoldersSupported || fAnnouncedFolders == fWorkspaceFolders)
+		return;
+
+	DidChangeWorkspaceFoldersParams params;
+	for (const std::string& folder : fWorkspaceFolders) {
+		if (fAnnouncedFolders.find(folder) == fAnnouncedFolders.end())
+			params.event.added.push_back(MakeWorkspaceFolder(folder));
+	}
+	for (const std::string& folder : fAnnouncedFolders) {
+		if (fWorkspaceFolders.find(folder) == fWorkspaceFolders.end())
+			params.event.removed.push_back(MakeWorkspaceFolder(folder));
+	}
+	fAnnouncedFolders = fWorkspaceFolders;
+	SendNotify("workspace/didChangeWorkspaceFolders", params);
 }
 
 
@@ -98,12 +301,22 @@ LSPProjectWrapper::_Create()
 	if (!looper)
 		return false;
 
-	looper->AddHandler(this);
+	if (Looper() == nullptr)
+		looper->AddHandler(this);
 	BMessenger thisProject = BMessenger(this, looper);
 
-	chdir(Name());
+	LSPServersManager::EnforceBudget(this);
+
+	// the server inherits the working directory: a shared one finds its
+	// folders in the workspace folders, and outlives the project it was
+	// started for
+	if (fServerConfig.IsSharedAcrossProjects())
+		chdir("/");
+	else
+		chdir(Name());
 
 	fLSPPipeClient = new LSPPipeClient(kLSPMessage, thisProject);
+	fMemorySampled = 0;
 
 	status_t started = fLSPPipeClient->Start(
 											const_cast<const char**>(fServerConfig.Argv()),
@@ -115,6 +328,9 @@ LSPProjectWrapper::_Create()
 		// supports a given file type
 		LogInfo("Can't execute lsp sever to provide advanced features! Please install '%s'",
 				fServerConfig.Argv()[0]);
+		// the looper has never been run: it can be deleted
+		delete fLSPPipeClient;
+		fLSPPipeClient = nullptr;
 		return false;
 	}
 
@@ -130,29 +346,96 @@ LSPProjectWrapper::~LSPProjectWrapper()
 		Looper()->RemoveHandler(this);
 	}
 
-	if (!fInitialized) {
-		if (fLSPPipeClient) {
-			fLSPPipeClient->ForceQuit();
-		}
-		return;
-	}
-
 	for (auto& m : fTextDocs)
 		LogError("LSPProjectWrapper::Dispose() still textDocument registered! [%s]",
 			m.second->GetFilenameURI().String());
 
-	Shutdown();
-	Exit();
+	Stop();
+}
+
+
+// Stops the server process. It will be started again by the next
+// registered document.
+void
+LSPProjectWrapper::Stop()
+{
+	delete fIdleRunner;
+	fIdleRunner = nullptr;
+
+	if (fLSPPipeClient == nullptr)
+		return;
+
+	if (fInitialized) {
+		Shutdown();
+		Exit();
+
+		// the server gets some time to exit on a thread of its own: Stop()
+		// is called by the window thread
+		thread_id thread = spawn_thread(_StopClientThread, "LSP server stopper",
+			B_LOW_PRIORITY, fLSPPipeClient);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			_StopClientThread(fLSPPipeClient);
+	} else {
+		fLSPPipeClient->ForceQuit();
+	}
+	fLSPPipeClient = nullptr;
+
+	fInitialized.store(false);
+	fInFlight.clear();
+	fAnnouncedFolders.clear();
+	fServerCapabilities = 0U;
+}
+
 
+/* static */
+status_t
+LSPProjectWrapper::_StopClientThread(void* cookie)
+{
+	LSPPipeClient* client = static_cast<LSPPipeClient*>(cookie);
 	int i = 0;
-	while (fLSPPipeClient && !fLSPPipeClient->HasQuitBeenRequested() && i++ < 3) {
+	while (!client->HasQuitBeenRequested() && i++ < 3) {
 		snooze(50000);
 	}
 
 	// let's force the thread to quit.
-	if (fLSPPipeClient) {
-		fLSPPipeClient->KillThread();
-	}
+	client->KillThread();
+	client->ForceQuit();
+	return B_OK;
+}
+
+
+// Resident memory of the server process, in bytes
+size_t
+LSPProjectWrapper::ServerMemory() const
+{
+	if (fLSPPipeClient == nullptr)
+		return 0;
+
+	const bigtime_t now = system_time();
+	if (fMemorySampled != 0 && now - fMemorySampled < kMemorySampleInterval)
+		return fServerMemory;
+
+	size_t memory = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(fLSPPipeClient->GetChildPid(), &cookie, &info) == B_OK)
+		memory += info.ram_size;
+	fServerMemory = memory;
+	fMemorySampled = now;
+	return memory;
+}
+
+
+void
+LSPProjectWrapper::GetServerInfo(BMessage* info) const
+{
+	info->AddString("server", fServerConfig.Argv()[0]);
+	for (const std::string& folder : fWorkspaceFolders)
+		info->AddString("folder", folder.c_str());
+	info->AddBool("running", IsRunning());
+	info->AddInt32("documents", fTextDocs.size());
+	info->AddInt32("pending", fInFlight.size());
+	info->AddUInt64("memory", ServerMemory());
 }
 
 
@@ -198,7 +481,8 @@ LSPProjectWrapper::onNotify(std::string method, value& params)
 		if (kind.compare("begin") == 0) {
 			fWorkDone.MakeEmpty();
 			fWorkDone.what = kLSPWorkProgress;
-			fWorkDone.AddString("project", fUrl.Path().String());
+			for (const std::string& folder : fWorkspaceFolders)
+				fWorkDone.AddString("project", folder.c_str());
 			fWorkDone.AddString("kind", kind.c_str());
 			fWorkDone.AddString("title", value["title"].get<std::string>().c_str());
 			if (value["percentage"].is_null() == false)
@@ -238,12 +522,10 @@ LSPProjectWrapper::onNotify(std::string method, value& params)
 void
 LSPProjectWrapper::onResponse(RequestID id, value& result)
 {
-	std::size_t found = id.find('_');
-	std::string key;
-	if (found != std::string::npos) {
-		key = id.substr(0, found);
-		id = id.substr(found + 1);
-	}
+	if (!_CompleteRequest(id))
+		return;
+
+	std::string key = SplitRequestID(id);
 
 	if (id.compare("initialize") == 0) {
 		fInitialized.store(true);
@@ -272,12 +554,10 @@ LSPProjectWrapper::onResponse(RequestID id, value& result)
 void
 LSPProjectWrapper::onError(RequestID id, value& error)
 {
-	std::size_t found = id.find('_');
-	std::string key;
-	if (found != std::string::npos) {
-		key = id.substr(0, found);
-		id = id.substr(found + 1);
-	}
+	if (!_CompleteRequest(id))
+		return;
+
+	std::string key = SplitRequestID(id);
 
 	auto search = fTextDocs.find(key);
 	if (search != fTextDocs.end())
@@ -302,6 +582,11 @@ LSPProjectWrapper::Initialize(option<DocumentUri> rootUri)
 	InitializeParams params;
 	params.processId = fLSPPipeClient->GetChildPid();
 	params.rootUri = rootUri;
+	std::vector<WorkspaceFolder> folders;
+	for (const std::string& folder : fWorkspaceFolders)
+		folders.push_back(MakeWorkspaceFolder(folder));
+	params.workspaceFolders = folders;
+	fAnnouncedFolders = fWorkspaceFolders;
 	return SendRequest("client", "initialize", params);
 }
 
@@ -386,7 +671,29 @@ LSPProjectWrapper::Initialized(json& result)
 		_CheckAndSetCapability(capas, "documentSymbolProvider", kLCapDocumentSymbols);
 	}
 
+	fWorkspaceFoldersSupported = capas.is_object()
+		&& capas["workspace"]["workspaceFolders"]["supported"] == true;
+
+	// LSP 3.17 'positionEncoding' or the older clangd 'offsetEncoding' extension.
+	// A server that doesn't say anything talks UTF-16.
+	fPositionEncoding = OffsetEncoding::UTF16;
+	try {
+		if (capas.is_object() && capas.contains("positionEncoding"))
+			fPositionEncoding = capas["positionEncoding"].get<OffsetEncoding>();
+		else if (result.contains("offsetEncoding"))
+			fPositionEncoding = result["offsetEncoding"].get<OffsetEncoding>();
+	} catch (std::exception& e) {
+		LogError("LSPProjectWrapper: invalid position encoding: %s", e.what());
+	}
+	if (fPositionEncoding != OffsetEncoding::UTF8 && fPositionEncoding != OffsetEncoding::UTF16) {
+		LogError("LSPProjectWrapper: unsupported position encoding, assuming utf-16");
+		fPositionEncoding = OffsetEncoding::UTF16;
+	}
+	LogDebug("positionEncoding [%s]", json(fPositionEncoding).get<std::string>().c_str());
+
 	SendNotify("initialized", json());
+	// folders added while the server was starting
+	_SyncWorkspaceFolders();
 
 	fMessenger.SendMessage(kMsgCapabilitiesUpdated);
 }
@@ -404,7 +711,9 @@ void
 LSPProjectWrapper::DidOpen(LSPTextDocument* textDocument, string_ref text, string_ref languageId)
 {
 	DidOpenTextDocumentParams params;
+	textDocument->SetVersion(0);
 	params.textDocument.uri = std::move(textDocument->GetFilenameURI().String());
+	params.textDocument.version = textDocument->Version();
 	params.textDocument.text = text;
 	params.textDocument.languageId = languageId;
 	SendNotify("textDocument/didOpen", params);
@@ -425,7 +734,9 @@ LSPProjectWrapper::DidChange(LSPTextDocument* textDocument,
 	std::vector<TextDocumentContentChangeEvent>& changes, option<bool> wantDiagnostics)
 {
 	DidChangeTextDocumentParams params;
+	textDocument->SetVersion(textDocument->Version() + 1);
 	params.textDocument.uri = std::move(textDocument->GetFilenameURI().String());
+	params.textDocument.version = textDocument->Version();
 	params.contentChanges = std::move(changes);
 	// params.wantDiagnostics = wantDiagnostics;
 	SendNotify("textDocument/didChange", params);
@@ -699,14 +1010,97 @@ LSPProjectWrapper::DocumentLink(LSPTextDocument* textDocument)
 
 
 RequestID
-LSPProjectWrapper::SendRequest(RequestID id, string_ref method, value params)
+LSPProjectWrapper::SendRequest(RequestID key, string_ref method, value params)
 {
-	id.append("_").append(method);
+	std::string methodName(method.c_str(), method.length());
+	if (IsSupersedable(methodName))
+		_CancelSuperseded(key, methodName);
+
+	RequestInfo info;
+	info.key = key;
+	info.method = methodName;
+	info.sent = system_time();
+	auto search = fTextDocs.find(key);
+	info.version = search != fTextDocs.end() ? search->second->Version() : 0;
+
+	RequestID id = key;
+	id.append("_").append(std::to_string(++fNextRequestID)).append("_").append(methodName);
+	fInFlight[id] = info;
+
 	fLSPPipeClient->request(method, params, id);
 	return id;
 }
 
 
+void
+LSPProjectWrapper::_CancelSuperseded(const std::string& key, const std::string& method)
+{
+	for (auto it = fInFlight.begin(); it != fInFlight.end();) {
+		if (it->second.key == key && it->second.method == method) {
+			LogDebug("LSPProjectWrapper: cancelling superseded request [%s]", it->first.c_str());
+			SendNotify("$/cancelRequest", {{"id", it->first}});
+			fRequestStats[method].cancelled++;
+			it = fInFlight.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+
+// Returns true if the answer to the request should be delivered.
+bool
+LSPProjectWrapper::_CompleteRequest(const RequestID& id)
+{
+	auto search = fInFlight.find(id);
+	if (search == fInFlight.end()) {
+		// cancelled: the server could have answered before receiving the cancel.
+		LogTrace("LSPProjectWrapper: dropping answer for cancelled request [%s]", id.c_str());
+		return false;
+	}
+
+	RequestInfo info = search->second;
+	fInFlight.erase(search);
+
+	RequestStats& stats = fRequestStats[info.method];
+	bigtime_t latency = system_time() - info.sent;
+	stats.count++;
+	stats.totalLatency += latency;
+	stats.maxLatency = std::max(stats.maxLatency, latency);
+	LogDebug("LSPProjectWrapper: [%s] answered in %" B_PRId64 " us", id.c_str(), latency);
+
+	if (IsSupersedable(info.method)) {
+		auto doc = fTextDocs.find(info.key);
+		if (doc != fTextDocs.end() && doc->second->Version() != info.version) {
+			LogDebug("LSPProjectWrapper: dropping stale answer [%s] (version %d, now %d)",
+				id.c_str(), info.version, doc->second->Version());
+			stats.dropped++;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void
+LSPProjectWrapper::GetRequestStats(BMessage* stats) const
+{
+	for (const auto& [method, methodStats] : fRequestStats) {
+		BMessage item;
+		item.AddString("method", method.c_str());
+		item.AddUInt32("count", methodStats.count);
+		item.AddUInt32("cancelled", methodStats.cancelled);
+		item.AddUInt32("dropped", methodStats.dropped);
+		item.AddInt64("latency:total", methodStats.totalLatency);
+		item.AddInt64("latency:max", methodStats.maxLatency);
+		if (methodStats.count > 0)
+			item.AddInt64("latency:average", methodStats.totalLatency / methodStats.count);
+		stats->AddMessage("request", &item);
+	}
+	stats->AddInt32("inflight", fInFlight.size());
+}
+
+
 void
 LSPProjectWrapper::SendNotify(string_ref method, value params = json())
 {
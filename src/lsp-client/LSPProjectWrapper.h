@@ -9,7 +9,9 @@
 #include <Path.h>
 #include <Locker.h>
 #include <atomic>
+#include <set>
 #include <MessageFilter.h>
+#include <MessageRunner.h>
 #include <Messenger.h>
 #include <Url.h>
 
@@ -32,12 +34,14 @@ struct FileEvent;
 struct WorkspaceEdit;
 struct ConfigurationSettings;
 enum class TypeHierarchyDirection: int;
+class LSPMessage;
 class LSPPipeClient;
 class LSPServerConfigInterface;
 
 using json = nlohmann::json;
 
 const int32 kLSPWorkProgress = 'lswp';
+const int32 kLSPIdleTimeout = 'lsit';
 
 class LSPProjectWrapper : public BHandler {
 
@@ -54,6 +58,21 @@ public:
 	bool	RegisterTextDocument(LSPTextDocument* fw);
 	void	UnregisterTextDocument(LSPTextDocument* fw);
 
+	// a server can be shared by more projects (see LSPServersManager)
+	void	AddWorkspaceFolder(const BPath& path);
+	int32	RemoveWorkspaceFolder(const BPath& path);
+	bool	HasWorkspaceFolder(const BPath& path) const;
+
+	// the server process is started by the first registered document and
+	// stopped when it has been idle for a while, or to respect the budget.
+	bool		IsRunning() const { return fLSPPipeClient != nullptr; }
+	bool		IsIdle() const { return fTextDocs.empty(); }
+	bigtime_t	LastUsed() const { return fLastUsed; }
+	void		Stop();
+	// sampled at most every few seconds: walking the areas is slow
+	size_t		ServerMemory() const;
+	void		GetServerInfo(BMessage* info) const;
+
     void onNotify(std::string method, value &params);
     void onResponse(RequestID ID, value &result);
     void onError(RequestID ID, value &error);
@@ -103,15 +122,52 @@ public:
     RequestID 	SendRequest(RequestID id, string_ref method, value params);
     void 		SendNotify(string_ref method, value params);
 
+	// per method counters of the requests sent to the server
+	void	GetRequestStats(BMessage* stats) const;
+
     std::string&	allCommitCharacters() { return fAllCommitCharacters; } //not yet used.
     std::string&	triggerCharacters() { return fTriggerCharacters; } //for completion
 
+	// encoding of Position::character, negotiated at initialize time
+	OffsetEncoding	PositionEncoding() const { return fPositionEncoding; }
+
 private:
 	bool	_Create();
+	void	_SyncWorkspaceFolders();
+	void	_StartIdleTimer();
+	void	_SetRoot(const std::string& path);
+	static status_t _StopClientThread(void* cookie);
 	LSPPipeClient*			fLSPPipeClient;
 	LSPTextDocument*	_DocumentByURI(const char* uri);
+	void	_HandleMessage(LSPMessage& message);
+	void	_DispatchDecoded(LSPMessage& message);
 	bool _CheckAndSetCapability(json& capas, const char* str, const LSPCapability flag);
 
+	bool	_CompleteRequest(const RequestID& id);
+	void	_CancelSuperseded(const std::string& key, const std::string& method);
+
+	struct RequestInfo {
+		std::string	key;
+		std::string	method;
+		int			version;
+		bigtime_t	sent;
+	};
+
+	struct RequestStats {
+		uint32		count = 0;
+		uint32		cancelled = 0;
+		uint32		dropped = 0;
+		bigtime_t	totalLatency = 0;
+		bigtime_t	maxLatency = 0;
+	};
+
+	typedef std::map<RequestID, RequestInfo> MapRequest;
+
+	MapRequest	fInFlight;
+	std::map<std::string, RequestStats> fRequestStats;
+	uint64		fNextRequestID;
+	OffsetEncoding	fPositionEncoding;
+
 	typedef std::map<std::string, LSPTextDocument*> MapFile;
 
 	MapFile	fTextDocs;
@@ -122,6 +178,14 @@ private:
 	std::string fTriggerCharacters;
 
 	BUrl fUrl;
+	std::set<std::string>	fWorkspaceFolders;
+	// the folders known by the server
+	std::set<std::string>	fAnnouncedFolders;
+	bool			fWorkspaceFoldersSupported;
+	bigtime_t		fLastUsed;
+	mutable size_t		fServerMemory;
+	mutable bigtime_t	fMemorySampled;
+	BMessageRunner*	fIdleRunner;
 	BMessenger fMessenger;
 	const LSPServerConfigInterface& fServerConfig;
 	uint32	fServerCapabilities;
@@ -12,6 +12,7 @@
 #include "LSPLogLevels.h"
 #include "LSPProjectWrapper.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -46,6 +47,9 @@ public:
 		fOffset = 1;
 	}
 
+	// clangd finds the compilation database of each file by itself
+	const bool	IsSharedAcrossProjects() const { return true; }
+
 	const bool	IsFileTypeSupported(const BString& fileType) const {
 		if (fileType.Compare("cpp") != 0 &&
 			fileType.Compare("c") != 0 &&
@@ -67,6 +71,7 @@ public:
 	const bool	IsFileTypeSupported(const BString& fileType) const {
 		return (fileType.Compare("python") == 0);
 	}
+	const bool	IsSharedAcrossProjects() const { return true; }
 };
 
 
@@ -115,6 +120,7 @@ public:
 
 
 std::vector<LSPServerConfigInterface*> LSPServersManager::fConfigs;
+std::vector<LSPProjectWrapper*> LSPServersManager::fServers;
 
 
 /* static */
@@ -155,12 +161,88 @@ LSPServersManager::DisposeLSPServersConfig()
 
 /* static */
 LSPProjectWrapper*
-LSPServersManager::CreateLSPProject(const BPath& path, const BMessenger& msgr, const BString& fileType)
+LSPServersManager::AcquireLSPServer(const BPath& path, const BMessenger& msgr,
+	const BString& fileType)
 {
 	for (LSPServerConfigInterface* interface: fConfigs) {
-		if (interface->IsFileTypeSupported(fileType)) {
-			return new LSPProjectWrapper(path, msgr, *interface);
+		if (!interface->IsFileTypeSupported(fileType))
+			continue;
+
+		if (interface->IsSharedAcrossProjects()) {
+			for (LSPProjectWrapper* server : fServers) {
+				if (&server->ServerConfig() == interface) {
+					server->AddWorkspaceFolder(path);
+					return server;
+				}
+			}
 		}
+		LSPProjectWrapper* server = new LSPProjectWrapper(path, msgr, *interface);
+		fServers.push_back(server);
+		return server;
 	}
 	return nullptr;
 }
+
+
+/* static */
+void
+LSPServersManager::ReleaseLSPServer(LSPProjectWrapper* server, const BPath& path)
+{
+	if (server->RemoveWorkspaceFolder(path) > 0)
+		return;
+
+	fServers.erase(std::remove(fServers.begin(), fServers.end(), server), fServers.end());
+	delete server;
+}
+
+
+/* static */
+void
+LSPServersManager::EnforceBudget(LSPProjectWrapper* starting)
+{
+	const int32 maxServers = gCFG["lsp_max_servers"];
+	const size_t maxMemory = size_t(int32(gCFG["lsp_max_memory"])) * 1024 * 1024;
+
+	int32 running = starting != nullptr ? 1 : 0;
+	size_t memory = 0;
+	std::vector<LSPProjectWrapper*> idle;
+	for (LSPProjectWrapper* server : fServers) {
+		if (server == starting || !server->IsRunning())
+			continue;
+		running++;
+		memory += server->ServerMemory();
+		if (server->IsIdle())
+			idle.push_back(server);
+	}
+
+	std::sort(idle.begin(), idle.end(), [](LSPProjectWrapper* a, LSPProjectWrapper* b) {
+		return a->LastUsed() < b->LastUsed();
+	});
+
+	for (LSPProjectWrapper* server : idle) {
+		if (running <= maxServers && memory <= maxMemory)
+			break;
+		LogInfo("LSP budget: stopping idle server [%s]", server->ServerConfig().Argv()[0]);
+		memory -= std::min(memory, server->ServerMemory());
+		server->Stop();
+		running--;
+	}
+
+	// servers with open documents are never stopped
+	if (running > maxServers || memory > maxMemory) {
+		LogInfo("LSP budget exceeded: %" B_PRId32 " servers, %zu MiB", running,
+			memory / (1024 * 1024));
+	}
+}
+
+
+/* static */
+void
+LSPServersManager::GetServersInfo(BMessage* info)
+{
+	for (LSPProjectWrapper* server : fServers) {
+		BMessage serverInfo;
+		server->GetServerInfo(&serverInfo);
+		info->AddMessage("server", &serverInfo);
+	}
+}
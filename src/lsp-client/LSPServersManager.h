@@ -13,6 +13,7 @@
 
 class LSPProjectWrapper;
 class LSPTextDocument;
+class BMessage;
 class BMessenger;
 class BPath;
 class BString;
@@ -21,6 +22,8 @@ class LSPServerConfigInterface {
 public:
 	virtual ~LSPServerConfigInterface() = default;
 	virtual const bool   IsFileTypeSupported (const BString& fileType) const = 0;
+	// true if one server instance can serve more projects (workspace folders)
+	virtual const bool   IsSharedAcrossProjects() const { return false; }
 	const char* const* Argv() const { return fArgv.data(); }
 				int32  Argc() const { return fArgv.size(); }
 
@@ -32,11 +35,22 @@ protected:
 class LSPServersManager {
 public:
 		static status_t				InitLSPServersConfig();
-		static LSPProjectWrapper*	CreateLSPProject(const BPath& path, const BMessenger& msgr, const BString& fileType);
 		static status_t				DisposeLSPServersConfig();
+
+		// Servers are pooled: a project acquires the server for a file type and
+		// releases it when closed. The server is deleted with its last project.
+		static LSPProjectWrapper*	AcquireLSPServer(const BPath& path, const BMessenger& msgr,
+										const BString& fileType);
+		static void					ReleaseLSPServer(LSPProjectWrapper* server, const BPath& path);
+
+		// Stops the least recently used idle servers to respect the process
+		// and memory limits, counting 'starting' which is about to run.
+		static void					EnforceBudget(LSPProjectWrapper* starting);
+		static void					GetServersInfo(BMessage* info);
 private:
 		static bool _AddValidConfig(LSPServerConfigInterface*);
 		static std::vector<LSPServerConfigInterface*>	fConfigs;
+		static std::vector<LSPProjectWrapper*>			fServers;
 };
 
 
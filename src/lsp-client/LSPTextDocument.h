@@ -14,7 +14,8 @@ public:
     LSPTextDocument(BPath filePath, BString fileType)
 		:
 		fFilenameURI(BUrl(filePath)),
-		fFileType(fileType)
+		fFileType(fileType),
+		fVersion(0)
 	{
 		fFilenameURI.SetAuthority("");
 	}
@@ -27,8 +28,13 @@ public:
 
 	const BString& FileType() const { return fFileType; }
 
+	// version of the document known by the server (bumped at each didChange)
+			int		Version() const { return fVersion; }
+			void	SetVersion(int version) { fVersion = version; }
+
 private:
 	BUrl 	fFilenameURI;
 	BString	fFileStatus;
 	BString fFileType;
+	int		fVersion;
 };
@@ -15,6 +15,8 @@
 using value = nlohmann::json;
 using RequestID = std::string;
 
+class LSPMessage;
+
 class MessageHandler {
 public:
     MessageHandler() = default;
@@ -22,6 +24,8 @@ public:
     virtual void onResponse(RequestID ID, value &result) {}
     virtual void onError(RequestID ID, value &error) {}
     virtual void onRequest(std::string method, value &params, value &ID) {}
+    // responses and notifications already decoded by the reader thread
+    virtual void onDecoded(LSPMessage &message) {}
 
 };
 
@@ -3,24 +3,34 @@
 
 #include "Transport.h"
 
+#include <Autolock.h>
 #include <Messenger.h>
 
 #include <json.hpp>
 
+#include "LSPMessage.h"
+
 #define    jsonrpc  "2.0"
 ///////////////////////
 
-enum {
-	kReadResult		= 'read',
-	kWriteRequest	= 'writ'
-};
+const uint32 kWriteRequest = 'writ';
+// the handler's port may be full: the reader retries until stopped
+const bigtime_t kDeliveryTimeout = 100000;
 
 
 AsyncJsonTransport::AsyncJsonTransport(uint32 what, BMessenger& msgr)
 	:
 	BLooper("AsyncJsonTransport"),
 	fWhat(what),
-	fMessenger(msgr)
+	fMessenger(msgr),
+	fStopped(false),
+	fIncomingLock("LSP incoming"),
+	fOutgoingLock("LSP outgoing")
+{
+}
+
+
+AsyncJsonTransport::~AsyncJsonTransport()
 {
 }
 
@@ -46,35 +56,53 @@ bool
 AsyncJsonTransport::readStep()
 {
 	std::string data;
-	bool result = readMessage(data);
-	if (result) {
-		BMessage req(kReadResult);
-		req.AddString("data", data.c_str());
-		return BLooper::PostMessage(&req) == B_OK;
+	if (!readMessage(data))
+		return false;
+
+	std::unique_ptr<LSPMessage> message(new LSPMessage());
+	if (!message->Parse(data)) {
+		// malformed message: skip it and keep reading
+		return true;
+	}
+
+	// the handler is notified once for all the messages it hasn't taken yet
+	fIncomingLock.Lock();
+	const bool notify = fIncoming.empty();
+	fIncoming.push_back(std::move(message));
+	fIncomingLock.Unlock();
+	if (!notify)
+		return true;
+
+	BMessage req(fWhat);
+	status_t status;
+	while ((status = fMessenger.SendMessage(&req, (BHandler*)nullptr, kDeliveryTimeout))
+			== B_TIMED_OUT && !fStopped) {
 	}
-    return result;
+	return status == B_OK;
+}
+
+
+void
+AsyncJsonTransport::TakeMessages(std::deque<std::unique_ptr<LSPMessage>>& messages)
+{
+	BAutolock lock(fIncomingLock);
+	messages.swap(fIncoming);
 }
 
 
 void
 AsyncJsonTransport::MessageReceived(BMessage* msg)
 {
-	switch(msg->what) {
-		case kReadResult:
-		{
-			const char* data;
-			if (msg->FindString("data", &data) == B_OK) {
-				msg->what = fWhat;
-				fMessenger.SendMessage(msg);
-			}
-			break;
-		}
+	switch (msg->what) {
 		case kWriteRequest:
 		{
-			const char* data;
-			if (msg->FindString("data", &data) == B_OK) {
-				std::string str(data);
-				writeMessage(str);
+			std::deque<std::string> outgoing;
+			fOutgoingLock.Lock();
+			outgoing.swap(fOutgoing);
+			fOutgoingLock.Unlock();
+			for (std::string& data : outgoing) {
+				if (!writeMessage(data))
+					break;
 			}
 			break;
 		}
@@ -85,10 +113,14 @@ AsyncJsonTransport::MessageReceived(BMessage* msg)
 }
 
 
+// The message is written by the looper thread: the caller never blocks on
+// a server not reading its input.
 bool
 AsyncJsonTransport::writeJson(value& msg)
 {
-	BMessage req(kWriteRequest);
-	req.AddString("data", msg.dump().c_str());
-	return BLooper::PostMessage(&req) == B_OK;
+	fOutgoingLock.Lock();
+	const bool post = fOutgoing.empty();
+	fOutgoing.push_back(msg.dump());
+	fOutgoingLock.Unlock();
+	return !post || PostMessage(kWriteRequest) == B_OK;
 }
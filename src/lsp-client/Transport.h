@@ -8,9 +8,16 @@
 
 #include "MessageHandler.h"
 
+#include <Locker.h>
 #include <Looper.h>
 #include <Messenger.h>
 
+#include <atomic>
+#include <deque>
+#include <memory>
+
+class LSPMessage;
+
 class Transport {
 public:
     virtual void notify(string_ref method,  value &params) = 0;
@@ -22,10 +29,16 @@ public:
     virtual bool writeMessage(std::string &) = 0;
 };
 
+// Messages read from the server are parsed by the reader thread and queued:
+// the handler is sent a BMessage (with the 'what' passed to the constructor)
+// when the queue stops being empty, and takes the messages with
+// TakeMessages(). Those never taken are deleted with the transport.
+// Outgoing messages are queued too, and written by the looper thread.
 class AsyncJsonTransport: public Transport, public BLooper {
 
 public:
 		 AsyncJsonTransport(uint32 handler, BMessenger& msgr);
+		~AsyncJsonTransport();
 
     void notify(string_ref method, value &params) override;
     void request(string_ref method, value &params, RequestID &id) override;
@@ -34,12 +47,24 @@ public:
 
 	void MessageReceived(BMessage* msg) override;
 
+	void TakeMessages(std::deque<std::unique_ptr<LSPMessage>>& messages);
+
+protected:
+	// the reader thread stops waiting on the handler's port
+	void StopDelivery() { fStopped = true; }
+
 private:
 
 	bool writeJson(value& value);
 
 	uint32			fWhat;
 	BMessenger		fMessenger;
+	std::atomic<bool>	fStopped;
+
+	BLocker			fIncomingLock;
+	std::deque<std::unique_ptr<LSPMessage>>	fIncoming;
+	BLocker			fOutgoingLock;
+	std::deque<std::string>	fOutgoing;
 };
 
 #endif //LSP_TRANSPORT_H
@@ -18,9 +18,11 @@
 
 #include <json.hpp>
 
-#include "LSPProjectWrapper.h"
+#include "MessageHandler.h"
 #include "uri.h"
 
+using json = nlohmann::json;
+
 #define MAP_JSON(...) {j = {__VA_ARGS__};}
 #define MAP_KEY(KEY) {#KEY, value.KEY}
 #define MAP_TO(KEY, TO) {KEY, value.TO}
@@ -87,6 +89,25 @@ struct VersionedTextDocumentIdentifier : public TextDocumentIdentifier {
 };
 JSON_SERIALIZE(VersionedTextDocumentIdentifier, MAP_JSON(MAP_KEY(uri), MAP_KEY(version)), {});
 
+struct WorkspaceFolder {
+    /// The associated URI for this workspace folder.
+    std::string uri;
+    /// The name of the workspace folder, used to refer to it in the UI.
+    std::string name;
+};
+JSON_SERIALIZE(WorkspaceFolder, MAP_JSON(MAP_KEY(uri), MAP_KEY(name)), {FROM_KEY(uri);FROM_KEY(name)});
+
+struct WorkspaceFoldersChangeEvent {
+    std::vector<WorkspaceFolder> added;
+    std::vector<WorkspaceFolder> removed;
+};
+JSON_SERIALIZE(WorkspaceFoldersChangeEvent, MAP_JSON(MAP_KEY(added), MAP_KEY(removed)), {});
+
+struct DidChangeWorkspaceFoldersParams {
+    WorkspaceFoldersChangeEvent event;
+};
+JSON_SERIALIZE(DidChangeWorkspaceFoldersParams, MAP_JSON(MAP_KEY(event)), {});
+
 #include "protocol_objects.h"
 // struct Position
 JSON_SERIALIZE(Position, MAP_JSON(MAP_KEY(line), MAP_KEY(character)), {FROM_KEY(line);FROM_KEY(character)});
@@ -130,16 +151,6 @@ enum class TextDocumentSyncKind {
 };
 // enum class CompletionItemKind
 
-enum class OffsetEncoding {
-    // Any string is legal on the wire. Unrecognized encodings parse as this.
-    UnsupportedEncoding,
-    // Length counts code units of UTF-16 encoded text. (Standard LSP behavior).
-    UTF16,
-    // Length counts bytes of UTF-8 encoded text. (Clangd extension).
-    UTF8,
-    // Length counts codepoints in unicode text. (Clangd extension).
-    UTF32,
-};
 enum class MarkupKind {
     PlainText,
     Markdown,
@@ -155,12 +166,6 @@ enum class FailureHandlingKind {
     Undo,
     TextOnlyTransactional
 };
-NLOHMANN_JSON_SERIALIZE_ENUM(OffsetEncoding, {
-    {OffsetEncoding::UnsupportedEncoding, "unspported"},
-    {OffsetEncoding::UTF8, "utf-8"},
-    {OffsetEncoding::UTF16, "utf-16"},
-    {OffsetEncoding::UTF32, "utf-32"},
-})
 NLOHMANN_JSON_SERIALIZE_ENUM(MarkupKind, {
     {MarkupKind::PlainText, "plaintext"},
     {MarkupKind::Markdown, "markdown"},
@@ -305,7 +310,10 @@ struct ClientCapabilities {
 	std::vector<std::string> CodeActionResolveSupport;
 
     /// Supported encodings for LSP character offsets. (clangd extension).
-    std::vector<OffsetEncoding> offsetEncoding = {OffsetEncoding::UTF8};
+    std::vector<OffsetEncoding> offsetEncoding = {OffsetEncoding::UTF8, OffsetEncoding::UTF16};
+    /// Supported position encodings, preferred first (LSP 3.17).
+    /// general.positionEncodings
+    std::vector<OffsetEncoding> positionEncodings = {OffsetEncoding::UTF8, OffsetEncoding::UTF16};
     /// The content format that should be used for Hover requests.
     std::vector<MarkupKind> HoverContentFormat = {MarkupKind::PlainText};
 
@@ -314,6 +322,8 @@ struct ClientCapabilities {
 
     bool ApplyEdit = false;
     bool DocumentChanges = false;
+    /// workspace.workspaceFolders
+    bool WorkspaceFolders = true;
     ClientCapabilities() {
         for (int i = 1; i <= 26; ++i) {
             WorkspaceSymbolKinds.push_back((SymbolKind) i);
@@ -327,6 +337,8 @@ struct ClientCapabilities {
     }
 };
 JSON_SERIALIZE(ClientCapabilities,MAP_JSON(
+            MAP_KV("general",
+                    MAP_TO("positionEncodings", positionEncodings)),
             MAP_KV("textDocument",
                 MAP_KV("publishDiagnostics", // PublishDiagnosticsClientCapabilities
                         MAP_TO("categorySupport", DiagnosticCategory),
@@ -355,6 +367,7 @@ JSON_SERIALIZE(ClientCapabilities,MAP_JSON(
                             MAP_KV("symbolKind",
                                     MAP_TO("valueSet", WorkspaceSymbolKinds))),
                     MAP_TO("applyEdit", ApplyEdit),
+                    MAP_TO("workspaceFolders", WorkspaceFolders),
                     MAP_KV("workspaceEdit", // WorkspaceEditClientCapabilities
                             MAP_TO("documentChanges", DocumentChanges))),
 			MAP_KV("window",
@@ -431,12 +444,14 @@ struct InitializeParams {
     ClientCapabilities capabilities;
     option<DocumentUri> rootUri;
     option<TextType> rootPath;
+    option<std::vector<WorkspaceFolder>> workspaceFolders;
     InitializationOptions initializationOptions;
 };
 JSON_SERIALIZE(InitializeParams, MAP_JSON(
         MAP_KEY(processId),
         MAP_KEY(capabilities),
         MAP_KEY(rootUri),
+        MAP_KEY(workspaceFolders),
         MAP_KEY(initializationOptions),
         MAP_KEY(rootPath)), {});
 
@@ -506,7 +521,7 @@ struct DidChangeTextDocumentParams {
     /// The document that did change. The version number points
     /// to the version after all provided content changes have
     /// been applied.
-    TextDocumentIdentifier textDocument;
+    VersionedTextDocumentIdentifier textDocument;
 
     /// The actual content changes.
     std::vector<TextDocumentContentChangeEvent> contentChanges;
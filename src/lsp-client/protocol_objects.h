@@ -13,12 +13,29 @@
 
 #include "uri.h"
 
+enum class OffsetEncoding {
+    // Any string is legal on the wire. Unrecognized encodings parse as this.
+    UnsupportedEncoding,
+    // Length counts code units of UTF-16 encoded text. (Standard LSP behavior).
+    UTF16,
+    // Length counts bytes of UTF-8 encoded text. (Clangd extension).
+    UTF8,
+    // Length counts codepoints in unicode text. (Clangd extension).
+    UTF32,
+};
+NLOHMANN_JSON_SERIALIZE_ENUM(OffsetEncoding, {
+    {OffsetEncoding::UnsupportedEncoding, "unspported"},
+    {OffsetEncoding::UTF8, "utf-8"},
+    {OffsetEncoding::UTF16, "utf-16"},
+    {OffsetEncoding::UTF32, "utf-32"},
+})
+
 struct Position {
     /// Line position in a document (zero-based).
     int line = 0;
     /// Character offset on a line in a document (zero-based).
-    /// WARNING: this is in UTF-16 codepoints, not bytes or characters!
-    /// Use the functions in SourceCode.h to construct/interpret Positions.
+    /// WARNING: this is in the negotiated OffsetEncoding units (UTF-16 code
+    /// units by default), not bytes or characters!
     int character = 0;
     friend bool operator==(const Position &LHS, const Position &RHS) {
         return std::tie(LHS.line, LHS.character) ==
@@ -15,8 +15,12 @@
 #include "ConfigManager.h"
 #include "GenioApp.h"
 #include "GitRepository.h"
+#include "GitWorker.h"
 #include "LSPProjectWrapper.h"
 #include "MakeFileHandler.h"
+#include "PathIndex.h"
+#include "ProjectNodeTable.h"
+#include "TrigramIndex.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "ProjectSettingsWindow"
@@ -54,6 +58,16 @@ SourceItem::SourceItem(const entry_ref& ref)
 }
 
 
+// the caller already knows the type, no need to ask the file system
+SourceItem::SourceItem(const entry_ref& ref, SourceItemType type)
+	:
+	fEntryRef(ref),
+	fType(type),
+	fProjectFolder(nullptr)
+{
+}
+
+
 SourceItem::~SourceItem()
 {
 }
@@ -86,18 +100,25 @@ ProjectFolder::ProjectFolder(const entry_ref& ref, const BMessenger& msgr)
 	SourceItem(ref),
 	fSettings(nullptr),
 	fMessenger(msgr),
-	fGitRepository(nullptr),
+	fGitWorker(nullptr),
 	fActive(false),
 	fIsBuilding(false),
-	fLoadingCompleted(false)
+	fLoadingCompleted(false),
+	fLoadingCancelled(false)
 {
 	fProjectFolder = this;
 	fType = SourceItemType::ProjectFolderItem;
 
 	fFullPath = BPath(EntryRef()).Path();
 
+	node_ref nodeRef;
+	BEntry(EntryRef()).GetNodeRef(&nodeRef);
+	fNodeTable.reset(new ProjectNodeTable(fFullPath, *EntryRef(), nodeRef));
+
 	try {
-		fGitRepository = new GitRepository(fFullPath);
+		fGitWorker = new GitWorker(new GitRepository(fFullPath), fFullPath);
+		// the branch menus and the window title read the branch from there
+		fGitWorker->Refresh(BMessenger());
 	} catch (const GitException &ex) {
 		LogError("Could not create a GitRepository instance on project %s with error %d: %s",
 			fFullPath.String(), ex.Error(), ex.what());
@@ -112,7 +133,8 @@ ProjectFolder::GetLSPServer(const BString& fileType)
 		if (w->ServerConfig().IsFileTypeSupported(fileType))
 			return w;
 	}
-	LSPProjectWrapper* wrap = LSPServersManager::CreateLSPProject(BPath(fFullPath), fMessenger, fileType);
+	LSPProjectWrapper* wrap = LSPServersManager::AcquireLSPServer(BPath(fFullPath), fMessenger,
+		fileType);
 	if (wrap)
 		fLSPProjectWrappers.push_back(wrap);
 	return wrap;
@@ -122,9 +144,11 @@ ProjectFolder::GetLSPServer(const BString& fileType)
 ProjectFolder::~ProjectFolder()
 {
 	for (LSPProjectWrapper* w : fLSPProjectWrappers) {
-		delete w;
+		LSPServersManager::ReleaseLSPServer(w, BPath(fFullPath));
 	}
-	delete fGitRepository;
+	// the worker may be running a job: it deletes itself when done
+	if (fGitWorker != nullptr)
+		fGitWorker->Quit();
 	delete fSettings;
 }
 
@@ -140,6 +164,18 @@ ProjectFolder::Open()
 	if (status != B_OK)
 		LogInfoF("%s", "Cannot load project settings");
 
+	fFileIndex = std::make_shared<PathIndex>(fFullPath);
+	fFileIndex->Start(BString(gCFG["find_exclude_directory"]), gCFG["find_use_gitignore"]);
+
+	if (gCFG["find_use_index"]) {
+		// the last reference may be released by a search: the index saves
+		// and deletes itself on its thread
+		fSearchIndex.reset(new TrigramIndex(fFullPath),
+			[](TrigramIndex* index) { index->Quit(); });
+		fSearchIndex->Start(BString(gCFG["find_exclude_directory"]),
+			gCFG["find_use_gitignore"]);
+	}
+
 	// not a fatal error, just start with defaults
 	return B_OK;
 }
@@ -149,6 +185,10 @@ status_t
 ProjectFolder::Close()
 {
 	SaveSettings();
+	// a search still running keeps its own reference, the index is saved
+	// by its thread
+	fSearchIndex.reset();
+	fFileIndex.reset();
 	return B_OK;
 }
 
@@ -372,20 +412,6 @@ ProjectFolder::RunInTerminal() const
 }
 
 
-GitRepository*
-ProjectFolder::GetRepository() const
-{
-	return fGitRepository;
-}
-
-
-void
-ProjectFolder::InitRepository(bool createInitialCommit) const
-{
-	fGitRepository->Init(createInitialCommit);
-}
-
-
 const rgb_color
 ProjectFolder::Color() const
 {
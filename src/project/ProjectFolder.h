@@ -9,11 +9,13 @@
 #include <Messenger.h>
 #include <String.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 
 namespace Genio::Git {
-	class GitRepository;
+	class GitWorker;
 }
 
 using namespace Genio::Git;
@@ -21,6 +23,9 @@ using namespace Genio::Git;
 class ConfigManager;
 class LSPProjectWrapper;
 class LSPTextDocument;
+class PathIndex;
+class ProjectNodeTable;
+class TrigramIndex;
 
 const uint32 kMsgProjectSettingsUpdated = 'PRJS';
 
@@ -41,6 +46,7 @@ class SourceItem {
 public:
 					explicit	SourceItem(const BString& path);
 					explicit	SourceItem(const entry_ref& ref);
+								SourceItem(const entry_ref& ref, SourceItemType type);
 								~SourceItem();
 
 	const entry_ref*			EntryRef() const;
@@ -105,27 +111,41 @@ public:
 	void						SetRunInTerminal(bool enabled);
 	bool						RunInTerminal() const;
 
-	GitRepository*				GetRepository() const;
-	void						InitRepository(bool createInitialCommit = true) const;
+	// runs the git operations off the window thread, and owns the
+	// repository. nullptr if it couldn't be created.
+	GitWorker*					GetGitWorker() const { return fGitWorker; }
 
 	const rgb_color				Color() const;
 
 	LSPProjectWrapper*			GetLSPServer(const BString& fileType);
 
+	// nullptr if "find_use_index" was off when the project was opened
+	std::shared_ptr<TrigramIndex>	SearchIndex() const { return fSearchIndex; }
+	std::shared_ptr<PathIndex>		FileIndex() const { return fFileIndex; }
+	// the files and folders under the project, filled by the ProjectBrowser
+	ProjectNodeTable*			NodeTable() const { return fNodeTable.get(); }
+
 	bool						IsLoading() const;
 	void						SetLoadingCompleted();
+	// closed while loading: the scan of the tree stops early
+	void						CancelLoading() { fLoadingCancelled = true; }
+	bool						IsLoadingCancelled() const { return fLoadingCancelled; }
 
 private:
 	void						_PrepareSettings();
 
 	std::vector<LSPProjectWrapper*>	fLSPProjectWrappers;
+	std::shared_ptr<TrigramIndex>	fSearchIndex;
+	std::shared_ptr<PathIndex>		fFileIndex;
+	std::unique_ptr<ProjectNodeTable>	fNodeTable;
 	ConfigManager*				fSettings;
 	BMessenger					fMessenger;
-	GitRepository*				fGitRepository;
+	GitWorker*					fGitWorker;
 	BString						fFullPath;
 	bool						fActive;
 	bool						fIsBuilding;
 	bool						fLoadingCompleted;
+	std::atomic<bool>			fLoadingCancelled;
 };
 
 typedef std::vector<ProjectFolder*> ProjectFolderList;
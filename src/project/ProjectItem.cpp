@@ -5,6 +5,8 @@
 
 #include "ProjectItem.h"
 
+#include <algorithm>
+
 #include <Application.h>
 #include <Bitmap.h>
 #include <Catalog.h>
@@ -18,9 +20,11 @@
 #include <TranslationUtils.h>
 #include <Window.h>
 
+#include "GitWorker.h"
 #include "IconCache.h"
 #include "Log.h"
 #include "ProjectFolder.h"
+#include "ProjectNodeTable.h"
 #include "SpinningAnimation.h"
 #include "Utils.h"
 
@@ -139,7 +143,13 @@ ProjectItem::DrawItem(BView* owner, BRect bounds, bool complete)
 		else
 			SetExtraText("");
 
+		bool isDirectory = false;
+		const uint32 gitStatus = _GitStatus(isDirectory);
+		if ((gitStatus & GIT_STATUS_IGNORED) != 0)
+			owner->SetHighColor(mix_color(owner->HighColor(), owner->LowColor(), 128));
+
 		DrawText(owner, Text(), ExtraText(), textPoint);
+		_DrawGitBadge(owner, bounds, textPoint, gitStatus, isDirectory);
 
 		owner->Sync();
 	}
@@ -226,6 +236,66 @@ ProjectItem::DrawIcon(BView* owner, const BRect& itemBounds,
 }
 
 
+uint32
+ProjectItem::_GitStatus(bool& isDirectory) const
+{
+	// while loading, the node table belongs to the scanning threads
+	ProjectFolder* project = fSourceItem->GetProjectFolder();
+	if (project == nullptr || project->GetGitWorker() == nullptr
+		|| project->NodeTable() == nullptr || project->IsLoading())
+		return GIT_STATUS_CURRENT;
+
+	const ProjectNodeTable* table = project->NodeTable();
+	const ProjectNodeTable::NodeId node = table->FindByRef(*fSourceItem->EntryRef());
+	if (node == ProjectNodeTable::kNoNode || node == table->Root())
+		return GIT_STATUS_CURRENT;
+
+	isDirectory = table->IsDirectory(node);
+	BString path = table->Path(node);
+	path.Remove(0, project->Path().Length() + 1);
+	return project->GetGitWorker()->Status().StatusOf(path, isDirectory);
+}
+
+
+// Files get the letter git status would show, folders a dot when something
+// changed below them
+void
+ProjectItem::_DrawGitBadge(BView* owner, BRect bounds, const BPoint& textPoint,
+	uint32 status, bool isDirectory)
+{
+	static const rgb_color kModifiedColor = { 205, 145, 30, 255 };
+
+	const char* badge = nullptr;
+	rgb_color color = kModifiedColor;
+	if ((status & GIT_STATUS_CONFLICTED) != 0) {
+		badge = "C";
+		color = ui_color(B_FAILURE_COLOR);
+	} else if ((status & GIT_STATUS_WT_NEW) != 0) {
+		badge = "U";
+		color = ui_color(B_SUCCESS_COLOR);
+	} else if ((status & GIT_STATUS_INDEX_NEW) != 0) {
+		badge = "A";
+		color = ui_color(B_SUCCESS_COLOR);
+	} else if ((status & (GIT_STATUS_WT_DELETED | GIT_STATUS_INDEX_DELETED)) != 0) {
+		badge = "D";
+		color = ui_color(B_FAILURE_COLOR);
+	} else if ((status & (GIT_STATUS_WT_MODIFIED | GIT_STATUS_INDEX_MODIFIED
+			| GIT_STATUS_WT_RENAMED | GIT_STATUS_INDEX_RENAMED
+			| GIT_STATUS_WT_TYPECHANGE | GIT_STATUS_INDEX_TYPECHANGE)) != 0) {
+		badge = "M";
+	}
+	if (badge == nullptr)
+		return;
+	if (isDirectory)
+		badge = "•";
+
+	owner->SetHighColor(color);
+	const float width = owner->StringWidth(badge);
+	owner->DrawString(badge, BPoint(std::max(textPoint.x,
+		bounds.right - width - be_control_look->DefaultLabelSpacing()), textPoint.y));
+}
+
+
 void
 ProjectItem::_DestroyTextWidget()
 {
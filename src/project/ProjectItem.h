@@ -42,6 +42,10 @@ private:
 	static BTextControl	*sTextControl;
 
 	void			_DestroyTextWidget();
+	// the git_status_t flags last read for the item
+	uint32			_GitStatus(bool& isDirectory) const;
+	void			_DrawGitBadge(BView* owner, BRect bounds, const BPoint& textPoint,
+						uint32 status, bool isDirectory);
 };
 
 
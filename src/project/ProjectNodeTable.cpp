@@ -0,0 +1,459 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+
+#include "ProjectNodeTable.h"
+
+#include <string.h>
+
+
+static constexpr uint32 kEmptySlot = 0xffffffff;
+static constexpr uint32 kErasedSlot = 0xfffffffe;
+
+
+static inline uint32
+Mix(uint64 key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return (uint32)key;
+}
+
+
+static inline uint32
+HashName(const char* name)
+{
+	uint32 hash = 2166136261u;
+	for (; *name != '\0'; name++) {
+		hash ^= (uint8)*name;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+template<typename Match>
+static uint32
+LookUp(const std::vector<uint32>& slots, uint32 hash, Match match)
+{
+	if (slots.empty())
+		return kEmptySlot;
+
+	const uint32 mask = slots.size() - 1;
+	for (uint32 i = hash & mask;; i = (i + 1) & mask) {
+		const uint32 value = slots[i];
+		if (value == kEmptySlot)
+			return kEmptySlot;
+		if (value != kErasedSlot && match(value))
+			return value;
+	}
+}
+
+
+static void
+Place(std::vector<uint32>& slots, uint32& used, uint32 value, uint32 hash)
+{
+	const uint32 mask = slots.size() - 1;
+	uint32 i = hash & mask;
+	while (slots[i] < kErasedSlot)
+		i = (i + 1) & mask;
+	if (slots[i] == kEmptySlot)
+		used++;
+	slots[i] = value;
+}
+
+
+// value must not be in the table yet. Erased slots count as used, so
+// that lookups always meet an empty slot: past 3/4 the table is rebuilt.
+template<typename Hash>
+static void
+Insert(std::vector<uint32>& slots, uint32& used, uint32 value, Hash hash)
+{
+	if ((used + 1) * 4 > slots.size() * 3) {
+		std::vector<uint32> old;
+		old.swap(slots);
+		size_t live = 1;
+		for (uint32 oldValue : old)
+			live += oldValue < kErasedSlot ? 1 : 0;
+		size_t size = 16;
+		while (size < live * 2)
+			size *= 2;
+		slots.assign(size, kEmptySlot);
+		used = 0;
+		for (uint32 oldValue : old) {
+			if (oldValue < kErasedSlot)
+				Place(slots, used, oldValue, hash(oldValue));
+		}
+	}
+	Place(slots, used, value, hash(value));
+}
+
+
+static void
+Erase(std::vector<uint32>& slots, uint32 value, uint32 hash)
+{
+	if (slots.empty())
+		return;
+
+	const uint32 mask = slots.size() - 1;
+	for (uint32 i = hash & mask; slots[i] != kEmptySlot; i = (i + 1) & mask) {
+		if (slots[i] == value) {
+			slots[i] = kErasedSlot;
+			return;
+		}
+	}
+}
+
+
+ProjectNodeTable::ProjectNodeTable(const BString& rootPath, const entry_ref& rootRef,
+	const node_ref& rootNode)
+	:
+	fRootPath(rootPath),
+	fRootRef(rootRef),
+	fNodeCount(1),
+	fNameSlotsUsed(0),
+	fChildSlotsUsed(0),
+	fDirectorySlotsUsed(0)
+{
+	if (fRootPath.EndsWith("/") && fRootPath.Length() > 1)
+		fRootPath.Truncate(fRootPath.Length() - 1);
+
+	fNames.push_back(_InternName(rootRef.name != nullptr ? rootRef.name : ""));
+	fParents.push_back(kNoNode);
+	fFirstChildren.push_back(kNoNode);
+	fNextSiblings.push_back(kNoNode);
+	fInodes.push_back(rootNode.node);
+	fDevices.push_back(rootNode.device);
+	fFlags.push_back(kDirectory);
+	fItems.push_back(nullptr);
+	Insert(fDirectorySlots, fDirectorySlotsUsed, Root(),
+		[this](uint32 node) { return _DirectoryHash(node); });
+}
+
+
+ProjectNodeTable::NodeId
+ProjectNodeTable::Add(NodeId parent, const char* name, const node_ref& nodeRef,
+	bool isDirectory)
+{
+	NodeId node = Find(parent, name);
+	if (node != kNoNode) {
+		if (IsDirectory(node) == isDirectory && NodeRef(node) == nodeRef)
+			return node;
+		// replaced by something else
+		Remove(node);
+	}
+
+	const uint32 nameOffset = _InternName(name);
+	if (!fFreeNodes.empty()) {
+		node = fFreeNodes.back();
+		fFreeNodes.pop_back();
+	} else {
+		node = fNames.size();
+		fNames.push_back(0);
+		fParents.push_back(kNoNode);
+		fFirstChildren.push_back(kNoNode);
+		fNextSiblings.push_back(kNoNode);
+		fInodes.push_back(0);
+		fDevices.push_back(0);
+		fFlags.push_back(0);
+		fItems.push_back(nullptr);
+	}
+	fNames[node] = nameOffset;
+	fParents[node] = parent;
+	fFirstChildren[node] = kNoNode;
+	fInodes[node] = nodeRef.node;
+	fDevices[node] = nodeRef.device;
+	fFlags[node] = isDirectory ? kDirectory : 0;
+	fItems[node] = nullptr;
+	fNodeCount++;
+
+	_Link(node, parent);
+	_InsertChild(node);
+	if (isDirectory) {
+		Insert(fDirectorySlots, fDirectorySlotsUsed, node,
+			[this](uint32 node) { return _DirectoryHash(node); });
+	}
+	return node;
+}
+
+
+void
+ProjectNodeTable::Remove(NodeId node)
+{
+	if (node == Root() || node == kNoNode)
+		return;
+
+	_Unlink(node);
+	std::vector<NodeId> stack(1, node);
+	while (!stack.empty()) {
+		const NodeId current = stack.back();
+		stack.pop_back();
+		for (NodeId child = fFirstChildren[current]; child != kNoNode;
+				child = fNextSiblings[child])
+			stack.push_back(child);
+
+		_EraseChild(current);
+		if (IsDirectory(current))
+			Erase(fDirectorySlots, current, _DirectoryHash(current));
+		fParents[current] = kNoNode;
+		fFirstChildren[current] = kNoNode;
+		fNextSiblings[current] = kNoNode;
+		fFlags[current] = 0;
+		fItems[current] = nullptr;
+		fFreeNodes.push_back(current);
+		fNodeCount--;
+	}
+}
+
+
+void
+ProjectNodeTable::Move(NodeId node, NodeId parent, const char* name)
+{
+	if (node == Root() || node == kNoNode)
+		return;
+
+	const NodeId replaced = Find(parent, name);
+	if (replaced == node)
+		return;
+	Remove(replaced);
+
+	_EraseChild(node);
+	_Unlink(node);
+	fParents[node] = parent;
+	fNames[node] = _InternName(name);
+	_Link(node, parent);
+	_InsertChild(node);
+}
+
+
+ProjectNodeTable::NodeId
+ProjectNodeTable::Find(NodeId parent, const char* name) const
+{
+	const uint32 nameOffset = _FindName(name);
+	if (nameOffset == kEmptySlot)
+		return kNoNode;
+
+	const uint32 hash = Mix(((uint64)parent << 32) | nameOffset);
+	const uint32 node = LookUp(fChildSlots, hash, [&](uint32 node) {
+		return fParents[node] == parent && fNames[node] == nameOffset;
+	});
+	return node == kEmptySlot ? kNoNode : node;
+}
+
+
+ProjectNodeTable::NodeId
+ProjectNodeTable::FindByPath(const char* path) const
+{
+	const int32 rootLength = fRootPath.Length();
+	if (strncmp(path, fRootPath.String(), rootLength) != 0)
+		return kNoNode;
+	path += rootLength;
+	if (*path != '\0' && *path != '/')
+		return kNoNode;
+
+	NodeId node = Root();
+	char name[B_FILE_NAME_LENGTH];
+	while (node != kNoNode && *path != '\0') {
+		path++;
+		const char* end = path;
+		while (*end != '\0' && *end != '/')
+			end++;
+		const size_t length = end - path;
+		if (length >= sizeof(name))
+			return kNoNode;
+		if (length > 0) {
+			memcpy(name, path, length);
+			name[length] = '\0';
+			node = Find(node, name);
+		}
+		path = end;
+	}
+	return node;
+}
+
+
+ProjectNodeTable::NodeId
+ProjectNodeTable::FindByRef(const entry_ref& ref) const
+{
+	if (ref == fRootRef)
+		return Root();
+	if (ref.name == nullptr)
+		return kNoNode;
+
+	const uint32 hash = Mix((uint64)ref.directory ^ ((uint64)ref.device << 48));
+	const uint32 directory = LookUp(fDirectorySlots, hash, [&](uint32 node) {
+		return fInodes[node] == ref.directory && fDevices[node] == ref.device;
+	});
+	if (directory == kEmptySlot)
+		return kNoNode;
+	return Find(directory, ref.name);
+}
+
+
+bool
+ProjectNodeTable::GetEntryRef(NodeId node, entry_ref* ref) const
+{
+	if (node == Root()) {
+		*ref = fRootRef;
+		return true;
+	}
+	const NodeId parent = fParents[node];
+	if (parent == kNoNode)
+		return false;
+
+	ref->device = fDevices[parent];
+	ref->directory = fInodes[parent];
+	return ref->set_name(Name(node)) == B_OK;
+}
+
+
+node_ref
+ProjectNodeTable::NodeRef(NodeId node) const
+{
+	return node_ref(fDevices[node], fInodes[node]);
+}
+
+
+BString
+ProjectNodeTable::Path(NodeId node) const
+{
+	std::vector<NodeId> components;
+	for (; node != Root() && node != kNoNode; node = fParents[node])
+		components.push_back(node);
+
+	BString path(fRootPath);
+	for (auto i = components.rbegin(); i != components.rend(); i++)
+		path << "/" << Name(*i);
+	return path;
+}
+
+
+void
+ProjectNodeTable::SetPopulated(NodeId node, bool populated)
+{
+	if (populated)
+		fFlags[node] |= kPopulated;
+	else
+		fFlags[node] &= ~kPopulated;
+}
+
+
+void
+ProjectNodeTable::ForgetItems(NodeId node)
+{
+	std::vector<NodeId> stack(1, node);
+	while (!stack.empty()) {
+		const NodeId current = stack.back();
+		stack.pop_back();
+		fItems[current] = nullptr;
+		fFlags[current] &= ~kPopulated;
+		for (NodeId child = fFirstChildren[current]; child != kNoNode;
+				child = fNextSiblings[child])
+			stack.push_back(child);
+	}
+}
+
+
+void
+ProjectNodeTable::ShrinkToFit()
+{
+	fNames.shrink_to_fit();
+	fParents.shrink_to_fit();
+	fFirstChildren.shrink_to_fit();
+	fNextSiblings.shrink_to_fit();
+	fInodes.shrink_to_fit();
+	fDevices.shrink_to_fit();
+	fFlags.shrink_to_fit();
+	fItems.shrink_to_fit();
+	fNamePool.shrink_to_fit();
+}
+
+
+size_t
+ProjectNodeTable::MemoryUsage() const
+{
+	const size_t capacity = fNames.capacity();
+	return capacity * (sizeof(uint32) + 3 * sizeof(NodeId) + sizeof(ino_t) + sizeof(dev_t)
+			+ sizeof(uint8) + sizeof(ProjectItem*))
+		+ fFreeNodes.capacity() * sizeof(NodeId)
+		+ fNamePool.capacity()
+		+ (fNameSlots.capacity() + fChildSlots.capacity() + fDirectorySlots.capacity())
+			* sizeof(uint32);
+}
+
+
+uint32
+ProjectNodeTable::_InternName(const char* name)
+{
+	uint32 offset = _FindName(name);
+	if (offset != kEmptySlot)
+		return offset;
+
+	offset = fNamePool.size();
+	fNamePool.insert(fNamePool.end(), name, name + strlen(name) + 1);
+	Insert(fNameSlots, fNameSlotsUsed, offset,
+		[this](uint32 offset) { return HashName(&fNamePool[offset]); });
+	return offset;
+}
+
+
+uint32
+ProjectNodeTable::_FindName(const char* name) const
+{
+	return LookUp(fNameSlots, HashName(name), [&](uint32 offset) {
+		return strcmp(&fNamePool[offset], name) == 0;
+	});
+}
+
+
+uint32
+ProjectNodeTable::_ChildHash(NodeId node) const
+{
+	return Mix(((uint64)fParents[node] << 32) | fNames[node]);
+}
+
+
+uint32
+ProjectNodeTable::_DirectoryHash(NodeId node) const
+{
+	return Mix((uint64)fInodes[node] ^ ((uint64)fDevices[node] << 48));
+}
+
+
+void
+ProjectNodeTable::_InsertChild(NodeId node)
+{
+	Insert(fChildSlots, fChildSlotsUsed, node,
+		[this](uint32 node) { return _ChildHash(node); });
+}
+
+
+void
+ProjectNodeTable::_EraseChild(NodeId node)
+{
+	Erase(fChildSlots, node, _ChildHash(node));
+}
+
+
+void
+ProjectNodeTable::_Link(NodeId node, NodeId parent)
+{
+	fNextSiblings[node] = fFirstChildren[parent];
+	fFirstChildren[parent] = node;
+}
+
+
+void
+ProjectNodeTable::_Unlink(NodeId node)
+{
+	NodeId* link = &fFirstChildren[fParents[node]];
+	while (*link != node)
+		link = &fNextSiblings[*link];
+	*link = fNextSiblings[node];
+	fNextSiblings[node] = kNoNode;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <vector>
+
+#include <Entry.h>
+#include <Node.h>
+#include <String.h>
+
+class ProjectItem;
+
+// The files and folders of a project, as a table of nodes stored column by
+// column: names are interned in a single pool, the tree is made of parent,
+// first child and next sibling indices, and two open addressing hash
+// tables find a child by (parent, name) and a folder by node_ref.
+// Lookups by path or entry_ref don't walk the list items any more, and
+// the browser creates items only for the folders being shown.
+// Not thread safe: the callers serialize the access.
+
+class ProjectNodeTable {
+public:
+	typedef uint32 NodeId;
+	static constexpr NodeId kNoNode = 0xffffffff;
+
+							ProjectNodeTable(const BString& rootPath,
+								const entry_ref& rootRef, const node_ref& rootNode);
+
+			NodeId			Root() const { return 0; }
+
+			// returns the node already there, if any
+			NodeId			Add(NodeId parent, const char* name, const node_ref& nodeRef,
+								bool isDirectory);
+			// removes the node and everything below it
+			void			Remove(NodeId node);
+			void			Move(NodeId node, NodeId parent, const char* name);
+
+			NodeId			Find(NodeId parent, const char* name) const;
+			NodeId			FindByPath(const char* path) const;
+			NodeId			FindByRef(const entry_ref& ref) const;
+
+			const char*		Name(NodeId node) const { return &fNamePool[fNames[node]]; }
+			NodeId			Parent(NodeId node) const { return fParents[node]; }
+			NodeId			FirstChild(NodeId node) const { return fFirstChildren[node]; }
+			NodeId			NextSibling(NodeId node) const { return fNextSiblings[node]; }
+			bool			IsDirectory(NodeId node) const
+								{ return (fFlags[node] & kDirectory) != 0; }
+			bool			GetEntryRef(NodeId node, entry_ref* ref) const;
+			node_ref		NodeRef(NodeId node) const;
+			BString			Path(NodeId node) const;
+
+			// the list item of the node, when the browser made one
+			ProjectItem*	Item(NodeId node) const { return fItems[node]; }
+			void			SetItem(NodeId node, ProjectItem* item) { fItems[node] = item; }
+			// whether all the children of the node have an item
+			bool			IsPopulated(NodeId node) const
+								{ return (fFlags[node] & kPopulated) != 0; }
+			void			SetPopulated(NodeId node, bool populated);
+			// clears the items and the populated flags of the subtree
+			void			ForgetItems(NodeId node);
+
+			// releases the spare capacity, once a scan is over
+			void			ShrinkToFit();
+
+			int32			CountNodes() const { return fNodeCount; }
+			size_t			MemoryUsage() const;
+
+private:
+	enum : uint8 {
+		kDirectory	= 0x01,
+		kPopulated	= 0x02
+	};
+
+			uint32			_InternName(const char* name);
+			uint32			_FindName(const char* name) const;
+			uint32			_ChildHash(NodeId node) const;
+			uint32			_DirectoryHash(NodeId node) const;
+			void			_InsertChild(NodeId node);
+			void			_EraseChild(NodeId node);
+			void			_Link(NodeId node, NodeId parent);
+			void			_Unlink(NodeId node);
+
+			BString				fRootPath;
+			entry_ref			fRootRef;
+
+			// one entry per node
+			std::vector<uint32>	fNames;			// offsets in fNamePool
+			std::vector<NodeId>	fParents;		// kNoNode for free slots
+			std::vector<NodeId>	fFirstChildren;
+			std::vector<NodeId>	fNextSiblings;
+			std::vector<ino_t>	fInodes;
+			std::vector<dev_t>	fDevices;
+			std::vector<uint8>	fFlags;
+			std::vector<ProjectItem*>	fItems;
+			std::vector<NodeId>	fFreeNodes;
+			int32				fNodeCount;
+
+			std::vector<char>	fNamePool;
+			// open addressing hash tables, holding name offsets and node ids
+			std::vector<uint32>	fNameSlots;
+			uint32				fNameSlotsUsed;
+			std::vector<uint32>	fChildSlots;
+			uint32				fChildSlotsUsed;
+			std::vector<uint32>	fDirectorySlots;
+			uint32				fDirectorySlotsUsed;
+};
@@ -46,6 +46,7 @@
 #include "GenioWindowMessages.h"
 #include "GitAlert.h"
 #include "GitRepository.h"
+#include "GitWorker.h"
 #include "GlobalStatusView.h"
 #include "GoToLineWindow.h"
 #include "IconMenuItem.h"
@@ -53,12 +54,14 @@
 #include "Languages.h"
 #include "Log.h"
 #include "LSPEditorWrapper.h"
+#include "LSPServersManager.h"
 #include "NoticeMessages.h"
 #include "PanelTabManager.h"
 #include "ProblemsPanel.h"
 #include "ProjectBrowser.h"
 #include "ProjectFolder.h"
 #include "ProjectItem.h"
+#include "QuickOpenWindow.h"
 #include "QuitAlert.h"
 #include "RemoteProjectWindow.h"
 #include "SearchResultTab.h"
@@ -170,6 +173,7 @@ GenioWindow::GenioWindow(BRect frame)
 	, fBuildLogView(nullptr)
 	, fMTermView(nullptr)
 	, fGoToLineWindow(nullptr)
+	, fQuickOpenWindow(nullptr)
 	, fSearchResultTab(nullptr)
 	, fScreenMode(kDefault)
 	, fPanelTabManager(nullptr)
@@ -228,6 +232,7 @@ GenioWindow::Show()
 		ActionManager::SetEnabled(MSG_JUMP_GO_FORWARD, false);
 
 		GitRepository::Looper()->StartWatching(this, MSG_NOTIFY_GIT_BRANCH_CHANGED);
+		fProjectsFolderBrowser->StartWatching(this, MSG_NOTIFY_GIT_STATUS_CHANGED);
 		be_app->StartWatching(this, gCFG.UpdateMessageWhat());
 		be_app->StartWatching(this, kMsgProjectSettingsUpdated);
 		UnlockLooper();
@@ -272,9 +277,15 @@ GenioWindow::MessageReceived(BMessage* message)
 			break;
 		case kLSPWorkProgress:
 		{
+			// a server can be shared by more projects
 			ProjectFolder* active = GetActiveProject();
-			if (active != nullptr && active->Path().Compare(message->GetString("project","")) == 0) {
-				SendNotices(MSG_NOTIFY_LSP_INDEXING, message);
+			const char* project = nullptr;
+			for (int32 i = 0; active != nullptr
+					&& message->FindString("project", i, &project) == B_OK; i++) {
+				if (active->Path().Compare(project) == 0) {
+					SendNotices(MSG_NOTIFY_LSP_INDEXING, message);
+					break;
+				}
 			}
 			break;
 		}
@@ -322,6 +333,17 @@ GenioWindow::MessageReceived(BMessage* message)
 					|| selected->GetProjectFolder()->Path() == projectPath) {
 					_UpdateWindowTitle(selected, currentBranch.String());
 				}
+			} else if (code == MSG_NOTIFY_GIT_STATUS_CHANGED) {
+				// HEAD may have moved: the editors diff against another commit
+				if (!message->GetBool("full", false))
+					break;
+				const BString projectPath = message->GetString("project_path");
+				fTabManager->ForEachEditor([&](Editor* editor) {
+					if (editor->GetProjectFolder() != nullptr
+						&& editor->GetProjectFolder()->Path() == projectPath)
+						editor->UpdateGitChanges();
+					return true;
+				});
 			}
 			break;
 		}
@@ -661,32 +683,36 @@ GenioWindow::MessageReceived(BMessage* message)
 		}
 		case MSG_GIT_SWITCH_BRANCH:
 		{
-			try {
-				const BString projectPath = message->GetString("project_path");
-				ProjectFolder* project = nullptr;
-				if (projectPath.IsEmpty())
-					project = GetActiveProject();
-				else
-					project = GetProjectBrowser()->ProjectByPath(projectPath);
-				const BString newBranch = message->GetString("branch");
-				if (project != nullptr && !newBranch.IsEmpty())
-					project->GetRepository()->SwitchBranch(newBranch);
-			} catch (const Genio::Git::GitConflictException &ex) {
-				BString message;
-				message << B_TRANSLATE("An error occurred while switching branch:")
-						<< " "
-						<< ex.Message();
-
+			const BString projectPath = message->GetString("project_path");
+			ProjectFolder* project = nullptr;
+			if (projectPath.IsEmpty())
+				project = GetActiveProject();
+			else
+				project = GetProjectBrowser()->ProjectByPath(projectPath);
+			const BString newBranch = message->GetString("branch");
+			if (project != nullptr && project->GetGitWorker() != nullptr && !newBranch.IsEmpty())
+				project->GetGitWorker()->SwitchBranch(BMessenger(this), newBranch);
+			break;
+		}
+		case MSG_GIT_JOB_DONE:
+		{
+			// the replies to MSG_GIT_SWITCH_BRANCH
+			if (message->GetInt32("status", B_OK) == B_OK || message->GetBool("cancelled", false))
+				break;
+			BString errorMessage;
+			errorMessage << B_TRANSLATE("An error occurred while switching branch:")
+					<< " "
+					<< message->GetString("error", "");
+			if (message->HasString("files")) {
+				std::vector<BString> files;
+				BString file;
+				for (int32 i = 0; message->FindString("files", i, &file) == B_OK; i++)
+					files.push_back(file);
 				auto alert = new GitAlert(B_TRANSLATE("Conflicts"),
-											B_TRANSLATE(message), ex.GetFiles());
+											B_TRANSLATE(errorMessage), files);
 				alert->Go();
-			} catch (const Genio::Git::GitException &ex) {
-				BString message;
-				message << B_TRANSLATE("An error occurred while switching branch:")
-						<< " "
-						<< ex.Message();
-
-				OKAlert("GitSwitchBranch", message, B_STOP_ALERT);
+			} else {
+				OKAlert("GitSwitchBranch", errorMessage, B_STOP_ALERT);
 			}
 			break;
 		}
@@ -699,6 +725,19 @@ GenioWindow::MessageReceived(BMessage* message)
 			}
 			fGoToLineWindow->ShowCentered(Frame());
 			break;
+		case MSG_QUICK_OPEN:
+		{
+			std::vector<QuickOpenWindow::Source> sources;
+			for (int32 i = 0; i < GetProjectBrowser()->CountProjects(); i++) {
+				ProjectFolder* project = GetProjectBrowser()->ProjectAt(i);
+				if (project->FileIndex() != nullptr)
+					sources.push_back({ project->Name(), project->Path(), project->FileIndex() });
+			}
+			if (fQuickOpenWindow == nullptr)
+				fQuickOpenWindow = new QuickOpenWindow(this);
+			fQuickOpenWindow->ShowCentered(Frame(), sources);
+			break;
+		}
 		case MSG_WHITE_SPACES_TOGGLE:
 			gCFG["show_white_space"] = !gCFG["show_white_space"];
 			break;
@@ -1034,6 +1073,14 @@ GenioWindow::MessageReceived(BMessage* message)
 					LogError("Selecting editor but it's null! (index %d)", index);
 					break;
 				}
+				// a restored tab: read the file, unless the user already
+				// moved to another tab. If it can't be read, the tab shows
+				// an empty read-only document, tried again when reselected.
+				if (!editor->IsLoaded() && !editor->IsLoading()) {
+					if (fTabManager->SelectedEditor() != editor)
+						break;
+					_LoadRestoredEditor(editor);
+				}
 				const int32 be_line   = message->GetInt32("start:line", -1);
 				const int32 lsp_char  = message->GetInt32("start:character", -1);
 
@@ -1129,6 +1176,9 @@ GenioWindow::MessageReceived(BMessage* message)
 		case MSG_HELP_DOCS:
 			_ShowDocumentation();
 			break;
+		case MSG_LSP_SERVERS_INFO:
+			_ShowLSPServersInfo();
+			break;
 		case kMsgCapabilitiesUpdated:
 			_UpdateTabChange(fTabManager->SelectedEditor(), "kMsgCapabilitiesUpdated");
 			break;
@@ -1543,16 +1593,21 @@ GenioWindow::QuitRequested()
 		fGoToLineWindow->Quit();
 	}
 
+	if (fQuickOpenWindow != nullptr) {
+		fQuickOpenWindow->LockLooper();
+		fQuickOpenWindow->Quit();
+	}
+
 	be_app->PostMessage(B_QUIT_REQUESTED);
 	return true;
 }
 
 
 Editor*
-GenioWindow::_AddEditorTab(entry_ref* ref, BMessage* addInfo)
+GenioWindow::_AddEditorTab(entry_ref* ref, BMessage* addInfo, int32 index)
 {
 	Editor* editor = new Editor(ref, BMessenger(this));
-	fTabManager->AddEditor(ref->name, editor, addInfo);
+	fTabManager->AddEditor(ref->name, editor, addInfo, index);
 	return editor;
 }
 
@@ -1725,15 +1780,55 @@ GenioWindow::_FileCloseAll()
 status_t
 GenioWindow::_FileOpenAtStartup(BMessage* msg)
 {
-	int32 opened_index = msg->GetInt32("opened_index", 0);
+	// Only the file of the selected tab is read now: the others are read,
+	// styled and sent to the LSP server when their tab is first selected.
+	const bigtime_t startTime = system_time();
+	const int32 opened_index = msg->GetInt32("opened_index", 0);
+	Editor* selected = nullptr;
 	entry_ref ref;
-	int32 refsCount = 0;
-	while (msg->FindRef("refs", refsCount++, &ref) == B_OK) {
-		_FileOpenWithPosition(&ref, false, -1,-1);
+	for (int32 i = 0; msg->FindRef("refs", i, &ref) == B_OK; i++) {
+		if (!BEntry(&ref).Exists() || !IsFileSupported(&ref))
+			continue;
+		Editor* editor = _AddEditorTab(&ref, nullptr, fTabManager->CountTabs());
+		if (i == opened_index)
+			selected = editor;
 	}
-	if (fTabManager->CountTabs() > opened_index) {
-		fTabManager->SelectTab(opened_index);
+	if (selected == nullptr && fTabManager->CountTabs() > 0)
+		selected = fTabManager->EditorAt(0);
+
+	int32 loaded = 0;
+	if (selected != nullptr) {
+		if (_LoadRestoredEditor(selected) == B_OK)
+			loaded++;
+		fTabManager->SelectTab(selected->FileRef());
 	}
+	LogInfo("Session restored: %d tabs, %d loaded, in %.2f ms", fTabManager->CountTabs(),
+		loaded, (system_time() - startTime) / 1000.0);
+	return B_OK;
+}
+
+
+status_t
+GenioWindow::_LoadRestoredEditor(Editor* editor)
+{
+	const bigtime_t startTime = system_time();
+	status_t status = editor->LoadFromFile();
+	if (status != B_OK) {
+		LogError("Failed loading file: %s", ::strerror(status));
+		return status;
+	}
+	editor->SetSavedCaretPosition();
+
+	be_roster->AddToRecentDocuments(editor->FileRef(), GenioNames::kApplicationSignature);
+
+	// a project may have been set while the file wasn't read: now the
+	// file type is known and the LSP server can be picked
+	if (editor->GetProjectFolder() != nullptr)
+		editor->SetProjectFolder(editor->GetProjectFolder());
+	_PostFileLoad(editor);
+
+	LogInfo("File open: %s (restored, %.2f ms)", editor->Name().String(),
+		(system_time() - startTime) / 1000.0);
 	return B_OK;
 }
 
@@ -1761,6 +1856,10 @@ GenioWindow::_FileOpen(BMessage* msg)
 
 		Editor* editor = fTabManager->EditorBy(&ref);
 		if (editor != nullptr) {
+			// the edits below need the text
+			if (!editor->IsLoaded() && !editor->IsLoading()
+				&& _LoadRestoredEditor(editor) != B_OK)
+				continue;
 			_SelectEditorToPosition(editor, be_line, lsp_char);
 		} else {
 			if (_FileOpenWithPosition(&ref , openWithPreferred, be_line, lsp_char) != B_OK)
@@ -2760,6 +2859,10 @@ GenioWindow::_InitActions()
 									B_TRANSLATE("Go to line" B_UTF8_ELLIPSIS),
 									"", "", ',');
 
+	ActionManager::RegisterAction(MSG_QUICK_OPEN,
+									B_TRANSLATE("Quick open" B_UTF8_ELLIPSIS),
+									"", "", 'P');
+
 	ActionManager::RegisterAction(MSG_PROJECT_OPEN,
 									B_TRANSLATE("Open project" B_UTF8_ELLIPSIS),
 									"","",'O', B_OPTION_KEY);
@@ -2913,6 +3016,8 @@ GenioWindow::_InitMenu()
 		new BMessage(MSG_HELP_DOCS)));
 	appMenu->AddItem(new BMenuItem(B_TRANSLATE("Genio project" B_UTF8_ELLIPSIS),
 		new BMessage(MSG_HELP_GITHUB)));
+	appMenu->AddItem(new BMenuItem(B_TRANSLATE("Language servers" B_UTF8_ELLIPSIS),
+		new BMessage(MSG_LSP_SERVERS_INFO)));
 	appMenu->AddSeparatorItem();
 	appMenu->AddItem(new BMenuItem(B_TRANSLATE("Settings" B_UTF8_ELLIPSIS),
 		new BMessage(MSG_WINDOW_SETTINGS), 'P', B_OPTION_KEY));
@@ -3065,6 +3170,7 @@ GenioWindow::_InitMenu()
 	searchMenu->AddSeparatorItem();
 
 	ActionManager::AddItem(MSG_GOTO_LINE, searchMenu);
+	ActionManager::AddItem(MSG_QUICK_OPEN, searchMenu);
 
 	ActionManager::SetEnabled(MSG_GOTO_LINE, false);
 
@@ -3656,6 +3762,37 @@ GenioWindow::_TemplateNewProject(BMessage* message)
 }
 
 
+void
+GenioWindow::_ShowLSPServersInfo()
+{
+	BMessage info;
+	LSPServersManager::GetServersInfo(&info);
+
+	BString text;
+	BMessage server;
+	for (int32 i = 0; info.FindMessage("server", i, &server) == B_OK; i++) {
+		BString line;
+		line.SetToFormat("%s\n", BPath(server.GetString("server", "")).Leaf());
+		text << line;
+		const char* folder = nullptr;
+		for (int32 f = 0; server.FindString("folder", f, &folder) == B_OK; f++)
+			text << "\t" << BPath(folder).Leaf() << "\n";
+		if (server.GetBool("running", false)) {
+			line.SetToFormat(B_TRANSLATE("\tDocuments: %d, pending requests: %d, memory: %.1f MiB\n"),
+				(int)server.GetInt32("documents", 0), (int)server.GetInt32("pending", 0),
+				server.GetUInt64("memory", 0) / (1024.0 * 1024.0));
+		} else {
+			line = B_TRANSLATE("\tNot running\n");
+		}
+		text << line << "\n";
+	}
+	if (text.IsEmpty())
+		text = B_TRANSLATE("No language server in use.");
+
+	OKAlert(B_TRANSLATE("Language servers"), text.String());
+}
+
+
 void
 GenioWindow::_ShowDocumentation()
 {
@@ -3696,9 +3833,15 @@ GenioWindow::_ProjectFolderClose(ProjectFolder *project)
 	if (project == nullptr)
 		return;
 
+	// Still loading: stop the scan, the opener task closes it when done
+	if (project->IsLoading() && !project->IsLoadingCancelled()) {
+		project->CancelLoading();
+		return;
+	}
+
 	// Don't close anything if tasks are running
 	// TODO: improve this
-	if (AreTasksRunning())
+	if (AreTasksRunning() && !project->IsLoadingCancelled())
 		return;
 
 	std::vector<Editor*> unsavedEditor;
@@ -3871,6 +4014,13 @@ GenioWindow::_ProjectFolderOpenerRunner(ProjectFolder* project, bool activate)
 {
 	ProjectFolder* result = GetProjectBrowser()->ProjectBrowser::ProjectFolderPopulate(project);
 
+	if (result->IsLoadingCancelled()) {
+		BMessage closeMessage(MSG_PROJECT_MENU_CLOSE);
+		closeMessage.AddPointer("project", result);
+		PostMessage(&closeMessage);
+		return result;
+	}
+
 	LockLooper();
 	_ProjectFolderOpenCompleted(result, *result->EntryRef(), activate);
 	UnlockLooper();
@@ -4264,13 +4414,8 @@ GenioWindow::_UpdateProjectMenuItemsState(bool enable)
 
 	if (enable) {
 		// Is the active project a git project?
-		try {
-			if (GetActiveProject()->GetRepository()->IsInitialized())
-				fGitMenu->SetEnabled(true);
-			else
-				fGitMenu->SetEnabled(false);
-		} catch (const GitException &ex) {
-		}
+		GitWorker* gitWorker = GetActiveProject()->GetGitWorker();
+		fGitMenu->SetEnabled(gitWorker != nullptr && gitWorker->IsRepository());
 
 		// Build mode
 		bool releaseMode = (GetActiveProject()->GetBuildMode() == BuildMode::ReleaseMode);
@@ -4492,12 +4637,11 @@ GenioWindow::_UpdateTabChange(Editor* editor, const BString& caller)
 
 	fBookmarksMenu->SetEnabled(true);
 
+	// as last read by the git worker
 	BString currentBranch;
-	try {
-		ProjectFolder* project = editor->GetProjectFolder();
-		currentBranch = project ? project->GetRepository()->GetCurrentBranch() : "";
-	} catch (...) {
-	}
+	ProjectFolder* project = editor->GetProjectFolder();
+	if (project != nullptr && project->GetGitWorker() != nullptr)
+		currentBranch = project->GetGitWorker()->CurrentBranch();
 	_UpdateWindowTitle(editor, currentBranch.String());
 
 	// editor is modified by _FilesNeedSave so it should be the last
@@ -4564,11 +4708,9 @@ GenioWindow::_HandleConfigurationChanged(BMessage* message)
 	Editor* selected = fTabManager->SelectedEditor();
 	BString currentBranch;
 	if (selected != nullptr) {
-		try {
-			ProjectFolder* project = selected->GetProjectFolder();
-			currentBranch = project ? project->GetRepository()->GetCurrentBranch() : "";
-		} catch (...) {
-		}
+		ProjectFolder* project = selected->GetProjectFolder();
+		if (project != nullptr && project->GetGitWorker() != nullptr)
+			currentBranch = project->GetGitWorker()->CurrentBranch();
 	}
 	_UpdateWindowTitle(selected, currentBranch.String());
 }
@@ -29,6 +29,7 @@ class GoToLineWindow;
 class ProblemsPanel;
 class ProjectFolder;
 class ProjectBrowser;
+class QuickOpenWindow;
 class SearchResultTab;
 class SourceControlPanel;
 class TemplatesMenu;
@@ -66,7 +67,8 @@ public:
 private:
 			void				_PrepareWorkspace();
 
-			Editor*				_AddEditorTab(entry_ref* ref, BMessage* addInfo);
+			Editor*				_AddEditorTab(entry_ref* ref, BMessage* addInfo,
+									int32 index = -1);
 			status_t			_RemoveTab(Editor* editor);
 
 			status_t			_BuildProject();
@@ -81,6 +83,7 @@ private:
 
 			status_t			_FileOpen(BMessage* msg);
 			status_t			_FileOpenAtStartup(BMessage* msg);
+			status_t			_LoadRestoredEditor(Editor* editor);
 			status_t			_FileOpenWithPosition(entry_ref* ref, bool openWithPreferred,  int32 be_line, int32 lsp_char);
 			status_t            _FileOpenWithPreferredApp(const entry_ref* ref);
 
@@ -129,6 +132,7 @@ private:
 			void				_TemplateNewFile(BMessage* message);
 
 			void				_ShowDocumentation();
+			void				_ShowLSPServersInfo();
 
 			// Project Folders (TODO: Rename to Project*, without "Folder")
 			void				_ProjectFolderClose(ProjectFolder *project);
@@ -255,6 +259,7 @@ private:
 			ConsoleIOTabView*	fBuildLogView;
 			ConsoleIOTabView*	fMTermView;
 			GoToLineWindow*		fGoToLineWindow;
+			QuickOpenWindow*	fQuickOpenWindow;
 			SearchResultTab*	fSearchResultTab;
 
 			screen_mode			fScreenMode;
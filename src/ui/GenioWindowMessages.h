@@ -84,6 +84,7 @@ enum {
 	MSG_REPLACE_PREVIOUS		= 'repr',
 	MSG_REPLACE_ALL				= 'real',
 	MSG_GOTO_LINE				= 'goli',
+	MSG_QUICK_OPEN				= 'quop',
 	MSG_BOOKMARK_CLEAR_ALL		= 'bcal',
 	MSG_BOOKMARK_GOTO_NEXT		= 'bgne',
 	MSG_BOOKMARK_GOTO_PREVIOUS	= 'bgpr',
@@ -141,6 +142,7 @@ enum {
 
 	MSG_HELP_GITHUB					= 'hegh',
 	MSG_HELP_DOCS					= 'hdoc',
+	MSG_LSP_SERVERS_INFO			= 'lspi',
 
 	MSG_WHEEL_WITH_COMMAND_KEY		= 'waco',
 
@@ -17,7 +17,9 @@
 #include <TabView.h>
 #include <Window.h>
 
+#include <algorithm>
 #include <string>
+#include <unordered_map>
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "ProblemsPanel"
@@ -44,8 +46,21 @@ public:
 
 	GMessage	fRange;
 	Editor 		*fEditor;
+	std::string	fKey;
 };
 
+
+// Identity of the row showing a diagnostic
+static std::string
+ProblemKey(const Diagnostic& diagnostic)
+{
+	const Range& r = diagnostic.range;
+	return std::to_string(r.start.line) + ":" + std::to_string(r.start.character) + "-"
+		+ std::to_string(r.end.line) + ":" + std::to_string(r.end.character) + " "
+		+ std::to_string(diagnostic.severity) + " " + diagnostic.category.value() + " "
+		+ diagnostic.source + " " + diagnostic.message;
+}
+
 #define ProblemLabel B_TRANSLATE("Problems")
 
 ProblemsPanel::ProblemsPanel(PanelTabManager* panelTabManager, tab_id id)
@@ -152,33 +167,61 @@ ProblemsPanel::MessageReceived(BMessage* msg)
 void
 ProblemsPanel::UpdateProblems(Editor* editor)
 {
-	Clear();
-
 	LSPEditorWrapper* lsp = editor->GetLSPEditorWrapper();
-	if (lsp) {
-		std::vector<LSPDiagnostic> diagnostics;
-		lsp->GetDiagnostics(diagnostics);
-		for (auto& dia: diagnostics) {
-			RangeRow* row = new RangeRow();
-
-			GMessage range;
-			range["start:line"] = dia.diagnostic.range.start.line;
-			range["start:character"] = dia.diagnostic.range.start.character;
-			range["end:line"] = dia.diagnostic.range.end.line;
-			range["end:character"] = dia.diagnostic.range.end.character;
-			row->fRange = range;
-			row->fEditor = editor;
-			row->fRange.AddRef("refs", editor->FileRef());
-			row->SetField(new BStringField(dia.diagnostic.category.value().c_str()), kCategoryColumn);
-			row->SetField(new BStringField(dia.diagnostic.message.c_str()), kMessageColumn);
-			row->SetField(new BStringField(dia.diagnostic.source.c_str()), kSourceColumn);
-			BString line;
-			line.SetToFormat("%d", dia.diagnostic.range.start.line + 1);
-			row->SetField(new BStringField(line), kPositionColumn);
-			AddRow(row);
+	if (lsp == nullptr) {
+		Clear();
+		return;
+	}
+
+	std::vector<LSPDiagnostic> diagnostics;
+	lsp->GetDiagnostics(diagnostics);
+
+	// Only the rows of the diagnostics that changed are removed or added,
+	// the others (and the selection) are left untouched.
+	std::unordered_map<std::string, int32> current;
+	for (auto& dia: diagnostics)
+		current[ProblemKey(dia.diagnostic)]++;
+
+	for (int32 i = CountRows() - 1; i >= 0; i--) {
+		RangeRow* row = static_cast<RangeRow*>(RowAt(i));
+		auto search = current.find(row->fKey);
+		if (row->fEditor == editor && search != current.end() && search->second > 0) {
+			search->second--;
+		} else {
+			RemoveRow(row);
+			delete row;
 		}
-		_UpdateTabLabel();
 	}
+
+	// what's left in 'current' is new
+	for (size_t index = 0; index < diagnostics.size(); index++) {
+		const Diagnostic& diagnostic = diagnostics[index].diagnostic;
+		std::string key = ProblemKey(diagnostic);
+		auto search = current.find(key);
+		if (search->second == 0)
+			continue;
+		search->second--;
+
+		RangeRow* row = new RangeRow();
+
+		GMessage range;
+		range["start:line"] = diagnostic.range.start.line;
+		range["start:character"] = diagnostic.range.start.character;
+		range["end:line"] = diagnostic.range.end.line;
+		range["end:character"] = diagnostic.range.end.character;
+		row->fRange = range;
+		row->fEditor = editor;
+		row->fKey = key;
+		row->fRange.AddRef("refs", editor->FileRef());
+		row->SetField(new BStringField(diagnostic.category.value().c_str()), kCategoryColumn);
+		row->SetField(new BStringField(diagnostic.message.c_str()), kMessageColumn);
+		row->SetField(new BStringField(diagnostic.source.c_str()), kSourceColumn);
+		BString line;
+		line.SetToFormat("%d", diagnostic.range.start.line + 1);
+		row->SetField(new BStringField(line), kPositionColumn);
+		AddRow(row, std::min((int32)index, CountRows()));
+	}
+	_UpdateTabLabel();
 }
 
 
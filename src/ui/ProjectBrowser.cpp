@@ -6,6 +6,9 @@
 #include "ProjectBrowser.h"
 
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
 
 #include <Catalog.h>
 #include <Debug.h>
@@ -17,7 +20,6 @@
 #include <NaturalCompare.h>
 #include <PopUpMenu.h>
 #include <ScrollView.h>
-#include <StringList.h>
 #include <StringView.h>
 
 #include "ActionManager.h"
@@ -26,15 +28,18 @@
 #include "GenioWatchingFilter.h"
 #include "GenioWindowMessages.h"
 #include "GenioWindow.h"
+#include "GitWorker.h"
 #include "GOutlineListView.h"
 #include "Log.h"
 #include "NoticeMessages.h"
+#include "PathIndex.h"
 #include "ProjectFolder.h"
 #include "ProjectItem.h"
 #include "SpinningAnimation.h"
 #include "SwitchBranchMenu.h"
 #include "TemplateManager.h"
 #include "TemplatesMenu.h"
+#include "TrigramIndex.h"
 #include "Utils.h"
 
 
@@ -43,11 +48,27 @@
 
 const uint32 kTick = 'tick';
 
+static const int32 kMaxScanThreads = 8;
+static const int32 kMemorySampleInterval = 4096;	// items
+static const bigtime_t kNodeEventsDelay = 16000;	// a frame at 60 Hz
+
+
+static size_t
+TeamMemoryUsage()
+{
+	size_t usage = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(B_CURRENT_TEAM, &cookie, &info) == B_OK)
+		usage += info.ram_size;
+	return usage;
+}
+
 static BMessageRunner* sAnimationTickRunner;
 
 class ProjectOutlineListView : public GOutlineListView {
 public:
-			ProjectOutlineListView();
+			ProjectOutlineListView(ProjectBrowser* browser);
 	virtual ~ProjectOutlineListView();
 
 	void MouseMoved(BPoint point, uint32 transit, const BMessage* message) override;
@@ -62,10 +83,15 @@ public:
 
 	static int CompareProjectItems(const BListItem* a, const BListItem* b);
 
+protected:
+	void ExpandOrCollapse(BListItem* superItem, bool expand) override;
+
 private:
 	void ShowPopupMenu(BPoint where) override;
 
 	void _AddProjectFolderMenuItems(BMenu* projectMenu, ProjectFolder* project);
+
+	ProjectBrowser* fProjectBrowser;
 };
 
 
@@ -125,9 +151,12 @@ public:
 ProjectBrowser::ProjectBrowser()
 	:
 	BView("Project browser", B_WILL_DRAW|B_FRAME_EVENTS),
-	fBatchLock("ProjectBrowser batch lock")
+	fNodeEventsFlushPending(false),
+	fScrollToSelection(false),
+	fNodeEventsReceived(0),
+	fNodeEventsApplied(0)
 {
-	fOutlineListView = new ProjectOutlineListView();
+	fOutlineListView = new ProjectOutlineListView(this);
 	ProjectDropView* projectDropView = new ProjectDropView();
 
 	BScrollView* scrollView = new BScrollView("scrollview", fOutlineListView,
@@ -150,58 +179,72 @@ ProjectBrowser::~ProjectBrowser()
 }
 
 
-ProjectItem*
-ProjectBrowser::_CreateNewProjectItem(ProjectItem* parentItem, BPath path)
+ProjectBrowser::NodeId
+ProjectBrowser::_CreatePath(ProjectFolder* project, const BPath& path)
 {
-	ProjectFolder *projectFolder = parentItem->GetSourceItem()->GetProjectFolder();
-	SourceItem *sourceItem = new SourceItem(path.Path());
-	sourceItem->SetProjectFolder(projectFolder);
-	return new ProjectItem(sourceItem);
+	LogTrace("Create path for %s", path.Path());
+	ProjectNodeTable* table = project->NodeTable();
+	NodeId node = table->FindByPath(path.Path());
+	if (node != ProjectNodeTable::kNoNode)
+		return node;
+
+	BPath parentPath;
+	if (path.GetParent(&parentPath) != B_OK)
+		return ProjectNodeTable::kNoNode;
+	const NodeId parent = _CreatePath(project, parentPath);
+	struct stat st;
+	if (parent == ProjectNodeTable::kNoNode || lstat(path.Path(), &st) != 0) {
+		LogTrace("Can't find path %s", path.Path());
+		return ProjectNodeTable::kNoNode;
+	}
+
+	LogTrace("Creating path %s", path.Path());
+	const bool isDirectory = S_ISDIR(st.st_mode);
+	node = table->Add(parent, path.Leaf(), node_ref(st.st_dev, st.st_ino), isDirectory);
+	// a folder moved in: what it holds doesn't show up as new entries
+	if (isDirectory)
+		_ProjectFolderScan(project, node);
+	if (table->IsPopulated(parent)) {
+		ProjectItem* parentItem = table->Item(parent);
+		_AddItem(project, node);
+		if (isDirectory && parentItem->IsExpanded())
+			_PopulateNode(project, node);
+		_SortLater(project, parent);
+	}
+	return node;
 }
 
 
-ProjectItem*
-ProjectBrowser::_CreatePath(BPath pathToCreate)
+void
+ProjectBrowser::_RemoveNode(ProjectFolder* project, NodeId node)
 {
-	LogTrace("Create path for %s", pathToCreate.Path());
-	ProjectItem *item = GetProjectItemByPath(pathToCreate.Path());
-
-	if (!item) {
-		LogTrace("Can't find path %s", pathToCreate.Path());
-		BPath parent;
-		if (pathToCreate.GetParent(&parent) == B_OK) {
-			ProjectItem* parentItem = _CreatePath(parent);
-			LogTrace("Creating path %s", pathToCreate.Path());
-			ProjectItem* newItem = _CreateNewProjectItem(parentItem, pathToCreate);
-
-			if (fOutlineListView->AddUnder(newItem,parentItem)) {
-				LogDebugF("AddUnder(%s,%s) (Parent %s)", newItem->Text(), parentItem->Text(), parent.Path());
-				fOutlineListView->SortItemsUnder(parentItem, true,
-					ProjectOutlineListView::CompareProjectItems);
-				fOutlineListView->Collapse(newItem);
-			}
-			return newItem;
-		}
-	}
-	LogTrace("Found path [%s]", pathToCreate.Path());
-	return item;
+	if (node == ProjectNodeTable::kNoNode)
+		return;
+
+	ProjectNodeTable* table = project->NodeTable();
+	ProjectItem* item = table->Item(node);
+	if (item != nullptr)
+		fOutlineListView->RemoveItem(item);
+	table->Remove(node);
 }
 
 
 void
-ProjectBrowser::_RemovePath(BString spath)
+ProjectBrowser::_RemovePath(ProjectFolder* project, const BString& spath)
 {
 	LogDebug("path %s", spath.String());
-	ProjectItem *item = GetProjectItemByPath(spath);
-	if (!item) {
-		LogError("Can't find an item to remove [%s]", spath.String());
+	ProjectNodeTable* table = project->NodeTable();
+	const NodeId node = table->FindByPath(spath);
+	if (node == ProjectNodeTable::kNoNode) {
+		// created and removed again before we knew
+		LogDebug("Can't find an item to remove [%s]", spath.String());
 		return;
 	}
-	if (item->GetSourceItem()->Type() == SourceItemType::ProjectFolderItem) {
+	if (node == table->Root()) {
 		if (LockLooper()) {
-			fOutlineListView->Select(fOutlineListView->IndexOf(item));
+			fOutlineListView->Select(fOutlineListView->IndexOf(table->Item(node)));
 			BMessage closePrj(MSG_PROJECT_MENU_CLOSE);
-			closePrj.AddPointer("project", item->GetSourceItem());
+			closePrj.AddPointer("project", project);
 			Window()->PostMessage(&closePrj);
 
 			// It seems not possible to track the project folder to the new
@@ -217,32 +260,31 @@ ProjectBrowser::_RemovePath(BString spath)
 			UnlockLooper();
 		}
 	} else {
-		fOutlineListView->RemoveItem(item);
-		fOutlineListView->SortItemsUnder(fOutlineListView->Superitem(item),
-			true, ProjectOutlineListView::CompareProjectItems);
+		_RemoveNode(project, node);
 	}
 }
 
 
 void
-ProjectBrowser::_HandleEntryMoved(BMessage* message)
+ProjectBrowser::_HandleEntryMoved(ProjectFolder* project, BMessage* message)
 {
+	ProjectNodeTable* table = project->NodeTable();
 	BString spath;
 	// An item moved outside of the project folder
 	if (message->GetBool("removed", false)) {
 		if (message->FindString("from path", &spath) == B_OK) {
 			LogDebug("from path %s",  spath.String());
-			ProjectItem *item = GetProjectItemByPath(spath);
-			if (!item) {
+			const NodeId node = table->FindByPath(spath);
+			if (node == ProjectNodeTable::kNoNode) {
 				LogError("Can't find an item to move [%s]", spath.String());
 				return;
 			}
 			// the project folder is being renamed
-			if (item->GetSourceItem()->Type() == SourceItemType::ProjectFolderItem) {
+			if (node == table->Root()) {
 				if (LockLooper()) {
-					fOutlineListView->Select(fOutlineListView->IndexOf(item));
+					fOutlineListView->Select(fOutlineListView->IndexOf(table->Item(node)));
 					BMessage closePrj(MSG_PROJECT_MENU_CLOSE);
-					closePrj.AddPointer("project", item->GetSourceItem());
+					closePrj.AddPointer("project", project);
 					Window()->PostMessage(&closePrj);
 
 					auto alert = new BAlert("ProjectFolderChanged",
@@ -265,42 +307,16 @@ ProjectBrowser::_HandleEntryMoved(BMessage* message)
 					UnlockLooper();
 				}
 			} else {
-				fOutlineListView->RemoveItem(item);
-				fOutlineListView->SortItemsUnder(fOutlineListView->Superitem(item),
-					true, ProjectOutlineListView::CompareProjectItems);
+				_RemoveNode(project, node);
 			}
 		}
 	} else {
 		BString oldName, newName;
 		BString oldPath, newPath;
 		if (message->GetBool("added")) {
-			if (message->FindString("path", &newPath) == B_OK) {
-				if (message->FindString("name", &newName) == B_OK) {
-					const BPath destination(newPath);
-					BEntry newPathEntry(newPath);
-					if (newPathEntry.IsDirectory()) {
-						// a new folder moved inside the project.
-						//ensure we have a parent
-						BPath parent;
-						destination.GetParent(&parent);
-						ProjectItem *parentItem = _CreatePath(parent);
-						// recursive parsing!
-						entry_ref entryRef;
-						newPathEntry.GetRef(&entryRef);
-						ProjectFolder* projectFolder = parentItem->GetSourceItem()->GetProjectFolder();
-						// Flush any existing batch before adding new items
-						_FlushItemBatch(projectFolder, true);
-						_ProjectFolderScan(&entryRef, parentItem, projectFolder);
-						// Flush the new items
-						_FlushItemBatch(projectFolder, true);
-						fOutlineListView->SortItemsUnder(parentItem, false,
-								ProjectOutlineListView::CompareProjectItems);
-					} else {
-						//Plain file
-						_CreatePath(destination);
-					}
-				}
-			}
+			// a file or a folder moved inside the project
+			if (message->FindString("path", &newPath) == B_OK)
+				_CreatePath(project, BPath(newPath));
 		} else if (message->FindString("from name", &oldName) == B_OK) {
 			if (message->FindString("name", &newName) == B_OK) {
 				if (message->FindString("from path", &oldPath) == B_OK) {
@@ -312,50 +328,51 @@ ProjectBrowser::_HandleEntryMoved(BMessage* message)
 						BPath bp_newParent;
 						bp_newPath.GetParent(&bp_newParent);
 
+						const NodeId node = table->FindByPath(oldPath);
+						if (node == ProjectNodeTable::kNoNode) {
+							// created and moved before we knew
+							LogDebug("Can't find an item to move oldPath[%s] -> newPath[%s]", oldPath.String(), newPath.String());
+							_CreatePath(project, bp_newPath);
+							return;
+						}
+
 						// If the path remains the same except the leaf
 						// then the item is being RENAMED
 						// if the path changes then the item is being MOVED
 						if (bp_oldParent == bp_newParent) {
-							ProjectItem *item = GetProjectItemByPath(oldPath);
-							if (!item) {
-								LogError("Can't find an item to move oldPath[%s] -> newPath[%s]", oldPath.String(), newPath.String());
-								return;
-							}
+							const NodeId replaced = table->Find(table->Parent(node), newName);
+							if (replaced != node)
+								_RemoveNode(project, replaced);
+							table->Move(node, table->Parent(node), newName);
+							ProjectItem* item = table->Item(node);
 							entry_ref newRef;
-							if (get_ref_for_path(newPath, &newRef) == B_OK) {
+							if (item != nullptr && table->GetEntryRef(node, &newRef)) {
 								item->SetText(newName);
 								item->GetSourceItem()->UpdateEntryRef(newRef);
-								fOutlineListView->SortItemsUnder(fOutlineListView->Superitem(item),
-									true, ProjectOutlineListView::CompareProjectItems);
+								_SortLater(project, table->Parent(node));
 								if (item->IsSelected())
-									fOutlineListView->ScrollToSelection();
-							} else {
-								LogError("Can't find ref for newPath[%s]", newPath.String());
-								return;
+									fScrollToSelection = true;
 							}
 						} else {
-							ProjectItem *item = GetProjectItemByPath(oldPath);
-							if (!item) {
-								LogError("Can't find an item to move oldPath [%s]", oldPath.String());
-								return;
-							}
-							ProjectItem *destinationItem = GetProjectItemByPath(bp_newParent.Path());
-							if (!destinationItem) {
+							const NodeId destination = _CreatePath(project, bp_newParent);
+							if (destination == ProjectNodeTable::kNoNode) {
 								LogError("Can't find an item to move newParent [%s]", bp_newParent.Path());
 								return;
 							}
-							bool status = fOutlineListView->RemoveItem(item);
-							if (status) {
-								fOutlineListView->SortItemsUnder(
-									fOutlineListView->Superitem(item), true,
-										ProjectOutlineListView::CompareProjectItems);
-
-								ProjectItem *newItem = _CreateNewProjectItem(item, bp_newPath);
-								status = fOutlineListView->AddUnder(newItem, destinationItem);
-								if (status) {
-									fOutlineListView->SortItemsUnder(destinationItem, true,
-										ProjectOutlineListView::CompareProjectItems);
-								}
+							ProjectItem* item = table->Item(node);
+							if (item != nullptr)
+								fOutlineListView->RemoveItem(item);
+							table->ForgetItems(node);
+							const NodeId replaced = table->Find(destination, newName);
+							if (replaced != node)
+								_RemoveNode(project, replaced);
+							table->Move(node, destination, newName);
+							if (table->IsPopulated(destination)) {
+								ProjectItem* destinationItem = table->Item(destination);
+								_AddItem(project, node);
+								if (table->IsDirectory(node) && destinationItem->IsExpanded())
+									_PopulateNode(project, node);
+								_SortLater(project, destination);
 							}
 						}
 					}
@@ -367,39 +384,169 @@ ProjectBrowser::_HandleEntryMoved(BMessage* message)
 
 
 void
-ProjectBrowser::_UpdateNode(BMessage* message)
+ProjectBrowser::_QueueNodeEvent(BMessage* message)
 {
-	int32 opCode;
-	if (message->FindInt32("opcode", &opCode) != B_OK)
+	if (!message->HasInt32("opcode") || !message->HasString("watched_path"))
 		return;
 
-	if (!message->HasString("watched_path"))
-		return;
+	fNodeEvents.push_back(*message);
+	fNodeEventsReceived++;
+	if (!fNodeEventsFlushPending) {
+		BMessage flush(MSG_PROJECT_FLUSH_NODE_EVENTS);
+		BMessageRunner::StartSending(BMessenger(this), &flush, kNodeEventsDelay, 1);
+		fNodeEventsFlushPending = true;
+	}
+}
 
-	switch (opCode) {
-		case B_ENTRY_CREATED:
-		{
-			BString spath;
-			if (message->FindString("path", &spath) == B_OK) {
-				BPath path(spath.String());
-				_CreatePath(path);
-			}
-			break;
+
+static bool
+HasGoneAncestor(const std::set<std::pair<BString, BString>>& gone,
+	const std::pair<BString, BString>& entry)
+{
+	const BString& watchedPath = entry.first;
+	BString path(entry.second);
+	for (int32 slash = path.FindLast('/'); slash > watchedPath.Length();
+			slash = path.FindLast('/')) {
+		path.Truncate(slash);
+		if (gone.count(std::make_pair(watchedPath, path)) != 0)
+			return true;
+	}
+	return false;
+}
+
+
+// Applies the node monitor messages queued in the last frame at once.
+// Creations and removals are checked against the disk: only the last one
+// of each path counts, and nothing below a folder that is gone needs
+// to be removed on its own. Moves are applied in order.
+void
+ProjectBrowser::_FlushNodeEvents()
+{
+	fNodeEventsFlushPending = false;
+	std::vector<BMessage> events;
+	events.swap(fNodeEvents);
+	const bigtime_t startTime = system_time();
+
+	// (watched path, path)
+	std::map<std::pair<BString, BString>, size_t> lastChange;
+	for (size_t i = 0; i < events.size(); i++) {
+		const int32 opcode = events[i].GetInt32("opcode", 0);
+		if (opcode == B_ENTRY_CREATED || opcode == B_ENTRY_REMOVED) {
+			lastChange[std::make_pair(BString(events[i].GetString("watched_path", "")),
+				BString(events[i].GetString("path", "")))] = i;
 		}
-		case B_ENTRY_REMOVED:
-		{
-			BString spath;
-			if (message->FindString("path", &spath) == B_OK) {
-				_RemovePath(spath);
-			}
-			break;
+	}
+	std::set<std::pair<BString, BString>> gone;
+	for (const auto& [entry, index] : lastChange) {
+		struct stat st;
+		if (lstat(entry.second, &st) != 0)
+			gone.insert(entry);
+	}
+
+	std::map<ProjectFolder*, std::set<BString>> changedPaths;
+	uint64 applied = 0;
+	for (size_t i = 0; i < events.size(); i++) {
+		BMessage& message = events[i];
+		ProjectFolder* project = ProjectByPath(message.GetString("watched_path", ""));
+		if (project == nullptr)
+			continue;
+
+		const char* fields[] = { "from path", "path" };
+		for (const char* field : fields) {
+			BString path;
+			if (message.FindString(field, &path) == B_OK)
+				changedPaths[project].insert(path);
 		}
-		case B_ENTRY_MOVED:
-			_HandleEntryMoved(message);
-			break;
-		default:
-			break;
+
+		const int32 opcode = message.GetInt32("opcode", 0);
+		if (opcode == B_ENTRY_CREATED || opcode == B_ENTRY_REMOVED) {
+			const std::pair<BString, BString> entry(message.GetString("watched_path", ""),
+				message.GetString("path", ""));
+			if (lastChange[entry] != i)
+				continue;
+			if (gone.count(entry) == 0)
+				_CreatePath(project, BPath(entry.second));
+			else if (!HasGoneAncestor(gone, entry))
+				_RemovePath(project, entry.second);
+			else
+				continue;
+		} else if (opcode == B_ENTRY_MOVED) {
+			_HandleEntryMoved(project, &message);
+		} else
+			continue;
+		applied++;
+	}
+
+	for (const auto& [project, paths] : changedPaths) {
+		for (const BString& path : paths)
+			_UpdateSearchIndex(project, path);
+		_UpdateGitStatus(project, paths);
+	}
+
+	for (const auto& [project, node] : fUnsortedNodes) {
+		ProjectItem* item = _IsLoaded(project) ? project->NodeTable()->Item(node) : nullptr;
+		if (item != nullptr) {
+			fOutlineListView->SortItemsUnder(item, true,
+				ProjectOutlineListView::CompareProjectItems);
+		}
+	}
+	const size_t sortedCount = fUnsortedNodes.size();
+	fUnsortedNodes.clear();
+	if (fScrollToSelection) {
+		fOutlineListView->ScrollToSelection();
+		fScrollToSelection = false;
+	}
+
+	fNodeEventsApplied += applied;
+	LogDebug("ProjectBrowser: %d node events, %d applied, %d folders sorted in %.2f ms "
+		"(%" B_PRIu64 " received, %" B_PRIu64 " applied so far)", (int32)events.size(), (int32)applied,
+		(int32)sortedCount, (system_time() - startTime) / 1000.0,
+		fNodeEventsReceived, fNodeEventsApplied);
+}
+
+
+// the folder is sorted once, when the queued events are all applied
+void
+ProjectBrowser::_SortLater(ProjectFolder* project, NodeId node)
+{
+	fUnsortedNodes.insert(std::make_pair(project, node));
+}
+
+
+void
+ProjectBrowser::_UpdateSearchIndex(ProjectFolder* project, const BString& path)
+{
+	// the indexes find out by themselves what happened to the path
+	if (project->SearchIndex() != nullptr)
+		project->SearchIndex()->Update(path);
+	if (project->FileIndex() != nullptr)
+		project->FileIndex()->Update(path);
+}
+
+
+// Only the subtrees which changed are read again. Changes inside .git
+// have the worker check whether the index or HEAD moved.
+void
+ProjectBrowser::_UpdateGitStatus(ProjectFolder* project, const std::set<BString>& paths)
+{
+	GitWorker* worker = project->GetGitWorker();
+	if (worker == nullptr)
+		return;
+
+	const BString projectPath = project->Path();
+	BString gitPath(projectPath);
+	gitPath << "/.git";
+	std::set<BString> relativePaths;
+	for (const BString& path : paths) {
+		if (!path.StartsWith(projectPath) || path == gitPath
+			|| path.StartsWith(BString(gitPath) << "/"))
+			continue;
+		if (path.Length() == projectPath.Length())
+			relativePaths.insert("");
+		else if (path[projectPath.Length()] == '/')
+			relativePaths.insert(BString(path.String() + projectPath.Length() + 1));
 	}
+	worker->RefreshStatus(BMessenger(this), relativePaths);
 }
 
 
@@ -412,10 +559,25 @@ ProjectBrowser::MessageReceived(BMessage* message)
 		{
 			if (Logger::IsDebugEnabled())
 				message->PrintToStream();
-			_UpdateNode(message);
+			_QueueNodeEvent(message);
 			SendNotices(B_PATH_MONITOR, message);
 			break;
 		}
+		case MSG_PROJECT_FLUSH_NODE_EVENTS:
+			_FlushNodeEvents();
+			break;
+		case MSG_GIT_JOB_DONE:
+		{
+			if (message->GetInt32("job", -1) != GitWorker::kJobStatus
+				|| !message->GetBool("changed", false))
+				break;
+			fOutlineListView->Invalidate();
+			BMessage notice(MSG_NOTIFY_GIT_STATUS_CHANGED);
+			notice.AddString("project_path", message->GetString("project_path", ""));
+			notice.AddBool("full", message->GetBool("full", false));
+			SendNotices(MSG_NOTIFY_GIT_STATUS_CHANGED, &notice);
+			break;
+		}
 		case MSG_PROJECT_MENU_DO_RENAME_FILE:
 		{
 			BString newName;
@@ -486,6 +648,10 @@ ProjectBrowser::MessageReceived(BMessage* message)
 						item->SetNeedsSave(needsSave);
 						fOutlineListView->InvalidateItem(fOutlineListView->IndexOf(item));
 					}
+					// the folders are watched, not the files: saving is seen here
+					ProjectFolder* project = _ProjectForPath(fileName);
+					if (!needsSave && project != nullptr)
+						_UpdateGitStatus(project, { fileName });
 					break;
 				}
 				case MSG_NOTIFY_BUILDING_PHASE:
@@ -545,39 +711,22 @@ ProjectBrowser::MessageReceived(BMessage* message)
 		}
 		case MSG_BROWSER_SELECT_ITEM:
 		{
-			const BListItem* item = reinterpret_cast<const BListItem*>
+			const ProjectItem* item = reinterpret_cast<const ProjectItem*>
 				(message->GetPointer("parent_item", nullptr));
 			entry_ref ref;
 			if (item != nullptr && message->FindRef("ref", &ref) == B_OK) {
-				int32 howMany = fOutlineListView->CountItemsUnder(const_cast<BListItem*>(item), true);
-				for (int32 i = 0; i < howMany; i++) {
-					ProjectItem* subItem = static_cast<ProjectItem*>
-						(fOutlineListView->ItemUnderAt(const_cast<BListItem*>(item), true, i));
-					if (*subItem->GetSourceItem()->EntryRef() == ref) {
-						fOutlineListView->Select(fOutlineListView->IndexOf(subItem));
-						fOutlineListView->ScrollToSelection();
-						bool doRename = message->GetBool("rename", false);
-						if (doRename) {
-							InitRename(subItem);
-						}
-						break;
+				ProjectItem* subItem = GetItemByRef(GetProjectFromItem(item), ref);
+				if (subItem != nullptr) {
+					fOutlineListView->Select(fOutlineListView->IndexOf(subItem));
+					fOutlineListView->ScrollToSelection();
+					bool doRename = message->GetBool("rename", false);
+					if (doRename) {
+						InitRename(subItem);
 					}
 				}
 			}
 			break;
 		}
-		case MSG_PROJECT_ADD_ITEMS_BATCH:
-		{
-			// Process a batch of items to add to the tree
-			_ProcessItemBatch(message);
-			break;
-		}
-		case MSG_PROJECT_BATCH_SYNC:
-		{
-			// Synchronization message - just reply to confirm processing
-			// This ensures all previous batches have been processed
-			break;
-		}
 		case B_SIMPLE_DATA:
 		{
 			entry_ref ref;
@@ -598,27 +747,43 @@ ProjectBrowser::MessageReceived(BMessage* message)
 }
 
 
-// TODO:
-// Optimize the search under a specific ProjectItem, tipically a
-// superitem (ProjectFolder)
 ProjectItem*
-ProjectBrowser::GetProjectItemByPath(BString const& path) const
+ProjectBrowser::GetProjectItemByPath(BString const& path)
 {
-	entry_ref ref;
-	status_t status = get_ref_for_path(path.String(), &ref);
-	if (status != B_OK) {
-		LogTraceF("invalid path %s (%s)", path.String(), strerror(status));
+	ProjectFolder* project = _ProjectForPath(path);
+	if (project == nullptr)
+		return nullptr;
+
+	const NodeId node = project->NodeTable()->FindByPath(path);
+	if (node == ProjectNodeTable::kNoNode) {
+		LogTraceF("invalid path %s", path.String());
 		return nullptr;
 	}
+	return _MaterializeItem(project, node);
+}
+
 
-	const int32 countItems = fOutlineListView->FullListCountItems();
-	for (int32 i = 0; i < countItems; i++) {
-		ProjectItem *item = dynamic_cast<ProjectItem*>(fOutlineListView->FullListItemAt(i));
-		if (item != nullptr && *item->GetSourceItem()->EntryRef() == ref)
-			return item;
+// the innermost project holding path
+ProjectFolder*
+ProjectBrowser::_ProjectForPath(const char* path) const
+{
+	ProjectFolder* found = nullptr;
+	for (ProjectFolder* project : fProjectList) {
+		const BString projectPath = project->Path();
+		if (strncmp(path, projectPath, projectPath.Length()) == 0
+			&& (path[projectPath.Length()] == '\0' || path[projectPath.Length()] == '/')
+			&& (found == nullptr || projectPath.Length() > found->Path().Length()))
+			found = project;
 	}
+	return found;
+}
 
-	return nullptr;
+
+// whether the scan is over: until then the table belongs to the scanning threads
+bool
+ProjectBrowser::_IsLoaded(const ProjectFolder* project) const
+{
+	return std::find(fProjectList.begin(), fProjectList.end(), project) != fProjectList.end();
 }
 
 
@@ -671,37 +836,22 @@ ProjectBrowser::GetSelectedProjectFileRef() const
 
 
 ProjectItem*
-ProjectBrowser::GetItemByRef(const ProjectFolder* project, const entry_ref& ref) const
+ProjectBrowser::GetItemByRef(const ProjectFolder* project, const entry_ref& ref)
 {
-	ProjectItem* projectItem = GetProjectItemForProject(project);
-	if (projectItem == nullptr)
+	if (project == nullptr || !_IsLoaded(project))
 		return nullptr;
 
-	bool found = false;
-	BPath path(&ref);
-	BString fullpath = path.Path();
-	if (fullpath.StartsWith(project->Path().String())) {
-		fullpath = fullpath.RemoveFirst(project->Path().String());
-
-		BStringList list;
-		fullpath.Split("/", true, list);
-		for (int32 i = 0; i < list.CountStrings(); i++) {
-			for (int32 j = 0; j < fOutlineListView->CountItemsUnder(projectItem, true); j++) {
-				ProjectItem* pItem = static_cast<ProjectItem*>(
-										fOutlineListView->ItemUnderAt(projectItem, true, j));
-				if (pItem->GetSourceItem()->Name().Compare(list.StringAt(i)) == 0) {
-					fOutlineListView->Expand(projectItem);
-					projectItem = pItem;
-					found = (i == list.CountStrings() - 1);
-					break;
-				}
-			}
-		}
-	}
-	if (!found)
+	ProjectFolder* folder = const_cast<ProjectFolder*>(project);
+	ProjectNodeTable* table = folder->NodeTable();
+	const NodeId node = table->FindByRef(ref);
+	if (node == ProjectNodeTable::kNoNode)
 		return nullptr;
 
-	return projectItem;
+	ProjectItem* item = _MaterializeItem(folder, node);
+	for (NodeId parent = table->Parent(node); parent != ProjectNodeTable::kNoNode;
+			parent = table->Parent(parent))
+		fOutlineListView->Expand(table->Item(parent));
+	return item;
 }
 
 
@@ -799,38 +949,39 @@ ProjectBrowser::ProjectFolderPopulate(ProjectFolder* project)
 	// Start timing
 	bigtime_t startTime = system_time();
 
+	// Show the project title (and its spinner) before reading the tree
+	ProjectNodeTable* table = project->NodeTable();
+	ProjectItem* projectItem = new ProjectTitleItem(project);
+	table->SetItem(table->Root(), projectItem);
 	if (LockLooper()) {
 		if (fOutlineListView->CountItems() == 0)
 			static_cast<BCardLayout*>(GetLayout())->SetVisibleItem(int32(0));
+		fOutlineListView->AddItem(projectItem);
 		UnlockLooper();
 	}
+	bigtime_t firstPaintTime = system_time();
 
-	// Scan the project tree - this collects items in batches
-	// Pass nullptr as parent for the root item (project title)
+	// Scan the project tree into the node table
+	const size_t startMemory = TeamMemoryUsage();
 	bigtime_t scanStartTime = system_time();
-	ProjectItem *projectItem = _ProjectFolderScan(project->EntryRef(), nullptr, project);
+	const size_t peakMemory = _ProjectFolderScan(project, table->Root());
+	table->ShrinkToFit();
 	bigtime_t scanEndTime = system_time();
 
-	ASSERT(projectItem != nullptr);
-
-	// Flush any remaining items in the batch for this specific project
-	_FlushItemBatch(project, false);
-
-	// Wait for all batch messages to be processed before continuing
-	// This ensures all items are in the tree before we sort
-	BMessage syncMessage(MSG_PROJECT_BATCH_SYNC);
-	BMessage syncReply;
-	bigtime_t syncStartTime = system_time();
-	BMessenger(this).SendMessage(&syncMessage, &syncReply);
-	bigtime_t syncEndTime = system_time();
-
 	LockLooper();
 
-	// TODO: here we are ordering ALL the elements (maybe and option could prevent ordering the projects)
-	fOutlineListView->SortItemsUnder(nullptr, false, ProjectOutlineListView::CompareProjectItems);
+	// only the first level is shown: the items of the rest come on demand
+	bigtime_t itemsStartTime = system_time();
+	if (!project->IsLoadingCancelled())
+		_ExpandNode(project, table->Root());
+	fOutlineListView->SortItemsUnder(nullptr, true, ProjectOutlineListView::CompareProjectItems);
+	const int32 itemCount = fOutlineListView->CountItemsUnder(projectItem, false);
+	bigtime_t itemsEndTime = system_time();
 
 	const BString projectPath = project->Path();
-	update_mime_info(projectPath, true, false, B_UPDATE_MIME_INFO_NO_FORCE);
+	// closed while loading: it's going away
+	if (!project->IsLoadingCancelled())
+		update_mime_info(projectPath, true, false, B_UPDATE_MIME_INFO_NO_FORCE);
 
 	fProjectList.push_back(project);
 	fProjectProjectItemList.push_back(projectItem);
@@ -847,20 +998,31 @@ ProjectBrowser::ProjectFolderPopulate(ProjectFolder* project)
 			B_WATCH_RECURSIVELY, BMessenger(this));
 	if (status != B_OK)
 		LogErrorF("Can't StartWatching! path [%s] error[%s]", projectPath.String(), ::strerror(status));
+	_UpdateGitStatus(project, {});
 
 	// Report timing
 	bigtime_t endTime = system_time();
 	bigtime_t totalTime = endTime - startTime;
 	bigtime_t scanTime = scanEndTime - scanStartTime;
-	bigtime_t syncTime = syncEndTime - syncStartTime;
-	int32 itemCount = fOutlineListView->FullListCountItems();
+	bigtime_t itemsTime = itemsEndTime - itemsStartTime;
+
+	if (project->IsLoadingCancelled()) {
+		LogInfoF("Project '%s' closed while loading, scan stopped after %.2f ms",
+			project->Name().String(), scanTime / 1000.0);
+		return project;
+	}
 
-	LogInfoF("Project '%s' loaded: %d items in %.2f ms (scan: %.2f ms, sync: %.2f ms)",
+	LogInfoF("Project '%s' loaded: %d entries (%.1f KiB), %d items in %.2f ms "
+		"(first paint: %.2f ms, scan: %.2f ms, items: %.2f ms, peak memory: +%.1f MiB)",
 		project->Name().String(),
+		table->CountNodes(),
+		table->MemoryUsage() / 1024.0,
 		itemCount,
 		totalTime / 1000.0,
+		(firstPaintTime - startTime) / 1000.0,
 		scanTime / 1000.0,
-		syncTime / 1000.0);
+		itemsTime / 1000.0,
+		(peakMemory - std::min(peakMemory, startMemory)) / (1024.0 * 1024.0));
 
 	return project;
 }
@@ -893,10 +1055,6 @@ ProjectBrowser::ProjectFolderDepopulate(ProjectFolder* project)
 	if (fOutlineListView->CountItems() == 0)
 		static_cast<BCardLayout*>(GetLayout())->SetVisibleItem(int32(1));
 
-	// Clean up any batch associated with this project
-	BAutolock lock(fBatchLock);
-	fItemBatches.erase(project);
-
 	Invalidate();
 }
 
@@ -915,147 +1073,197 @@ ProjectBrowser::ExpandProjectCollapseOther(const BString& project)
 }
 
 
-ProjectItem*
-ProjectBrowser::_ProjectFolderScan(const entry_ref* ref, ProjectItem* parentItem, ProjectFolder *projectFolder)
+struct ProjectBrowser::ScanState {
+	ProjectFolder*				project;
+	ProjectNodeTable*			table;
+	BLocker						lock;	// guards what follows, and the table
+	std::deque<std::pair<NodeId, node_ref>>	directories;
+	int32						pending;	// directories queued or being read
+	sem_id						queued;		// one count per queued directory
+	int32						threadCount;
+	int32						itemCount;
+	size_t						peakMemory;
+};
+
+
+size_t
+ProjectBrowser::_ProjectFolderScan(ProjectFolder* project, NodeId directory)
 {
-	// Create the item WITHOUT adding it to the tree yet
-	ProjectItem *newItem;
-	if (parentItem != nullptr) {
-		// Regular file/folder item
-		SourceItem *sourceItem = new SourceItem(*ref);
-		sourceItem->SetProjectFolder(projectFolder);
-		newItem = new ProjectItem(sourceItem);
-	} else {
-		// Project title item (root level)
-		newItem = new ProjectTitleItem(projectFolder);
+	system_info info;
+	get_system_info(&info);
+
+	ScanState state;
+	state.project = project;
+	state.table = project->NodeTable();
+	state.directories.emplace_back(directory, state.table->NodeRef(directory));
+	state.pending = 1;
+	state.queued = create_sem(1, "project scan");
+	// a folder showing up later is read in place
+	state.threadCount = directory == state.table->Root()
+		? std::clamp((int32)info.cpu_count, (int32)1, kMaxScanThreads) : 1;
+	state.itemCount = 0;
+	state.peakMemory = TeamMemoryUsage();
+
+	std::vector<thread_id> threads;
+	for (int32 i = 0; state.threadCount > 1 && i < state.threadCount; i++) {
+		thread_id thread = spawn_thread(_ScanThread, "project scan", B_NORMAL_PRIORITY, &state);
+		if (thread >= 0 && resume_thread(thread) == B_OK)
+			threads.push_back(thread);
 	}
-
-	// Record the command to add this item with its parent
-	// This replicates the exact sequence: AddUnder(newItem, parentItem) or AddItem(newItem)
-	_AddItemCommandToBatch(newItem, parentItem, projectFolder);
-
-	// Recursively scan subdirectories
-	BEntry entry(ref);
-	if (entry.IsDirectory()) {
-		BDirectory dir(&entry);
-		entry_ref nextRef;
-		while (dir.GetNextRef(&nextRef) != B_ENTRY_NOT_FOUND) {
-			// Pass this item as the parent for children
-			_ProjectFolderScan(&nextRef, newItem, projectFolder);
-		}
+	if (threads.empty())
+		_ScanThread(&state);
+	for (thread_id thread : threads) {
+		status_t result;
+		wait_for_thread(thread, &result);
 	}
+	delete_sem(state.queued);
 
-	return newItem;
+	return std::max(state.peakMemory, TeamMemoryUsage());
 }
 
 
-void
-ProjectBrowser::_AddItemCommandToBatch(ProjectItem* item, ProjectItem* parent, ProjectFolder* project)
+/* static */
+status_t
+ProjectBrowser::_ScanThread(void* cookie)
 {
-	// Thread-safe: multiple scanner threads may call this concurrently
-	BAutolock lock(fBatchLock);
+	ScanState& state = *static_cast<ScanState*>(cookie);
+	while (acquire_sem(state.queued) == B_OK) {
+		NodeId directory;
+		node_ref nodeRef;
+		{
+			BAutolock lock(state.lock);
+			// the last directory read woke everybody up
+			if (state.directories.empty())
+				break;
+			directory = state.directories.front().first;
+			nodeRef = state.directories.front().second;
+			state.directories.pop_front();
+		}
 
-	// Get or create the batch for this project
-	std::vector<AddItemCommand>& projectBatch = fItemBatches[project];
+		if (!state.project->IsLoadingCancelled())
+			_ScanDirectory(directory, nodeRef, state);
 
-	// Reserve space on first use to avoid reallocations
-	if (projectBatch.empty()) {
-		projectBatch.reserve(kProjectItemBatchSize);
+		BAutolock lock(state.lock);
+		if (--state.pending == 0)
+			release_sem_etc(state.queued, state.threadCount, 0);
 	}
+	return B_OK;
+}
 
-	// Record the command: this replicates what the old code did
-	AddItemCommand cmd;
-	cmd.item = item;
-	cmd.parent = parent;
-	cmd.shouldCollapse = (parent != nullptr);  // Collapse all non-root items
-
-	projectBatch.push_back(cmd);
 
-	// Flush when batch reaches threshold
-	if (projectBatch.size() >= kProjectItemBatchSize) {
-		_FlushItemBatchLocked(project, false);  // Lock is already held
+/* static */
+void
+ProjectBrowser::_ScanDirectory(NodeId directoryNode, const node_ref& nodeRef, ScanState& state)
+{
+	BDirectory directory(&nodeRef);
+	entry_ref ref;
+	while (directory.GetNextRef(&ref) == B_OK) {
+		if (state.project->IsLoadingCancelled())
+			return;
+
+		// symlinks are not followed, as before
+		struct stat st;
+		if (directory.GetStatFor(ref.name, &st) != B_OK) {
+			st.st_mode = 0;
+			st.st_dev = ref.device;
+			st.st_ino = -1;
+		}
+		const bool isDirectory = S_ISDIR(st.st_mode);
+		const node_ref childRef(st.st_dev, st.st_ino);
+
+		BAutolock lock(state.lock);
+		const NodeId node = state.table->Add(directoryNode, ref.name, childRef, isDirectory);
+		if (isDirectory) {
+			state.directories.emplace_back(node, childRef);
+			state.pending++;
+			release_sem(state.queued);
+		}
+		if (++state.itemCount % kMemorySampleInterval == 0)
+			state.peakMemory = std::max(state.peakMemory, TeamMemoryUsage());
 	}
 }
 
 
-void
-ProjectBrowser::_FlushItemBatch(ProjectFolder* project, bool synchronous)
+ProjectItem*
+ProjectBrowser::_AddItem(ProjectFolder* project, NodeId node)
 {
-	BAutolock lock(fBatchLock);
-	_FlushItemBatchLocked(project, synchronous);
+	ProjectNodeTable* table = project->NodeTable();
+	entry_ref ref;
+	if (!table->GetEntryRef(node, &ref))
+		return nullptr;
+
+	SourceItem* sourceItem = new SourceItem(ref,
+		table->IsDirectory(node) ? SourceItemType::FolderItem : SourceItemType::FileItem);
+	sourceItem->SetProjectFolder(project);
+	ProjectItem* item = new ProjectItem(sourceItem);
+	fOutlineListView->AddUnder(item, table->Item(table->Parent(node)));
+	fOutlineListView->Collapse(item);
+	table->SetItem(node, item);
+	// an empty folder: whatever shows up in it gets an item right away
+	if (table->IsDirectory(node) && table->FirstChild(node) == ProjectNodeTable::kNoNode)
+		table->SetPopulated(node, true);
+	return item;
 }
 
 
+// Gives an item to each child of node, which must have one already
 void
-ProjectBrowser::_FlushItemBatchLocked(ProjectFolder* project, bool synchronous)
+ProjectBrowser::_PopulateNode(ProjectFolder* project, NodeId node)
 {
-	// Assumes fBatchLock is already held
-	auto it = fItemBatches.find(project);
-	if (it == fItemBatches.end() || it->second.empty())
+	ProjectNodeTable* table = project->NodeTable();
+	if (table->IsPopulated(node))
 		return;
 
-	std::vector<AddItemCommand>& projectBatch = it->second;
-
-	// Create a message with all commands in the batch
-	BMessage batchMessage(MSG_PROJECT_ADD_ITEMS_BATCH);
+	for (NodeId child = table->FirstChild(node); child != ProjectNodeTable::kNoNode;
+			child = table->NextSibling(child)) {
+		if (table->Item(child) == nullptr)
+			_AddItem(project, child);
+	}
+	table->SetPopulated(node, true);
+	fOutlineListView->SortItemsUnder(table->Item(node), true,
+		ProjectOutlineListView::CompareProjectItems);
+}
 
-	// Add project pointer so we know which project these commands belong to
-	batchMessage.AddPointer("project", project);
 
-	// Serialize the commands into the message
-	for (const AddItemCommand& cmd : projectBatch) {
-		batchMessage.AddPointer("item", cmd.item);
-		batchMessage.AddPointer("parent", cmd.parent);
-		batchMessage.AddBool("collapse", cmd.shouldCollapse);
+// The folders shown by expanding node get their children too, so that
+// they have an expander when they're not empty
+void
+ProjectBrowser::_ExpandNode(ProjectFolder* project, NodeId node)
+{
+	ProjectNodeTable* table = project->NodeTable();
+	_PopulateNode(project, node);
+	for (NodeId child = table->FirstChild(node); child != ProjectNodeTable::kNoNode;
+			child = table->NextSibling(child)) {
+		if (table->IsDirectory(child))
+			_PopulateNode(project, child);
 	}
+}
 
-	// Clear the batch before sending
-	projectBatch.clear();
 
-	// Send to our own looper for processing
-	if (synchronous) {
-		// Synchronous: wait for processing to complete
-		BMessage reply;
-		BMessenger(this).SendMessage(&batchMessage, &reply);
-	} else {
-		// Asynchronous: queue for processing
-		// Messages will be processed in FIFO order, maintaining sequence
-		BMessenger(this).SendMessage(&batchMessage);
-	}
+ProjectItem*
+ProjectBrowser::_MaterializeItem(ProjectFolder* project, NodeId node)
+{
+	ProjectNodeTable* table = project->NodeTable();
+	std::vector<NodeId> ancestors;
+	for (NodeId parent = table->Parent(node); parent != ProjectNodeTable::kNoNode;
+			parent = table->Parent(parent))
+		ancestors.push_back(parent);
+	for (auto i = ancestors.rbegin(); i != ancestors.rend(); i++)
+		_PopulateNode(project, *i);
+	return table->Item(node);
 }
 
 
 void
-ProjectBrowser::_ProcessItemBatch(BMessage* message)
+ProjectBrowser::_ItemExpanded(ProjectItem* item)
 {
-	// This is called from MessageReceived on the looper thread
-	// We must already have the looper locked
-	ASSERT(Window() != nullptr && Window()->IsLocked());
-
-	ProjectItem* item;
-	ProjectItem* parent;
-	bool shouldCollapse;
-	int32 index = 0;
-
-	// Replay commands in order - this replicates the exact sequence the old code did
-	while (message->FindPointer("item", index, reinterpret_cast<void**>(&item)) == B_OK &&
-	       message->FindPointer("parent", index, reinterpret_cast<void**>(&parent)) == B_OK &&
-	       message->FindBool("collapse", index, &shouldCollapse) == B_OK) {
-
-		if (parent != nullptr) {
-			fOutlineListView->AddUnder(item, parent);
-			if (shouldCollapse) {
-				fOutlineListView->Collapse(item);
-			}
-		} else {
-			fOutlineListView->AddItem(item);
-		}
-
-		index++;
-	}
+	ProjectFolder* project = GetProjectFromItem(item);
+	if (project == nullptr || !_IsLoaded(project))
+		return;
 
-	// Note: We deliberately don't call Invalidate() here
-	// The list view will invalidate as items are added
+	const NodeId node = project->NodeTable()->FindByRef(*item->GetSourceItem()->EntryRef());
+	if (node != ProjectNodeTable::kNoNode)
+		_ExpandNode(project, node);
 }
 
 
@@ -1154,9 +1362,10 @@ ProjectBrowser::SelectItemByRef(const ProjectFolder* project, const entry_ref& r
 
 
 // ProjectOutlineListView
-ProjectOutlineListView::ProjectOutlineListView()
+ProjectOutlineListView::ProjectOutlineListView(ProjectBrowser* browser)
 	:
-	GOutlineListView("ProjectBrowserOutline", B_SINGLE_SELECTION_LIST)
+	GOutlineListView("ProjectBrowserOutline", B_SINGLE_SELECTION_LIST),
+	fProjectBrowser(browser)
 {
 }
 
@@ -1247,6 +1456,17 @@ ProjectOutlineListView::SelectionChanged()
 }
 
 
+/* virtual */
+void
+ProjectOutlineListView::ExpandOrCollapse(BListItem* superItem, bool expand)
+{
+	GOutlineListView::ExpandOrCollapse(superItem, expand);
+	// the folders just shown need their own children
+	if (expand)
+		fProjectBrowser->_ItemExpanded(static_cast<ProjectItem*>(superItem));
+}
+
+
 ProjectItem*
 ProjectOutlineListView::ProjectItemAt(int32 index) const
 {
@@ -1450,8 +1670,10 @@ ProjectOutlineListView::_AddProjectFolderMenuItems(BMenu* projectMenu, ProjectFo
 
 	if (window != nullptr) {
 		ProjectFolder* activeProject = window->GetActiveProject();
-		setActiveProjectMenuItem->SetEnabled(!project->Active() && !activeProject->IsBuilding());
-		if (window->AreTasksRunning())
+		setActiveProjectMenuItem->SetEnabled(!project->Active() && !project->IsLoading()
+			&& (activeProject == nullptr || !activeProject->IsBuilding()));
+		// closing a project which is still loading stops the scan
+		if (window->AreTasksRunning() && !project->IsLoading())
 			closeProjectMenuItem->SetEnabled(false);
 	}
 
@@ -4,13 +4,15 @@
  */
 #pragma once
 
-#include <map>
+#include <set>
+#include <vector>
 
-#include <Locker.h>
+#include <Path.h>
 #include <View.h>
 
 #include "ProjectFolder.h"
 #include "ProjectItem.h"
+#include "ProjectNodeTable.h"
 
 
 enum {
@@ -25,13 +27,9 @@ enum {
 	MSG_PROJECT_MENU_DO_RENAME_FILE		= 'pmdr',
 
 	MSG_BROWSER_SELECT_ITEM				= 'sele',
-	MSG_PROJECT_ADD_ITEMS_BATCH			= 'paib',
-	MSG_PROJECT_BATCH_SYNC				= 'pbsy'
+	MSG_PROJECT_FLUSH_NODE_EVENTS		= 'pfne'
 };
 
-// Batch size for adding items - tuned for performance vs responsiveness
-constexpr int32 kProjectItemBatchSize = 100;
-
 class ProjectOutlineListView;
 class GenioWatchingFilter;
 
@@ -48,7 +46,7 @@ public:
 	ProjectItem*	GetSelectedProjectItem() const;
 	const entry_ref* GetSelectedProjectFileRef() const;
 
-	ProjectItem*	GetItemByRef(const ProjectFolder* project, const entry_ref& ref) const;
+	ProjectItem*	GetItemByRef(const ProjectFolder* project, const entry_ref& ref);
 
 	ProjectItem*	GetProjectItemForProject(const ProjectFolder*) const;
 
@@ -70,35 +68,51 @@ public:
 	void			ExpandProjectCollapseOther(const BString& projectName);
 
 	void			InitRename(ProjectItem *item);
+
+	// node monitor messages received, and the ones left to apply to the
+	// tree once coalesced
+	uint64			CountNodeEventsReceived() const { return fNodeEventsReceived; }
+	uint64			CountNodeEventsApplied() const { return fNodeEventsApplied; }
 private:
+	friend class ProjectOutlineListView;
 
-	ProjectItem*	GetProjectItemByPath(const BString& path) const;
+	typedef ProjectNodeTable::NodeId NodeId;
 
-	ProjectItem*	_ProjectFolderScan(const entry_ref* ref, ProjectItem* parentItem, ProjectFolder *projectFolder = NULL);
+	ProjectItem*	GetProjectItemByPath(const BString& path);
+	ProjectFolder*	_ProjectForPath(const char* path) const;
+	bool			_IsLoaded(const ProjectFolder* project) const;
 
-	void			_ShowProjectItemPopupMenu(BPoint where);
+	// Reads the tree below directory into the node table of the project,
+	// with a pool of threads for the whole project. Returns the peak memory
+	// usage of the team seen while scanning.
+	struct ScanState;
 
-	ProjectItem*	_CreatePath(BPath pathToCreate);
-	void			_RemovePath(BString pathToRemove);
-	void			_HandleEntryMoved(BMessage* message);
-	void			_UpdateNode(BMessage *message);
+	size_t			_ProjectFolderScan(ProjectFolder* project, NodeId directory);
+	static status_t	_ScanThread(void* cookie);
+	static void		_ScanDirectory(NodeId directory, const node_ref& nodeRef,
+						ScanState& state);
 
-	status_t		_RenameCurrentSelectedFile(const BString& newName);
+	// The list items exist only for the children of the populated nodes
+	// of the table: the folders shown and the ones right below them.
+	ProjectItem*	_AddItem(ProjectFolder* project, NodeId node);
+	void			_PopulateNode(ProjectFolder* project, NodeId node);
+	void			_ExpandNode(ProjectFolder* project, NodeId node);
+	ProjectItem*	_MaterializeItem(ProjectFolder* project, NodeId node);
+	void			_ItemExpanded(ProjectItem* item);
 
-	ProjectItem*	_CreateNewProjectItem(ProjectItem* parentItem, BPath path);
+	void			_ShowProjectItemPopupMenu(BPoint where);
 
-	// Command pattern for batched item insertion
-	struct AddItemCommand {
-		ProjectItem* item;
-		ProjectItem* parent;  // nullptr for root items
-		bool shouldCollapse;
-	};
+	NodeId			_CreatePath(ProjectFolder* project, const BPath& path);
+	void			_RemoveNode(ProjectFolder* project, NodeId node);
+	void			_RemovePath(ProjectFolder* project, const BString& path);
+	void			_HandleEntryMoved(ProjectFolder* project, BMessage* message);
+	void			_QueueNodeEvent(BMessage* message);
+	void			_FlushNodeEvents();
+	void			_SortLater(ProjectFolder* project, NodeId node);
+	void			_UpdateSearchIndex(ProjectFolder* project, const BString& path);
+	void			_UpdateGitStatus(ProjectFolder* project, const std::set<BString>& paths);
 
-	// Batch processing helpers
-	void			_AddItemCommandToBatch(ProjectItem* item, ProjectItem* parent, ProjectFolder* project);
-	void			_FlushItemBatch(ProjectFolder* project, bool synchronous = false);
-	void			_FlushItemBatchLocked(ProjectFolder* project, bool synchronous);
-	void			_ProcessItemBatch(BMessage* message);
+	status_t		_RenameCurrentSelectedFile(const BString& newName);
 
 private:
 	ProjectOutlineListView*	fOutlineListView;
@@ -107,8 +121,11 @@ private:
 	ProjectFolderList	fProjectList;
 	ProjectItemList		fProjectProjectItemList;
 
-	// Batch processing state (protected by fBatchLock for thread safety)
-	// Each project has its own batch of commands to prevent mixing
-	BLocker					fBatchLock;
-	std::map<ProjectFolder*, std::vector<AddItemCommand>>	fItemBatches;
-};
+	// node monitor messages waiting for the next frame
+	std::vector<BMessage>	fNodeEvents;
+	bool					fNodeEventsFlushPending;
+	std::set<std::pair<ProjectFolder*, NodeId>>	fUnsortedNodes;
+	bool					fScrollToSelection;
+	uint64					fNodeEventsReceived;
+	uint64					fNodeEventsApplied;
+};
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include "QuickOpenWindow.h"
+
+#include <algorithm>
+
+#include <Catalog.h>
+#include <Entry.h>
+#include <GroupLayout.h>
+#include <LayoutBuilder.h>
+#include <ListView.h>
+#include <ScrollView.h>
+#include <TextControl.h>
+
+#include "PathIndex.h"
+#include "Utils.h"
+
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "QuickOpenWindow"
+
+
+static const int32 kMaxResults = 50;
+
+
+QuickOpenWindow::QuickOpenWindow(BWindow* owner)
+	:
+	BWindow(BRect(0, 0, 0, 0), B_TRANSLATE("Quick open"), B_MODAL_WINDOW_LOOK,
+		B_MODAL_SUBSET_WINDOW_FEEL,
+		B_NOT_RESIZABLE | B_NOT_MOVABLE | B_AUTO_UPDATE_SIZE_LIMITS),
+	fOwner(owner)
+{
+	fQuery = new BTextControl("QuickOpenTC", nullptr, "", new BMessage(QOW_OPEN));
+	fQuery->SetModificationMessage(new BMessage(QOW_QUERY_CHANGED));
+
+	fResults = new BListView("QuickOpenResults");
+	fResults->SetInvocationMessage(new BMessage(QOW_OPEN));
+	BScrollView* scrollView = new BScrollView("QuickOpenScroll", fResults, 0, false, true);
+	scrollView->SetExplicitMinSize(BSize(be_plain_font->StringWidth("M") * 50,
+		be_plain_font->Size() * 30));
+
+	AddCommonFilter(new KeyDownMessageFilter(QOW_CANCEL, B_ESCAPE));
+	AddCommonFilter(new KeyDownMessageFilter(QOW_SELECT_PREVIOUS, B_UP_ARROW));
+	AddCommonFilter(new KeyDownMessageFilter(QOW_SELECT_NEXT, B_DOWN_ARROW));
+
+	AddToSubset(fOwner);
+
+	BGroupLayout* layout = new BGroupLayout(B_VERTICAL, 5);
+	layout->SetInsets(5, 5, 5, 5);
+	SetLayout(layout);
+	layout->View()->SetViewColor(ui_color(B_PANEL_BACKGROUND_COLOR));
+	BLayoutBuilder::Group<>(layout)
+		.Add(fQuery)
+		.Add(scrollView);
+}
+
+
+void
+QuickOpenWindow::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case QOW_QUERY_CHANGED:
+			_Search();
+			break;
+		case QOW_SELECT_PREVIOUS:
+			_Select(fResults->CurrentSelection() - 1);
+			break;
+		case QOW_SELECT_NEXT:
+			_Select(fResults->CurrentSelection() + 1);
+			break;
+		case QOW_OPEN:
+			_Open();
+			break;
+		case QOW_CANCEL:
+			Hide();
+			break;
+		default:
+			BWindow::MessageReceived(message);
+			break;
+	}
+}
+
+
+// Called by the owner's thread: the window is locked while its state changes
+void
+QuickOpenWindow::ShowCentered(BRect ownerRect, const std::vector<Source>& sources)
+{
+	if (!LockLooper())
+		return;
+	fSources = sources;
+	// the projects may have changed since the last time
+	_Search();
+	CenterIn(ownerRect);
+	Show();
+	UnlockLooper();
+}
+
+
+void
+QuickOpenWindow::Hide()
+{
+	BWindow::Hide();
+	// the indexes of the projects closed meanwhile must not be kept alive
+	fSources.clear();
+	for (int32 i = 0; i < fResults->CountItems(); i++)
+		delete fResults->ItemAt(i);
+	fResults->MakeEmpty();
+	fPaths.clear();
+}
+
+
+void
+QuickOpenWindow::WindowActivated(bool active)
+{
+	fQuery->MakeFocus();
+	fQuery->TextView()->SelectAll();
+}
+
+
+void
+QuickOpenWindow::_Search()
+{
+	struct Result {
+		int32		score;
+		BString		label;
+		std::string	path;
+	};
+	std::vector<Result> results;
+
+	const BString query(fQuery->Text());
+	for (const Source& source : fSources) {
+		std::vector<PathIndex::Match> matches;
+		source.index->Search(query, kMaxResults, matches);
+		for (PathIndex::Match& match : matches) {
+			// "name — project/folder"
+			BString label(match.path.c_str() + match.nameStart);
+			label << " \xE2\x80\x94 " << source.name;
+			if (match.nameStart > source.path.Length() + 1) {
+				label << "/";
+				label.Append(match.path.c_str() + source.path.Length() + 1,
+					match.nameStart - source.path.Length() - 2);
+			}
+			results.push_back({ match.score, label, std::move(match.path) });
+		}
+	}
+	std::stable_sort(results.begin(), results.end(),
+		[](const Result& a, const Result& b) { return a.score > b.score; });
+	if (results.size() > (size_t)kMaxResults)
+		results.resize(kMaxResults);
+
+	for (int32 i = 0; i < fResults->CountItems(); i++)
+		delete fResults->ItemAt(i);
+	fResults->MakeEmpty();
+	fPaths.clear();
+	for (Result& result : results) {
+		fResults->AddItem(new BStringItem(result.label));
+		fPaths.push_back(std::move(result.path));
+	}
+	_Select(0);
+}
+
+
+void
+QuickOpenWindow::_Open()
+{
+	const int32 selection = fResults->CurrentSelection();
+	if (selection < 0 || selection >= (int32)fPaths.size())
+		return;
+
+	entry_ref ref;
+	if (get_ref_for_path(fPaths[selection].c_str(), &ref) != B_OK)
+		return;
+
+	BMessage refs(B_REFS_RECEIVED);
+	refs.AddRef("refs", &ref);
+	fOwner->PostMessage(&refs);
+	Hide();
+}
+
+
+void
+QuickOpenWindow::_Select(int32 index)
+{
+	if (index < 0 || index >= fResults->CountItems())
+		return;
+	fResults->Select(index);
+	fResults->ScrollToSelection();
+}
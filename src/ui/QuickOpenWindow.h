@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024, Andrea Anzani <andrea.anzani@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <String.h>
+#include <Window.h>
+
+class BListView;
+class BTextControl;
+class PathIndex;
+
+
+enum {
+	QOW_CANCEL				= 'qowc',
+	QOW_OPEN				= 'qowo',
+	QOW_QUERY_CHANGED		= 'qowq',
+	QOW_SELECT_PREVIOUS		= 'qowp',
+	QOW_SELECT_NEXT			= 'qown'
+};
+
+
+// Fuzzy finder over the files of the open projects: the selected file is
+// sent to the owner as B_REFS_RECEIVED.
+class QuickOpenWindow : public BWindow {
+public:
+	struct Source {
+		BString						name;	// of the project
+		BString						path;
+		std::shared_ptr<PathIndex>	index;
+	};
+
+							QuickOpenWindow(BWindow* owner);
+
+			void			MessageReceived(BMessage* message);
+			void			ShowCentered(BRect ownerRect, const std::vector<Source>& sources);
+			void			Hide();
+			void			WindowActivated(bool active);
+
+private:
+			void			_Search();
+			void			_Open();
+			void			_Select(int32 index);
+
+			BTextControl*	fQuery;
+			BListView*		fResults;
+			std::vector<std::string>	fPaths;	// of the items in fResults
+			std::vector<Source>			fSources;
+
+			BWindow*		fOwner;
+};
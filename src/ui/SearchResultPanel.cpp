@@ -11,7 +11,6 @@
 #include <Window.h>
 #include <string>
 
-#include "ActionManager.h"
 #include "GenioWindowMessages.h"
 
 #undef B_TRANSLATION_CONTEXT
@@ -70,7 +69,8 @@ public:
 SearchResultPanel::SearchResultPanel(PanelTabManager* panelTabManager, tab_id id)
 	:
 	BColumnListView(SearchResultPanelLabel, B_NAVIGABLE, B_FANCY_BORDER, true),
-	fGrepThread(nullptr),
+	fEngine(nullptr),
+	fSearchId(0),
 	fPanelTabManager(panelTabManager),
 	fCountResults(0),
 	fTabId(id)
@@ -80,6 +80,12 @@ SearchResultPanel::SearchResultPanel(PanelTabManager* panelTabManager, tab_id id
 }
 
 
+SearchResultPanel::~SearchResultPanel()
+{
+	_StopSearch();
+}
+
+
 void
 SearchResultPanel::SetTabLabel(BString label)
 {
@@ -91,25 +97,31 @@ SearchResultPanel::SetTabLabel(BString label)
 
 
 void
-SearchResultPanel::StartSearch(BString command, BString projectPath)
+SearchResultPanel::StartSearch(const FindInFilesEngine::Options& options)
 {
-	if (fGrepThread)
-		return;
+	// a new search supersedes the running one
+	_StopSearch();
 
 	fCountResults = 0;
-	fProjectPath = projectPath;
+	fProjectPath = options.rootPath;
 	if (!fProjectPath.EndsWith("/"))
 		fProjectPath.Append("/");
 	ClearSearch();
 
-	BMessage message;
-	message.AddString("cmd", command);
+	_UpdateTabLabel("\xe2\x8c\x9b");//U+231x
+	fEngine = new FindInFilesEngine(options, BMessenger(this), ++fSearchId);
+	if (fEngine->Start() != B_OK) {
+		_StopSearch();
+		_UpdateTabLabel();
+	}
+}
 
-	ActionManager::SetEnabled(MSG_FIND_IN_FILES, false);
 
-	_UpdateTabLabel("\xe2\x8c\x9b");//U+231x
-	fGrepThread = new GrepThread(&message, BMessenger(this));
-	fGrepThread->Start();
+void
+SearchResultPanel::_StopSearch()
+{
+	delete fEngine;
+	fEngine = nullptr;
 }
 
 
@@ -128,7 +140,9 @@ SearchResultPanel::MessageReceived(BMessage* msg)
 {
 	switch (msg->what) {
 		case MSG_REPORT_RESULT:
-			UpdateSearch(msg);
+			// results of a superseded search may still be queued
+			if (msg->GetInt32("search_id", -1) == fSearchId)
+				UpdateSearch(msg);
 			break;
 		case SEARCHRESULT_CLICK:
 		{
@@ -143,13 +157,10 @@ SearchResultPanel::MessageReceived(BMessage* msg)
 		}
 		case MSG_GREP_DONE:
 		{
-			if (fGrepThread) {
-				fGrepThread->InterruptExternal();
-				delete fGrepThread;
-				fGrepThread = nullptr;
-			}
+			if (msg->GetInt32("search_id", -1) != fSearchId)
+				break;
+			_StopSearch();
 			_UpdateTabLabel(std::to_string(fCountResults).c_str());
-			ActionManager::SetEnabled(MSG_FIND_IN_FILES, true);
 			break;
 		}
 		default:
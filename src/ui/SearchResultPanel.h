@@ -7,7 +7,7 @@
 
 #include <ColumnListView.h>
 #include <SupportDefs.h>
-#include "GrepThread.h"
+#include "FindInFilesEngine.h"
 #include "PanelTabManager.h"
 
 // For now this is specific to manage only the FindInFiles results
@@ -17,7 +17,9 @@ class SearchResultPanel : public BColumnListView {
 public:
 		SearchResultPanel(PanelTabManager*, tab_id id);
 
-		void StartSearch(BString command, BString projectPath);
+		~SearchResultPanel();
+
+		void StartSearch(const FindInFilesEngine::Options& options);
 
 		virtual void	MessageReceived(BMessage* msg);
 		virtual void	AttachedToWindow();
@@ -29,7 +31,9 @@ private:
 		void	_UpdateTabLabel(const char* txt = nullptr);
 		void	ClearSearch();
 		void 	UpdateSearch(BMessage* msg);
-		GrepThread*	fGrepThread;
+		void	_StopSearch();
+		FindInFilesEngine*	fEngine;
+		int32		fSearchId;
 		BString 	fProjectPath;
 		PanelTabManager*	fPanelTabManager;
 		int32		fCountResults;
@@ -14,9 +14,10 @@
 #include "ConfigManager.h"
 #include "GenioWindow.h"
 #include "GenioWindowMessages.h"
+#include "ProjectBrowser.h"
+#include "ProjectFolder.h"
 #include "ProjectMenuField.h"
 #include "SearchResultPanel.h"
-#include "TextUtils.h"
 #include "ToolBar.h"
 
 
@@ -147,31 +148,17 @@ SearchResultTab::_StartSearch(BString text, bool wholeWord,
 	if (text.IsEmpty())
 		return;
 
-	BString extraParameters;
-	if (wholeWord)
-		extraParameters += "w";
-
-	if (!caseSensitive)
-		extraParameters += "i";
-
-	text.CharacterEscape("\\\n\"", '\\');
-
-	BString grepCommand("grep");
-	BString excludeDir(gCFG["find_exclude_directory"]);
-	if (!excludeDir.IsEmpty()) {
-		if (excludeDir.FindFirst(",") >= 0)
-			grepCommand << " --exclude-dir={" << excludeDir << "}";
-		else
-			grepCommand << " --exclude-dir=" << excludeDir << "";
-	}
-
-	grepCommand += " -IFHrn";
-	grepCommand += extraParameters;
-	grepCommand += " -- ";
-	grepCommand += EscapeQuotesWrap(text);
-	grepCommand += " ";
-	grepCommand += EscapeQuotesWrap(projectPath);
-
-	LogInfo("Find in file, executing: [%s]", grepCommand.String());
-	fSearchResultPanel->StartSearch(grepCommand, projectPath);
+	FindInFilesEngine::Options options;
+	options.text = text;
+	options.rootPath = projectPath;
+	options.excludeDirectories = BString(gCFG["find_exclude_directory"]);
+	options.wholeWord = wholeWord;
+	options.caseSensitive = caseSensitive;
+	options.useGitIgnore = gCFG["find_use_gitignore"];
+	ProjectFolder* project = gMainWindow->GetProjectBrowser()->ProjectByPath(projectPath);
+	if (project != nullptr)
+		options.index = project->SearchIndex();
+
+	LogInfo("Find in files: [%s] in [%s]", text.String(), projectPath.String());
+	fSearchResultPanel->StartSearch(options);
 }
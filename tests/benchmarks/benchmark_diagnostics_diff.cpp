@@ -0,0 +1,254 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Republishes diagnostics on a 20000 lines document and reports the time
+// of the indicator update done by DiffDiagnostics(), against clearing all
+// the indicators and filling them again as before, with the count of
+// repaints each one causes. The indicators are kept by Scintilla's own
+// DecorationList, filled as SCI_INDICATORFILLRANGE does.
+// After every update the indicators are checked to be those of a full
+// refill. The republishes are those of a server while typing: the same
+// diagnostics, one fixed, one added, some replaced and overlapping ones.
+// Runs on any POSIX system, with the Haiku types stubbed. From this folder:
+//   g++ -std=c++17 -O2 -DNDEBUG -Istubs -I../../src/helpers
+//     -I../../src/lsp-client -I../../libs/json -I../../libs/scintilla/include
+//     -I../../libs/scintilla/src benchmark_diagnostics_diff.cpp
+//     ../../src/lsp-client/LSPDiagnostic.cpp ../../libs/scintilla/src/Decoration.cxx
+//     ../../libs/scintilla/src/RunStyles.cxx stubs/HaikuStubs.cpp -lpthread
+//     -o benchmark_diagnostics_diff
+// Usage: benchmark_diagnostics_diff [diagnostics]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <OS.h>
+
+#include "ScintillaTypes.h"
+#include "Debugging.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "Decoration.h"
+
+#include "LSPDiagnostic.h"
+
+using namespace Scintilla::Internal;
+
+
+static const int32 kLines = 20000;
+static const int32 kLineLength = 40;
+static const int32 kDocumentLength = kLines * kLineLength;
+static const int32 kDefaultDiagnosticCount = 2000;
+static const int32 kRuns = 20;
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+static LSPDiagnostic
+MakeDiagnostic(uint32& seed, int32 line)
+{
+	LSPDiagnostic diagnostic;
+	diagnostic.range.from = line * kLineLength + Random(seed) % (kLineLength / 2);
+	diagnostic.range.to = diagnostic.range.from + 1 + Random(seed) % (kLineLength / 2);
+	diagnostic.range.info = "unused variable 'index" + std::to_string(Random(seed) % 1000)
+		+ "' [-Wunused-variable]";
+	return diagnostic;
+}
+
+
+// The indicators of a document, in Scintilla's own DecorationList as the
+// SCI_INDICATOR* messages fill them. Each fill changing a value notifies
+// the views, which repaint the range.
+class Indicators {
+public:
+	Indicators()
+		:
+		fDecorations(DecorationListCreate(false)),
+		fNotifications(0)
+	{
+		fDecorations->InsertSpace(0, kDocumentLength);
+		fDecorations->SetCurrentIndicator(kIndicator);
+		fDecorations->SetCurrentValue(1);
+	}
+
+	void Fill(const InfoRange& range)
+	{
+		_Fill(range.from, 1, range.to - range.from);
+	}
+
+	void Clear(const InfoRange& range)
+	{
+		_Fill(range.from, 0, range.to - range.from);
+	}
+
+	void ClearAll()
+	{
+		_Fill(0, 0, kDocumentLength);
+	}
+
+	// the same runs of values
+	bool operator==(const Indicators& other) const
+	{
+		Sci::Position position = 0;
+		while (position < kDocumentLength) {
+			if (fDecorations->ValueAt(kIndicator, position)
+					!= other.fDecorations->ValueAt(kIndicator, position)
+				|| fDecorations->End(kIndicator, position)
+					!= other.fDecorations->End(kIndicator, position)) {
+				return false;
+			}
+			const Sci::Position end = fDecorations->End(kIndicator, position);
+			position = end > position ? end : kDocumentLength;
+		}
+		return true;
+	}
+
+	int32 Notifications() const { return fNotifications; }
+
+private:
+	static const int kIndicator = 8;
+
+	void _Fill(Sci::Position position, int value, Sci::Position length)
+	{
+		if (fDecorations->FillRange(position, value, length).changed)
+			fNotifications++;
+	}
+
+	std::unique_ptr<IDecorationList>	fDecorations;
+	int32								fNotifications;
+};
+
+
+// _FillDiagnosticIndicators()
+static void
+Refill(Indicators& indicators, const std::vector<LSPDiagnostic>& diagnostics)
+{
+	indicators.ClearAll();
+	for (const LSPDiagnostic& d : diagnostics)
+		indicators.Fill(d.range);
+}
+
+
+// _UpdateDiagnosticIndicators()
+static bool
+Update(Indicators& indicators, const std::vector<LSPDiagnostic>& previous,
+	const std::vector<LSPDiagnostic>& current)
+{
+	if (current.empty()) {
+		if (previous.empty())
+			return false;
+		indicators.ClearAll();
+		return true;
+	}
+
+	std::vector<const InfoRange*> removed;
+	std::vector<const InfoRange*> added;
+	if (!DiffDiagnostics(previous, current, removed, added))
+		return false;
+	for (const InfoRange* r : removed)
+		indicators.Clear(*r);
+	for (const InfoRange* r : added)
+		indicators.Fill(*r);
+	return true;
+}
+
+
+static bool
+Run(const char* name, const std::vector<LSPDiagnostic>& previous,
+	const std::vector<LSPDiagnostic>& current, bool expectChanged)
+{
+	std::vector<bigtime_t> updateTimes;
+	std::vector<bigtime_t> refillTimes;
+	bool passed = true;
+	int32 updateNotifications = 0;
+	int32 refillNotifications = 0;
+	for (int32 run = 0; run < kRuns; run++) {
+		Indicators updated;
+		Refill(updated, previous);
+		int32 notifications = updated.Notifications();
+		bigtime_t start = system_time();
+		const bool changed = Update(updated, previous, current);
+		updateTimes.push_back(system_time() - start);
+		updateNotifications = updated.Notifications() - notifications;
+
+		Indicators refilled;
+		Refill(refilled, previous);
+		notifications = refilled.Notifications();
+		start = system_time();
+		Refill(refilled, current);
+		refillTimes.push_back(system_time() - start);
+		refillNotifications = refilled.Notifications() - notifications;
+
+		passed = passed && changed == expectChanged && updated == refilled;
+	}
+	std::sort(updateTimes.begin(), updateTimes.end());
+	std::sort(refillTimes.begin(), refillTimes.end());
+	printf("  %-18s %9.1f us %6d repaints  %9.1f us %6d repaints%s\n", name,
+		(double)updateTimes[kRuns / 2], (int)updateNotifications,
+		(double)refillTimes[kRuns / 2], (int)refillNotifications,
+		passed ? "" : "  WRONG INDICATORS");
+	return passed;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 count = argc > 1 ? atoi(argv[1]) : kDefaultDiagnosticCount;
+
+	uint32 seed = 42;
+	std::vector<LSPDiagnostic> diagnostics;
+	for (int32 i = 0; i < count; i++)
+		diagnostics.push_back(MakeDiagnostic(seed, Random(seed) % kLines));
+
+	std::vector<LSPDiagnostic> fixed(diagnostics);
+	fixed.erase(fixed.begin() + count / 2);
+
+	std::vector<LSPDiagnostic> added(diagnostics);
+	added.insert(added.begin() + count / 3, MakeDiagnostic(seed, Random(seed) % kLines));
+
+	std::vector<LSPDiagnostic> replaced(diagnostics);
+	for (int32 i = 0; i < count / 10; i++)
+		replaced[Random(seed) % count] = MakeDiagnostic(seed, Random(seed) % kLines);
+
+	// the fixed diagnostic overlaps others which stay
+	std::vector<LSPDiagnostic> overlapping(diagnostics);
+	for (int32 i = 0; i < 3; i++) {
+		LSPDiagnostic d = diagnostics[i];
+		d.range.info = "expected ';' after expression";
+		d.range.to += 3;
+		overlapping.push_back(d);
+	}
+	std::vector<LSPDiagnostic> overlapFixed(overlapping);
+	overlapFixed.pop_back();
+
+	printf("  %d diagnostics on %d lines\n", (int)count, (int)kLines);
+	printf("  %-18s %25s  %25s\n", "republish", "diff", "clear and refill");
+	bool passed = Run("same", diagnostics, diagnostics, false);
+	passed = Run("one fixed", diagnostics, fixed, true) && passed;
+	passed = Run("one added", diagnostics, added, true) && passed;
+	passed = Run("10% replaced", diagnostics, replaced, true) && passed;
+	passed = Run("overlapping fixed", overlapping, overlapFixed, true) && passed;
+	passed = Run("all fixed", diagnostics, std::vector<LSPDiagnostic>(), true) && passed;
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
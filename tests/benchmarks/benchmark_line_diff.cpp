@@ -0,0 +1,331 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Edits a generated 20000 lines source file as the editor does, line
+// ranges replaced by Replace() and diffed by Update(), and reports the
+// time of a keystroke diff against diffing the whole file with SetLines().
+// After every Update() the hunks are checked to turn the base into the
+// text, and against SetLines() on the same text. With repeated lines, as
+// braces and blank lines are, both can pick different lines for as many
+// edits: how often is only reported. Update() keeps the lines around the
+// edits as they were, so after many edits it can miss a few lines shorter
+// diff found by SetLines(): up to kMaxExcess more changed lines pass.
+// The random edits are typed characters, new lines, joined lines, pasted
+// and deleted blocks and lines reverted to the base.
+// Runs on any POSIX system, with the Haiku types stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers -I../../src/git
+//     benchmark_line_diff.cpp ../../src/git/LineDiff.cpp stubs/HaikuStubs.cpp
+//     -lpthread -o benchmark_line_diff
+// Usage: benchmark_line_diff [lines] [edits]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <OS.h>
+
+#include "LineDiff.h"
+
+
+using Genio::Git::DiffHunk;
+using Genio::Git::LineDiff;
+
+
+static const int32 kDefaultLineCount = 20000;
+static const int32 kDefaultEditCount = 5000;
+static const double kMaxExcess = 0.01;
+static const int32 kKeystrokes = 2000;
+// SetLines() is timed every this many keystrokes
+static const int32 kFullDiffInterval = 100;
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+// Source-like lines: many are repeated, as braces and blank lines are
+static std::string
+MakeLine(uint32& seed)
+{
+	static const char* kLines[] = { "", "}", "{", "\treturn B_OK;", "\tbreak;",
+		"\t\tbreak;", "\t}", "\t{", "\t\tfItems.push_back(item);" };
+	const uint32 kind = Random(seed) % 20;
+	if (kind < 9)
+		return kLines[kind];
+	std::string line(Random(seed) % 4, '\t');
+	line += "status_t result = fTarget" + std::to_string(Random(seed) % 5000)
+		+ "->SendMessage(&message);";
+	return line;
+}
+
+
+static uint32
+Hash(const std::string& line)
+{
+	return LineDiff::HashLine(line.c_str(), line.length());
+}
+
+
+static std::vector<uint32>
+Hashes(const std::vector<std::string>& lines)
+{
+	std::vector<uint32> hashes;
+	for (const std::string& line : lines)
+		hashes.push_back(Hash(line));
+	return hashes;
+}
+
+
+// The lines [line, line + removed) replaced by added, as the editor reports
+// an edit: the line it starts on always counts as removed and added
+static void
+Edit(std::vector<std::string>& text, LineDiff& diff, int32 line, int32 removed,
+	const std::vector<std::string>& added)
+{
+	text.erase(text.begin() + line, text.begin() + line + removed);
+	text.insert(text.begin() + line, added.begin(), added.end());
+	diff.Replace(line, removed, Hashes(added));
+}
+
+
+static void
+RandomEdit(uint32& seed, std::vector<std::string>& text, LineDiff& diff,
+	const std::vector<std::string>& base)
+{
+	const int32 count = text.size();
+	const int32 line = Random(seed) % count;
+	std::vector<std::string> added(1, text[line]);
+	int32 removed = 1;
+	switch (Random(seed) % 10) {
+		case 0:
+		case 1:
+		case 2:
+		case 3:
+			// a typed character
+			added[0].insert(Random(seed) % (added[0].length() + 1), 1, 'a' + Random(seed) % 26);
+			break;
+		case 4:
+		{
+			// a new line
+			const size_t split = Random(seed) % (added[0].length() + 1);
+			added.push_back(added[0].substr(split));
+			added[0].resize(split);
+			break;
+		}
+		case 5:
+			// joined with the next line
+			if (line + 1 < count) {
+				added[0] += text[line + 1];
+				removed = 2;
+			}
+			break;
+		case 6:
+		{
+			// a pasted block
+			const int32 lines = 1 + Random(seed) % 30;
+			for (int32 i = 0; i < lines; i++)
+				added.push_back(MakeLine(seed));
+			break;
+		}
+		case 7:
+			// a deleted block
+			removed = std::min(1 + (int32)(Random(seed) % 30), count - line);
+			break;
+		default:
+			// reverted: the line of the base at the same place
+			if (line < (int32)base.size())
+				added[0] = base[line];
+			break;
+	}
+	Edit(text, diff, line, removed, added);
+}
+
+
+// The hunks turn the base into the text, sorted and apart from each other
+static bool
+Applies(const std::vector<DiffHunk>& hunks, const std::vector<uint32>& base,
+	const std::vector<uint32>& text)
+{
+	std::vector<uint32> result;
+	int32 oldLine = 0;
+	for (const DiffHunk& hunk : hunks) {
+		if ((&hunk != &hunks.front() && hunk.oldStart <= oldLine)
+			|| hunk.newStart != (int32)result.size() + hunk.oldStart - oldLine)
+			return false;
+		result.insert(result.end(), base.begin() + oldLine, base.begin() + hunk.oldStart);
+		result.insert(result.end(), text.begin() + hunk.newStart,
+			text.begin() + hunk.newStart + hunk.newCount);
+		oldLine = hunk.oldStart + hunk.oldCount;
+	}
+	result.insert(result.end(), base.begin() + oldLine, base.end());
+	return result == text;
+}
+
+
+static int32
+ChangedLines(const std::vector<DiffHunk>& hunks)
+{
+	int32 count = 0;
+	for (const DiffHunk& hunk : hunks)
+		count += hunk.oldCount + hunk.newCount;
+	return count;
+}
+
+
+static bool
+SameHunks(const std::vector<DiffHunk>& a, const std::vector<DiffHunk>& b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+		[](const DiffHunk& x, const DiffHunk& y) {
+			return x.oldStart == y.oldStart && x.oldCount == y.oldCount
+				&& x.newStart == y.newStart && x.newCount == y.newCount;
+		});
+}
+
+
+static bigtime_t
+Median(std::vector<bigtime_t>& times)
+{
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+
+// keystrokes take less than the microsecond system_time() counts
+static double
+Mean(const std::vector<bigtime_t>& times)
+{
+	bigtime_t total = 0;
+	for (bigtime_t time : times)
+		total += time;
+	return (double)total / times.size();
+}
+
+
+// Random edits, a few at a time as the editor batches them, each batch
+// checked against a full diff
+static bool
+RunEdits(const std::vector<std::string>& base, int32 editCount)
+{
+	const std::vector<uint32> baseHashes = Hashes(base);
+	std::vector<std::string> text(base);
+	LineDiff diff{std::vector<uint32>(baseHashes)};
+	diff.SetLines(Hashes(text));
+
+	uint32 seed = 7;
+	int32 applied = 0;
+	int32 longer = 0;
+	double excess = 0;
+	int32 different = 0;
+	int32 batches = 0;
+	for (int32 edit = 0; edit < editCount; batches++) {
+		const int32 batch = 1 + Random(seed) % 4;
+		for (int32 i = 0; i < batch && edit < editCount; i++, edit++)
+			RandomEdit(seed, text, diff, base);
+		int32 first;
+		int32 last;
+		diff.Update(first, last);
+
+		const std::vector<uint32> hashes = Hashes(text);
+		applied += Applies(diff.Hunks(), baseHashes, hashes);
+		LineDiff full{std::vector<uint32>(baseHashes)};
+		full.SetLines(std::vector<uint32>(hashes));
+		const int32 changed = ChangedLines(diff.Hunks());
+		const int32 fullChanged = ChangedLines(full.Hunks());
+		if (changed > fullChanged) {
+			longer++;
+			excess = std::max(excess, (double)(changed - fullChanged) / fullChanged);
+		}
+		different += !SameHunks(diff.Hunks(), full.Hunks());
+	}
+
+	const bool passed = applied == batches && excess <= kMaxExcess;
+	printf("  %d edits in %d batches, %d hunks at the end\n", (int)editCount,
+		(int)batches, (int)diff.Hunks().size());
+	printf("  batches not turning the base into the text: %d\n", (int)(batches - applied));
+	printf("  batches changing more lines than SetLines(): %d, by %.2f%% at most\n",
+		(int)longer, excess * 100);
+	printf("  batches changing other lines than SetLines(): %d\n", (int)different);
+	return passed;
+}
+
+
+// Typing in the middle of the file, after the given count of random edits
+static bool
+RunKeystrokes(const std::vector<std::string>& base, int32 editCount)
+{
+	std::vector<std::string> text(base);
+	LineDiff diff{Hashes(base)};
+	diff.SetLines(Hashes(text));
+	uint32 seed = 11;
+	for (int32 i = 0; i < editCount; i++)
+		RandomEdit(seed, text, diff, base);
+
+	bigtime_t start = system_time();
+	diff.SetLines(Hashes(text));
+	const bigtime_t setLines = system_time() - start;
+	const size_t hunks = diff.Hunks().size();
+
+	std::vector<bigtime_t> replaceTimes;
+	std::vector<bigtime_t> updateTimes;
+	std::vector<bigtime_t> fullTimes;
+	const int32 line = text.size() / 2;
+	for (int32 i = 0; i < kKeystrokes; i++) {
+		text[line].push_back('a' + i % 26);
+		const std::vector<uint32> added(1, Hash(text[line]));
+		start = system_time();
+		diff.Replace(line, 1, added);
+		replaceTimes.push_back(system_time() - start);
+
+		int32 first;
+		int32 last;
+		start = system_time();
+		diff.Update(first, last);
+		updateTimes.push_back(system_time() - start);
+
+		if (i % kFullDiffInterval == 0) {
+			LineDiff full{Hashes(base)};
+			std::vector<uint32> hashes = Hashes(text);
+			start = system_time();
+			full.SetLines(std::move(hashes));
+			fullTimes.push_back(system_time() - start);
+		}
+	}
+
+	printf("  %zu lines, %zu hunks: SetLines() %.2f ms\n", text.size(), hunks,
+		setLines / 1000.0);
+	printf("  keystroke on line %d: Replace() mean %.2f us, Update() mean %.2f us, "
+		"max %d us; SetLines() median %.2f ms\n", (int)line, Mean(replaceTimes),
+		Mean(updateTimes), (int)*std::max_element(updateTimes.begin(), updateTimes.end()),
+		Median(fullTimes) / 1000.0);
+	return Applies(diff.Hunks(), Hashes(base), Hashes(text));
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 lineCount = argc > 1 ? atoi(argv[1]) : kDefaultLineCount;
+	const int32 editCount = argc > 2 ? atoi(argv[2]) : kDefaultEditCount;
+
+	uint32 seed = 42;
+	std::vector<std::string> base;
+	for (int32 i = 0; i < lineCount; i++)
+		base.push_back(MakeLine(seed));
+
+	bool passed = RunEdits(base, editCount);
+	passed = RunKeystrokes(base, 0) && passed;
+	passed = RunKeystrokes(base, 200) && passed;
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
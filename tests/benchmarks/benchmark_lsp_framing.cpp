@@ -0,0 +1,308 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Replays a recorded-like stream of LSP messages through LSPPipeClient and
+// reports the time to split it into messages. The same stream is read with
+// the framing used before, one read() per header byte, for comparison.
+// Every body read is checked against the one written.
+// The stream mixes, as a C++ server sends them while typing, small
+// notifications, diagnostics, hovers and a large completion list every
+// 100 messages. It's written, always the same, in /tmp/genio_lsp_replay:
+// 5000 messages by default, or the given count. Both readers get it from a
+// cat child, through a pipe.
+// Runs on any POSIX system, with the Haiku calls stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers -I../../src/lsp-client
+//     -I../../libs/json benchmark_lsp_framing.cpp
+//     ../../src/lsp-client/LSPPipeClient.cpp ../../src/lsp-client/LSPReaderThread.cpp
+//     ../../src/lsp-client/Transport.cpp ../../src/lsp-client/LSPMessage.cpp
+//     ../../src/helpers/PipeImage.cpp stubs/HaikuStubs.cpp -lpthread
+//     -o benchmark_lsp_framing
+// Usage: benchmark_lsp_framing [message count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <Messenger.h>
+#include <OS.h>
+
+#include "LSPPipeClient.h"
+#include "Logger.h"
+
+
+static const char* kReplayPath = "/tmp/genio_lsp_replay";
+static const int32 kDefaultMessageCount = 5000;
+static const int32 kRuns = 5;
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+static std::string
+Words(uint32& seed, size_t length)
+{
+	static const char* kWords[] = { "BString", "status_t", "const", "int32",
+		"message", "result", "std::vector", "nullptr", "Lock", "fItems" };
+	std::string text;
+	while (text.length() < length) {
+		text += kWords[Random(seed) % 10];
+		text += ' ';
+	}
+	return text;
+}
+
+
+static std::string
+Diagnostic(uint32& seed, int32 line)
+{
+	char range[128];
+	snprintf(range, sizeof(range), "{\"range\":{\"start\":{\"line\":%d,\"character\":4},"
+		"\"end\":{\"line\":%d,\"character\":12}},\"severity\":1,", (int)line, (int)line);
+	return std::string(range) + "\"source\":\"clang\",\"message\":\""
+		+ Words(seed, 60 + Random(seed) % 120) + "\"}";
+}
+
+
+// The body of the message i, always the same
+static std::string
+Body(int32 i, uint32& seed)
+{
+	char id[64];
+	std::string body;
+	if (i % 100 == 99) {
+		snprintf(id, sizeof(id), "%d:textDocument/completion", (int)i);
+		body = std::string("{\"jsonrpc\":\"2.0\",\"id\":\"") + id
+			+ "\",\"result\":{\"isIncomplete\":false,\"items\":[";
+		for (int32 item = 0; item < 5000; item++) {
+			char text[256];
+			snprintf(text, sizeof(text), "%s{\"label\":\"Item%d\",\"kind\":3,"
+				"\"detail\":\"status_t (int32 index)\",\"sortText\":\"%08d\","
+				"\"insertText\":\"Item%d\",\"insertTextFormat\":2}",
+				item == 0 ? "" : ",", (int)item, (int)item, (int)item);
+			body += text;
+		}
+		body += "]}}";
+	} else if (i % 10 == 0) {
+		body = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+			"\"params\":{\"uri\":\"file:///boot/home/project/src/Editor.cpp\","
+			"\"diagnostics\":[";
+		const int32 count = 5 + Random(seed) % 30;
+		for (int32 diagnostic = 0; diagnostic < count; diagnostic++) {
+			if (diagnostic > 0)
+				body += ",";
+			body += Diagnostic(seed, diagnostic * 7);
+		}
+		body += "]}}";
+	} else if (i % 10 == 5) {
+		snprintf(id, sizeof(id), "%d:textDocument/hover", (int)i);
+		body = std::string("{\"jsonrpc\":\"2.0\",\"id\":\"") + id
+			+ "\",\"result\":{\"contents\":{\"kind\":\"markdown\",\"value\":\""
+			+ Words(seed, 2000 + Random(seed) % 20000) + "\"}}}";
+	} else {
+		snprintf(id, sizeof(id), "%d", (int)i);
+		body = std::string("{\"jsonrpc\":\"2.0\",\"method\":\"$/progress\",\"params\":"
+			"{\"token\":") + id + ",\"value\":{\"kind\":\"report\",\"message\":\""
+			+ Words(seed, 40 + Random(seed) % 200) + "\"}}}";
+	}
+	return body;
+}
+
+
+static void
+GenerateReplay(int32 messageCount, std::vector<std::string>& bodies, size_t& size)
+{
+	uint32 seed = 42;
+	for (int32 i = 0; i < messageCount; i++)
+		bodies.push_back(Body(i, seed));
+
+	std::string marker(kReplayPath);
+	marker += ".complete";
+	std::ifstream complete(marker);
+	int32 existing = 0;
+	std::ofstream stream;
+	if (!(complete >> existing && existing == messageCount)) {
+		printf("Writing %d messages in %s\n", (int)messageCount, kReplayPath);
+		stream.open(kReplayPath, std::ios::binary | std::ios::trunc);
+	}
+
+	size = 0;
+	for (int32 i = 0; i < messageCount; i++) {
+		char header[128];
+		// some servers send the optional Content-Type too
+		const int length = snprintf(header, sizeof(header),
+			i % 7 == 0 ? "Content-Length: %zu\r\nContent-Type: "
+				"application/vscode-jsonrpc; charset=utf-8\r\n\r\n"
+				: "Content-Length: %zu\r\n\r\n", bodies[i].length());
+		size += length + bodies[i].length();
+		if (stream.is_open())
+			stream.write(header, length) << bodies[i];
+	}
+	if (stream.is_open()) {
+		stream.close();
+		std::ofstream(marker) << messageCount;
+	}
+}
+
+
+// The framing before the buffered reader: headers one byte per read()
+class ByteReader {
+public:
+	ByteReader(int fd) : fFD(fd) {}
+
+	bool ReadMessage(std::string& body)
+	{
+		char line[255];
+		int32 length = 0;
+		while (_ReadLine(line, sizeof(line))) {
+			if (strncmp(line, "Content-Length: ", 16) == 0)
+				length = strtol(line + 16, nullptr, 10);
+			else if (strncmp(line, "\r\n", 2) == 0)
+				break;
+		}
+		if (length == 0)
+			return false;
+		body.resize(length);
+		int32 read = 0;
+		while (read < length) {
+			const ssize_t hasRead = ::read(fFD, &body[read], length - read);
+			if (hasRead <= 0)
+				return false;
+			read += hasRead;
+		}
+		return true;
+	}
+
+private:
+	bool _ReadLine(char* line, size_t size)
+	{
+		size_t length = 0;
+		while (::read(fFD, &line[length], 1) == 1) {
+			if (length >= size - 1)
+				return false;
+			if (line[length] == '\n') {
+				line[length + 1] = '\0';
+				return true;
+			}
+			length++;
+		}
+		return false;
+	}
+
+	int		fFD;
+};
+
+
+static bool
+Check(const std::string& body, const std::vector<std::string>& bodies, int32 index)
+{
+	return index < (int32)bodies.size() && body == bodies[index];
+}
+
+
+static bigtime_t
+RunClient(const std::vector<std::string>& bodies, bool& passed)
+{
+	BMessenger messenger;
+	LSPPipeClient client('lspm', messenger);
+	const char* argv[] = { "cat", kReplayPath, nullptr };
+	if (client.Start(argv, 2) != B_OK) {
+		passed = false;
+		return 0;
+	}
+
+	const bigtime_t start = system_time();
+	std::string body;
+	int32 count = 0;
+	while (client.readMessage(body))
+		passed = Check(body, bodies, count++) && passed;
+	const bigtime_t elapsed = system_time() - start;
+	passed = passed && count == (int32)bodies.size();
+	waitpid(client.GetChildPid(), nullptr, 0);
+	return elapsed;
+}
+
+
+static bigtime_t
+RunByteReader(const std::vector<std::string>& bodies, bool& passed)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		passed = false;
+		return 0;
+	}
+	const pid_t child = fork();
+	if (child == 0) {
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		execlp("cat", "cat", kReplayPath, (char*)nullptr);
+		_exit(1);
+	}
+	close(fds[1]);
+
+	const bigtime_t start = system_time();
+	ByteReader reader(fds[0]);
+	std::string body;
+	int32 count = 0;
+	while (reader.ReadMessage(body))
+		passed = Check(body, bodies, count++) && passed;
+	const bigtime_t elapsed = system_time() - start;
+	passed = passed && count == (int32)bodies.size();
+	close(fds[0]);
+	waitpid(child, nullptr, 0);
+	return elapsed;
+}
+
+
+static void
+Report(const char* what, std::vector<bigtime_t>& times, size_t size, int32 count)
+{
+	std::sort(times.begin(), times.end());
+	const bigtime_t median = std::max(times[times.size() / 2], (bigtime_t)1);
+	printf("  %-24s median %8.2f ms  %8.1f MiB/s  %6.2f us/message\n", what,
+		median / 1000.0, size / 1048576.0 / (median / 1000000.0),
+		(double)median / count);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 messageCount = argc > 1 ? atoi(argv[1]) : kDefaultMessageCount;
+	Logger::SetLevel(LOG_LEVEL_ERROR);
+
+	std::vector<std::string> bodies;
+	size_t size;
+	GenerateReplay(messageCount, bodies, size);
+	printf("%s\n  %d messages, %.1f MiB\n", kReplayPath, (int)messageCount,
+		size / 1048576.0);
+
+	bool clientPassed = true;
+	bool bytePassed = true;
+	std::vector<bigtime_t> clientTimes;
+	std::vector<bigtime_t> byteTimes;
+	for (int32 run = 0; run < kRuns; run++) {
+		clientTimes.push_back(RunClient(bodies, clientPassed));
+		byteTimes.push_back(RunByteReader(bodies, bytePassed));
+	}
+	Report("LSPPipeClient", clientTimes, size, messageCount);
+	Report("headers byte by byte", byteTimes, size, messageCount);
+
+	const bool passed = clientPassed && bytePassed;
+	printf("  messages %s\n", passed ? "intact" : "WRONG");
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,385 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Parses the LSP messages decoded on the reader thread, as a C++ server
+// sends them, and reports the time of LSPMessage::Parse() against the json
+// DOM followed by the protocol.h conversion, as the window thread did.
+// Every payload decoded is checked against the one of the DOM. Messages
+// sending the payload before the id, a null result and a payload of the
+// wrong type are checked to fall back to the DOM.
+// Runs on any POSIX system, with the Haiku calls stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers -I../../src/lsp-client
+//     -I../../libs/json benchmark_lsp_message.cpp
+//     ../../src/lsp-client/LSPMessage.cpp stubs/HaikuStubs.cpp -lpthread
+//     -o benchmark_lsp_message
+// Usage: benchmark_lsp_message [completion items]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <OS.h>
+
+#include "LSPMessage.h"
+#include "Logger.h"
+#include "protocol.h"
+
+
+static const int32 kDefaultItemCount = 5000;
+static const int32 kRuns = 20;
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+static std::string
+Words(uint32& seed, size_t length)
+{
+	static const char* kWords[] = { "BString", "status_t", "const", "int32",
+		"message", "result", "std::vector", "nullptr", "Lock", "fItems" };
+	std::string text;
+	while (text.length() < length) {
+		text += kWords[Random(seed) % 10];
+		text += ' ';
+	}
+	return text;
+}
+
+
+static std::string
+RandomRange(uint32& seed)
+{
+	const int32 line = Random(seed) % 5000;
+	const int32 character = Random(seed) % 80;
+	return "{\"start\":{\"line\":" + std::to_string(line) + ",\"character\":"
+		+ std::to_string(character) + "},\"end\":{\"line\":" + std::to_string(line)
+		+ ",\"character\":" + std::to_string(character + 8) + "}}";
+}
+
+
+static std::string
+Edit(uint32& seed)
+{
+	return "{\"range\":" + RandomRange(seed) + ",\"newText\":\"" + Words(seed, 12) + "\"}";
+}
+
+
+static std::string
+Completion(uint32& seed, int32 count)
+{
+	std::string body = "{\"jsonrpc\":\"2.0\",\"id\":\"1_7_textDocument/completion\","
+		"\"result\":{\"isIncomplete\":true,\"items\":[";
+	for (int32 i = 0; i < count; i++) {
+		if (i > 0)
+			body += ",";
+		const std::string name = "Item" + std::to_string(i);
+		body += "{\"label\":\" " + name + "\",\"kind\":" + std::to_string(1 + i % 25)
+			+ ",\"detail\":\"status_t (int32 index)\",\"sortText\":\"" + name
+			+ "\",\"filterText\":\"" + name + "\",\"insertText\":\"" + name
+			+ "\",\"insertTextFormat\":" + std::to_string(1 + i % 2)
+			+ ",\"score\":0.5,\"documentation\":{\"kind\":\"markdown\",\"value\":\""
+			+ Words(seed, 40) + "\"},\"textEdit\":" + Edit(seed);
+		if (i % 10 == 0)
+			body += ",\"additionalTextEdits\":[" + Edit(seed) + "," + Edit(seed) + "]";
+		body += "}";
+	}
+	return body + "]}}";
+}
+
+
+static std::string
+Diagnostics(uint32& seed, int32 count)
+{
+	std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+		"\"params\":{\"uri\":\"file:///boot/home/project/src/Editor.cpp\","
+		"\"version\":12,\"diagnostics\":[";
+	for (int32 i = 0; i < count; i++) {
+		if (i > 0)
+			body += ",";
+		body += "{\"range\":" + RandomRange(seed) + ",\"severity\":" + std::to_string(1 + i % 4)
+			+ ",\"code\":\"unused_variable\",\"source\":\"clang\",\"message\":\""
+			+ Words(seed, 60 + Random(seed) % 120) + "\"";
+		if (i % 3 == 0)
+			body += ",\"category\":\"Semantic Issue\"";
+		if (i % 4 == 0) {
+			body += ",\"relatedInformation\":[{\"location\":{\"uri\":"
+				"\"file:///boot/home/project/src/Editor.h\",\"range\":" + RandomRange(seed)
+				+ "},\"message\":\"" + Words(seed, 30) + "\"}]";
+		}
+		if (i % 5 == 0) {
+			body += ",\"codeActions\":[{\"title\":\"change 'x' to 'y'\",\"kind\":\"quickfix\","
+				"\"edit\":{\"changes\":{\"file:///boot/home/project/src/Editor.cpp\":["
+				+ Edit(seed) + "]}}}]";
+		}
+		body += "}";
+	}
+	return body + "]}}";
+}
+
+
+static std::string
+Symbol(uint32& seed, int32 depth)
+{
+	std::string symbol = "{\"name\":\"" + Words(seed, 10) + "\",\"detail\":\"void ()\","
+		"\"kind\":" + std::to_string(1 + Random(seed) % 26) + ",\"range\":" + RandomRange(seed)
+		+ ",\"selectionRange\":" + RandomRange(seed);
+	if (Random(seed) % 7 == 0)
+		symbol += ",\"deprecated\":true";
+	if (depth < 3) {
+		symbol += ",\"children\":[";
+		const int32 count = Random(seed) % 6;
+		for (int32 i = 0; i < count; i++) {
+			if (i > 0)
+				symbol += ",";
+			symbol += Symbol(seed, depth + 1);
+		}
+		symbol += "]";
+	}
+	return symbol + "}";
+}
+
+
+static std::string
+DocumentSymbols(uint32& seed, int32 count)
+{
+	std::string body = "{\"jsonrpc\":\"2.0\",\"id\":\"1_8_textDocument/documentSymbol\","
+		"\"result\":[";
+	for (int32 i = 0; i < count; i++) {
+		if (i > 0)
+			body += ",";
+		body += Symbol(seed, 1);
+	}
+	return body + "]}";
+}
+
+
+static std::string
+SymbolList(uint32& seed, int32 count)
+{
+	std::string body = "{\"jsonrpc\":\"2.0\",\"id\":\"1_9_textDocument/documentSymbol\","
+		"\"result\":[";
+	for (int32 i = 0; i < count; i++) {
+		if (i > 0)
+			body += ",";
+		body += "{\"name\":\"" + Words(seed, 10) + "\",\"kind\":"
+			+ std::to_string(1 + Random(seed) % 26) + ",\"location\":{\"uri\":"
+			"\"file:///boot/home/project/src/Editor.cpp\",\"range\":" + RandomRange(seed) + "}";
+		if (i % 2 == 0)
+			body += ",\"containerName\":\"Editor\"";
+		body += "}";
+	}
+	return body + "]}";
+}
+
+
+static std::string
+Hover(uint32& seed)
+{
+	return "{\"jsonrpc\":\"2.0\",\"id\":\"1_10_textDocument/hover\",\"result\":"
+		"{\"contents\":{\"kind\":\"markdown\",\"value\":\"" + Words(seed, 20000)
+		+ "\"},\"range\":" + RandomRange(seed) + "}}";
+}
+
+
+// The payloads as text, to compare those of the two paths
+static std::string
+Describe(const TextEdit& edit)
+{
+	return value(edit).dump();
+}
+
+
+static std::string
+Describe(const CompletionList& list)
+{
+	std::string text = list.isIncomplete ? "incomplete\n" : "complete\n";
+	for (const CompletionItem& item : list.items) {
+		text += item.label + "|" + std::to_string((int)item.kind) + "|" + item.detail
+			+ "|" + item.sortText + "|" + item.filterText + "|" + item.insertText + "|"
+			+ std::to_string((int)item.insertTextFormat) + "|" + Describe(item.textEdit);
+		for (const TextEdit& edit : item.additionalTextEdits)
+			text += "|" + Describe(edit);
+		text += "\n";
+	}
+	return text;
+}
+
+
+static std::string
+Describe(const std::vector<DocumentSymbol>& symbols)
+{
+	std::string text = "[";
+	for (const DocumentSymbol& symbol : symbols) {
+		text += symbol.name + "|" + symbol.detail + "|" + std::to_string((int)symbol.kind)
+			+ "|" + (symbol.deprecated ? "deprecated" : "") + "|"
+			+ value(symbol.range).dump() + "|" + value(symbol.selectionRange).dump()
+			+ Describe(symbol.children) + "\n";
+	}
+	return text + "]";
+}
+
+
+struct Payload {
+	const char*		name;
+	std::string		body;
+};
+
+
+// The conversion of _DecodeDOM(), for the reference payload
+static std::string
+ParseDOM(const std::string& body)
+{
+	value json = value::parse(body);
+	if (json.contains("params")) {
+		value& params = json["params"];
+		return params["uri"].get<std::string>()
+			+ value(params["diagnostics"].get<std::vector<Diagnostic>>()).dump();
+	}
+	const std::string id = json["id"].get<std::string>();
+	value& result = json["result"];
+	if (id.find("completion") != std::string::npos)
+		return Describe(result.get<CompletionList>());
+	if (id.find("hover") != std::string::npos)
+		return result["contents"]["value"].get<std::string>();
+	if (result[0]["location"].is_null())
+		return Describe(result.get<std::vector<DocumentSymbol>>());
+	return value(result.get<std::vector<SymbolInformation>>()).dump();
+}
+
+
+static std::string
+ParseMessage(const std::string& body, LSPMessage::DecodedType& type)
+{
+	LSPMessage message;
+	if (!message.Parse(body)) {
+		type = LSPMessage::kNotDecoded;
+		return "";
+	}
+	type = message.Decoded();
+	switch (type) {
+		case LSPMessage::kCompletion:
+			return Describe(message.completion);
+		case LSPMessage::kDiagnostics:
+			return message.URI() + value(message.diagnostics).dump();
+		case LSPMessage::kDocumentSymbol:
+			if (!message.symbolInformation.empty())
+				return value(message.symbolInformation).dump();
+			return Describe(message.documentSymbols);
+		case LSPMessage::kHover:
+			return message.hover;
+		default:
+			return "";
+	}
+}
+
+
+static bigtime_t
+Median(std::vector<bigtime_t>& times)
+{
+	std::sort(times.begin(), times.end());
+	return std::max(times[times.size() / 2], (bigtime_t)1);
+}
+
+
+static bool
+Run(const Payload& payload)
+{
+	std::vector<bigtime_t> messageTimes;
+	std::vector<bigtime_t> domTimes;
+	std::string decoded;
+	std::string reference;
+	LSPMessage::DecodedType type = LSPMessage::kNotDecoded;
+	for (int32 run = 0; run < kRuns; run++) {
+		bigtime_t start = system_time();
+		decoded = ParseMessage(payload.body, type);
+		messageTimes.push_back(system_time() - start);
+
+		start = system_time();
+		reference = ParseDOM(payload.body);
+		domTimes.push_back(system_time() - start);
+	}
+
+	const bool passed = type != LSPMessage::kNotDecoded && decoded == reference;
+	const bigtime_t message = Median(messageTimes);
+	const bigtime_t dom = Median(domTimes);
+	printf("  %-18s %8.1f KiB  %9.2f ms  %9.2f ms  %5.2fx%s\n", payload.name,
+		payload.body.length() / 1024.0, message / 1000.0, dom / 1000.0,
+		(double)dom / message, passed ? "" : "  WRONG PAYLOAD");
+	return passed;
+}
+
+
+// The messages the decoders can't take: the payload is converted from the
+// DOM, or left in the json for the window thread
+static bool
+RunFallbacks()
+{
+	bool passed = true;
+
+	LSPMessage::DecodedType type;
+	const std::string late = "{\"result\":{\"contents\":{\"value\":\"late\"}},"
+		"\"id\":\"1_2_textDocument/hover\",\"jsonrpc\":\"2.0\"}";
+	passed = ParseMessage(late, type) == "late" && type == LSPMessage::kHover && passed;
+
+	LSPMessage empty;
+	passed = empty.Parse("{\"jsonrpc\":\"2.0\",\"id\":\"1_3_textDocument/completion\","
+		"\"result\":null}") && empty.Decoded() == LSPMessage::kCompletion
+		&& empty.completion.items.empty() && passed;
+
+	LSPMessage wrong;
+	passed = wrong.Parse("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+		"\"params\":{\"uri\":\"file:///a.cpp\",\"diagnostics\":[{\"message\":\"m\","
+		"\"codeActions\":[{\"title\":3}]}]}}") && wrong.Decoded() == LSPMessage::kNotDecoded
+		&& wrong.diagnostics.empty()
+		&& wrong.json["params"]["diagnostics"][0]["message"] == "m" && passed;
+
+	LSPMessage other;
+	passed = other.Parse("{\"jsonrpc\":\"2.0\",\"method\":\"$/progress\",\"params\":"
+		"{\"token\":1,\"value\":{\"kind\":\"report\",\"percentage\":12.5}}}")
+		&& other.Decoded() == LSPMessage::kNotDecoded
+		&& other.json["params"]["value"]["percentage"] == 12.5 && passed;
+
+	LSPMessage broken;
+	passed = !broken.Parse("{\"jsonrpc\":\"2.0\",\"id\":\"1_4_textDocument/hover\","
+		"\"result\":{\"contents\":") && passed;
+
+	printf("  fallbacks %s\n", passed ? "right" : "WRONG");
+	return passed;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 itemCount = argc > 1 ? atoi(argv[1]) : kDefaultItemCount;
+	// the broken message is logged
+	Logger::SetLevel(LOG_LEVEL_OFF);
+
+	uint32 seed = 42;
+	const Payload payloads[] = {
+		{ "completion", Completion(seed, itemCount) },
+		{ "diagnostics", Diagnostics(seed, 200) },
+		{ "document symbols", DocumentSymbols(seed, 300) },
+		{ "symbol information", SymbolList(seed, 2000) },
+		{ "hover", Hover(seed) }
+	};
+
+	printf("  %-18s %12s  %12s  %12s\n", "message", "size", "Parse()", "DOM + get");
+	bool passed = true;
+	for (const Payload& payload : payloads)
+		passed = Run(payload) && passed;
+	passed = RunFallbacks() && passed;
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
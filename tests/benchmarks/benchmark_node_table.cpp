@@ -0,0 +1,180 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Fills a ProjectNodeTable with generated trees of 10k, 100k and 1M
+// entries, or of the given sizes, and reports the memory used by each
+// entry and the time of a lookup by path and by entry_ref. A lookup
+// walking all the nodes, as the browser did through its list items, is
+// timed too. Every lookup is checked.
+// Runs on any POSIX system, with the Haiku types stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/project benchmark_node_table.cpp
+//     ../../src/project/ProjectNodeTable.cpp -o benchmark_node_table
+// Usage: benchmark_node_table [entries...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "ProjectNodeTable.h"
+
+
+static const dev_t kDevice = 3;
+static const int32 kFoldersPerFolder = 8;
+static const int32 kFilesPerFolder = 40;
+static const int32 kLookups = 200000;
+static const int32 kScans = 20;
+
+static const char* kExtensions[] = { ".cpp", ".h", ".txt", ".md", ".rdef" };
+
+
+static bigtime_t
+Now()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (bigtime_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+struct Entry {
+	ProjectNodeTable::NodeId	node;
+	std::string					path;
+	entry_ref					ref;
+};
+
+
+// Adds folders breadth first, each with its files, until count entries:
+// the names are unique, as the interning would hide the cost of the names
+static void
+Fill(ProjectNodeTable& table, const std::string& rootPath, int32 count,
+	std::vector<Entry>& entries)
+{
+	ino_t inode = 2;
+	std::vector<std::pair<ProjectNodeTable::NodeId, std::string>> folders;
+	folders.push_back({ table.Root(), rootPath });
+	char name[64];
+	for (size_t folder = 0; folder < folders.size() && (int32)entries.size() < count;
+			folder++) {
+		const ProjectNodeTable::NodeId parent = folders[folder].first;
+		const std::string parentPath = folders[folder].second;
+		const ino_t parentInode = table.NodeRef(parent).node;
+		for (int32 i = 0; i < kFoldersPerFolder + kFilesPerFolder
+				&& (int32)entries.size() < count; i++) {
+			const bool isDirectory = i < kFoldersPerFolder;
+			if (isDirectory)
+				snprintf(name, sizeof(name), "module_%lld", (long long)inode);
+			else {
+				snprintf(name, sizeof(name), "source_file_%lld%s", (long long)inode,
+					kExtensions[inode % 5]);
+			}
+			Entry entry;
+			entry.node = table.Add(parent, name, node_ref(kDevice, inode++), isDirectory);
+			entry.path = parentPath + "/" + name;
+			entry.ref = entry_ref(kDevice, parentInode, name);
+			if (isDirectory)
+				folders.push_back({ entry.node, entry.path });
+			entries.push_back(std::move(entry));
+		}
+	}
+}
+
+
+// The lookup by path of the browser before the table: a walk of every
+// node, comparing the paths
+static ProjectNodeTable::NodeId
+ScanForPath(const ProjectNodeTable& table, const char* path)
+{
+	std::vector<ProjectNodeTable::NodeId> stack(1, table.Root());
+	while (!stack.empty()) {
+		const ProjectNodeTable::NodeId node = stack.back();
+		stack.pop_back();
+		const char* name = table.Name(node);
+		const size_t length = strlen(name);
+		const size_t pathLength = strlen(path);
+		if (pathLength >= length && strcmp(path + pathLength - length, name) == 0
+			&& table.Path(node) == path)
+			return node;
+		for (ProjectNodeTable::NodeId child = table.FirstChild(node);
+				child != ProjectNodeTable::kNoNode; child = table.NextSibling(child))
+			stack.push_back(child);
+	}
+	return ProjectNodeTable::kNoNode;
+}
+
+
+static bool
+Run(int32 count)
+{
+	const std::string rootPath = "/boot/home/workspace/project";
+	ProjectNodeTable table(rootPath.c_str(), entry_ref(kDevice, 1, "project"),
+		node_ref(kDevice, 1));
+	std::vector<Entry> entries;
+	entries.reserve(count);
+
+	bigtime_t start = Now();
+	Fill(table, rootPath, count, entries);
+	table.ShrinkToFit();
+	const bigtime_t fillTime = Now() - start;
+
+	uint32 seed = 7;
+	std::vector<const Entry*> lookups;
+	for (int32 i = 0; i < kLookups; i++)
+		lookups.push_back(&entries[Random(seed) % entries.size()]);
+
+	bool passed = true;
+	start = Now();
+	for (const Entry* entry : lookups)
+		passed = passed && table.FindByPath(entry->path.c_str()) == entry->node;
+	const bigtime_t pathTime = Now() - start;
+
+	start = Now();
+	for (const Entry* entry : lookups)
+		passed = passed && table.FindByRef(entry->ref) == entry->node;
+	const bigtime_t refTime = Now() - start;
+
+	start = Now();
+	for (int32 i = 0; i < kScans; i++)
+		passed = passed && ScanForPath(table, lookups[i]->path.c_str()) == lookups[i]->node;
+	const bigtime_t scanTime = Now() - start;
+
+	for (const Entry& entry : entries)
+		passed = passed && table.Path(entry.node) == entry.path.c_str();
+
+	printf("%8d  %11.1f  %9.1f ms  %8.0f ns  %8.0f ns  %9.0f us%s\n", (int)count,
+		(double)table.MemoryUsage() / table.CountNodes(), fillTime / 1000.0,
+		pathTime * 1000.0 / kLookups, refTime * 1000.0 / kLookups,
+		(double)scanTime / kScans, passed ? "" : "  WRONG NODES");
+	return passed;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	std::vector<int32> counts;
+	for (int32 i = 1; i < argc; i++)
+		counts.push_back(atoi(argv[i]));
+	if (counts.empty())
+		counts = { 10000, 100000, 1000000 };
+
+	printf(" entries  bytes/entry       fill  path lookup  ref lookup  linear scan\n");
+	bool passed = true;
+	for (int32 count : counts)
+		passed = Run(count) && passed;
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Fills a PathIndex from a generated tree and reports the time of the walk,
+// the latency of the Quick open queries and the cost of the scorer alone,
+// with and without the character masks. Every result is checked to hold
+// the query letters in order, and the files named by a query to come
+// first. Path monitor events are queued with Update() and their
+// application is timed too.
+// The tree is generated, always the same, in /tmp/genio_path_corpus:
+// 100000 one line files by default, or the given count.
+// Runs on any POSIX system, with the Haiku calls stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers benchmark_path_index.cpp
+//     ../../src/helpers/PathIndex.cpp ../../src/helpers/ProjectWalker.cpp
+//     stubs/HaikuStubs.cpp -lpthread -o benchmark_path_index
+// Usage: benchmark_path_index [file count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <OS.h>
+
+#include "Logger.h"
+#include "PathIndex.h"
+#include "ProjectWalker.h"
+
+
+static const char* kCorpusPath = "/tmp/genio_path_corpus";
+static const int32 kDefaultFileCount = 100000;
+static const int32 kMaxResults = 50;
+static const int32 kRuns = 20;
+static const int32 kUpdates = 20000;
+
+static const char* kFolders[] = { "src", "ui", "helpers", "editor", "lsp-client",
+	"project", "git", "scintilla", "terminal", "tests", "data", "locales", "build",
+	"objects.x86_64-cc13-release", "Crème brûlée", "docs" };
+static const int32 kFolderCount = sizeof(kFolders) / sizeof(kFolders[0]);
+
+static const char* kNames[] = { "Genio", "Window", "Editor", "Path", "Index",
+	"Project", "Folder", "Browser", "Git", "Worker", "Quick", "Open", "Find",
+	"Files", "Engine", "Lsp", "Pipe", "Client", "Message", "Panel", "Tab",
+	"Manager", "Config", "Theme", "Über", "Trigram", "Node", "Table" };
+static const int32 kNameCount = sizeof(kNames) / sizeof(kNames[0]);
+
+static const char* kExtensions[] = { ".cpp", ".h", ".o", ".d", ".rdef", ".md", ".py" };
+static const int32 kExtensionCount = sizeof(kExtensions) / sizeof(kExtensions[0]);
+
+// planted once, at the bottom of the tree, and searched by name
+static const char* kTarget = "src/ui/QuickOpenWindow.cpp";
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+// the walk skips empty files
+static void
+CreateFile(const std::string& path)
+{
+	std::ofstream(path) << "\n";
+}
+
+
+static void
+GenerateCorpus(int32 fileCount)
+{
+	std::string marker(kCorpusPath);
+	marker += ".complete";
+	std::ifstream complete(marker);
+	int32 existing = 0;
+	if (complete >> existing && existing == fileCount)
+		return;
+
+	printf("Generating %d files in %s\n", (int)fileCount, kCorpusPath);
+	std::string command("rm -rf ");
+	command += kCorpusPath;
+	if (system(command.c_str()) != 0)
+		exit(1);
+	mkdir(kCorpusPath, 0755);
+
+	uint32 seed = 42;
+	std::vector<std::string> folders(1, kCorpusPath);
+	std::vector<int32> depths(1, 0);
+	for (int32 i = 0; i < fileCount - 1; i++) {
+		// a new folder every 40 files, below one of the existing ones up to
+		// 6 levels deep
+		if (i % 40 == 0) {
+			size_t parent;
+			do {
+				parent = Random(seed) % folders.size();
+			} while (depths[parent] >= 6);
+			std::string folder = folders[parent];
+			folder.append("/").append(kFolders[Random(seed) % kFolderCount]);
+			char suffix[16];
+			snprintf(suffix, sizeof(suffix), "_%d", (int)folders.size());
+			folder += suffix;
+			mkdir(folder.c_str(), 0755);
+			folders.push_back(folder);
+			depths.push_back(depths[parent] + 1);
+		}
+		std::string path = folders.back();
+		path += "/";
+		const int32 words = 1 + Random(seed) % 3;
+		for (int32 word = 0; word < words; word++)
+			path += kNames[Random(seed) % kNameCount];
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "%d%s", (int)i, kExtensions[Random(seed)
+			% kExtensionCount]);
+		path += suffix;
+		CreateFile(path);
+	}
+
+	const std::string root(kCorpusPath);
+	mkdir((root + "/src").c_str(), 0755);
+	mkdir((root + "/src/ui").c_str(), 0755);
+	CreateFile(root + "/" + kTarget);
+	std::ofstream(marker) << fileCount;
+}
+
+
+static std::string
+Fold(const char* text)
+{
+	std::string folded;
+	for (; *text != '\0'; text++) {
+		if (*text != ' ')
+			folded.push_back(*text >= 'A' && *text <= 'Z' ? *text + ('a' - 'A') : *text);
+	}
+	return folded;
+}
+
+
+// The letters of the query, in order, case folded
+static bool
+Holds(const std::string& path, const char* query)
+{
+	const std::string folded = Fold(path.c_str());
+	const std::string letters = Fold(query);
+	size_t position = 0;
+	for (char c : letters) {
+		position = folded.find(c, position);
+		if (position == std::string::npos)
+			return false;
+		position++;
+	}
+	return true;
+}
+
+
+static void
+WaitCount(PathIndex& index, int32 count)
+{
+	while (index.CountPaths() < count)
+		snooze(1000);
+}
+
+
+static bool
+RunQueries(PathIndex& index)
+{
+	struct Query {
+		const char*	text;
+		const char*	first;	// the leaf expected first, if any
+	};
+	const Query queries[] = {
+		{ "QuickOpenWindow.cpp", "QuickOpenWindow.cpp" },
+		{ "qowcpp", "QuickOpenWindow.cpp" },
+		{ "gwin", nullptr },
+		{ "src/ui/editor", nullptr },
+		{ "Überpy", nullptr },
+		{ "pathindex.h", nullptr },
+		{ "x", nullptr },
+		{ "zzzzqq", nullptr }
+	};
+
+	bool passed = true;
+	for (const Query& query : queries) {
+		std::vector<PathIndex::Match> matches;
+		std::vector<bigtime_t> times;
+		for (int32 run = 0; run < kRuns; run++) {
+			matches.clear();
+			const bigtime_t start = system_time();
+			index.Search(query.text, kMaxResults, matches);
+			times.push_back(system_time() - start);
+		}
+		std::sort(times.begin(), times.end());
+
+		bool right = true;
+		for (size_t i = 0; i < matches.size(); i++) {
+			right = right && Holds(matches[i].path, query.text);
+			right = right && (i == 0 || matches[i - 1].score >= matches[i].score);
+		}
+		if (query.first != nullptr) {
+			right = right && !matches.empty()
+				&& strcmp(matches[0].path.c_str() + matches[0].nameStart, query.first) == 0;
+		}
+		passed = passed && right;
+		printf("  %-20s %3zu results  median %7.2f ms%s\n", query.text, matches.size(),
+			times[kRuns / 2] / 1000.0, right ? "" : "  WRONG RESULTS");
+	}
+	return passed;
+}
+
+
+// The scorer alone, over every relative path, as Search() calls it
+static void
+RunScorer(const char* text)
+{
+	std::vector<std::string> paths;
+	std::vector<std::string> folded;
+	const size_t rootLength = strlen(kCorpusPath) + 1;
+	std::atomic<bool> stop(false);
+	ProjectWalker(kCorpusPath, "", false).Walk([&](std::string&& path, const struct stat&) {
+		paths.push_back(path.substr(rootLength));
+		folded.push_back(Fold(paths.back().c_str()));
+	}, stop);
+
+	const std::string query = Fold(text);
+	const bigtime_t start = system_time();
+	int32 found = 0;
+	for (size_t i = 0; i < paths.size(); i++) {
+		const int32 nameStart = paths[i].rfind('/') + 1;
+		found += PathIndex::Score(paths[i].c_str(), folded[i].c_str(), paths[i].length(),
+			nameStart, query.c_str(), query.length()) > 0;
+	}
+	const bigtime_t elapsed = system_time() - start;
+	printf("  scorer alone on \"%s\": %.0f ns/path, %d of %zu paths match\n", text,
+		elapsed * 1000.0 / std::max(paths.size(), (size_t)1), (int)found, paths.size());
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 fileCount = argc > 1 ? atoi(argv[1]) : kDefaultFileCount;
+	GenerateCorpus(fileCount);
+	Logger::SetLevel(LOG_LEVEL_ERROR);
+
+	PathIndex index(kCorpusPath);
+	bigtime_t start = system_time();
+	index.Start("", false);
+	WaitCount(index, fileCount);
+	printf("%s\n  %d paths listed in %.2f ms\n", kCorpusPath, (int)index.CountPaths(),
+		(system_time() - start) / 1000.0);
+
+	bool passed = RunQueries(index);
+	RunScorer("gwin");
+	RunScorer("srcuiquickopen");
+
+	// path monitor events, as the ProjectBrowser forwards them: new files in
+	// a new folder, then the folder removed
+	std::string folder(kCorpusPath);
+	folder += "/added";
+	mkdir(folder.c_str(), 0755);
+	std::vector<std::string> added;
+	for (int32 i = 0; i < kUpdates; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "/AddedFile%d.cpp", (int)i);
+		added.push_back(folder + name);
+		CreateFile(added.back());
+	}
+	start = system_time();
+	for (const std::string& path : added)
+		index.Update(path.c_str());
+	const bigtime_t queued = system_time() - start;
+	WaitCount(index, fileCount + kUpdates);
+	printf("  %d events queued in %.2f ms, applied in %.2f ms\n", (int)kUpdates,
+		queued / 1000.0, (system_time() - start) / 1000.0);
+
+	std::vector<PathIndex::Match> matches;
+	index.Search("AddedFile123.cpp", 1, matches);
+	const bool addedFound = !matches.empty()
+		&& matches[0].path == folder + "/AddedFile123.cpp";
+	printf("  added file %s\n", addedFound ? "found" : "NOT FOUND");
+	passed = passed && addedFound;
+
+	std::string command("rm -rf ");
+	command += folder;
+	if (system(command.c_str()) != 0)
+		return 1;
+	start = system_time();
+	index.Update(folder.c_str());
+	while (index.CountPaths() > fileCount)
+		snooze(1000);
+	printf("  removed folder applied in %.2f ms\n", (system_time() - start) / 1000.0);
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
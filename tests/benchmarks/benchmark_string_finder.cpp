@@ -0,0 +1,192 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Counts the matches of a few needles in a generated source-like buffer with
+// the StringFinder of Find in files, and reports its throughput against a
+// byte by byte search and, when the case matters, against memmem(). Every
+// count is checked against the byte by byte search.
+// The buffer is 16 MiB by default, or the given size in MiB.
+// Runs on any POSIX system. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers benchmark_string_finder.cpp
+//     ../../src/helpers/StringFinder.cpp stubs/HaikuStubs.cpp -lpthread
+//     -o benchmark_string_finder
+// Usage: benchmark_string_finder [MiB]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <OS.h>
+
+#include "StringFinder.h"
+
+
+static const int32 kDefaultSize = 16;
+static const int32 kRuns = 5;
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+static std::string
+Generate(size_t size)
+{
+	static const char* kWords[] = { "BString", "status_t", "const", "int32", "return",
+		"message", "result", "std::vector", "nullptr", "fItems", "if", "else", "for",
+		"->Lock()", "SendMessage", "Über", "B_OK", "while", "delete", "Window" };
+	static const int32 kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+	uint32 seed = 42;
+	std::string text;
+	text.reserve(size + 64);
+	while (text.length() < size) {
+		const int32 indent = Random(seed) % 4;
+		text.append(indent, '\t');
+		const int32 words = 2 + Random(seed) % 10;
+		for (int32 word = 0; word < words; word++) {
+			text += kWords[Random(seed) % kWordCount];
+			text += word + 1 < words ? ' ' : ';';
+		}
+		// planted once in a while
+		if (Random(seed) % 5000 == 0)
+			text += " // QuickOpenWindow";
+		text += '\n';
+	}
+	return text;
+}
+
+
+static inline char
+Fold(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+static int32
+CountFinder(const std::string& text, const char* needle, bool caseSensitive)
+{
+	StringFinder finder(needle, caseSensitive);
+	const char* end = text.data() + text.length();
+	int32 count = 0;
+	for (const char* p = finder.Find(text.data(), end); p != nullptr;
+			p = finder.Find(p + 1, end)) {
+		count++;
+	}
+	return count;
+}
+
+
+static int32
+CountBytes(const std::string& text, const char* needle, bool caseSensitive)
+{
+	const size_t length = strlen(needle);
+	int32 count = 0;
+	for (size_t i = 0; i + length <= text.length(); i++) {
+		size_t j = 0;
+		if (caseSensitive) {
+			while (j < length && text[i + j] == needle[j])
+				j++;
+		} else {
+			while (j < length && Fold(text[i + j]) == Fold(needle[j]))
+				j++;
+		}
+		count += j == length;
+	}
+	return count;
+}
+
+
+static int32
+CountMemmem(const std::string& text, const char* needle, bool)
+{
+	const size_t length = strlen(needle);
+	const char* end = text.data() + text.length();
+	int32 count = 0;
+	for (const char* p = (const char*)memmem(text.data(), text.length(), needle, length);
+			p != nullptr; p = (const char*)memmem(p + 1, end - p - 1, needle, length)) {
+		count++;
+	}
+	return count;
+}
+
+
+typedef int32 (*Counter)(const std::string&, const char*, bool);
+
+
+static double
+Time(Counter counter, const std::string& text, const char* needle, bool caseSensitive,
+	int32& count, int32 runs = kRuns)
+{
+	std::vector<bigtime_t> times;
+	for (int32 run = 0; run < runs; run++) {
+		const bigtime_t start = system_time();
+		count = counter(text, needle, caseSensitive);
+		times.push_back(system_time() - start);
+	}
+	std::sort(times.begin(), times.end());
+	// MiB/s
+	return text.length() / 1048576.0 / (std::max(times[runs / 2], (bigtime_t)1) / 1000000.0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const int32 size = argc > 1 ? atoi(argv[1]) : kDefaultSize;
+	const std::string text = Generate((size_t)size * 1048576);
+
+	struct Needle {
+		const char*	text;
+		bool		caseSensitive;
+	};
+	const Needle needles[] = {
+		{ "QuickOpenWindow", true },
+		{ "quickopenwindow", false },
+		{ "status_t", true },
+		{ "STATUS_T", false },
+		{ "->Lock()", true },
+		{ "else if", false },
+		{ "Else If", true },
+		{ "über", false },
+		{ "NotInTheText", false }
+	};
+
+	printf("  %d MiB\n  %-18s %-5s %8s %13s %13s %13s\n", (int)size, "needle", "case",
+		"matches", "StringFinder", "byte by byte", "memmem");
+	bool passed = true;
+	for (const Needle& needle : needles) {
+		int32 count;
+		int32 expected;
+		const double finder = Time(CountFinder, text, needle.text, needle.caseSensitive,
+			count);
+		// the slowest, once
+		const double bytes = Time(CountBytes, text, needle.text, needle.caseSensitive,
+			expected, 1);
+		char memmem[32] = "-";
+		if (needle.caseSensitive) {
+			int32 memmemCount;
+			snprintf(memmem, sizeof(memmem), "%7.0f MiB/s", Time(CountMemmem, text,
+				needle.text, true, memmemCount));
+			passed = passed && memmemCount == expected;
+		}
+		passed = passed && count == expected;
+		printf("  %-18s %-5s %8d %7.0f MiB/s %7.0f MiB/s %13s%s\n", needle.text,
+			needle.caseSensitive ? "yes" : "no", (int)count, finder, bytes, memmem,
+			count == expected ? "" : "  WRONG COUNT");
+	}
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+// Builds the TrigramIndex of a corpus and reports the build time, the size
+// of the saved index, the time to load it again and the query latency.
+// It also checks the candidates of each query include every file holding
+// the text, that a damaged index file is rebuilt and that an index quit
+// while building is not saved.
+// The corpus is generated, always the same, in /tmp/genio_trigram_corpus:
+// 40000 C++ like files by default, or the given count. A folder can be
+// given instead, e.g. /usr/include.
+// Runs on any POSIX system, with the Haiku calls stubbed. From this folder:
+//   g++ -std=c++17 -O2 -Istubs -I../../src/helpers benchmark_trigram_index.cpp
+//     ../../src/helpers/TrigramIndex.cpp ../../src/helpers/ProjectWalker.cpp
+//     stubs/HaikuStubs.cpp -lpthread -o benchmark_trigram_index
+// Usage: benchmark_trigram_index [file count | folder]
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <FindDirectory.h>
+#include <OS.h>
+
+#include "Logger.h"
+#include "TrigramIndex.h"
+
+
+static const char* kCorpusPath = "/tmp/genio_trigram_corpus";
+static const int32 kDefaultFileCount = 40000;
+static const int32 kRuns = 20;
+
+static const char* kWords[] = {
+	"int32", "uint32", "status_t", "BString", "BMessage", "const", "return",
+	"if", "else", "for", "while", "switch", "case", "break", "auto", "void",
+	"fCount", "fItems", "fLock", "message", "result", "index", "value",
+	"path", "node", "entry", "Lock", "Unlock", "AddString", "FindInt32",
+	"SendMessage", "Invalidate", "std::vector", "std::string", "nullptr",
+	"static_cast", "LogError", "B_OK", "B_ERROR", "B_BAD_VALUE", "size",
+	"count", "first", "last", "length", "offset", "buffer", "window"
+};
+static const int32 kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+// planted in every 1000th file, and found nowhere else
+static const char* kRareText = "GenioTrigramNeedle";
+
+
+static uint32
+Random(uint32& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+
+static void
+GenerateCorpus(int32 fileCount)
+{
+	std::string marker(kCorpusPath);
+	marker += ".complete";
+	std::ifstream complete(marker);
+	int32 existing = 0;
+	if (complete >> existing && existing == fileCount)
+		return;
+
+	printf("Generating %d files in %s\n", (int)fileCount, kCorpusPath);
+	std::string command("rm -rf ");
+	command += kCorpusPath;
+	if (system(command.c_str()) != 0)
+		exit(1);
+	mkdir(kCorpusPath, 0755);
+
+	uint32 seed = 42;
+	std::string text;
+	for (int32 i = 0; i < fileCount; i++) {
+		// 20 folders of 20 folders
+		char folder[PATH_MAX - 32];
+		snprintf(folder, sizeof(folder), "%s/module%02d", kCorpusPath, (int)(i % 20));
+		mkdir(folder, 0755);
+		snprintf(folder + strlen(folder), sizeof(folder) - strlen(folder), "/part%02d",
+			(int)(i / 20 % 20));
+		mkdir(folder, 0755);
+
+		text.clear();
+		const int32 lines = 50 + Random(seed) % 250;
+		for (int32 line = 0; line < lines; line++) {
+			text.append(Random(seed) % 3, '\t');
+			const int32 words = 3 + Random(seed) % 8;
+			for (int32 word = 0; word < words; word++) {
+				text += kWords[Random(seed) % kWordCount];
+				text += word + 1 < words ? " " : ";\n";
+			}
+			if (i % 1000 == 0 && line == lines / 2)
+				text.append("\t// ").append(kRareText).append("\n");
+		}
+
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/file%06d.cpp", folder, (int)i);
+		std::ofstream(path) << text;
+	}
+	std::ofstream(marker) << fileCount;
+}
+
+
+// The files holding text, case folded as the index does
+static void
+FindFiles(const std::string& folder, std::string text, std::vector<std::string>& found)
+{
+	std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+	DIR* directory = opendir(folder.c_str());
+	if (directory == nullptr)
+		return;
+	while (struct dirent* entry = readdir(directory)) {
+		if (entry->d_name[0] == '.')
+			continue;
+		std::string path(folder);
+		path.append("/").append(entry->d_name);
+		struct stat st;
+		if (lstat(path.c_str(), &st) != 0)
+			continue;
+		if (S_ISDIR(st.st_mode)) {
+			FindFiles(path, text, found);
+		} else if (S_ISREG(st.st_mode)) {
+			std::ifstream file(path, std::ios::binary);
+			std::string content((std::istreambuf_iterator<char>(file)),
+				std::istreambuf_iterator<char>());
+			std::transform(content.begin(), content.end(), content.begin(), ::tolower);
+			if (content.find(text) != std::string::npos)
+				found.push_back(path);
+		}
+	}
+	closedir(directory);
+}
+
+
+static std::string
+CachePath(const char* root)
+{
+	BPath path;
+	find_directory(B_USER_CACHE_DIRECTORY, &path);
+	path.Append("Genio/index");
+	char name[32];
+	snprintf(name, sizeof(name), "%016zx.trigrams", std::hash<std::string>()(root));
+	path.Append(name);
+	return path.Path();
+}
+
+
+// Returns the time until the index answers, in seconds
+static double
+WaitReady(TrigramIndex& index)
+{
+	const bigtime_t start = system_time();
+	std::vector<std::string> paths;
+	while (!index.Query("wait", "", false, paths))
+		snooze(5000);
+	return (system_time() - start) / 1000000.0;
+}
+
+
+static void
+WaitSaved(const std::string& cachePath)
+{
+	struct stat st;
+	while (stat(cachePath.c_str(), &st) != 0)
+		snooze(5000);
+}
+
+
+// Runs the queries, and fails if a file holding the text is not a
+// candidate
+static bool
+RunQueries(TrigramIndex& index, const char* root, bool report)
+{
+	const char* queries[] = { kRareText, "SendMessage", "FindInt32(", "B_BAD_VALUE;",
+		"nothing like this" };
+	bool passed = true;
+	for (const char* query : queries) {
+		std::vector<std::string> expected;
+		FindFiles(root, query, expected);
+		std::vector<std::string> candidates;
+		std::vector<bigtime_t> times;
+		for (int32 run = 0; run < kRuns; run++) {
+			candidates.clear();
+			const bigtime_t start = system_time();
+			index.Query(query, "", false, candidates);
+			times.push_back(system_time() - start);
+		}
+		std::sort(times.begin(), times.end());
+		std::sort(candidates.begin(), candidates.end());
+		std::sort(expected.begin(), expected.end());
+		const bool complete = std::includes(candidates.begin(), candidates.end(),
+			expected.begin(), expected.end());
+		passed = passed && complete;
+		if (report) {
+			printf("  %-20s %8zu candidates %8zu files  median %8.2f ms%s\n", query,
+				candidates.size(), expected.size(), times[kRuns / 2] / 1000.0,
+				complete ? "" : "  MISSING FILES");
+		}
+	}
+	return passed;
+}
+
+
+template<typename T>
+static T
+Read(const std::string& content, size_t& offset)
+{
+	T value = 0;
+	if (offset + sizeof(T) <= content.size())
+		memcpy(&value, content.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return value;
+}
+
+
+// Damages the posting list of the "sen" trigram, the first of the
+// SendMessage query, following the layout written by TrigramIndex::_Save()
+static bool
+Damage(std::string& content, int32 damage)
+{
+	if (damage == 0) {
+		content.resize(content.size() / 2);
+		return true;
+	}
+
+	// magic, version, root and fingerprint, then the files
+	size_t offset = 8;
+	for (int32 i = 0; i < 2; i++) {
+		const uint32 length = Read<uint32>(content, offset);
+		offset += length;
+	}
+	const uint32 fileCount = Read<uint32>(content, offset);
+	for (uint32 i = 0; i < fileCount; i++) {
+		const uint32 length = Read<uint32>(content, offset);
+		offset += length + 8 + 8 + 1;
+	}
+	const uint32 postingCount = Read<uint32>(content, offset);
+	const uint32 sen = ('s' << 16) | ('e' << 8) | 'n';
+	for (uint32 i = 0; i < postingCount && offset < content.size(); i++) {
+		const uint32 trigram = Read<uint32>(content, offset);
+		const size_t lengthOffset = offset;
+		const uint32 length = Read<uint32>(content, offset);
+		const size_t lastOffset = offset;
+		const uint32 last = Read<uint32>(content, offset);
+		if (trigram != sen) {
+			offset += length;
+			continue;
+		}
+		if (damage == 1) {
+			// one more id, well past the files, with a matching last id
+			const uint32 delta = 1 << 20, newLast = last + delta;
+			const char varint[] = { char(0x80), char(0x80), char(delta >> 14) };
+			content.insert(offset + length, varint, sizeof(varint));
+			const uint32 newLength = length + sizeof(varint);
+			memcpy(&content[lengthOffset], &newLength, sizeof(newLength));
+			memcpy(&content[lastOffset], &newLast, sizeof(newLast));
+		} else {
+			content[offset + length - 1] |= 0x80;
+		}
+		return true;
+	}
+	return false;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	std::string root(kCorpusPath);
+	if (argc > 1 && argv[1][0] == '/')
+		root = argv[1];
+	else
+		GenerateCorpus(argc > 1 ? atoi(argv[1]) : kDefaultFileCount);
+
+	Logger::SetLevel(LOG_LEVEL_ERROR);
+	const std::string cachePath = CachePath(root.c_str());
+	unlink(cachePath.c_str());
+
+	// quit while building: the thread deletes the index, and must not save
+	// the partial one
+	TrigramIndex* interrupted = new TrigramIndex(root.c_str());
+	interrupted->Start("", false);
+	snooze(50000);
+	interrupted->Quit();
+	snooze(1000000);
+	struct stat st;
+	bool passed = stat(cachePath.c_str(), &st) != 0;
+	printf("  index quit while building %s\n", passed ? "not saved" : "SAVED");
+
+	{
+		TrigramIndex index(root.c_str());
+		index.Start("", false);
+		const double buildTime = WaitReady(index);
+		WaitSaved(cachePath);
+		stat(cachePath.c_str(), &st);
+		printf("%s\n  built in %.2f s, index file %.1f MiB\n", root.c_str(), buildTime,
+			st.st_size / 1048576.0);
+		passed = RunQueries(index, root.c_str(), true) && passed;
+	}
+	{
+		TrigramIndex index(root.c_str());
+		index.Start("", false);
+		printf("  loaded and refreshed in %.2f s\n", WaitReady(index));
+	}
+
+	// damaged index files, which must be rebuilt
+	const std::string saved = cachePath + ".saved";
+	if (rename(cachePath.c_str(), saved.c_str()) != 0)
+		return 1;
+	const char* damages[] = { "a truncation", "an id past the files",
+		"an unterminated varint" };
+	for (int32 damage = 0; damage < 3; damage++) {
+		{
+			std::ifstream in(saved, std::ios::binary);
+			std::string content((std::istreambuf_iterator<char>(in)),
+				std::istreambuf_iterator<char>());
+			if (!Damage(content, damage)) {
+				printf("  unexpected index file format\n");
+				return 1;
+			}
+			std::ofstream(cachePath, std::ios::binary | std::ios::trunc) << content;
+		}
+		TrigramIndex index(root.c_str());
+		index.Start("", false);
+		WaitReady(index);
+		const bool rebuilt = RunQueries(index, root.c_str(), false);
+		printf("  index file with %s: %s\n", damages[damage],
+			rebuilt ? "rebuilt" : "WRONG CANDIDATES");
+		passed = passed && rebuilt;
+	}
+	unlink(saved.c_str());
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+enum {
+	B_QUIT_REQUESTED	= '_QRQ'
+};
@@ -0,0 +1,20 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Locker.h"
+
+class BAutolock {
+public:
+					BAutolock(BLocker& locker) : fLocker(&locker) { fLocked = locker.Lock(); }
+					BAutolock(BLocker* locker) : fLocker(locker) { fLocked = locker->Lock(); }
+					~BAutolock() { if (fLocked) fLocker->Unlock(); }
+
+		bool		IsLocked() const { return fLocked; }
+
+private:
+		BLocker*	fLocker;
+		bool		fLocked;
+};
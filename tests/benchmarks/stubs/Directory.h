@@ -0,0 +1,12 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <sys/stat.h>
+
+#include "SupportDefs.h"
+
+// creates the missing folders of path
+status_t	create_directory(const char* path, mode_t mode);
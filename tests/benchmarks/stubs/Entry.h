@@ -0,0 +1,37 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SupportDefs.h"
+
+struct entry_ref {
+					entry_ref() : device(-1), directory(-1), name(nullptr) {}
+					entry_ref(dev_t device, ino_t directory, const char* name)
+						: device(device), directory(directory), name(nullptr)
+						{ set_name(name); }
+					entry_ref(const entry_ref& other) : entry_ref(other.device,
+						other.directory, other.name) {}
+					~entry_ref() { free(name); }
+
+		entry_ref&	operator=(const entry_ref& other)
+						{ if (this != &other) { device = other.device;
+						  directory = other.directory; set_name(other.name); }
+						  return *this; }
+		status_t	set_name(const char* newName)
+						{ free(name); name = newName != nullptr ? strdup(newName) : nullptr;
+						  return B_OK; }
+
+		bool		operator==(const entry_ref& other) const
+						{ return device == other.device && directory == other.directory
+							&& (name == other.name || (name != nullptr
+								&& other.name != nullptr && strcmp(name, other.name) == 0)); }
+
+		dev_t		device;
+		ino_t		directory;
+		char*		name;
+};
@@ -0,0 +1,14 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Path.h"
+
+enum directory_which {
+	B_USER_CACHE_DIRECTORY
+};
+
+// $GENIO_CACHE_DIRECTORY, or a folder in /tmp
+status_t	find_directory(directory_which which, BPath* path, bool createIt = false);
@@ -0,0 +1,30 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Message.h"
+#include "OS.h"
+
+// The thread of the LSP reader is never started: the benchmarks read the
+// messages themselves
+class GenericThread {
+public:
+					GenericThread(const char* threadName = "generic_thread",
+						int32 priority = B_NORMAL_PRIORITY, BMessage* message = nullptr)
+						: fQuitRequested(false) {}
+	virtual			~GenericThread() {}
+
+		status_t	Start() { return B_OK; }
+		void		Quit() { fQuitRequested = true; }
+		bool		HasQuitBeenRequested() { return fQuitRequested; }
+		status_t	Suspend() { return B_OK; }
+		status_t	Kill() { return B_OK; }
+
+protected:
+	virtual	status_t	ExecuteUnit() { return B_OK; }
+
+private:
+		bool		fQuitRequested;
+};
@@ -0,0 +1,285 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <OS.h>
+#include <image.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+
+
+bigtime_t
+system_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (bigtime_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+void
+snooze(bigtime_t microseconds)
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+}
+
+
+// Threads are started by resume_thread(), as on Haiku
+
+struct Thread {
+	thread_func	function;
+	void*		data;
+	status_t	result;
+	std::thread	thread;
+
+	// a thread nobody waits for, as on Haiku
+	~Thread()
+	{
+		if (thread.joinable())
+			thread.detach();
+	}
+};
+
+static std::mutex sThreadsLock;
+static std::map<thread_id, std::shared_ptr<Thread>> sThreads;
+static thread_id sNextThread = 1;
+
+
+static std::shared_ptr<Thread>
+FindThread(thread_id id)
+{
+	std::lock_guard<std::mutex> lock(sThreadsLock);
+	auto found = sThreads.find(id);
+	return found != sThreads.end() ? found->second : nullptr;
+}
+
+
+thread_id
+spawn_thread(thread_func function, const char* name, int32 priority, void* data)
+{
+	std::lock_guard<std::mutex> lock(sThreadsLock);
+	std::shared_ptr<Thread> thread = std::make_shared<Thread>();
+	thread->function = function;
+	thread->data = data;
+	thread->result = B_OK;
+	sThreads[sNextThread] = thread;
+	return sNextThread++;
+}
+
+
+status_t
+resume_thread(thread_id id)
+{
+	std::shared_ptr<Thread> thread = FindThread(id);
+	if (thread == nullptr || thread->thread.joinable())
+		return B_BAD_THREAD_ID;
+	Thread* raw = thread.get();
+	thread->thread = std::thread([raw]() { raw->result = raw->function(raw->data); });
+	return B_OK;
+}
+
+
+status_t
+wait_for_thread(thread_id id, status_t* result)
+{
+	std::shared_ptr<Thread> thread = FindThread(id);
+	if (thread == nullptr)
+		return B_BAD_THREAD_ID;
+	if (thread->thread.joinable())
+		thread->thread.join();
+	*result = thread->result;
+	std::lock_guard<std::mutex> lock(sThreadsLock);
+	sThreads.erase(id);
+	return B_OK;
+}
+
+
+struct Semaphore {
+	std::mutex				lock;
+	std::condition_variable	released;
+	int32					count;
+	bool					deleted;
+};
+
+static std::mutex sSemaphoresLock;
+static std::map<sem_id, std::shared_ptr<Semaphore>> sSemaphores;
+static sem_id sNextSemaphore = 1;
+
+
+static std::shared_ptr<Semaphore>
+FindSemaphore(sem_id id)
+{
+	std::lock_guard<std::mutex> lock(sSemaphoresLock);
+	auto found = sSemaphores.find(id);
+	return found != sSemaphores.end() ? found->second : nullptr;
+}
+
+
+sem_id
+create_sem(int32 count, const char* name)
+{
+	std::lock_guard<std::mutex> lock(sSemaphoresLock);
+	std::shared_ptr<Semaphore> semaphore = std::make_shared<Semaphore>();
+	semaphore->count = count;
+	semaphore->deleted = false;
+	sSemaphores[sNextSemaphore] = semaphore;
+	return sNextSemaphore++;
+}
+
+
+status_t
+delete_sem(sem_id id)
+{
+	std::shared_ptr<Semaphore> semaphore = FindSemaphore(id);
+	if (semaphore == nullptr)
+		return B_BAD_SEM_ID;
+	{
+		std::lock_guard<std::mutex> lock(semaphore->lock);
+		semaphore->deleted = true;
+	}
+	semaphore->released.notify_all();
+	std::lock_guard<std::mutex> lock(sSemaphoresLock);
+	sSemaphores.erase(id);
+	return B_OK;
+}
+
+
+status_t
+acquire_sem_etc(sem_id id, int32 count, uint32 flags, bigtime_t timeout)
+{
+	std::shared_ptr<Semaphore> semaphore = FindSemaphore(id);
+	if (semaphore == nullptr)
+		return B_BAD_SEM_ID;
+	std::unique_lock<std::mutex> lock(semaphore->lock);
+	auto ready = [&]() { return semaphore->deleted || semaphore->count >= count; };
+	if ((flags & B_RELATIVE_TIMEOUT) != 0) {
+		if (!semaphore->released.wait_for(lock, std::chrono::microseconds(timeout), ready))
+			return B_TIMED_OUT;
+	} else
+		semaphore->released.wait(lock, ready);
+	if (semaphore->deleted)
+		return B_BAD_SEM_ID;
+	semaphore->count -= count;
+	return B_OK;
+}
+
+
+status_t
+acquire_sem(sem_id id)
+{
+	return acquire_sem_etc(id, 1, 0, 0);
+}
+
+
+status_t
+release_sem(sem_id id)
+{
+	std::shared_ptr<Semaphore> semaphore = FindSemaphore(id);
+	if (semaphore == nullptr)
+		return B_BAD_SEM_ID;
+	{
+		std::lock_guard<std::mutex> lock(semaphore->lock);
+		semaphore->count++;
+	}
+	semaphore->released.notify_all();
+	return B_OK;
+}
+
+
+status_t
+get_sem_count(sem_id id, int32* count)
+{
+	std::shared_ptr<Semaphore> semaphore = FindSemaphore(id);
+	if (semaphore == nullptr)
+		return B_BAD_SEM_ID;
+	std::lock_guard<std::mutex> lock(semaphore->lock);
+	*count = semaphore->count;
+	return B_OK;
+}
+
+
+status_t
+find_directory(directory_which which, BPath* path, bool createIt)
+{
+	const char* folder = getenv("GENIO_CACHE_DIRECTORY");
+	path->SetTo(folder != nullptr ? folder : "/tmp/genio-benchmark-cache");
+	return createIt ? create_directory(path->Path(), 0755) : B_OK;
+}
+
+
+status_t
+create_directory(const char* path, mode_t mode)
+{
+	std::string partial;
+	for (const char* c = path; ; c++) {
+		if (*c == '/' || *c == '\0') {
+			if (!partial.empty() && mkdir(partial.c_str(), mode) != 0 && errno != EEXIST)
+				return B_ERROR;
+			if (*c == '\0')
+				break;
+		}
+		partial += *c;
+	}
+	return B_OK;
+}
+
+
+thread_id
+load_image(int32 argc, const char** argv, const char** environment)
+{
+	const pid_t child = fork();
+	if (child == 0) {
+		execvp(argv[0], const_cast<char* const*>(argv));
+		_exit(1);
+	}
+	return child < 0 ? B_ERROR : child;
+}
+
+
+// Only the errors and the infos, as the stats of the index, are shown
+
+log_level Logger::sLevel = LOG_LEVEL_INFO;
+int Logger::sDestination = LOGGER_DEST_STDOUT;
+
+
+bool
+Logger::IsLevelEnabled(log_level value)
+{
+	return value <= sLevel;
+}
+
+
+void
+Logger::SetLevel(log_level value)
+{
+	sLevel = value;
+}
+
+
+void
+Logger::LogFormat(log_level level, const char* fmtString, ...)
+{
+	va_list arguments;
+	va_start(arguments, fmtString);
+	vprintf(fmtString, arguments);
+	va_end(arguments);
+	putchar('\n');
+}
@@ -0,0 +1,14 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Message.h"
+
+class BHandler {
+public:
+	virtual			~BHandler() {}
+
+	virtual	void	MessageReceived(BMessage* message) {}
+};
@@ -0,0 +1,20 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <mutex>
+
+#include "SupportDefs.h"
+
+class BLocker {
+public:
+					BLocker(const char* name = nullptr) {}
+
+		bool		Lock() { fMutex.lock(); return true; }
+		void		Unlock() { fMutex.unlock(); }
+
+private:
+	std::recursive_mutex	fMutex;
+};
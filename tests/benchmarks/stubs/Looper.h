@@ -0,0 +1,20 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Handler.h"
+#include "OS.h"
+
+// A looper never run: the messages posted to it are dropped
+class BLooper : public BHandler {
+public:
+					BLooper(const char* name = nullptr) {}
+
+		status_t	PostMessage(uint32 what) { return B_OK; }
+		status_t	PostMessage(BMessage* message) { return B_OK; }
+
+	virtual	thread_id	Run() { return B_ERROR; }
+	virtual	void	Quit() {}
+};
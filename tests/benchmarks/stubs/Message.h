@@ -0,0 +1,16 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "AppDefs.h"
+#include "SupportDefs.h"
+
+// Only the code: the benchmarks never look inside a message
+class BMessage {
+public:
+					BMessage(uint32 what = 0) : what(what) {}
+
+		uint32		what;
+};
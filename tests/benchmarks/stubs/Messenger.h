@@ -0,0 +1,23 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "Handler.h"
+#include "OS.h"
+
+// Counts the messages sent, the benchmarks don't deliver them
+class BMessenger {
+public:
+					BMessenger() : fSent(0) {}
+
+		status_t	SendMessage(BMessage* message, BHandler* replyTo = nullptr,
+						bigtime_t timeout = B_INFINITE_TIMEOUT)
+						{ fSent++; return B_OK; }
+
+		int32		CountSent() const { return fSent; }
+
+private:
+		int32		fSent;
+};
@@ -0,0 +1,18 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "SupportDefs.h"
+
+struct node_ref {
+					node_ref() : device(-1), node(-1) {}
+					node_ref(dev_t device, ino_t node) : device(device), node(node) {}
+
+		bool		operator==(const node_ref& other) const
+						{ return device == other.device && node == other.node; }
+
+		dev_t		device;
+		ino_t		node;
+};
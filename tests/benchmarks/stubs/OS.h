@@ -0,0 +1,35 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "SupportDefs.h"
+
+typedef status_t (*thread_func)(void*);
+
+enum {
+	B_LOW_PRIORITY		= 5,
+	B_NORMAL_PRIORITY	= 10
+};
+
+enum {
+	B_RELATIVE_TIMEOUT	= 0x8
+};
+
+#define B_INFINITE_TIMEOUT	INT64_MAX
+
+bigtime_t	system_time();
+void		snooze(bigtime_t microseconds);
+
+thread_id	spawn_thread(thread_func function, const char* name, int32 priority,
+				void* data);
+status_t	resume_thread(thread_id thread);
+status_t	wait_for_thread(thread_id thread, status_t* result);
+
+sem_id		create_sem(int32 count, const char* name);
+status_t	delete_sem(sem_id sem);
+status_t	acquire_sem(sem_id sem);
+status_t	acquire_sem_etc(sem_id sem, int32 count, uint32 flags, bigtime_t timeout);
+status_t	release_sem(sem_id sem);
+status_t	get_sem_count(sem_id sem, int32* count);
@@ -0,0 +1,28 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <string>
+
+#include "SupportDefs.h"
+
+class BPath {
+public:
+					BPath() {}
+					BPath(const char* path) : fPath(path) {}
+
+		status_t	InitCheck() const { return fPath.empty() ? B_ERROR : B_OK; }
+		status_t	SetTo(const char* path) { fPath = path; return B_OK; }
+		status_t	Append(const char* leaf)
+						{ if (!fPath.empty() && fPath.back() != '/') fPath += '/';
+						  fPath += leaf; return B_OK; }
+	const char*		Path() const { return fPath.c_str(); }
+	const char*		Leaf() const
+						{ const size_t slash = fPath.rfind('/');
+						  return fPath.c_str() + (slash == std::string::npos ? 0 : slash + 1); }
+
+private:
+		std::string	fPath;
+};
@@ -0,0 +1,82 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <string.h>
+
+#include <string>
+
+#include "SupportDefs.h"
+
+class BString {
+public:
+					BString() {}
+					BString(const char* string) : fString(string != nullptr ? string : "") {}
+					BString(const char* string, int32 length)
+						: fString(string, strnlen(string, length)) {}
+
+	const char*		String() const { return fString.c_str(); }
+		int32		Length() const { return fString.length(); }
+		bool		IsEmpty() const { return fString.empty(); }
+		char		ByteAt(int32 index) const { return fString[index]; }
+		char		operator[](int32 index) const { return fString[index]; }
+
+		BString&	SetTo(const char* string) { return *this = BString(string); }
+		BString&	SetTo(const char* string, int32 length)
+						{ return *this = BString(string, length); }
+		BString&	Append(const char* string) { fString += string; return *this; }
+		BString&	Append(const BString& string) { fString += string.fString; return *this; }
+		BString&	Append(const char* string, int32 length)
+						{ fString.append(string, strnlen(string, length)); return *this; }
+		BString&	Prepend(const char* string) { fString.insert(0, string); return *this; }
+		BString&	Truncate(int32 length)
+						{ if (length < Length()) fString.resize(length); return *this; }
+		BString&	Trim()
+						{ const size_t first = fString.find_first_not_of(" \t\r\n");
+						  if (first == std::string::npos) fString.clear();
+						  else fString = fString.substr(first,
+							fString.find_last_not_of(" \t\r\n") - first + 1);
+						  return *this; }
+		BString&	Remove(int32 from, int32 length)
+						{ fString.erase(from, length); return *this; }
+		BString&	CopyInto(BString& into, int32 from, int32 length) const
+						{ into.fString = fString.substr(from, length); return into; }
+
+		int32		FindFirst(const char* string, int32 from = 0) const
+						{ return _Index(fString.find(string, from)); }
+		int32		FindFirst(char c, int32 from = 0) const
+						{ return _Index(fString.find(c, from)); }
+		int32		FindLast(const char* string) const { return _Index(fString.rfind(string)); }
+		int32		FindLast(char c) const { return _Index(fString.rfind(c)); }
+		bool		StartsWith(const char* string) const
+						{ return fString.compare(0, strlen(string), string) == 0; }
+		bool		EndsWith(const char* string) const
+						{ const size_t length = strlen(string);
+						  return fString.length() >= length
+							&& fString.compare(fString.length() - length, length, string) == 0; }
+
+		BString&	operator+=(const char* string) { return Append(string); }
+		BString&	operator+=(const BString& string) { return Append(string); }
+		BString&	operator+=(char c) { fString += c; return *this; }
+		BString&	operator<<(const char* string) { return Append(string); }
+		BString&	operator<<(const BString& string) { return Append(string); }
+		BString&	operator<<(char c) { fString += c; return *this; }
+		BString&	operator<<(int32 value) { fString += std::to_string(value); return *this; }
+		BString&	operator<<(uint32 value) { fString += std::to_string(value); return *this; }
+		BString&	operator<<(int64 value) { fString += std::to_string(value); return *this; }
+		BString&	operator<<(uint64 value) { fString += std::to_string(value); return *this; }
+
+		bool		operator==(const BString& other) const { return fString == other.fString; }
+		bool		operator!=(const BString& other) const { return fString != other.fString; }
+		bool		operator==(const char* other) const { return fString == other; }
+		bool		operator!=(const char* other) const { return fString != other; }
+		bool		operator<(const BString& other) const { return fString < other.fString; }
+
+private:
+	static	int32	_Index(size_t index)
+						{ return index == std::string::npos ? -1 : (int32)index; }
+
+		std::string	fString;
+};
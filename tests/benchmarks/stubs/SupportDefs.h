@@ -0,0 +1,45 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+// The few Haiku types and calls used by the classes built by the
+// benchmarks, so they can run on any POSIX system
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int8_t		int8;
+typedef uint8_t		uint8;
+typedef int16_t		int16;
+typedef uint16_t	uint16;
+typedef int32_t		int32;
+typedef uint32_t	uint32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+
+typedef int32		status_t;
+typedef int64		bigtime_t;
+typedef int32		thread_id;
+typedef int32		sem_id;
+
+enum {
+	B_OK			= 0,
+	B_ERROR			= -1,
+	B_NO_MEMORY		= INT32_MIN,
+	B_BAD_VALUE		= B_NO_MEMORY + 5,
+	B_TIMED_OUT		= B_NO_MEMORY + 9,
+	B_INTERRUPTED	= B_NO_MEMORY + 10,
+	B_BUSY			= B_NO_MEMORY + 14,
+	B_BAD_SEM_ID	= B_NO_MEMORY + 0x1000 + 1,
+	B_BAD_THREAD_ID	= B_NO_MEMORY + 0x1000 + 3,
+	B_ENTRY_NOT_FOUND	= B_NO_MEMORY + 0x6000 + 3
+};
+
+#define B_PRId64	PRId64
+
+#define B_PATH_NAME_LENGTH	1024
+#define B_FILE_NAME_LENGTH	256
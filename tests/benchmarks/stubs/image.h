@@ -0,0 +1,10 @@
+/*
+ * Copyright The Genio Contributors
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include "OS.h"
+
+// fork() and exec(): the child runs at once, resume_thread() is not needed
+thread_id	load_image(int32 argc, const char** argv, const char** environment);
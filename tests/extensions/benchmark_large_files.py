@@ -0,0 +1,90 @@
+#!python3
+# Copyright The Genio Contributors
+# All rights reserved. Distributed under the terms of the MIT license.
+
+# Measures the time Genio takes to insert a character in files of 1, 50
+# and 500 MB, through the scripting interface, as a stand in for the
+# keystroke latency. Genio must be running.
+# Usage: benchmark_large_files.py [size in MB...]
+
+import os
+import statistics
+import sys
+import time
+from Be import BMessenger, BMessage, BEntry, BPath, \
+    B_GET_PROPERTY, B_SET_PROPERTY, B_CREATE_PROPERTY, B_COUNT_PROPERTIES
+
+genio = BMessenger("application/x-vnd.Genio")
+
+KEYSTROKES = 200
+LINE = "int value = compute(first, second) + offset; // some comment here\n"
+
+
+def MakeFile(megabytes):
+    path = f"/tmp/genio_benchmark_{megabytes}MB.cpp"
+    lines = megabytes * 1024 * 1024 // len(LINE)
+    if not os.path.exists(path) or os.path.getsize(path) != lines * len(LINE):
+        with open(path, "w") as file:
+            chunk = LINE * 1024
+            for i in range(lines // 1024):
+                file.write(chunk)
+            file.write(LINE * (lines % 1024))
+    return path, lines
+
+
+def OpenEditor(path):
+    entry = BEntry(path)
+    entryPath = BPath()
+    entry.GetPath(entryPath)
+    message = BMessage(B_CREATE_PROPERTY)
+    message.AddSpecifier("Editor", entryPath.Path())
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+    return reply.GetInt32("error", 0) == 0
+
+
+def CountLines():
+    message = BMessage(B_COUNT_PROPERTIES)
+    message.AddSpecifier("Line")
+    message.AddSpecifier("SelectedEditor")
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+    return reply.GetInt32("result", -1)
+
+
+def Insert(position, text):
+    message = BMessage(B_SET_PROPERTY)
+    message.AddSpecifier("Text", position)
+    message.AddSpecifier("SelectedEditor")
+    message.AddString("data", text)
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+
+
+def Benchmark(megabytes):
+    path, lines = MakeFile(megabytes)
+    start = time.monotonic()
+    if not OpenEditor(path):
+        print(f"{megabytes} MB: could not open {path}")
+        return
+    # big files are read in the background
+    while CountLines() < lines:
+        time.sleep(0.05)
+    opened = time.monotonic() - start
+
+    position = os.path.getsize(path) // 2
+    samples = []
+    for i in range(KEYSTROKES):
+        start = time.monotonic()
+        Insert(position + i, "x")
+        samples.append((time.monotonic() - start) * 1000)
+    samples.sort()
+    print(f"{megabytes} MB: opened in {opened:.2f} s, keystroke median "
+        f"{statistics.median(samples):.3f} ms, p95 {samples[int(len(samples) * 0.95)]:.3f} ms, "
+        f"max {samples[-1]:.3f} ms")
+
+
+if __name__ == "__main__":
+    sizes = [int(size) for size in sys.argv[1:]] or [1, 50, 500]
+    for size in sizes:
+        Benchmark(size)
@@ -0,0 +1,106 @@
+#!python3
+# Copyright The Genio Contributors
+# All rights reserved. Distributed under the terms of the MIT license.
+
+# Scrolls a 100k lines file page by page, through the scripting interface,
+# and times each page: with line wrapping on, every jump has the lines up
+# to the new position laid out. Genio must be running.
+# Usage: benchmark_scrolling.py [lines]
+
+import os
+import statistics
+import sys
+import time
+from Be import BMessenger, BMessage, BEntry, BPath, \
+    B_GET_PROPERTY, B_SET_PROPERTY, B_CREATE_PROPERTY, B_COUNT_PROPERTIES
+
+genio = BMessenger("application/x-vnd.Genio")
+
+# ASCII and non ASCII text, of different lengths
+LINES = [
+    "\tfor (int32 index = 0; index < count; index++) {\n",
+    "\t\t// Ünïcödé text: naïve café, déjà vu, ½ ≤ ¾, 日本語のテキスト\n",
+    "\t\tresult += compute(values[index], weights[index]) * factor + offset - correction;"
+    " // a long line to wrap " + "x" * 120 + "\n",
+    "\t}\n",
+]
+
+
+def MakeFile(lines):
+    path = f"/tmp/genio_benchmark_{lines}_lines.cpp"
+    if not os.path.exists(path):
+        with open(path, "w") as file:
+            for i in range(lines):
+                file.write(LINES[i % len(LINES)])
+    return path
+
+
+def OpenEditor(path):
+    entry = BEntry(path)
+    entryPath = BPath()
+    entry.GetPath(entryPath)
+    message = BMessage(B_CREATE_PROPERTY)
+    message.AddSpecifier("Editor", entryPath.Path())
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+    return reply.GetInt32("error", 0) == 0
+
+
+def CountLines():
+    message = BMessage(B_COUNT_PROPERTIES)
+    message.AddSpecifier("Line")
+    message.AddSpecifier("SelectedEditor")
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+    return reply.GetInt32("result", -1)
+
+
+def VisibleLines():
+    message = BMessage(B_GET_PROPERTY)
+    message.AddSpecifier("VisibleLines")
+    message.AddSpecifier("SelectedEditor")
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+    result = BMessage()
+    reply.FindMessage("result", result)
+    return result.GetInt32("first_line", 0), result.GetInt32("last_line", 0)
+
+
+def ScrollTo(line):
+    message = BMessage(B_SET_PROPERTY)
+    message.AddSpecifier("ScrollPosition")
+    message.AddSpecifier("SelectedEditor")
+    message.AddInt32("data", line)
+    reply = BMessage()
+    genio.SendMessage(message, reply)
+
+
+def Benchmark(lines):
+    path = MakeFile(lines)
+    if not OpenEditor(path):
+        print(f"Could not open {path}")
+        return
+    while CountLines() < lines:
+        time.sleep(0.05)
+
+    first, last = VisibleLines()
+    page = max(1, last - first)
+    samples = []
+    start = time.monotonic()
+    line = 1
+    while line < lines:
+        pageStart = time.monotonic()
+        ScrollTo(line)
+        # the reply comes once the scroll is done
+        VisibleLines()
+        samples.append((time.monotonic() - pageStart) * 1000)
+        line += page
+    total = time.monotonic() - start
+    samples.sort()
+    print(f"{lines} lines, {len(samples)} pages in {total:.2f} s: page median "
+        f"{statistics.median(samples):.3f} ms, p95 {samples[int(len(samples) * 0.95)]:.3f} ms, "
+        f"max {samples[-1]:.3f} ms")
+
+
+if __name__ == "__main__":
+    Benchmark(int(sys.argv[1]) if len(sys.argv) > 1 else 100000)